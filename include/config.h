@@ -56,9 +56,27 @@
 #ifndef FEATURE_COSMANIA
 #define FEATURE_COSMANIA  0
 #endif
+#ifndef FEATURE_COSMANIA_PUSH
+#define FEATURE_COSMANIA_PUSH 0     // SSE /events stream, polling as fallback
+#endif
 #ifndef FEATURE_SOVEREIGNTY
 #define FEATURE_SOVEREIGNTY 0
 #endif
+#ifndef FEATURE_PROFILER
+#define FEATURE_PROFILER  0
+#endif
+#ifndef FEATURE_JOURNAL
+#define FEATURE_JOURNAL   0
+#endif
+#ifndef FEATURE_HISTORY
+#define FEATURE_HISTORY   0
+#endif
+#ifndef FEATURE_METRICS
+#define FEATURE_METRICS   0         // Prometheus /metrics on the STA link
+#endif
+#ifndef FEATURE_TELEMETRY
+#define FEATURE_TELEMETRY 0         // batched POSTs to Cosmania (needs FEATURE_COSMANIA)
+#endif
 
 // -- Stat decay timing (ms) ------------------------------------------------
 #define HUNGER_DECAY_MS       5000
@@ -68,6 +86,47 @@
 #define LOGIC_TICK_MS          100
 #define DEFAULT_SAVE_MS      30000
 #define COSMANIA_POLL_MS     30000
+#define HISTORY_SAMPLE_MS    60000
+
+// -- WiFi STA reconnect ----------------------------------------------------
+// A DHCP lease is reused (no DHCP round trip) for this long after it was
+// handed out; 0 = always ask. A static address skips DHCP altogether.
+#define WIFI_LEASE_REUSE_S    1800
+// A reused lease is ARP-probed (RFC 5227, from 0.0.0.0) before it is
+// configured: an answer from another host within this window means the
+// address was handed on, and the connect falls back to DHCP. 0 = trust
+// the lease unprobed.
+#define WIFI_ARP_PROBE_MS      300
+#define WIFI_STATIC_IP          ""      // e.g. "192.168.1.50"; "" = DHCP
+#define WIFI_STATIC_GATEWAY     ""
+#define WIFI_STATIC_MASK        "255.255.255.0"
+#define WIFI_STATIC_DNS         ""      // "" = the gateway
+
+// -- Cosmania warm start ---------------------------------------------------
+// The last good status is kept in NVS and shown from boot, marked stale,
+// until a poll lands. At most one write this often: the status when it
+// changed, otherwise a stamp that a poll confirmed it unchanged. Mood,
+// evolution and decay only act on the snapshot while it is younger than
+// COSMANIA_STALE_MAX_S; until the clock is set its age is unknown and it
+// is shown but not acted on.
+#define COSMANIA_CACHE_SAVE_S   600
+#define COSMANIA_STALE_MAX_S   3600
+
+// -- Metrics endpoint (FEATURE_METRICS) ------------------------------------
+#define METRICS_PORT          9100
+
+// -- Telemetry upload (FEATURE_TELEMETRY) ----------------------------------
+// Events batch until TELEMETRY_MIN_BYTES of MessagePack or the oldest is
+// TELEMETRY_MAX_AGE_S old; offline batches spill to the "telemetry" partition.
+#define TELEMETRY_PATH         "/telemetry"     // appended to the Cosmania URL
+#define TELEMETRY_MIN_BYTES    1024
+#define TELEMETRY_MAX_AGE_S     300
+#define TELEMETRY_PET_S          60     // pet sample period (plus mood / stage changes)
+#define TELEMETRY_RADIO_S        15     // radio environment, at most this often on change
+
+// -- Offline catch-up ------------------------------------------------------
+#define EPOCH_VALID_MIN   1704067200UL      // 2024-01-01: wall clock is set
+#define CATCHUP_MAX_MS    (7UL * 24 * 3600 * 1000)
 
 // -- Animation timing (ms) -------------------------------------------------
 #define IDLE_BASE_DELAY       200
@@ -91,15 +150,38 @@
 #define DECISION_INTERVAL_MIN  8000
 #define DECISION_INTERVAL_MAX 15000
 
+// -- WiFi scan while associated --------------------------------------------
+// Passive, one channel per async scan, back on the home channel between
+#define WIFI_SCAN_CHANNELS      13
+#define WIFI_SCAN_DWELL_MS     110      // per channel: one beacon interval
+#define WIFI_SCAN_HOME_MS       60      // home-channel gap between channels
+
+// -- Network table (every BSSID heard, across scans) -----------------------
+// Powers of two; the small one is used when there is no PSRAM
+#define NET_TABLE_CAPACITY    4096      // 24 B each: 96 KB of PSRAM
+#define NET_TABLE_CAPACITY_SRAM 256     // 6 KB of internal RAM
+
+// -- BLE device table (every address heard, least recent evicted) ---------
+// Any size up to 65534; the small one is used when there is no PSRAM
+#define BLE_TABLE_CAPACITY    2048      // 56 B each: 112 KB of PSRAM
+#define BLE_TABLE_CAPACITY_SRAM 64      // 3.5 KB of internal RAM
+#define BLE_ADVERT_RING       128       // scan callback -> loop(), 36 B a slot: 4.5 KB
+
 // -- Sovereignty: radio scanning -------------------------------------------
-#define MAX_BLE_DEVICES         64
 #define MAX_PROBE_REQUESTS      32
 #define MAX_THREATS             16
 #define BLE_SCAN_INTERVAL_MS  5000
 #define BLE_SCAN_DURATION_S      3
 #define PROMISC_CHANNEL_HOP_MS 500
+#define RADIO_COUNT_WINDOW_S   300   // distinct devices/probers reported over
 #define THREAT_EXPIRE_MS     300000  // 5 minutes
-#define ROGUE_SCAN_THRESHOLD    10   // scans/min to flag
+// Per-device rates count every advert heard (duplicates included), so a
+// scan hears BLE_SCAN_DURATION_S of every BLE_SCAN_INTERVAL_MS: 0.6 of
+// what a device sends. Phones, laptops and beacons advertise every 100 ms
+// to 1 s (~35-360 heard/min); trackers, spam and enumeration tools go
+// down to the 20 ms minimum (~1400 heard/min)
+#define BLE_RATE_WINDOW_MS   20000   // per-device advert rate time constant
+#define ROGUE_SCAN_THRESHOLD   600   // heard adverts/min, ~60 ms interval
 #define DEAUTH_THRESHOLD         5   // deauths in window
 #define DEAUTH_WINDOW_MS     10000
-#define MASS_ENUM_THRESHOLD     20   // BLE scans from single source
+#define MASS_ENUM_THRESHOLD   1000   // heard adverts/min, ~35 ms: enumeration
@@ -103,6 +103,11 @@ struct WifiStats {
     int avgRSSI     = -100;
     int openCount   = 0;
     int wpaCount    = 0;
+    int newCount     = 0;   // BSSIDs never heard before (NetTable)
+    int goneCount    = 0;   // heard last scan, not this one
+    int changedCount = 0;   // SSID, auth, channel or signal moved
+    int knownCount   = 0;   // networks the table remembers
+    uint32_t version = 0;   // new value per scan result
 };
 
 // -- Agent info (from Cosmania /status JSON) -------------------------------
@@ -117,7 +122,9 @@ struct AgentInfo {
 
 // -- Cosmania system status ------------------------------------------------
 struct CosmaniaStatus {
-    bool connected          = false;
+    bool connected          = false;    // a stale snapshot counts while young enough
+    bool stale              = false;    // warm-start snapshot, no poll has confirmed it
+    uint32_t savedAt        = 0;        // stale: epoch s last confirmed live, 0 = unknown
     uint32_t lastPollMs     = 0;
     BudgetTier budgetTier   = TIER_UNKNOWN;
     float totalDailyBudget  = 0.0f;
@@ -128,6 +135,7 @@ struct CosmaniaStatus {
     uint8_t overdueCount    = 0;
     uint8_t activeCount     = 0;    // agents with todayRuns > 0
     uint8_t greenDaysStreak = 0;    // consecutive GREEN days
+    uint32_t version        = 0;    // bumped per parsed poll / disconnect
 };
 
 // -- Location geofence profile ---------------------------------------------
@@ -175,8 +183,8 @@ struct BleDevice {
     uint8_t addrHash[4]     = {0};  // truncated hash (not raw MAC)
     int8_t rssi             = -127;
     uint8_t deviceType      = 0;    // 0=unknown 1=phone 2=laptop 3=wearable 4=beacon
-    bool isScanner          = false;
-    uint8_t scanRate         = 0;    // observed scans/min from this device
+    bool isScanner          = false;  // scanRate at threshold, as of the last scan
+    float scanRate          = 0;    // adverts/min as of lastSeenMs, see BLE::scanRate()
     uint32_t lastSeenMs     = 0;
     char name[20]           = {0};
 };
@@ -191,14 +199,15 @@ struct ProbeRequest {
 
 // -- Sovereignty: aggregated radio environment -----------------------------
 struct RadioEnvironment {
-    int bleDeviceCount      = 0;
+    int bleDeviceCount      = 0;    // distinct, last RADIO_COUNT_WINDOW_S
     int bleScannerCount     = 0;
-    int probeCount          = 0;
-    int uniqueProbers       = 0;
+    int probeCount          = 0;    // probe window occupancy
+    int uniqueProbers       = 0;    // distinct, last RADIO_COUNT_WINDOW_S
     int deauthCount         = 0;
     int threatCount         = 0;
     ThreatSeverity worstThreat = THREAT_INFO;
     uint8_t safetyScore     = 100;  // 0-100, 100 = safe
+    uint32_t version        = 0;    // bumped only when a field changes
 };
 
 // -- Persisted settings ----------------------------------------------------
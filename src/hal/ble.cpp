@@ -5,6 +5,20 @@
 // BLE -- ESP32-S3 passive BLE scanning
 // Detects nearby BLE devices, identifies scanners, collects metadata.
 // MAC addresses are hashed -- raw MACs never stored.
+// Every advertisement also feeds a WindowHll, so distinctDevices() keeps
+// counting once the table is full and evicting.
+// The device table is a BleTable: O(1) lookup per advertisement, least
+// recently heard evicted when full, in PSRAM when the module has it.
+// Adverts cross from the Bluedroid callback task to loop() through an
+// SpscRing, as probe requests do in WifiPromisc: the callback only fills
+// a claimed slot, tick() drains the ring into the table. The table, its
+// rates and isScanner are then loop()-only, like everything that reads
+// them. Adverts that arrive with the ring full are dropped and counted.
+// Each device's scanRate is a RateMeter: adverts per minute, decayed over
+// BLE_RATE_WINDOW_MS, so a phone that lingers nearby doesn't creep up
+// to the scanner thresholds the way a count of sightings did. The scan
+// reports duplicates, so that is every advert heard -- the thresholds
+// in config.h are set against those rates, not sightings per scan.
 // ==========================================================================
 
 #if FEATURE_SOVEREIGNTY
@@ -12,16 +26,36 @@
 #include <BLEDevice.h>
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
+#include <esp_heap_caps.h>
+#include "../sys/ble_table.h"
+#include "../sys/metrics.h"
+#include "../sys/rate_meter.h"
+#include "../sys/spsc_ring.h"
+#include "../sys/window_hll.h"
+
+// One advert as the callback heard it
+struct BleAdvert {
+    uint8_t  addrHash[4];
+    int8_t   rssi;
+    uint8_t  deviceType;
+    uint32_t heardMs;
+    char     name[sizeof(BleDevice::name)];
+};
+
+// Scan callback -> loop()
+static SpscRing<BleAdvert, BLE_ADVERT_RING> s_ring;
+static uint32_t s_overflowsSeen = 0;
 
-static BleDevice s_devices[MAX_BLE_DEVICES];
-static int s_deviceCount  = 0;
+// loop() side
+static BleTable s_table;
 static int s_scannerCount = 0;
 static BLEScan* s_scanner = nullptr;
 static bool s_scanning    = false;
 static unsigned long s_lastScanMs = 0;
+static WindowHll s_crowd;           // fed from the scan callback, before the ring
 
-// Simple hash of 6-byte MAC to 4-byte fingerprint
-static void hashAddr(const uint8_t* addr, uint8_t* out) {
+// Simple hash of 6-byte MAC to 4-byte fingerprint; returns it whole too
+static uint32_t hashAddr(const uint8_t* addr, uint8_t* out) {
     // FNV-1a 32-bit
     uint32_t h = 2166136261u;
     for (int i = 0; i < 6; i++) {
@@ -32,17 +66,7 @@ static void hashAddr(const uint8_t* addr, uint8_t* out) {
     out[1] = (h >> 16) & 0xFF;
     out[2] = (h >> 8) & 0xFF;
     out[3] = h & 0xFF;
-}
-
-static bool hashMatch(const uint8_t* a, const uint8_t* b) {
-    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
-}
-
-static int findDevice(const uint8_t* hash) {
-    for (int i = 0; i < s_deviceCount; i++) {
-        if (hashMatch(s_devices[i].addrHash, hash)) return i;
-    }
-    return -1;
+    return h;
 }
 
 static uint8_t classifyDevice(BLEAdvertisedDevice& dev) {
@@ -56,66 +80,76 @@ static uint8_t classifyDevice(BLEAdvertisedDevice& dev) {
     return 0;
 }
 
+// Runs in the Bluedroid task: hash, classify, hand over. Nothing shared
+// with loop() but the ring and the WindowHll
 class ScanCallbacks : public BLEAdvertisedDeviceCallbacks {
     void onResult(BLEAdvertisedDevice advertisedDevice) override {
         uint8_t hash[4];
         const uint8_t* rawAddr = advertisedDevice.getAddress().getNative();
-        hashAddr(rawAddr, hash);
-
-        int idx = findDevice(hash);
-        unsigned long now = millis();
-
-        if (idx >= 0) {
-            // Update existing device
-            BleDevice& d = s_devices[idx];
-            d.rssi = advertisedDevice.getRSSI();
-
-            // Track scan rate: if seen again within 10s, increment
-            unsigned long delta = now - d.lastSeenMs;
-            if (delta < 10000) {
-                d.scanRate = min(255, d.scanRate + 1);
-            }
-            d.lastSeenMs = now;
+        s_crowd.add(hashAddr(rawAddr, hash));
+
+        // Filled in place; dropped (and counted) if loop() is behind
+        BleAdvert* slot = s_ring.claim();
+        if (!slot) return;
+        BleAdvert& a = *slot;
+        memcpy(a.addrHash, hash, 4);
+        a.rssi       = advertisedDevice.getRSSI();
+        a.deviceType = classifyDevice(advertisedDevice);
+        a.heardMs    = millis();
+        if (advertisedDevice.haveName()) {
+            strncpy(a.name, advertisedDevice.getName().c_str(), 19);
+            a.name[19] = '\0';
         } else {
-            // New device
-            if (s_deviceCount < MAX_BLE_DEVICES) {
-                idx = s_deviceCount++;
-            } else {
-                // Overwrite oldest
-                uint32_t oldest = UINT32_MAX;
-                idx = 0;
-                for (int i = 0; i < MAX_BLE_DEVICES; i++) {
-                    if (s_devices[i].lastSeenMs < oldest) {
-                        oldest = s_devices[i].lastSeenMs;
-                        idx = i;
-                    }
-                }
-            }
-
-            BleDevice& d = s_devices[idx];
-            memcpy(d.addrHash, hash, 4);
-            d.rssi = advertisedDevice.getRSSI();
-            d.lastSeenMs = now;
-            d.scanRate = 0;
-            d.isScanner = false;
-            d.deviceType = classifyDevice(advertisedDevice);
-
-            if (advertisedDevice.haveName()) {
-                strncpy(d.name, advertisedDevice.getName().c_str(), 19);
-                d.name[19] = '\0';
-            } else {
-                d.name[0] = '\0';
-            }
+            a.name[0] = '\0';
         }
+        s_ring.publish();
     }
 };
 
+// loop(): one drained advert into the table
+static void applyAdvert(const BleAdvert& a) {
+    bool created;
+    BleDevice* dev = s_table.upsert(a.addrHash, created);
+    if (!dev) return;
+    BleDevice& d = *dev;
+
+    if (!created) {
+        // Update existing device
+        d.rssi = a.rssi;
+        d.scanRate = RateMeter::hit(d.scanRate, d.lastSeenMs, a.heardMs, BLE_RATE_WINDOW_MS);
+        d.lastSeenMs = a.heardMs;
+    } else {
+        // New device, in a fresh slot or the least recent one's
+        d.rssi = a.rssi;
+        d.lastSeenMs = a.heardMs;
+        d.scanRate = RateMeter::hit(0, a.heardMs, a.heardMs, BLE_RATE_WINDOW_MS);
+        d.isScanner = false;
+        d.deviceType = a.deviceType;
+        memcpy(d.name, a.name, sizeof(d.name));
+    }
+}
+
 static ScanCallbacks s_callbacks;
 
 void BLE::init() {
+    if (!s_table.capacity()) {
+        uint32_t capacity = BLE_TABLE_CAPACITY;
+        void* storage = heap_caps_malloc(BleTable::bytesFor(capacity), MALLOC_CAP_SPIRAM);
+        if (!storage) {
+            capacity = BLE_TABLE_CAPACITY_SRAM;
+            storage  = heap_caps_malloc(BleTable::bytesFor(capacity), MALLOC_CAP_INTERNAL);
+        }
+        if (storage && s_table.init(storage, capacity)) {
+            Serial.printf("[ble] device table: %lu entries, %u B in %s\n", (unsigned long)capacity,
+                          (unsigned)BleTable::bytesFor(capacity),
+                          capacity == BLE_TABLE_CAPACITY ? "PSRAM" : "SRAM");
+        }
+    }
+    s_ring.reset();
+    s_overflowsSeen = 0;
     BLEDevice::init("");
     s_scanner = BLEDevice::getScan();
-    s_scanner->setAdvertisedDeviceCallbacks(&s_callbacks, true);
+    s_scanner->setAdvertisedDeviceCallbacks(&s_callbacks, true);  // every advert: see scanRate
     s_scanner->setActiveScan(false);  // passive -- don't send scan requests
     s_scanner->setInterval(100);
     s_scanner->setWindow(99);         // near-continuous window
@@ -123,7 +157,22 @@ void BLE::init() {
 }
 
 void BLE::tick() {
+    // Everything heard since the last tick, in order, a few at a time: at
+    // most a ring's worth, so a busy callback can't keep tick() here
+    BleAdvert batch[16];
+    for (uint32_t taken = 0, n = 1; n && taken < BLE_ADVERT_RING; taken += n) {
+        n = s_ring.drain(batch, 16);
+        for (uint32_t i = 0; i < n; i++) applyAdvert(batch[i]);
+    }
+
+    uint32_t overflows = s_ring.overflows();
+    if (overflows != s_overflowsSeen) {
+        Metrics::inc(Metrics::BLE_OVERFLOWS, overflows - s_overflowsSeen);
+        s_overflowsSeen = overflows;
+    }
+
     unsigned long now = millis();
+    s_crowd.advance(now / 1000);
 
     if (!s_scanning && (now - s_lastScanMs >= BLE_SCAN_INTERVAL_MS)) {
         s_scanner->start(BLE_SCAN_DURATION_S, false);
@@ -138,39 +187,59 @@ void BLE::tick() {
             s_scanning = false;
             s_scanner->clearResults();
 
-            // Recount scanners
+            // Recount scanners: a device that has calmed down stops being one
             s_scannerCount = 0;
-            for (int i = 0; i < s_deviceCount; i++) {
-                if (s_devices[i].scanRate >= ROGUE_SCAN_THRESHOLD) {
-                    s_devices[i].isScanner = true;
-                    s_scannerCount++;
-                }
+            BleDevice* devices = s_table.entries();
+            for (uint32_t i = 0; i < s_table.size(); i++) {
+                devices[i].isScanner = BLE::scanRate(devices[i]) >= ROGUE_SCAN_THRESHOLD;
+                if (devices[i].isScanner) s_scannerCount++;
             }
         }
     }
 }
 
-int BLE::deviceCount() { return s_deviceCount; }
+int BLE::deviceCount() { return s_table.size(); }
+int BLE::deviceCapacity() { return s_table.capacity(); }
 int BLE::scannerCount() { return s_scannerCount; }
-const BleDevice* BLE::devices() { return s_devices; }
+float BLE::scanRate(const BleDevice& d) {
+    return RateMeter::at(d.scanRate, d.lastSeenMs, millis(), BLE_RATE_WINDOW_MS);
+}
+const BleDevice* BLE::devices() { return s_table.entries(); }
 const BleDevice* BLE::device(int idx) {
-    if (idx < 0 || idx >= s_deviceCount) return nullptr;
-    return &s_devices[idx];
+    if (idx < 0 || idx >= static_cast<int>(s_table.size())) return nullptr;
+    return &s_table.entries()[idx];
 }
 void BLE::clearDevices() {
-    s_deviceCount = 0;
+    s_table.clear();
     s_scannerCount = 0;
 }
 
+void BLE::printStats() {
+    const BleTable::Stats& st = s_table.stats();
+    const BleDevice* oldest = s_table.oldest();
+    Serial.printf("[ble] table %lu/%lu (%u B), %lu inserts, %lu updates, %lu evicted, "
+                  "oldest %lus ago, %lu adverts dropped\n",
+                  (unsigned long)s_table.size(), (unsigned long)s_table.capacity(),
+                  (unsigned)BleTable::bytesFor(s_table.capacity()), (unsigned long)st.inserts,
+                  (unsigned long)st.updates, (unsigned long)st.evictions,
+                  oldest ? (unsigned long)((millis() - oldest->lastSeenMs) / 1000) : 0ul,
+                  (unsigned long)s_ring.overflows());
+}
+uint32_t BLE::distinctDevices(uint32_t windowS) { return s_crowd.count(windowS); }
+
 #else
 
 // -- Stubs when sovereignty disabled ---------------------------------------
 void BLE::init() {}
 void BLE::tick() {}
 int BLE::deviceCount() { return 0; }
+int BLE::deviceCapacity() { return 0; }
 int BLE::scannerCount() { return 0; }
+float BLE::scanRate(const BleDevice&) { return 0; }
 const BleDevice* BLE::devices() { return nullptr; }
 const BleDevice* BLE::device(int) { return nullptr; }
 void BLE::clearDevices() {}
+void BLE::printStats() { Serial.println("[ble] sovereignty disabled"); }
+uint32_t BLE::distinctDevices(uint32_t) { return 0; }
 
 #endif
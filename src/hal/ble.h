@@ -12,11 +12,18 @@ namespace BLE {
 void init();
 void tick();
 
-int deviceCount();
+int deviceCount();                // entries in the table, at most deviceCapacity()
+int deviceCapacity();             // BLE_TABLE_CAPACITY, or _SRAM without PSRAM
 int scannerCount();               // devices actively scanning
-const BleDevice* devices();       // ring buffer, up to MAX_BLE_DEVICES
+float scanRate(const BleDevice& d);   // adverts/min, decayed to now
+const BleDevice* devices();       // [0, deviceCount()); a slot is reused on eviction
 const BleDevice* device(int idx);
 
 void clearDevices();
+void printStats();                // table occupancy, inserts / updates / evictions
+
+// Estimated distinct addresses heard over the last windowS seconds
+// (60 .. 900, see WindowHll), however many the table can hold
+uint32_t distinctDevices(uint32_t windowS);
 
 }  // namespace BLE
@@ -45,3 +45,11 @@ bool Buttons::downPressed() { return s_buttons[2].pressed; }
 bool Buttons::r1Pressed()   { return s_buttons[3].pressed; }
 bool Buttons::r2Pressed()   { return s_buttons[4].pressed; }
 bool Buttons::r3Pressed()   { return s_buttons[5].pressed; }
+
+uint8_t Buttons::pressedMask() {
+    uint8_t mask = 0;
+    for (int i = 0; i < BTN_COUNT; i++) {
+        if (s_buttons[i].pressed) mask |= (1 << i);
+    }
+    return mask;
+}
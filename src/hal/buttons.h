@@ -18,4 +18,7 @@ bool r1Pressed();
 bool r2Pressed();
 bool r3Pressed();
 
+// All edges from the last tick: bit 0..5 = UP, OK, DOWN, R1, R2, R3
+uint8_t pressedMask();
+
 }  // namespace Buttons
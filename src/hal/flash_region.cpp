@@ -0,0 +1,35 @@
+#include "flash_region.h"
+#include <esp_partition.h>
+
+// ==========================================================================
+// Flash Region -- esp_partition wrapper
+// ==========================================================================
+
+static const esp_partition_t* part(const void* p) {
+    return static_cast<const esp_partition_t*>(p);
+}
+
+bool FlashRegion::open(const char* label) {
+    const esp_partition_t* p = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!p) return false;
+    m_part = p;
+    m_size = p->size;
+    return true;
+}
+
+bool FlashRegion::read(uint32_t offset, void* dst, size_t len) const {
+    if (!m_part || offset + len > m_size) return false;
+    return esp_partition_read(part(m_part), offset, dst, len) == ESP_OK;
+}
+
+bool FlashRegion::write(uint32_t offset, const void* src, size_t len) {
+    if (!m_part || offset + len > m_size) return false;
+    return esp_partition_write(part(m_part), offset, src, len) == ESP_OK;
+}
+
+bool FlashRegion::eraseSector(uint32_t sector) {
+    if (!m_part || (sector + 1) * SECTOR_SIZE > m_size) return false;
+    return esp_partition_erase_range(part(m_part), sector * SECTOR_SIZE,
+                                     SECTOR_SIZE) == ESP_OK;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Flash Region -- Raw data partition access (read / program / erase)
+// Erase unit is one 4 KB sector; programming only clears bits, so a
+// sector must be erased before it is rewritten.
+// ==========================================================================
+
+class FlashRegion {
+public:
+    static constexpr uint32_t SECTOR_SIZE = 4096;
+
+    bool open(const char* label);       // Partition label from partitions.csv
+    bool isOpen() const { return m_part != nullptr; }
+
+    uint32_t size() const { return m_size; }
+    uint32_t sectorCount() const { return m_size / SECTOR_SIZE; }
+
+    bool read(uint32_t offset, void* dst, size_t len) const;
+    bool write(uint32_t offset, const void* src, size_t len);
+    bool eraseSector(uint32_t sector);
+
+private:
+    const void* m_part = nullptr;
+    uint32_t    m_size = 0;
+};
@@ -1,40 +1,58 @@
 #include "storage.h"
+#include "storage_codec.h"
+#include "config.h"
+#include <Arduino.h>
 #include <Preferences.h>
+#include <time.h>
 
 // ==========================================================================
 // Storage HAL -- NVS persistence (ported from upstream TamaFi.ino)
+//
+// PetState + Settings are encoded by StorageCodec's field table into one
+// CRC-checked record and written with a single putBytes, alternating
+// between two keys (A/B). A torn write can only damage the slot being
+// written; load takes the valid slot with the highest seq and migrates
+// older schemas forward. save() is a no-op unless the content changed.
 // ==========================================================================
 
 static Preferences s_prefs;
 
-void Storage::init() {
-    s_prefs.begin("tamafi2", false);
-}
+using namespace StorageCodec;
 
-void Storage::save(const PetState& pet, const Settings& settings) {
-    s_prefs.putInt("hunger",   pet.hunger);
-    s_prefs.putInt("happy",    pet.happiness);
-    s_prefs.putInt("health",   pet.health);
-    s_prefs.putULong("ageMin", pet.ageMinutes);
-    s_prefs.putULong("ageHr",  pet.ageHours);
-    s_prefs.putULong("ageDay", pet.ageDays);
-    s_prefs.putUChar("stage",  static_cast<uint8_t>(pet.stage));
-    s_prefs.putBool("hatched", pet.hatched);
-
-    s_prefs.putBool("sound",   settings.soundEnabled);
-    s_prefs.putBool("neo",     settings.neoPixelsEnabled);
-    s_prefs.putUChar("tftBri", settings.tftBrightness);
-    s_prefs.putUChar("ledBri", settings.ledBrightness);
-    s_prefs.putBool("sleep",   settings.autoSleep);
-    s_prefs.putUShort("saveMs", settings.autoSaveMs);
+static const char* const SLOT_KEYS[2] = { "stateA", "stateB" };
+static constexpr size_t  BLOB_MAX     = HEADER_SIZE + PAYLOAD_MAX;
+
+// -- Persisted-copy tracking -----------------------------------------------
+static uint32_t s_seq         = 0;      // seq of the newest valid slot
+static int      s_slot        = -1;     // slot holding it, -1 = none
+static uint32_t s_contentHash = 0;
+static bool     s_haveHash    = false;
+static uint32_t s_savedAt     = 0;
+static bool     s_legacyKeys  = false;  // per-key layout still present
+static uint16_t s_loadedSchema = 0;     // < SCHEMA_VERSION: rewrite on next save
+
+static Storage::Stats s_stats;
+static uint8_t s_blob[2][BLOB_MAX];     // one per slot; [0] doubles as save buffer
+
+// Reads a slot and checks framing + CRC; schema is checked by decode()
+static bool readSlot(int slot, Header& hdr) {
+    size_t n = s_prefs.getBytesLength(SLOT_KEYS[slot]);
+    if (n < HEADER_SIZE || n > BLOB_MAX) return false;
+    if (s_prefs.getBytes(SLOT_KEYS[slot], s_blob[slot], n) != n) return false;
+    readHeader(s_blob[slot], hdr);
+    if (hdr.magic != MAGIC || hdr.len != n - HEADER_SIZE) return false;
+    return crc32(s_blob[slot] + HEADER_SIZE, hdr.len) == hdr.crc;
 }
 
-void Storage::load(PetState& pet, Settings& settings) {
+// -- Legacy per-key layout (pre-blob firmware) -----------------------------
+static const char* const LEGACY_KEYS[] = {
+    "hunger", "happy", "health", "ageMin", "ageHr", "ageDay", "stage", "hatched",
+    "sound", "neo", "tftBri", "ledBri", "sleep", "saveMs", "savedAt",
+};
+
+static bool loadLegacy(PetState& pet, Settings& settings) {
     int h = s_prefs.getInt("hunger", -1);
-    if (h == -1) {
-        // First boot: defaults already set by struct initializers
-        return;
-    }
+    if (h == -1) return false;
 
     pet.hunger     = s_prefs.getInt("hunger", 70);
     pet.happiness  = s_prefs.getInt("happy",  70);
@@ -51,4 +69,127 @@ void Storage::load(PetState& pet, Settings& settings) {
     settings.ledBrightness    = s_prefs.getUChar("ledBri", 1);
     settings.autoSleep        = s_prefs.getBool("sleep", true);
     settings.autoSaveMs       = s_prefs.getUShort("saveMs", 30000);
+
+    s_savedAt = s_prefs.getULong("savedAt", 0);
+    return true;
+}
+
+void Storage::init() {
+    s_prefs.begin("tamafi2", false);
+}
+
+void Storage::save(const PetState& pet, const Settings& settings) {
+    time_t t = time(nullptr);
+    uint32_t savedAt = t > static_cast<time_t>(EPOCH_VALID_MIN) ? static_cast<uint32_t>(t) : 0;
+
+    uint8_t* payload = s_blob[0] + HEADER_SIZE;
+    size_t len = encode(pet, settings, savedAt, payload, PAYLOAD_MAX);
+    if (len == 0) {
+        s_stats.failed++;
+        return;
+    }
+
+    // Unchanged content is skipped -- unless the clock just became valid
+    // and the stored copy has no stamp for offline catch-up yet
+    uint32_t hash = contentHash(payload, len);
+    bool needStamp = s_savedAt == 0 && savedAt != 0;
+    if (s_haveHash && hash == s_contentHash && !needStamp) {
+        s_stats.skipped++;
+        return;
+    }
+
+    Header hdr;
+    hdr.magic  = MAGIC;
+    hdr.schema = SCHEMA_VERSION;
+    hdr.len    = static_cast<uint16_t>(len);
+    hdr.seq    = s_seq + 1;
+    hdr.crc    = crc32(payload, len);
+    writeHeader(s_blob[0], hdr);
+
+    // Overwrite the older slot; the newer one survives a torn write
+    int slot = s_slot < 0 ? 0 : 1 - s_slot;
+    size_t total = HEADER_SIZE + len;
+    if (s_prefs.putBytes(SLOT_KEYS[slot], s_blob[0], total) != total) {
+        s_stats.failed++;
+        return;
+    }
+
+    s_seq         = hdr.seq;
+    s_slot        = slot;
+    s_contentHash = hash;
+    s_haveHash    = true;
+    s_savedAt     = savedAt;
+    s_stats.written++;
+
+    if (s_legacyKeys) {
+        for (const char* key : LEGACY_KEYS) s_prefs.remove(key);
+        s_legacyKeys = false;
+        Serial.println("[storage] migrated legacy keys");
+    }
+    if (s_loadedSchema && s_loadedSchema < SCHEMA_VERSION) {
+        Serial.printf("[storage] migrated schema %u -> %u\n",
+                      (unsigned)s_loadedSchema, (unsigned)SCHEMA_VERSION);
+    }
+    s_loadedSchema = SCHEMA_VERSION;
+}
+
+void Storage::load(PetState& pet, Settings& settings) {
+    s_seq          = 0;
+    s_slot         = -1;
+    s_haveHash     = false;
+    s_savedAt      = 0;
+    s_legacyKeys   = false;
+    s_loadedSchema = 0;
+
+    Header hdr[2];
+    bool valid[2] = { readSlot(0, hdr[0]), readSlot(1, hdr[1]) };
+
+    // Newest first; a slot whose schema this firmware can't decode (written
+    // by a newer build) falls back to the other one
+    int order[2] = { 0, 1 };
+    if (valid[0] && valid[1] && hdr[1].seq > hdr[0].seq) { order[0] = 1; order[1] = 0; }
+    else if (!valid[0]) { order[0] = 1; order[1] = 0; }
+
+    for (int slot : order) {
+        if (!valid[slot]) continue;
+        PetState p;
+        Settings st;
+        uint32_t savedAt = 0;
+        if (!decode(hdr[slot].schema, s_blob[slot] + HEADER_SIZE, hdr[slot].len, p, st, savedAt)) {
+            valid[slot] = false;
+            continue;
+        }
+
+        pet      = p;
+        settings = st;
+        s_seq    = hdr[slot].seq;
+        s_slot   = slot;
+        s_savedAt      = savedAt;
+        s_loadedSchema = hdr[slot].schema;
+
+        // Older schema: leave the hash unset so the next save rewrites it
+        if (s_loadedSchema == SCHEMA_VERSION) {
+            size_t len = encode(pet, settings, savedAt, s_blob[0] + HEADER_SIZE, PAYLOAD_MAX);
+            s_contentHash = contentHash(s_blob[0] + HEADER_SIZE, len);
+            s_haveHash    = true;
+        }
+        if (!valid[1 - slot] && s_prefs.isKey(SLOT_KEYS[1 - slot])) s_stats.corruptSlots++;
+        return;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (s_prefs.isKey(SLOT_KEYS[i])) s_stats.corruptSlots++;
+    }
+
+    // No blob yet: older firmware stored one NVS key per field
+    s_legacyKeys = loadLegacy(pet, settings);
+    // First boot otherwise: defaults already set by struct initializers
+}
+
+uint32_t Storage::savedAt() {
+    return s_savedAt;
+}
+
+const Storage::Stats& Storage::stats() {
+    return s_stats;
 }
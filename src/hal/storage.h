@@ -3,6 +3,9 @@
 
 // ==========================================================================
 // Storage HAL -- NVS persistence for pet state + settings
+// One schema-tagged, CRC-checked record in A/B slots (see storage_codec.h);
+// save() only writes when the content changed, so it is cheap to call on
+// every auto-save tick.
 // ==========================================================================
 
 namespace Storage {
@@ -11,4 +14,15 @@ void init();
 void save(const PetState& pet, const Settings& settings);
 void load(PetState& pet, Settings& settings);
 
+// Wall-clock time (epoch s) of the last write, 0 if the clock wasn't set
+uint32_t savedAt();
+
+struct Stats {
+    uint32_t written      = 0;  // blob writes (one NVS op each)
+    uint32_t skipped      = 0;  // saves with unchanged content
+    uint32_t failed       = 0;
+    uint32_t corruptSlots = 0;  // slots rejected at load (bad CRC/magic)
+};
+const Stats& stats();
+
 }  // namespace Storage
@@ -0,0 +1,278 @@
+#include "storage_codec.h"
+#include <cstring>
+
+// ==========================================================================
+// Storage Codec -- field table, TLV encode/decode, schema-1 layout decoder
+// ==========================================================================
+
+namespace StorageCodec {
+
+#define PET_FIELD(tag, member, type, since) \
+    { tag, OWNER_PET, type, offsetof(PetState, member), \
+      sizeof(PetState::member), 1, 0, since, #member }
+#define SET_FIELD(tag, member, type, since) \
+    { tag, OWNER_SETTINGS, type, offsetof(Settings, member), \
+      sizeof(Settings::member), 1, 0, since, #member }
+#define SET_ARRAY(tag, array, Elem, member, type, since) \
+    { tag, OWNER_SETTINGS, type, offsetof(Settings, array) + offsetof(Elem, member), \
+      sizeof(Elem::member), sizeof(Settings::array) / sizeof(Elem), sizeof(Elem), \
+      since, #array "." #member }
+
+// Tags are the on-flash identity: append new rows, never renumber
+constexpr Field FIELDS[] = {
+    PET_FIELD( 1, hunger,     FT_INT,  1),
+    PET_FIELD( 2, happiness,  FT_INT,  1),
+    PET_FIELD( 3, health,     FT_INT,  1),
+    PET_FIELD( 4, ageMinutes, FT_UINT, 1),
+    PET_FIELD( 5, ageHours,   FT_UINT, 1),
+    PET_FIELD( 6, ageDays,    FT_UINT, 1),
+    PET_FIELD( 7, stage,      FT_UINT, 1),
+    PET_FIELD( 8, hatched,    FT_BOOL, 1),
+
+    SET_FIELD(16, soundEnabled,     FT_BOOL, 1),
+    SET_FIELD(17, neoPixelsEnabled, FT_BOOL, 1),
+    SET_FIELD(18, tftBrightness,    FT_UINT, 1),
+    SET_FIELD(19, ledBrightness,    FT_UINT, 1),
+    SET_FIELD(20, autoSleep,        FT_BOOL, 1),
+    SET_FIELD(21, autoSaveMs,       FT_UINT, 1),
+    SET_FIELD(22, pollIntervalMs,   FT_UINT, 2),
+    SET_FIELD(23, cosmaniaUrl,      FT_STR,  2),
+    SET_FIELD(24, wifiSsid,         FT_STR,  2),
+    SET_FIELD(25, wifiPass,         FT_STR,  2),
+
+    SET_ARRAY(32, geoProfiles, GeoProfile, lat,    FT_F32,   2),
+    SET_ARRAY(33, geoProfiles, GeoProfile, lng,    FT_F32,   2),
+    SET_ARRAY(34, geoProfiles, GeoProfile, radius, FT_F32,   2),
+    SET_ARRAY(35, geoProfiles, GeoProfile, zone,   FT_UINT,  2),
+    SET_ARRAY(40, nfcTags,     NfcTag,     uid,    FT_BYTES, 2),
+    SET_ARRAY(41, nfcTags,     NfcTag,     uidLen, FT_UINT,  2),
+    SET_ARRAY(42, nfcTags,     NfcTag,     zone,   FT_UINT,  2),
+};
+constexpr int FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+#undef PET_FIELD
+#undef SET_FIELD
+#undef SET_ARRAY
+
+// -- Table checks (compile time) -------------------------------------------
+static constexpr size_t recordMax(const Field& f) {
+    return f.type == FT_STR ? f.size - 1 : static_cast<size_t>(f.size) * f.count;
+}
+
+static constexpr bool tableValid() {
+    size_t total = 4;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        const Field& f = FIELDS[i];
+        if (f.tag == 0 || f.since < 1 || f.since > SCHEMA_VERSION) return false;
+        if (recordMax(f) > 255) return false;
+        if ((f.type == FT_INT || f.type == FT_UINT) && f.size > 4) return false;
+        if (f.type == FT_BOOL && f.size != 1) return false;
+        if (f.type == FT_F32 && f.size != 4) return false;
+        for (int j = 0; j < i; j++) {
+            if (FIELDS[j].tag == f.tag) return false;
+        }
+        total += 2 + recordMax(f);
+    }
+    return total <= PAYLOAD_MAX;
+}
+static_assert(tableValid(), "storage field table: bad row, duplicate tag, or payload too big");
+
+// -- Helpers ---------------------------------------------------------------
+static uint8_t* ownerBase(FieldOwner owner, PetState& pet, Settings& settings) {
+    return owner == OWNER_PET ? reinterpret_cast<uint8_t*>(&pet)
+                              : reinterpret_cast<uint8_t*>(&settings);
+}
+
+static const uint8_t* ownerBase(FieldOwner owner, const PetState& pet, const Settings& settings) {
+    return owner == OWNER_PET ? reinterpret_cast<const uint8_t*>(&pet)
+                              : reinterpret_cast<const uint8_t*>(&settings);
+}
+
+static const Field* findField(uint8_t tag) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (FIELDS[i].tag == tag) return &FIELDS[i];
+    }
+    return nullptr;
+}
+
+static uint32_t readU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void writeU32(uint8_t* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+// Integers are stored at their in-memory width; a scalar read back at a
+// different width (field widened or narrowed later) is sign/zero-extended
+static void storeInt(uint8_t* dst, uint8_t size, const uint8_t* src, size_t n, bool isSigned) {
+    uint32_t v = 0;
+    for (size_t i = 0; i < n && i < 4; i++) v |= static_cast<uint32_t>(src[i]) << (8 * i);
+    if (isSigned && n < 4 && (src[n - 1] & 0x80)) v |= 0xFFFFFFFFu << (8 * n);
+    for (uint8_t i = 0; i < size; i++) dst[i] = v >> (8 * i);
+}
+
+static void applyField(const Field& f, uint8_t* base, const uint8_t* data, size_t n) {
+    uint8_t* dst = base + f.offset;
+
+    if (f.type == FT_STR) {
+        size_t keep = n < f.size ? n : f.size - 1u;
+        memcpy(dst, data, keep);
+        memset(dst + keep, 0, f.size - keep);
+        return;
+    }
+
+    if (f.count == 1 && (f.type == FT_INT || f.type == FT_UINT)) {
+        if (n >= 1 && n <= 4) storeInt(dst, f.size, data, n, f.type == FT_INT);
+        return;
+    }
+
+    // Fixed-width elements; an array may have grown or shrunk since
+    if (n % f.size != 0) return;
+    size_t elems = n / f.size;
+    if (elems > f.count) elems = f.count;
+    for (size_t i = 0; i < elems; i++) {
+        uint8_t* el = dst + i * f.stride;
+        const uint8_t* src = data + i * f.size;
+        if (f.type == FT_BOOL) *reinterpret_cast<bool*>(el) = src[0] != 0;
+        else memcpy(el, src, f.size);
+    }
+}
+
+// Defaults are implied: decode starts from default-constructed structs
+static bool isDefault(const Field& f, const uint8_t* src, const uint8_t* def) {
+    for (uint8_t e = 0; e < f.count; e++) {
+        const uint8_t* a = src + e * f.stride;
+        const uint8_t* b = def + e * f.stride;
+        if (f.type == FT_STR) return strncmp(reinterpret_cast<const char*>(a),
+                                             reinterpret_cast<const char*>(b), f.size) == 0;
+        if (f.type == FT_BOOL) {
+            if (*reinterpret_cast<const bool*>(a) != *reinterpret_cast<const bool*>(b)) return false;
+        } else if (memcmp(a, b, f.size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -- Header ----------------------------------------------------------------
+void writeHeader(uint8_t* out, const Header& h) {
+    writeU32(out, h.magic);
+    out[4] = h.schema; out[5] = h.schema >> 8;
+    out[6] = h.len;    out[7] = h.len >> 8;
+    writeU32(out + 8, h.seq);
+    writeU32(out + 12, h.crc);
+}
+
+void readHeader(const uint8_t* in, Header& h) {
+    h.magic  = readU32(in);
+    h.schema = in[4] | (in[5] << 8);
+    h.len    = in[6] | (in[7] << 8);
+    h.seq    = readU32(in + 8);
+    h.crc    = readU32(in + 12);
+}
+
+// -- Payload ---------------------------------------------------------------
+size_t encode(const PetState& pet, const Settings& settings, uint32_t savedAt,
+              uint8_t* out, size_t cap) {
+    if (cap < 4) return 0;
+    writeU32(out, savedAt);
+    size_t len = 4;
+
+    static const PetState defPet;
+    static const Settings defSettings;
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        const Field& f = FIELDS[i];
+        const uint8_t* src = ownerBase(f.owner, pet, settings) + f.offset;
+        if (isDefault(f, src, ownerBase(f.owner, defPet, defSettings) + f.offset)) continue;
+
+        size_t n = f.type == FT_STR ? strnlen(reinterpret_cast<const char*>(src), f.size - 1u)
+                                    : static_cast<size_t>(f.size) * f.count;
+        if (len + 2 + n > cap) return 0;
+
+        out[len++] = f.tag;
+        out[len++] = static_cast<uint8_t>(n);
+        if (f.type == FT_STR) {
+            memcpy(out + len, src, n);
+            len += n;
+            continue;
+        }
+        for (uint8_t e = 0; e < f.count; e++) {
+            const uint8_t* el = src + e * f.stride;
+            if (f.type == FT_BOOL) out[len] = *reinterpret_cast<const bool*>(el) ? 1 : 0;
+            else memcpy(out + len, el, f.size);
+            len += f.size;
+        }
+    }
+    return len;
+}
+
+// Schema 1: the packed fixed layout written before the field table
+static constexpr size_t V1_LEN = 31;
+
+static bool decodeV1(const uint8_t* in, size_t len,
+                     PetState& pet, Settings& settings, uint32_t& savedAt) {
+    if (len != V1_LEN) return false;
+    auto i16 = [&](size_t o) { return static_cast<int16_t>(in[o] | (in[o + 1] << 8)); };
+
+    pet.hunger     = i16(0);
+    pet.happiness  = i16(2);
+    pet.health     = i16(4);
+    pet.ageMinutes = readU32(in + 6);
+    pet.ageHours   = readU32(in + 10);
+    pet.ageDays    = readU32(in + 14);
+    pet.stage      = static_cast<EvolutionStage>(in[18]);
+    pet.hatched    = in[19] != 0;
+
+    settings.soundEnabled     = in[20] != 0;
+    settings.neoPixelsEnabled = in[21] != 0;
+    settings.tftBrightness    = in[22];
+    settings.ledBrightness    = in[23];
+    settings.autoSleep        = in[24] != 0;
+    settings.autoSaveMs       = in[25] | (in[26] << 8);
+    savedAt = readU32(in + 27);
+    return true;
+}
+
+bool decode(uint16_t schema, const uint8_t* in, size_t len,
+            PetState& pet, Settings& settings, uint32_t& savedAt) {
+    if (schema == 1) return decodeV1(in, len, pet, settings, savedAt);
+    if (schema < 1 || schema > SCHEMA_VERSION || len < 4) return false;
+
+    savedAt = readU32(in);
+    size_t pos = 4;
+    while (pos < len) {
+        if (pos + 2 > len) return false;
+        uint8_t tag = in[pos];
+        uint8_t n   = in[pos + 1];
+        pos += 2;
+        if (pos + n > len) return false;
+
+        // Tags newer than the blob's schema can't be ours; skip like unknowns
+        const Field* f = findField(tag);
+        if (f && f->since <= schema) {
+            applyField(*f, ownerBase(f->owner, pet, settings), in + pos, n);
+        }
+        pos += n;
+    }
+    return true;
+}
+
+uint32_t contentHash(const uint8_t* payload, size_t len) {
+    return len < 4 ? 0 : crc32(payload + 4, len - 4);
+}
+
+uint32_t crc32(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= p[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+}  // namespace StorageCodec
@@ -0,0 +1,87 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Storage Codec -- Schema-driven encoding of PetState + Settings
+// Platform-neutral (no Arduino deps): linked into the firmware and the
+// host check in tools/storage_wear/.
+//
+// FIELDS describes every persisted member (tag, owner struct, offset, type,
+// size, element count, schema version that added it). Payload:
+//   [u32 savedAt] then one record per field: [u8 tag][u8 len] data
+// Integers and floats are raw little-endian at their in-memory width,
+// strings are stored without the trailing NULs, arrays as one record.
+// Fields still at their struct default are omitted. Unknown tags are
+// skipped and missing ones keep the defaults, so adding a field only
+// needs a new row with since = SCHEMA_VERSION.
+// Blobs older than the field table (schema 1) go through a layout decoder.
+// ==========================================================================
+
+namespace StorageCodec {
+
+static constexpr uint32_t MAGIC          = 0x414D4154;     // "TAMA"
+static constexpr uint16_t SCHEMA_VERSION = 2;
+static constexpr size_t   HEADER_SIZE    = 16;
+static constexpr size_t   PAYLOAD_MAX    = 512;
+
+enum FieldType : uint8_t {
+    FT_INT,             // signed integer, size = width
+    FT_UINT,            // unsigned integer / uint8_t enum
+    FT_BOOL,
+    FT_F32,
+    FT_STR,             // NUL-terminated char[size]
+    FT_BYTES,           // opaque uint8_t[size]
+};
+
+enum FieldOwner : uint8_t {
+    OWNER_PET,
+    OWNER_SETTINGS,
+};
+
+struct Field {
+    uint8_t    tag;     // stable on-flash id, never reused
+    FieldOwner owner;
+    FieldType  type;
+    uint16_t   offset;  // of element 0 within the owner struct
+    uint8_t    size;    // bytes per element
+    uint8_t    count;   // array elements (1 for scalars)
+    uint16_t   stride;  // bytes between elements
+    uint8_t    since;   // schema version that added the field
+    const char* name;
+};
+
+extern const Field FIELDS[];
+extern const int   FIELD_COUNT;
+
+// -- Blob header -----------------------------------------------------------
+struct Header {
+    uint32_t magic;
+    uint16_t schema;
+    uint16_t len;       // payload bytes
+    uint32_t seq;       // higher = newer
+    uint32_t crc;       // CRC-32 over payload
+};
+
+void writeHeader(uint8_t* out, const Header& h);
+void readHeader(const uint8_t* in, Header& h);
+
+// -- Payload ---------------------------------------------------------------
+// Returns payload length, 0 if it didn't fit in cap
+size_t encode(const PetState& pet, const Settings& settings, uint32_t savedAt,
+              uint8_t* out, size_t cap);
+
+// Decodes a payload written with `schema` (1..SCHEMA_VERSION). Pass
+// default-constructed pet/settings: omitted fields keep what they hold.
+// False if the schema is unknown or the payload is malformed; pet and
+// settings may then be partially written.
+bool decode(uint16_t schema, const uint8_t* in, size_t len,
+            PetState& pet, Settings& settings, uint32_t& savedAt);
+
+// CRC-32 of the payload minus savedAt: changes only when content does
+uint32_t contentHash(const uint8_t* payload, size_t len);
+
+uint32_t crc32(const void* data, size_t len);
+
+}  // namespace StorageCodec
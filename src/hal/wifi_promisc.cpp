@@ -10,10 +10,22 @@
 //
 // Runs alongside STA mode on the connected channel.
 // Channel hopping available when disconnected.
+//
+// Probe requests cross from the WiFi task to loop() through an SpscRing:
+// the callback fills a claimed slot in place and publishes it, tick()
+// drains everything new into a batch (newProbes()) and the window of
+// the last MAX_PROBE_REQUESTS that probeCount() reads. Probes that arrive
+// with the ring full are dropped and counted.
+//
+// Distinct probers are counted by a WindowHll the callback feeds before
+// the ring, so a burst that overflows it still counts every sender.
 // ==========================================================================
 
 #if FEATURE_SOVEREIGNTY
 
+#include "../sys/metrics.h"
+#include "../sys/spsc_ring.h"
+#include "../sys/window_hll.h"
 #include <esp_wifi.h>
 #include <esp_wifi_types.h>
 
@@ -21,10 +33,20 @@
 static constexpr uint8_t FC_PROBE_REQ  = 0x40;
 static constexpr uint8_t FC_DEAUTH     = 0xC0;
 
-// Ring buffer for probe requests
+// WiFi task -> loop()
+static SpscRing<ProbeRequest, MAX_PROBE_REQUESTS> s_ring;
+static uint32_t s_overflowsSeen = 0;
+
+// loop() side: this tick's batch, and a window of the latest probes
+static ProbeRequest s_batch[MAX_PROBE_REQUESTS];
+static int s_batchCount = 0;
 static ProbeRequest s_probes[MAX_PROBE_REQUESTS];
-static volatile int s_probeWriteIdx = 0;
+static int s_probeNext  = 0;
 static int s_probeCount = 0;
+static uint32_t s_probeTotal = 0;
+
+// Distinct senders over 1 / 5 / 15 minutes: fed by the callback
+static WindowHll s_probers;
 
 // Deauth counter
 static volatile int s_deauthCount = 0;
@@ -35,8 +57,8 @@ static bool s_channelHop  = false;
 static uint8_t s_channel  = 1;
 static unsigned long s_lastHopMs = 0;
 
-// FNV-1a hash for MAC address (same as BLE module)
-static void hashMAC(const uint8_t* mac, uint8_t* out) {
+// FNV-1a hash for MAC address (same as BLE module); returns it whole too
+static uint32_t hashMAC(const uint8_t* mac, uint8_t* out) {
     uint32_t h = 2166136261u;
     for (int i = 0; i < 6; i++) {
         h ^= mac[i];
@@ -46,6 +68,7 @@ static void hashMAC(const uint8_t* mac, uint8_t* out) {
     out[1] = (h >> 16) & 0xFF;
     out[2] = (h >> 8) & 0xFF;
     out[3] = h & 0xFF;
+    return h;
 }
 
 // Promiscuous mode callback -- runs in WiFi task, must be fast
@@ -64,12 +87,15 @@ static void IRAM_ATTR promisc_cb(void* buf, wifi_promiscuous_pkt_type_t type) {
     if (fc0 == FC_PROBE_REQ) {
         // Source MAC is at bytes 10-15
         const uint8_t* srcMAC = &frame[10];
+        uint8_t hash[4];
+        s_probers.add(hashMAC(srcMAC, hash));
 
-        // Write to ring buffer (single writer, safe without lock)
-        int idx = s_probeWriteIdx % MAX_PROBE_REQUESTS;
-        ProbeRequest& pr = s_probes[idx];
+        // Filled in place; dropped (and counted) if loop() is behind
+        ProbeRequest* slot = s_ring.claim();
+        if (!slot) return;
+        ProbeRequest& pr = *slot;
 
-        hashMAC(srcMAC, pr.srcHash);
+        memcpy(pr.srcHash, hash, 4);
         pr.rssi = pkt->rx_ctrl.rssi;
         pr.timestampMs = millis();
 
@@ -85,24 +111,42 @@ static void IRAM_ATTR promisc_cb(void* buf, wifi_promiscuous_pkt_type_t type) {
             }
         }
 
-        s_probeWriteIdx++;
+        s_ring.publish();
     }
 }
 
 void WifiPromisc::init() {
-    memset(s_probes, 0, sizeof(s_probes));
-    s_probeWriteIdx = 0;
+    s_ring.reset();
+    s_overflowsSeen = 0;
+    s_batchCount = 0;
+    s_probeNext  = 0;
     s_probeCount = 0;
+    s_probeTotal = 0;
+    s_probers.reset();
     s_deauthCount = 0;
     s_enabled = false;
     Serial.println("[promisc] ready");
 }
 
 void WifiPromisc::tick() {
-    if (!s_enabled) return;
+    // Everything captured since the last tick, each probe exactly once;
+    // a ring's worth is all the callback can have published
+    s_batchCount = s_ring.drain(s_batch, MAX_PROBE_REQUESTS);
+    for (int i = 0; i < s_batchCount; i++) {
+        s_probes[s_probeNext] = s_batch[i];
+        s_probeNext = (s_probeNext + 1) % MAX_PROBE_REQUESTS;
+    }
+    s_probeCount  = min(s_probeCount + s_batchCount, MAX_PROBE_REQUESTS);
+    s_probeTotal += s_batchCount;
+
+    uint32_t overflows = s_ring.overflows();
+    if (overflows != s_overflowsSeen) {
+        Metrics::inc(Metrics::PROBE_OVERFLOWS, overflows - s_overflowsSeen);
+        s_overflowsSeen = overflows;
+    }
+    s_probers.advance(millis() / 1000);
 
-    // Update probe count from write index
-    s_probeCount = min((int)s_probeWriteIdx, MAX_PROBE_REQUESTS);
+    if (!s_enabled) return;
 
     // Channel hopping
     if (s_channelHop) {
@@ -134,31 +178,19 @@ bool WifiPromisc::isEnabled() { return s_enabled; }
 
 int WifiPromisc::probeCount() { return s_probeCount; }
 
-int WifiPromisc::uniqueProbers() {
-    // Count unique source hashes in the buffer
-    int count = 0;
-    uint8_t seen[MAX_PROBE_REQUESTS][4];
-    int seenCount = 0;
-
-    for (int i = 0; i < s_probeCount; i++) {
-        bool found = false;
-        for (int j = 0; j < seenCount; j++) {
-            if (memcmp(s_probes[i].srcHash, seen[j], 4) == 0) {
-                found = true;
-                break;
-            }
-        }
-        if (!found && seenCount < MAX_PROBE_REQUESTS) {
-            memcpy(seen[seenCount], s_probes[i].srcHash, 4);
-            seenCount++;
-            count++;
-        }
-    }
-    return count;
-}
+int WifiPromisc::uniqueProbers() { return s_probers.count(RADIO_COUNT_WINDOW_S); }
+uint32_t WifiPromisc::distinctProbers(uint32_t windowS) { return s_probers.count(windowS); }
 
 const ProbeRequest* WifiPromisc::probes() { return s_probes; }
 
+int WifiPromisc::newProbes(const ProbeRequest*& out) {
+    out = s_batch;
+    return s_batchCount;
+}
+
+uint32_t WifiPromisc::probeTotal() { return s_probeTotal; }
+uint32_t WifiPromisc::probeOverflows() { return s_ring.overflows(); }
+
 int WifiPromisc::deauthCount() { return s_deauthCount; }
 void WifiPromisc::resetDeauthCount() { s_deauthCount = 0; }
 
@@ -177,7 +209,11 @@ void WifiPromisc::disable() {}
 bool WifiPromisc::isEnabled() { return false; }
 int WifiPromisc::probeCount() { return 0; }
 int WifiPromisc::uniqueProbers() { return 0; }
+uint32_t WifiPromisc::distinctProbers(uint32_t) { return 0; }
 const ProbeRequest* WifiPromisc::probes() { return nullptr; }
+int WifiPromisc::newProbes(const ProbeRequest*& out) { out = nullptr; return 0; }
+uint32_t WifiPromisc::probeTotal() { return 0; }
+uint32_t WifiPromisc::probeOverflows() { return 0; }
 int WifiPromisc::deauthCount() { return 0; }
 void WifiPromisc::resetDeauthCount() {}
 void WifiPromisc::setChannelHopping(bool) {}
@@ -19,8 +19,18 @@ bool isEnabled();
 
 // Probe request data
 int probeCount();
-int uniqueProbers();
-const ProbeRequest* probes();     // ring buffer, up to MAX_PROBE_REQUESTS
+int uniqueProbers();              // distinct senders, last RADIO_COUNT_WINDOW_S
+const ProbeRequest* probes();     // window of the latest probeCount(), unordered
+
+// Estimated distinct senders over the last windowS seconds (60 .. 900,
+// see WindowHll for what each covers); dropped probes count too
+uint32_t distinctProbers(uint32_t windowS);
+
+// Probes drained by the last tick(), oldest first, each handed out by
+// exactly one tick; valid until the next tick()
+int newProbes(const ProbeRequest*& out);
+uint32_t probeTotal();            // drained since init()
+uint32_t probeOverflows();        // dropped: capture ring full
 
 // Deauth detection
 int deauthCount();
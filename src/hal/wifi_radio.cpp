@@ -1,53 +1,163 @@
 #include "wifi_radio.h"
+#include "config.h"
+#include "../sys/metrics.h"
+#include "../sys/net_table.h"
 #include <WiFi.h>
+#include <esp_heap_caps.h>
 
 // ==========================================================================
 // WiFi Radio HAL -- Async scan (ported from upstream TamaFi.ino)
+// A linked scan is WIFI_SCAN_CHANNELS single-channel passive scans, each
+// started from isScanDone() once the one before it has been counted and
+// the radio has had WIFI_SCAN_HOME_MS on the home channel. Each AP is
+// heard on its own channel only, so per-channel results simply add up.
+// The net table lives in PSRAM when the module has it, else a small one
+// in internal RAM; either way it only costs memory, not scan time.
 // ==========================================================================
 
-static bool s_scanning = false;
+static bool     s_scanning   = false;
+static bool     s_linked     = false;   // associated scan, channel by channel
+static uint8_t  s_channel    = 0;       // channel scanning / last scanned
+static bool     s_between    = false;   // on the home channel between two
+static uint32_t s_startMs    = 0;
+static uint32_t s_chanDoneMs = 0;
+static WifiStats s_acc;                 // counts so far
+static int       s_rssiSum   = 0;
+static NetTable  s_table;
+
+// Adds the finished scan's results to s_acc and frees them
+static void countResults(int n) {
+    for (int i = 0; i < n; i++) {
+        int rssi = WiFi.RSSI(i);
+        s_rssiSum += rssi;
+        if (rssi > -60) s_acc.strongCount++;
+        if (WiFi.SSID(i).length() == 0) s_acc.hiddenCount++;
+        wifi_auth_mode_t auth = WiFi.encryptionType(i);
+        if (auth == WIFI_AUTH_OPEN) s_acc.openCount++;
+        else s_acc.wpaCount++;
+        s_table.observe(WiFi.BSSID(i), NetTable::ssidHash(WiFi.SSID(i).c_str()),
+                        static_cast<uint8_t>(auth), WiFi.channel(i), rssi);
+    }
+    if (n > 0) s_acc.netCount += n;
+    WiFi.scanDelete();
+}
+
+static void scanChannel(uint8_t channel) {
+    s_channel = channel;
+    s_between = false;
+    WiFi.scanNetworks(true, false, true, WIFI_SCAN_DWELL_MS, channel);  // async, passive
+}
 
 void WifiRadio::init() {
+    if (!s_table.capacity()) {
+        uint32_t capacity = NET_TABLE_CAPACITY;
+        void* storage = heap_caps_malloc(NetTable::bytesFor(capacity), MALLOC_CAP_SPIRAM);
+        if (!storage) {
+            capacity = NET_TABLE_CAPACITY_SRAM;
+            storage  = heap_caps_malloc(NetTable::bytesFor(capacity), MALLOC_CAP_INTERNAL);
+        }
+        if (storage && s_table.init(storage, capacity)) {
+            Serial.printf("[radio] net table: %lu entries, %u B in %s\n", (unsigned long)capacity,
+                          (unsigned)NetTable::bytesFor(capacity),
+                          capacity == NET_TABLE_CAPACITY ? "PSRAM" : "SRAM");
+        }
+    }
     WiFi.mode(WIFI_STA);
     WiFi.disconnect(true);
 }
 
 void WifiRadio::startScan() {
+    s_acc      = WifiStats();
+    s_rssiSum  = 0;
+    s_startMs  = millis();
+    s_scanning = true;
+    s_table.beginScan(s_startMs / 1000);
+    s_linked   = WiFi.status() == WL_CONNECTED;
+    if (s_linked) {
+        scanChannel(1);
+        return;
+    }
     WiFi.mode(WIFI_STA);
     WiFi.disconnect(true);
     WiFi.scanNetworks(true);    // async
-    s_scanning = true;
 }
 
 bool WifiRadio::isScanDone() {
     if (!s_scanning) return false;
-    int n = WiFi.scanComplete();
-    return (n != WIFI_SCAN_RUNNING);
+    if (!s_linked) return WiFi.scanComplete() != WIFI_SCAN_RUNNING;
+
+    uint32_t now = millis();
+    if (!s_between) {
+        int n = WiFi.scanComplete();
+        if (n == WIFI_SCAN_RUNNING) return false;
+        countResults(n);
+        s_between    = true;
+        s_chanDoneMs = now;
+    }
+    if (s_channel >= WIFI_SCAN_CHANNELS) return true;
+    if (now - s_chanDoneMs < WIFI_SCAN_HOME_MS) return false;
+    scanChannel(s_channel + 1);
+    return false;
 }
 
 WifiStats WifiRadio::getResults() {
+    static uint32_t s_version = 0;
     s_scanning = false;
-    WifiStats stats;
 
-    int n = WiFi.scanComplete();
-    if (n < 0) {
-        WiFi.scanDelete();
-        return stats;
+    if (!s_linked) {
+        int n = WiFi.scanComplete();
+        if (n < 0) WiFi.scanDelete();
+        else       countResults(n);
     }
+    WifiStats stats = s_acc;
+    stats.version = ++s_version;
+    stats.avgRSSI = stats.netCount > 0 ? s_rssiSum / stats.netCount : -100;
 
-    stats.netCount = n;
-    int totalRSSI = 0;
-
-    for (int i = 0; i < n; i++) {
-        int rssi = WiFi.RSSI(i);
-        totalRSSI += rssi;
-        if (rssi > -60) stats.strongCount++;
-        if (WiFi.SSID(i).length() == 0) stats.hiddenCount++;
-        if (WiFi.encryptionType(i) == WIFI_AUTH_OPEN) stats.openCount++;
-        else stats.wpaCount++;
-    }
+    const NetTable::Diff& diff = s_table.endScan();
+    stats.newCount     = diff.added;
+    stats.goneCount    = diff.gone;
+    stats.changedCount = diff.changed;
+    stats.knownCount   = s_table.size();
+    Metrics::inc(Metrics::WIFI_SCANS);
+    Metrics::set(Metrics::WIFI_NETWORKS, stats.netCount);
 
-    stats.avgRSSI = (n > 0) ? (totalRSSI / n) : -100;
-    WiFi.scanDelete();
+    Serial.printf("[radio] scan %s: %d nets (%d new, %d gone, %d changed) in %lu ms\n",
+                  s_linked ? "kept link, passive" : "link off, active", stats.netCount,
+                  stats.newCount, stats.goneCount, stats.changedCount,
+                  (unsigned long)(millis() - s_startMs));
     return stats;
 }
+
+void WifiRadio::printTable() {
+    const NetTable::Stats& st = s_table.stats();
+    const NetTable::Diff& diff = s_table.lastDiff();
+    Serial.printf("[radio] net table %lu / %lu (limit %lu): %lu scans, %lu inserts, "
+                  "%lu evicted, %lu dropped full\n",
+                  (unsigned long)s_table.size(), (unsigned long)s_table.capacity(),
+                  (unsigned long)s_table.limit(), (unsigned long)st.scans,
+                  (unsigned long)st.inserts, (unsigned long)st.evictions,
+                  (unsigned long)st.overflows);
+    Serial.printf("[radio] last scan: %u heard, %u new, %u gone, %u changed\n",
+                  diff.heard, diff.added, diff.gone, diff.changed);
+
+    // Strongest few still in range
+    static constexpr int TOP = 5;
+    const NetEntry* top[TOP] = {nullptr};
+    s_table.forEach([&](const NetEntry& e) {
+        if (e.flags & NetEntry::F_GONE) return;
+        for (int i = 0; i < TOP; i++) {
+            if (top[i] && top[i]->rssiQ8 >= e.rssiQ8) continue;
+            for (int j = TOP - 1; j > i; j--) top[j] = top[j - 1];
+            top[i] = &e;
+            return;
+        }
+    });
+    for (int i = 0; i < TOP && top[i]; i++) {
+        const NetEntry& e = *top[i];
+        Serial.printf("[radio]   %02x:%02x:%02x:%02x:%02x:%02x ch %2u %4d dBm, %u scans, "
+                      "first %lu s%s\n",
+                      e.bssid[0], e.bssid[1], e.bssid[2], e.bssid[3], e.bssid[4], e.bssid[5],
+                      e.channel, e.rssi(), e.scans, (unsigned long)e.firstSeen,
+                      e.ssidHash ? "" : ", hidden");
+    }
+}
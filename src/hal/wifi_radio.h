@@ -2,14 +2,20 @@
 #include "types.h"
 
 // ==========================================================================
-// WiFi Radio HAL -- Scan abstraction (no STA connection)
+// WiFi Radio HAL -- Scan abstraction
+// While the STA is associated (Cosmania link up), scans keep the link:
+// passive, a channel at a time, back on the home channel in between.
+// Otherwise one active scan of every channel with the STA off.
+// Every result also goes into a NetTable, whose new/gone/changed counts
+// for the scan come back in the WifiStats.
 // ==========================================================================
 
 namespace WifiRadio {
 
 void init();
 void startScan();
-bool isScanDone();          // True once results are ready
+bool isScanDone();          // True once results are ready; steps a linked scan
 WifiStats getResults();     // Consumes scan results
+void printTable();          // Table size, diff of the last scan, strongest known
 
 }  // namespace WifiRadio
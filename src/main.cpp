@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <time.h>
 #include "config.h"
 #include "types.h"
 #include "hal/display.h"
@@ -15,11 +16,19 @@
 #include "hal/wifi_promisc.h"
 #include "net/wifi_manager.h"
 #include "net/cosmania_client.h"
+#include "net/metrics_export.h"
+#include "net/telemetry.h"
 #include "state/pet_state.h"
 #include "state/nfc_actions.h"
 #include "state/location.h"
 #include "state/threat_detect.h"
 #include "ui/renderer.h"
+#include "sys/profiler.h"
+#include "sys/console.h"
+#include "sys/journal.h"
+#include "sys/history.h"
+#include "sys/boot.h"
+#include "sys/metrics.h"
 
 // ==========================================================================
 // TamaFi -- setup() + loop()
@@ -56,9 +65,15 @@ static int settingsIndex = 0;
 static int agentIndex    = 0;
 
 // -- Timers ----------------------------------------------------------------
+static unsigned long loopNowMs     = 0;     // millis() at top of loop()
 static unsigned long lastLogicTick = 0;
 static unsigned long lastSaveTime  = 0;
 
+// -- Offline catch-up ------------------------------------------------------
+static unsigned long bootTimeMs    = 0;
+static uint32_t      savedAtEpoch  = 0;     // wall clock of the last save, 0 = none
+static uint32_t      logicSeed     = 0;
+
 // -- Pet logic context -----------------------------------------------------
 static PetLogic::Context petCtx;
 
@@ -175,12 +190,15 @@ static void handleSettingsInput() {
                 else settings.autoSaveMs = 15000;
                 break;
             case 6:
-                PetLogic::resetPet(petCtx, false);
+                Journal::petReset(loopNowMs, false);
+                PetLogic::resetPet(petCtx, false, loopNowMs);
                 break;
             case 7:
-                PetLogic::resetPet(petCtx, true);
+                Journal::petReset(loopNowMs, true);
+                PetLogic::resetPet(petCtx, true, loopNowMs);
                 pet.stage   = STAGE_EGG;
                 pet.hatched = false;
+                Journal::petSnapshot(loopNowMs, pet);
                 Storage::save(pet, settings);
                 hatchTriggered = false;
                 switchScreen(SCREEN_HATCH);
@@ -195,10 +213,12 @@ static void handleSettingsInput() {
 static void handleGameoverInput() {
     if (Buttons::okPressed()) {
         Sound::click();
-        PetLogic::resetPet(petCtx, true);
+        Journal::petReset(loopNowMs, true);
+        PetLogic::resetPet(petCtx, true, loopNowMs);
         pet.stage   = STAGE_EGG;
         pet.hatched = false;
         pet.alive   = true;
+        Journal::petSnapshot(loopNowMs, pet);
         Storage::save(pet, settings);
         hatchTriggered = false;
         switchScreen(SCREEN_HATCH);
@@ -269,49 +289,101 @@ static void handleInput() {
     }
 }
 
+// Apply the time spent powered off once the wall clock is known (RTC
+// survives deep sleep; otherwise NTP sets it after WiFi connects)
+static void offlineCatchUp(unsigned long now) {
+    if (savedAtEpoch == 0) return;
+    time_t wall = time(nullptr);
+    if (wall <= static_cast<time_t>(EPOCH_VALID_MIN)) return;
+
+    uint32_t bootEpoch = static_cast<uint32_t>(wall) - (now - bootTimeMs) / 1000;
+    uint32_t offlineS  = bootEpoch > savedAtEpoch ? bootEpoch - savedAtEpoch : 0;
+    savedAtEpoch = 0;
+    if (offlineS == 0 || !pet.hatched || !pet.alive) return;
+
+    uint32_t elapsedMs = offlineS > CATCHUP_MAX_MS / 1000 ? CATCHUP_MAX_MS : offlineS * 1000;
+    Journal::catchUp(now, elapsedMs);
+    PetLogic::catchUp(petCtx, elapsedMs, now);
+    Serial.printf("[tamafi] caught up %lus offline\n", (unsigned long)offlineS);
+}
+
+// Build the draw context from the globals and push a frame
+static void render() {
+    Renderer::DrawContext ctx = {};
+    ctx.screen             = currentScreen;
+    ctx.menuIndex          = menuIndex;
+    ctx.settingsIndex      = settingsIndex;
+    ctx.pet                = &pet;
+    ctx.settings           = &settings;
+    ctx.wifi               = &wifiStats;
+    ctx.cosmania           = &cosmania;
+    ctx.activity           = currentActivity;
+    ctx.restPhase          = restPhase;
+    ctx.restFrameIndex     = restFrameIndex;
+    ctx.hungerEffectActive = hungerEffectActive;
+    ctx.hungerEffectFrame  = hungerEffectFrame;
+    ctx.hatchTriggered     = hatchTriggered;
+    ctx.agentIndex         = agentIndex;
+    ctx.location           = location;
+    ctx.radio              = &radioEnv;
+    ctx.threats            = ThreatDetect::threats();
+    ctx.threatCount        = ThreatDetect::threatCount();
+
+    { PROF_SCOPE(PROBE_RENDER); Renderer::draw(ctx); }
+}
+
 // ==========================================================================
-// setup + loop
+// Boot stages
+// Display + renderer come up in setup() so the boot screen is on the panel
+// before anything slow runs; the rest is staged through Boot. WifiRadio
+// runs before BLE because the WiFi and BT controllers share the PHY and
+// their bring-up must not overlap. PetLogic can start a WiFi scan, so the
+// radio is required; NFC/BLE/GPS/network/promisc/threat are deferred.
 // ==========================================================================
 
-void setup() {
-    Serial.begin(115200);
-    randomSeed(esp_random());
+enum BootStage : uint8_t {
+    BOOT_STORAGE,
+    BOOT_INPUT,
+    BOOT_OUTPUT,
+    BOOT_RADIO,
+    BOOT_STATE,
+    BOOT_NFC,
+    BOOT_BLE,
+    BOOT_GPS,
+    BOOT_NET,
+    BOOT_PROMISC,
+    BOOT_THREAT,
+};
 
-    Display::init();
+static constexpr uint32_t after(BootStage s) { return 1u << s; }
+
+static void bootStorage() {
+    Storage::init();
+    Storage::load(pet, settings);
+}
+
+static void bootInput() {
     Buttons::init();
+}
+
+static void bootOutput() {
     Sound::init();
     LEDs::init();
-    Storage::init();
-    WifiRadio::init();
-    NFC::init();
-    GPS::init();
     Haptics::init();
     Power::init();
-    BLE::init();
-    WifiPromisc::init();
-    ThreatDetect::init();
-    Renderer::init();
-
-    Storage::load(pet, settings);
-
-    // WiFi STA + Cosmania (if configured)
-    #if FEATURE_COSMANIA
-    WifiManager::init(settings.wifiSsid, settings.wifiPass);
-    CosmaniaClient::init(settings.cosmaniaUrl);
-    #endif
-
-    // Enable promiscuous mode for radio scanning
-    #if FEATURE_SOVEREIGNTY
-    WifiPromisc::enable();
-    WifiPromisc::setChannelHopping(true);
-    #endif
 
     // Apply loaded settings
     Display::setBrightness(settings.tftBrightness);
     LEDs::setBrightness(settings.ledBrightness);
     LEDs::setEnabled(settings.neoPixelsEnabled);
     Sound::setEnabled(settings.soundEnabled);
+}
+
+static void bootRadio() {
+    WifiRadio::init();
+}
 
+static void bootState() {
     // Build pet logic context
     petCtx.pet             = &pet;
     petCtx.wifi            = &wifiStats;
@@ -324,31 +396,129 @@ void setup() {
     petCtx.restStatsApplied = &restStatsApplied;
     petCtx.radio            = &radioEnv;
 
-    PetLogic::init(petCtx);
+    bootTimeMs = millis();
+    savedAtEpoch = Storage::savedAt();
+    PetLogic::seed(logicSeed);
+    PetLogic::init(petCtx, bootTimeMs);
+    Journal::init(logicSeed, pet, bootTimeMs);
+    History::init(bootTimeMs);
     Location::init(settings);
 
+    lastLogicTick = bootTimeMs;
+    lastSaveTime  = bootTimeMs;
+}
+
+static void bootNfc() {
+    NFC::init();                // blocks on the PN532 firmware query
+}
+
+static void bootBle() {
+    BLE::init();
+}
+
+static void bootGps() {
+    GPS::init();
+}
+
+static void bootNet() {
+    // WiFi STA + Cosmania (if configured)
+    #if FEATURE_COSMANIA
+    WifiManager::init(settings.wifiSsid, settings.wifiPass);
+    CosmaniaClient::init(settings.cosmaniaUrl, settings.pollIntervalMs);
+    Telemetry::init(settings.cosmaniaUrl);
+    #endif
+}
+
+static void bootPromisc() {
+    WifiPromisc::init();
+
+    // Enable promiscuous mode for radio scanning
+    #if FEATURE_SOVEREIGNTY
+    WifiPromisc::enable();
+    WifiPromisc::setChannelHopping(true);
+    #endif
+}
+
+static void bootThreat() {
+    ThreatDetect::init();
+}
+
+static const Boot::Stage BOOT_STAGES[] = {
+    { "storage", bootStorage, 0,                                 0 },
+    { "input",   bootInput,   0,                                 0 },
+    { "output",  bootOutput,  after(BOOT_STORAGE),               0 },
+    { "radio",   bootRadio,   0,                                 0 },
+    { "state",   bootState,   after(BOOT_STORAGE),               0 },
+    { "nfc",     bootNfc,     0,                                 Boot::STAGE_BACKGROUND | Boot::STAGE_DEFERRED },
+    { "ble",     bootBle,     after(BOOT_RADIO),                 Boot::STAGE_BACKGROUND | Boot::STAGE_DEFERRED },
+    { "gps",     bootGps,     0,                                 Boot::STAGE_DEFERRED },
+    { "net",     bootNet,     after(BOOT_STORAGE) | after(BOOT_RADIO), Boot::STAGE_DEFERRED },
+    { "promisc", bootPromisc, after(BOOT_NET),                   Boot::STAGE_DEFERRED },
+    { "threat",  bootThreat,  after(BOOT_BLE) | after(BOOT_PROMISC), Boot::STAGE_DEFERRED },
+};
+static constexpr int BOOT_STAGE_COUNT = sizeof(BOOT_STAGES) / sizeof(BOOT_STAGES[0]);
+static_assert(BOOT_STAGE_COUNT == BOOT_THREAT + 1, "BOOT_STAGES out of sync with BootStage");
+
+// ==========================================================================
+// setup + loop
+// ==========================================================================
+
+void setup() {
+    Serial.begin(115200);
+    randomSeed(esp_random());
+    logicSeed = esp_random();
+    Console::init();
+    Profiler::init();
+
+    // First frame before anything slow; everything else is a boot stage
+    Display::init();
+    Renderer::init();
     currentScreen = SCREEN_BOOT;
-    lastLogicTick = millis();
-    lastSaveTime  = millis();
+    render();
+    Boot::firstFrame();
 
+    Boot::start(BOOT_STAGES, BOOT_STAGE_COUNT);
     Serial.println("[tamafi] boot");
 }
 
 void loop() {
+    PROF_SCOPE(PROBE_LOOP);
     unsigned long now = millis();
+    loopNowMs = now;
+
+    #if FEATURE_METRICS
+    static uint32_t lastLoopUs = 0;
+    uint32_t loopUs = micros();
+    if (lastLoopUs) Metrics::observe(Metrics::LOOP_SECONDS, loopUs - lastLoopUs);
+    lastLoopUs = loopUs;
+    #endif
+
+    // Serial diagnostics
+    Console::tick();
+
+    // Staged init: one foreground stage per pass, boot screen in between
+    if (!Boot::complete()) {
+        Boot::step();
+        if (!Boot::interactive()) {
+            render();
+            return;
+        }
+    }
 
-    // HAL ticks (every loop iteration)
-    Buttons::tick();
-    Sound::tick();
-    LEDs::tick();
-    NFC::tick();
-    GPS::tick();
-    Haptics::tick();
-    Power::tick();
-    BLE::tick();
-    WifiPromisc::tick();
-    ThreatDetect::tick();
+    // HAL ticks (every loop iteration; deferred modules once their stage ran)
+    { PROF_SCOPE(PROBE_BUTTONS); Buttons::tick();      }
+    Journal::buttons(now, Buttons::pressedMask());
+    { PROF_SCOPE(PROBE_SOUND);   Sound::tick();        }
+    { PROF_SCOPE(PROBE_LEDS);    LEDs::tick();         }
+    if (Boot::ready(BOOT_NFC))     { PROF_SCOPE(PROBE_NFC);     NFC::tick();          }
+    if (Boot::ready(BOOT_GPS))     { PROF_SCOPE(PROBE_GPS);     GPS::tick();          }
+    { PROF_SCOPE(PROBE_HAPTICS); Haptics::tick();      }
+    { PROF_SCOPE(PROBE_POWER);   Power::tick();        }
+    if (Boot::ready(BOOT_BLE))     { PROF_SCOPE(PROBE_BLE);     BLE::tick();          }
+    if (Boot::ready(BOOT_PROMISC)) { PROF_SCOPE(PROBE_PROMISC); WifiPromisc::tick();  }
+    if (Boot::ready(BOOT_THREAT))  { PROF_SCOPE(PROBE_THREAT);  ThreatDetect::tick(); }
     radioEnv = ThreatDetect::environment();
+    Journal::radio(now, radioEnv);
 
     // Haptic alert on new threats
     int currentThreats = ThreatDetect::threatCount();
@@ -362,15 +532,28 @@ void loop() {
 
     // Network ticks
     #if FEATURE_COSMANIA
-    WifiManager::tick();
-    CosmaniaClient::tick();
-    cosmania = CosmaniaClient::getStatus();
+    if (Boot::ready(BOOT_NET)) {
+        { PROF_SCOPE(PROBE_WIFI_MGR); WifiManager::tick();    }
+        PollScheduler::Inputs pollCtx;
+        pollCtx.zone          = location;
+        pollCtx.tier          = cosmania.budgetTier;
+        pollCtx.screen        = currentScreen;
+        pollCtx.displayAsleep = Power::isDisplaySleeping();
+        pollCtx.batteryPct    = Power::batteryPercent();
+        { PROF_SCOPE(PROBE_COSMANIA); CosmaniaClient::tick(pollCtx); }
+        cosmania = CosmaniaClient::getStatus();
+        Journal::cosmania(now, cosmania);
+        { PROF_SCOPE(PROBE_METRICS); MetricsExport::tick(now, pet, radioEnv); }
+        { PROF_SCOPE(PROBE_TELEMETRY); Telemetry::tick(now, pet, radioEnv); }
+    }
     #endif
 
     // NFC tap handling
     NFC::TapType tap = NFC::consumeTap();
     if (tap != NFC::TAP_NONE && currentScreen != SCREEN_BOOT &&
         currentScreen != SCREEN_HATCH && currentScreen != SCREEN_GAMEOVER) {
+        PROF_SCOPE(PROBE_NFC_ACTIONS);
+        Journal::nfcTap(now, tap, NFC::lastUID(), NFC::lastUIDLen());
         NfcActions::Result nfcResult = NfcActions::process(
             tap, NFC::lastUID(), NFC::lastUIDLen(), settings);
 
@@ -383,7 +566,9 @@ void loop() {
     }
 
     // Input handling
-    handleInput();
+    { PROF_SCOPE(PROBE_INPUT); handleInput(); }
+
+    offlineCatchUp(now);
 
     // Logic tick (100ms, only when game is active)
     if (now - lastLogicTick >= LOGIC_TICK_MS) {
@@ -392,8 +577,9 @@ void loop() {
         if (currentScreen != SCREEN_BOOT &&
             currentScreen != SCREEN_HATCH &&
             currentScreen != SCREEN_GAMEOVER) {
-            PetLogic::tick(petCtx);
-            Location::tick(settings);
+            Journal::logicTick(now);
+            { PROF_SCOPE(PROBE_PET_LOGIC); PetLogic::tick(petCtx, now); }
+            { PROF_SCOPE(PROBE_LOCATION);  Location::tick(settings); }
             location = Location::current();
 
             // Death transition
@@ -406,36 +592,20 @@ void loop() {
     // Auto-save
     if (now - lastSaveTime >= settings.autoSaveMs) {
         lastSaveTime = now;
+        PROF_SCOPE(PROBE_SAVE);
         Storage::save(pet, settings);
+        Journal::checkpoint(now, pet);
     }
+    Journal::tick(now);
+    { PROF_SCOPE(PROBE_HISTORY); History::tick(now, pet, cosmania, radioEnv, wifiStats); }
 
-    // Build draw context
-    Renderer::DrawContext ctx = {};
-    ctx.screen             = currentScreen;
-    ctx.menuIndex          = menuIndex;
-    ctx.settingsIndex      = settingsIndex;
-    ctx.pet                = &pet;
-    ctx.settings           = &settings;
-    ctx.wifi               = &wifiStats;
-    ctx.cosmania           = &cosmania;
-    ctx.activity           = currentActivity;
-    ctx.restPhase          = restPhase;
-    ctx.restFrameIndex     = restFrameIndex;
-    ctx.hungerEffectActive = hungerEffectActive;
-    ctx.hungerEffectFrame  = hungerEffectFrame;
-    ctx.hatchTriggered     = hatchTriggered;
-    ctx.agentIndex         = agentIndex;
-    ctx.location           = location;
-    ctx.radio              = &radioEnv;
-    ctx.threats            = ThreatDetect::threats();
-    ctx.threatCount        = ThreatDetect::threatCount();
-
-    Renderer::draw(ctx);
+    render();
 
     // Hatch completion (checked after draw)
     if (currentScreen == SCREEN_HATCH && Renderer::wasHatchComplete()) {
         pet.hatched    = true;
         hatchTriggered = false;
+        Journal::petSnapshot(now, pet);
         Storage::save(pet, settings);
         switchScreen(SCREEN_HOME);
     }
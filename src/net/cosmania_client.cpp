@@ -1,114 +1,351 @@
 #include "cosmania_client.h"
+#include "cosmania_poll.h"
+#include "cosmania_push.h"
+#include "poll_scheduler.h"
+#include "wifi_manager.h"
 #include "config.h"
-#include <HTTPClient.h>
-#include <ArduinoJson.h>
-#include <WiFi.h>
+#include "../sys/journal_codec.h"
+#include "../sys/metrics.h"
+#include <Preferences.h>
+#include <cstring>
+#include <time.h>
 
 // ==========================================================================
 // Cosmania Client -- Polls /status endpoint, parses SystemStatus JSON
+// (or MessagePack, asked for with Accept when the server offers it)
+// The request runs on CosmaniaPoll, one non-blocking HttpFetch step per
+// tick(); body bytes stream straight into StatusParser, which fills the
+// back half of a double-buffered CosmaniaStatus. Nothing of the body is
+// kept, so a poll costs the parser's fixed state whatever the payload
+// size, and an unchanged status costs a 304 and no parse at all. When to
+// poll is PollScheduler's call, from the context main passes in. With
+// FEATURE_COSMANIA_PUSH, an SSE stream (CosmaniaPush) updates the same
+// status as events arrive and polling only runs while it is down. This
+// file is the device glue: WiFi gating, scheduling, stats, and the
+// warm-start cache: the last live status goes to NVS in the journal's
+// encoding, and comes back at init() as a stale snapshot so the screens
+// have agents to show long before the link is up and the first poll in.
 // ==========================================================================
 
-static CosmaniaStatus s_status;
-static char s_url[128] = {0};
-static unsigned long s_lastPoll = 0;
-static unsigned long s_pollInterval = COSMANIA_POLL_MS;
-
-// -- Budget tier string -> enum -------------------------------------------
-static BudgetTier parseTier(const char* str) {
-    if (!str) return TIER_UNKNOWN;
-    if (strcmp(str, "GREEN")  == 0) return TIER_GREEN;
-    if (strcmp(str, "YELLOW") == 0) return TIER_YELLOW;
-    if (strcmp(str, "RED")    == 0) return TIER_RED;
-    if (strcmp(str, "BLACK")  == 0) return TIER_BLACK;
-    return TIER_UNKNOWN;
+static CosmaniaPoll   s_poll;
+static PollScheduler  s_sched;
+#if FEATURE_COSMANIA_PUSH
+static CosmaniaPush   s_push(s_poll);
+#endif
+static bool     s_configured = false;
+static uint32_t s_initMs = 0;
+static uint32_t s_heapStart = 0;    // free heap when the request started
+static uint32_t s_heapMin   = 0;    // lowest free heap seen during it
+
+static CosmaniaClient::Stats s_stats;
+
+// -- Warm-start cache ------------------------------------------------------
+// [u32 magic][u32 savedAt][encodeCosmania body][u16 crc16 of what precedes]
+// plus "seenAt", the last time a poll or the push stream confirmed that
+// same content. A status that doesn't change for hours is still current:
+// its age runs from the later of the two stamps. Only the 4-byte stamp is
+// rewritten for that, never the blob
+static constexpr uint32_t CACHE_MAGIC = 0x43535431;     // "CST1"
+static const char* const  CACHE_KEY   = "status";
+static const char* const  SEEN_KEY    = "seenAt";
+static constexpr size_t   CACHE_HEAD  = 8;
+static constexpr size_t   CACHE_MAX   = 256;            // 7 full agents: ~240
+
+static Preferences s_prefs;
+static uint8_t  s_savedBody[CACHE_MAX];     // what NVS holds, minus the stamp
+static size_t   s_savedLen     = 0;
+static uint32_t s_savedMs      = 0;         // last NVS write attempt this boot, 0 = none
+static uint32_t s_savedVersion = 0;         // last status version NVS matches
+static uint32_t s_stampAt      = 0;         // newest confirmation NVS holds (epoch s)
+static uint32_t s_confirmedMs  = 0;         // last successful poll / live push, 0 = none
+
+// Seconds since savedAt by the wall clock, -1 if either is unknown
+static int32_t cacheAge(uint32_t savedAt) {
+    time_t now = time(nullptr);
+    if (savedAt == 0 || now <= static_cast<time_t>(EPOCH_VALID_MIN) ||
+        static_cast<uint32_t>(now) < savedAt) {
+        return -1;
+    }
+    return static_cast<int32_t>(static_cast<uint32_t>(now) - savedAt);
+}
+
+// Young enough for mood / evolution / decay to act on
+static bool cacheUsable(uint32_t savedAt) {
+    int32_t age = cacheAge(savedAt);
+    return age >= 0 && age <= static_cast<int32_t>(COSMANIA_STALE_MAX_S);
 }
 
-// -- Parse JSON response --------------------------------------------------
-static bool parseResponse(const String& body) {
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, body);
-    if (err) return false;
-
-    s_status.connected     = true;
-    s_status.lastPollMs    = millis();
-    s_status.budgetTier    = parseTier(doc["budgetTier"] | "UNKNOWN");
-    s_status.totalDailyBudget = doc["totalDailyBudget"] | 0.0f;
-    s_status.totalDailySpend  = doc["totalDailySpend"]  | 0.0f;
-
-    // Parse agents array
-    JsonArray agents = doc["agents"].as<JsonArray>();
-    s_status.agentCount   = 0;
-    s_status.overdueCount = 0;
-    s_status.activeCount  = 0;
-    s_status.errorCount   = 0;
-
-    for (JsonObject agent : agents) {
-        if (s_status.agentCount >= 7) break;
-        AgentInfo& info = s_status.agents[s_status.agentCount];
-
-        const char* name = agent["name"] | "";
-        strncpy(info.name, name, sizeof(info.name) - 1);
-        info.name[sizeof(info.name) - 1] = '\0';
-
-        info.overdue     = agent["overdue"]      | false;
-        info.overBudget  = agent["overBudget"]    | false;
-        info.todayCostUsd = agent["todayCostUsd"] | 0.0f;
-        info.todayRuns   = agent["todayRuns"]     | 0;
-        info.minutesSince = agent["minutesSinceLastRun"] | -1;
-
-        if (info.overdue) s_status.overdueCount++;
-        if (info.todayRuns > 0) s_status.activeCount++;
-
-        s_status.agentCount++;
+static void loadCache() {
+    uint8_t blob[CACHE_MAX];
+    size_t n = s_prefs.getBytesLength(CACHE_KEY);
+    if (n < CACHE_HEAD + 2 || n > sizeof(blob) || s_prefs.getBytes(CACHE_KEY, blob, n) != n) return;
+
+    uint32_t magic, savedAt;
+    uint16_t crc;
+    memcpy(&magic, blob, 4);
+    memcpy(&savedAt, blob + 4, 4);
+    memcpy(&crc, blob + n - 2, 2);
+    CosmaniaStatus snap;
+    size_t bodyLen = n - CACHE_HEAD - 2;
+    if (magic != CACHE_MAGIC || JournalCodec::crc16(blob, n - 2) != crc ||
+        !JournalCodec::decodeCosmania(blob + CACHE_HEAD, bodyLen, snap)) {
+        Serial.println("[cosmania] status cache corrupt, ignored");
+        return;
     }
+    uint32_t seenAt = s_prefs.getULong(SEEN_KEY, 0);
+    if (seenAt > savedAt) savedAt = seenAt;     // confirmed unchanged since it was written
+    snap.savedAt = savedAt;
+    if (!s_poll.restore(snap, cacheUsable(savedAt))) return;
 
-    // Count recent errors
-    JsonArray errors = doc["recentErrors"].as<JsonArray>();
-    s_status.errorCount = 0;
-    for (JsonVariant v : errors) {
-        s_status.errorCount++;
-        (void)v;
+    memcpy(s_savedBody, blob + CACHE_HEAD, bodyLen);   // unchanged content isn't rewritten
+    s_savedLen       = bodyLen;
+    s_stampAt        = savedAt;
+    s_stats.warmMs   = millis();
+    s_stats.warmAgeS = cacheAge(savedAt);
+    if (s_stats.warmAgeS < 0) {
+        Serial.printf("[cosmania] warm start: %u agents, age unknown (not acted on)\n",
+                      (unsigned)snap.agentCount);
+    } else {
+        Serial.printf("[cosmania] warm start: %u agents, %ld s old%s\n",
+                      (unsigned)snap.agentCount, (long)s_stats.warmAgeS,
+                      cacheUsable(savedAt) ? "" : " (too old to act on)");
     }
+}
 
-    return true;
+// Live status: write it back when it changed, otherwise stamp the stored
+// copy as confirmed; one NVS write per COSMANIA_CACHE_SAVE_S at most, and
+// only once the clock can stamp it (an unstamped snapshot has no age)
+static void saveCache(uint32_t now) {
+    const CosmaniaStatus& st = s_poll.status();
+    if (!st.connected || st.stale || !s_confirmedMs) return;
+    if (s_savedMs && now - s_savedMs < COSMANIA_CACHE_SAVE_S * 1000UL) return;
+    time_t wall = time(nullptr);
+    if (wall <= static_cast<time_t>(EPOCH_VALID_MIN)) return;
+    uint32_t seenAt = static_cast<uint32_t>(wall) - (now - s_confirmedMs) / 1000;
+
+    // A version is only marked handled once NVS holds its content: until
+    // then the stored blob is not what's live, and mustn't be stamped
+    if (st.version != s_savedVersion) {
+        uint8_t blob[CACHE_MAX];
+        JournalCodec::Buf body(blob + CACHE_HEAD, sizeof(blob) - CACHE_HEAD - 2);
+        JournalCodec::encodeCosmania(body, st);
+        if (!body.ok) return;
+        if (body.len != s_savedLen || memcmp(body.data, s_savedBody, body.len) != 0) {
+            memcpy(blob, &CACHE_MAGIC, 4);
+            memcpy(blob + 4, &seenAt, 4);
+            size_t n = CACHE_HEAD + body.len;
+            uint16_t crc = JournalCodec::crc16(blob, n);
+            memcpy(blob + n, &crc, 2);
+            n += 2;
+            s_savedMs = now;                    // a failed write retries on the next slot
+            if (s_prefs.putBytes(CACHE_KEY, blob, n) != n) return;
+            memcpy(s_savedBody, body.data, body.len);
+            s_savedLen     = body.len;
+            s_savedVersion = st.version;
+            s_stampAt      = seenAt;
+            s_stats.cacheWrites++;
+            return;
+        }
+        s_savedVersion = st.version;
+    }
+
+    // Same content as stored: only its confirmation time moves on
+    if (s_savedLen == 0 || seenAt <= s_stampAt) return;
+    if (s_prefs.putULong(SEEN_KEY, seenAt) != sizeof(uint32_t)) return;
+    s_stampAt = seenAt;
+    s_savedMs = now;
+    s_stats.cacheStamps++;
 }
 
-void CosmaniaClient::init(const char* baseUrl) {
-    if (!baseUrl || baseUrl[0] == '\0') return;
-    snprintf(s_url, sizeof(s_url), "%s/status", baseUrl);
+// Runs once per finished request
+static void complete(CosmaniaPoll::Result result, const PollScheduler::Inputs& in) {
+    uint32_t ms = s_poll.lastMs();
+    s_stats.lastMs = ms;
+    s_stats.busyMs += ms;
+    if (ms > s_stats.maxMs) s_stats.maxMs = ms;
+    if (s_poll.lastReused()) { s_stats.reusedMs += ms; s_stats.reused++; }
+    else                     { s_stats.freshMs  += ms; s_stats.fresh++;  }
+    s_stats.heapLast = s_heapStart > s_heapMin ? s_heapStart - s_heapMin : 0;
+    if (s_stats.heapLast > s_stats.heapPeak) s_stats.heapPeak = s_stats.heapLast;
+    s_stats.bodyBytes += s_poll.lastBytes();
+    Metrics::observe(Metrics::COSMANIA_POLL_SECONDS, ms);
+    if (result == CosmaniaPoll::UPDATED || result == CosmaniaPoll::NOT_MODIFIED) {
+        s_confirmedMs = millis();
+        s_sched.succeeded(s_poll.lastChanged());
+    } else {
+        s_sched.failed(in);
+        s_stats.backoffs++;
+    }
+    switch (result) {
+        case CosmaniaPoll::UPDATED:
+            s_stats.ok++;
+            if (s_poll.lastDelta()) s_stats.deltas++;
+            if (s_poll.lastPacked()) s_stats.packed++;
+            break;
+        case CosmaniaPoll::NOT_MODIFIED:
+            s_stats.notModified++;
+            break;
+        case CosmaniaPoll::PARSE_ERROR:
+            s_stats.parseErrors++;
+            Metrics::inc(Metrics::COSMANIA_ERRORS_PARSE);
+            break;
+        case CosmaniaPoll::HTTP_ERROR:
+            s_stats.httpErrors++;
+            Metrics::inc(Metrics::COSMANIA_ERRORS_HTTP);
+            s_stats.lastStatus = s_poll.lastStatus();
+            break;
+        case CosmaniaPoll::NET_ERROR:
+            s_stats.netErrors++;
+            Metrics::inc(Metrics::COSMANIA_ERRORS_NET);
+            s_stats.lastError = s_poll.lastError();
+            if (s_poll.lastError() == HttpFetch::ERR_TIMEOUT) s_stats.timeouts++;
+            break;
+        case CosmaniaPoll::BUSY:
+            break;
+    }
 }
 
-void CosmaniaClient::tick() {
-    if (s_url[0] == '\0') return;
-    if (WiFi.status() != WL_CONNECTED) return;
+void CosmaniaClient::init(const char* baseUrl, uint32_t pollMs) {
+    s_sched.setBase(pollMs ? pollMs : COSMANIA_POLL_MS);
+    s_sched.seed(esp_random());
+    s_initMs = millis();
+    if (!baseUrl || baseUrl[0] == '\0') return;
+    char url[128];
+    snprintf(url, sizeof(url), "%s/status", baseUrl);
+    s_configured = s_poll.setUrl(url);
+    s_poll.setKeepAlive(true);
+    s_poll.setMsgpack(true);        // JSON still parsed if that's what comes back
+    if (!s_configured) {
+        Serial.printf("[cosmania] unusable url: %s\n", url);
+        return;
+    }
+    s_prefs.begin("cosmania", false);
+    loadCache();
+    #if FEATURE_COSMANIA_PUSH
+    snprintf(url, sizeof(url), "%s/events", baseUrl);
+    s_push.setUrl(url);
+    s_push.seed(esp_random());
+    #endif
+}
 
+void CosmaniaClient::tick(const PollScheduler::Inputs& in) {
+    if (!s_configured) return;
+    uint32_t t0 = micros();
     unsigned long now = millis();
-    if (now - s_lastPoll < s_pollInterval) return;
-    s_lastPoll = now;
 
-    HTTPClient http;
-    http.setTimeout(5000);
-    http.begin(s_url);
+    // A stale snapshot ages out of use (or, once the clock is set and
+    // shows it young enough, into it); live data goes back to the cache
+    const CosmaniaStatus& st = s_poll.status();
+    if (st.stale) s_poll.trustStale(cacheUsable(st.savedAt));
+    else if (st.connected && s_stats.liveMs == 0) s_stats.liveMs = now;
+    saveCache(now);
 
-    int code = http.GET();
-    if (code == 200) {
-        String body = http.getString();
-        parseResponse(body);
-    } else {
-        s_status.connected = false;
+    if (!WifiManager::isConnected()) {
+        s_poll.abort();             // request and kept connection died with the link
+        #if FEATURE_COSMANIA_PUSH
+        s_push.stop();
+        #endif
+        return;
+    }
+
+    #if FEATURE_COSMANIA_PUSH
+    // While the stream is live it is the source; when it drops, a poll
+    // catches up at once and polling carries on until it is back
+    s_push.connect(now);
+    if (s_push.poll(now) == CosmaniaPush::DROPPED) s_sched.pollNow();
+    if (s_push.live()) {
+        s_confirmedMs = now;
+        uint32_t us = micros() - t0;
+        if (us > s_stats.maxTickUs) s_stats.maxTickUs = us;
+        return;
     }
+    #endif
 
-    http.end();
+    if (!s_poll.busy()) {
+        s_poll.idle(now);
+        if (!s_sched.due(now, in)) return;
+        s_sched.started(now);
+        s_heapStart = s_heapMin = ESP.getFreeHeap();
+        s_poll.start(now);
+        s_stats.polls++;
+        Metrics::inc(Metrics::COSMANIA_POLLS);
+        s_stats.intervalMs = s_sched.interval(in);
+    }
+
+    CosmaniaPoll::Result result = s_poll.poll(now);
+    uint32_t heap = ESP.getFreeHeap();
+    if (heap < s_heapMin) s_heapMin = heap;
+    if (result != CosmaniaPoll::BUSY) complete(result, in);
+
+    uint32_t us = micros() - t0;
+    if (us > s_stats.maxTickUs) s_stats.maxTickUs = us;
 }
 
 void CosmaniaClient::pollNow() {
-    s_lastPoll = 0;     // Force next tick to poll
+    s_sched.pollNow();      // Next tick polls, backoff or not
 }
 
 bool CosmaniaClient::isConnected() {
-    return s_status.connected;
+    return s_poll.status().connected;
 }
 
 const CosmaniaStatus& CosmaniaClient::getStatus() {
-    return s_status;
+    return s_poll.status();
+}
+
+const CosmaniaClient::Stats& CosmaniaClient::stats() {
+    return s_stats;
+}
+
+void CosmaniaClient::printStats() {
+    Serial.printf("[cosmania] %lu polls: %lu ok (%lu delta, %lu msgpack), %lu not modified, "
+                  "%lu body bytes\n",
+                  (unsigned long)s_stats.polls, (unsigned long)s_stats.ok,
+                  (unsigned long)s_stats.deltas, (unsigned long)s_stats.packed,
+                  (unsigned long)s_stats.notModified, (unsigned long)s_stats.bodyBytes);
+    Serial.printf("[cosmania] errors: %lu http, %lu net (%lu timeout), %lu parse\n",
+                  (unsigned long)s_stats.httpErrors, (unsigned long)s_stats.netErrors,
+                  (unsigned long)s_stats.timeouts, (unsigned long)s_stats.parseErrors);
+    Serial.printf("[cosmania] last request %lu ms, last status %d, last error %s, worst tick %lu us\n",
+                  (unsigned long)s_stats.lastMs, s_stats.lastStatus,
+                  HttpFetch::errorName(static_cast<HttpFetch::Error>(s_stats.lastError)),
+                  (unsigned long)s_stats.maxTickUs);
+    uint32_t upMs = millis() - s_initMs;
+    Serial.printf("[cosmania] interval %lu ms, change rate %.2f, %u failures (backoff %lu ms), "
+                  "radio busy %.2f%% of %lu s\n",
+                  (unsigned long)s_stats.intervalMs, s_sched.changeRate(), s_sched.failures(),
+                  (unsigned long)s_sched.backoffMs(),
+                  upMs ? 100.0f * s_stats.busyMs / upMs : 0.0f, (unsigned long)(upMs / 1000));
+    const HttpFetch& fetch = s_poll.fetch();
+    Serial.printf("[cosmania] latency: fresh %lu ms avg (%lu), kept-alive %lu ms avg (%lu), max %lu ms\n",
+                  (unsigned long)(s_stats.fresh ? s_stats.freshMs / s_stats.fresh : 0),
+                  (unsigned long)s_stats.fresh,
+                  (unsigned long)(s_stats.reused ? s_stats.reusedMs / s_stats.reused : 0),
+                  (unsigned long)s_stats.reused, (unsigned long)s_stats.maxMs);
+    Serial.printf("[cosmania] %lu connects, %lu reuses, %lu stale retries, %lu dns, %s; "
+                  "heap per request %lu B (peak %lu B)\n",
+                  (unsigned long)fetch.connects(), (unsigned long)fetch.reuses(),
+                  (unsigned long)fetch.retries(), (unsigned long)fetch.lookups(),
+                  fetch.connected() ? "connection open" : "no connection",
+                  (unsigned long)s_stats.heapLast, (unsigned long)s_stats.heapPeak);
+    #if FEATURE_COSMANIA_PUSH
+    const CosmaniaPush::Stats& push = s_push.stats();
+    Serial.printf("[cosmania] push %s: %lu events (%lu bad), %lu heartbeats, %lu B, "
+                  "%lu connects, %lu drops, retry in %lu ms\n",
+                  s_push.live() ? "live" : "down", (unsigned long)push.events,
+                  (unsigned long)push.badEvents, (unsigned long)push.heartbeats,
+                  (unsigned long)push.bytes, (unsigned long)push.connects,
+                  (unsigned long)push.drops, (unsigned long)s_push.retryInMs(millis()));
+    #endif
+    const CosmaniaStatus& st = s_poll.status();
+    char age[16] = "age unknown";
+    if (s_stats.warmAgeS >= 0) snprintf(age, sizeof(age), "%ld s old", (long)s_stats.warmAgeS);
+    Serial.printf("[cosmania] dashboard: cached status at %lu ms (%s), live at %lu ms, "
+                  "%s now, %lu cache writes, %lu confirmed\n",
+                  (unsigned long)s_stats.warmMs, s_stats.warmMs ? age : "none",
+                  (unsigned long)s_stats.liveMs,
+                  st.stale ? (st.connected ? "stale" : "stale, not acted on") : "live",
+                  (unsigned long)s_stats.cacheWrites, (unsigned long)s_stats.cacheStamps);
+    Serial.printf("[cosmania] etag %s, cursor %s\n",
+                  s_poll.etag()[0] ? s_poll.etag() : "-", s_poll.cursor()[0] ? s_poll.cursor() : "-");
 }
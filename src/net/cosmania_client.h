@@ -1,14 +1,52 @@
 #pragma once
 #include "types.h"
+#include "poll_scheduler.h"
 
 // ==========================================================================
-// Cosmania Client -- HTTP poll /status endpoint, parse JSON
+// Cosmania Client -- HTTP poll /status endpoint, parse JSON or MessagePack
 // ==========================================================================
 
 namespace CosmaniaClient {
 
-void init(const char* baseUrl);
-void tick();    // Non-blocking: polls at configured interval
+struct Stats {
+    uint32_t polls       = 0;
+    uint32_t ok          = 0;   // 200s parsed and published
+    uint32_t deltas      = 0;   // of which delta bodies
+    uint32_t packed      = 0;   // ... and MessagePack bodies
+    uint32_t notModified = 0;   // 304s: no parse, nothing published
+    uint32_t httpErrors  = 0;   // non-200 responses
+    uint32_t netErrors   = 0;   // dns / connect / timeout / closed
+    uint32_t timeouts    = 0;
+    uint32_t parseErrors = 0;
+    uint32_t backoffs    = 0;   // failures that pushed the next poll out
+    uint32_t bodyBytes   = 0;   // total body bytes received
+    uint32_t busyMs      = 0;   // total request time: the radio's share
+    uint32_t intervalMs  = 0;   // interval when the last poll started
+    uint32_t lastMs      = 0;   // duration of the last request
+    uint32_t maxMs       = 0;
+    uint32_t freshMs     = 0;   // total time of requests on a new connection
+    uint32_t fresh       = 0;
+    uint32_t reusedMs    = 0;   // ... and on a kept-alive one
+    uint32_t reused      = 0;
+    uint32_t heapPeak    = 0;   // most heap a request has taken (bytes)
+    uint32_t heapLast    = 0;   // ... and the last one
+    uint32_t maxTickUs   = 0;   // longest tick(): what the loop pays
+    int      lastStatus  = 0;
+    uint8_t  lastError   = 0;   // HttpFetch::Error
+    // Time to a useful dashboard: millis() since reset
+    uint32_t warmMs      = 0;   // cached snapshot published (0 = none)
+    int32_t  warmAgeS    = -1;  // ... its age then, -1 = unknown
+    uint32_t liveMs      = 0;   // first live status (poll or push)
+    uint32_t cacheWrites = 0;   // snapshots written to NVS
+    uint32_t cacheStamps = 0;   // ... confirmed unchanged (stamp-only writes)
+};
+
+// pollMs: base (HOME) interval, 0 = COSMANIA_POLL_MS. Publishes the
+// cached status, if any, as stale until the first poll lands
+void init(const char* baseUrl, uint32_t pollMs);
+// Non-blocking: one HttpFetch step per call, polls when PollScheduler
+// says so for this context
+void tick(const PollScheduler::Inputs& in);
 
 bool isConnected();
 const CosmaniaStatus& getStatus();
@@ -16,4 +54,7 @@ const CosmaniaStatus& getStatus();
 // Force immediate poll (e.g., after location change)
 void pollNow();
 
+const Stats& stats();
+void printStats();
+
 }  // namespace CosmaniaClient
@@ -0,0 +1,213 @@
+#include "cosmania_poll.h"
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+// ==========================================================================
+// Cosmania Poll -- conditional / delta requests over HttpFetch
+// start() builds the request from what the front status was parsed from;
+// poll() steps the fetch and, once it finishes, decides what is published.
+// The response's ETag is held aside until its body has parsed, so a body
+// that fails never leaves behind a validator for data we don't have.
+// ==========================================================================
+
+static bool isUnreserved(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+// "since=<percent-encoded cursor>"; false if it doesn't fit
+static bool sinceQuery(const char* cursor, char* out, size_t size) {
+    static const char HEX[] = "0123456789ABCDEF";
+    size_t n = snprintf(out, size, "since=");
+    for (const char* p = cursor; *p; p++) {
+        if (n + 4 > size) return false;
+        if (isUnreserved(*p)) {
+            out[n++] = *p;
+        } else {
+            out[n++] = '%';
+            out[n++] = HEX[static_cast<uint8_t>(*p) >> 4];
+            out[n++] = HEX[static_cast<uint8_t>(*p) & 0x0F];
+        }
+    }
+    out[n] = '\0';
+    return true;
+}
+
+// What a poll fills, compared field by field (AgentInfo has padding)
+static bool sameContent(const CosmaniaStatus& a, const CosmaniaStatus& b) {
+    if (a.budgetTier != b.budgetTier || a.totalDailyBudget != b.totalDailyBudget ||
+        a.totalDailySpend != b.totalDailySpend || a.agentCount != b.agentCount ||
+        a.errorCount != b.errorCount) {
+        return false;
+    }
+    for (int i = 0; i < a.agentCount; i++) {
+        const AgentInfo& x = a.agents[i];
+        const AgentInfo& y = b.agents[i];
+        if (strcmp(x.name, y.name) != 0 || x.overdue != y.overdue ||
+            x.overBudget != y.overBudget || x.todayCostUsd != y.todayCostUsd ||
+            x.todayRuns != y.todayRuns || x.minutesSince != y.minutesSince) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -- Double buffer ---------------------------------------------------------
+// Back half starts as a copy of the front: fields a poll doesn't touch
+// carry over, and a delta has the state it applies to
+CosmaniaStatus& CosmaniaPoll::backBuffer() {
+    CosmaniaStatus& back = m_status[m_front ^ 1];
+    back = m_status[m_front];
+    return back;
+}
+
+void CosmaniaPoll::publish() {
+    m_status[m_front ^ 1].version = m_status[m_front].version + 1;
+    m_front ^= 1;
+}
+
+void CosmaniaPoll::disconnect() {
+    if (!m_status[m_front].connected || m_status[m_front].stale) return;
+    backBuffer().connected = false;
+    publish();
+}
+
+bool CosmaniaPoll::restore(const CosmaniaStatus& snapshot, bool connected) {
+    if (busy() || m_status[m_front].version != 0) return false;
+    CosmaniaStatus& back = m_status[m_front ^ 1];
+    back = snapshot;
+    back.connected  = connected;
+    back.stale      = true;
+    back.lastPollMs = 0;
+    publish();
+    return true;
+}
+
+void CosmaniaPoll::trustStale(bool connected) {
+    const CosmaniaStatus& front = m_status[m_front];
+    if (busy() || !front.stale || front.connected == connected) return;
+    backBuffer().connected = connected;
+    publish();
+}
+
+// A poll or push landed: the front is live data from here on
+static void markFresh(CosmaniaStatus& s, uint32_t now) {
+    s.connected  = true;
+    s.stale      = false;
+    s.savedAt    = 0;
+    s.lastPollMs = now;
+}
+
+void CosmaniaPoll::forget() {
+    m_etag[0]   = '\0';
+    m_cursor[0] = '\0';
+}
+
+void CosmaniaPoll::commit(uint32_t now, const char* cursor) {
+    markFresh(m_status[m_front ^ 1], now);
+    publish();
+    m_etag[0] = '\0';
+    snprintf(m_cursor, sizeof(m_cursor), "%s", cursor);
+}
+
+// -- Sinks -----------------------------------------------------------------
+
+bool CosmaniaPoll::onBody(void* ctx, const uint8_t* data, size_t len) {
+    return static_cast<CosmaniaPoll*>(ctx)->m_parser.feed(data, len);
+}
+
+void CosmaniaPoll::onHeader(void* ctx, const char* name, const char* value) {
+    CosmaniaPoll* self = static_cast<CosmaniaPoll*>(ctx);
+    if (strcasecmp(name, "Content-Type") == 0) {
+        // Headers are done before the first body byte reaches the parser
+        bool packed = strncasecmp(value, "application/msgpack", 19) == 0 ||
+                      strncasecmp(value, "application/x-msgpack", 21) == 0;
+        self->m_parser.setFormat(packed ? StatusParser::MSGPACK : StatusParser::JSON);
+        return;
+    }
+    if (strcasecmp(name, "ETag") != 0) return;
+    size_t len = strlen(value);
+    while (len > 0 && (value[len - 1] == ' ' || value[len - 1] == '\t')) len--;
+    if (len == 0 || len >= ETAG_LEN) return;
+    memcpy(self->m_pendingEtag, value, len);
+    self->m_pendingEtag[len] = '\0';
+}
+
+// -- Request ---------------------------------------------------------------
+
+bool CosmaniaPoll::start(uint32_t now) {
+    if (busy()) return true;
+
+    char query[HttpFetch::QUERY_LEN];
+    if (!m_cursor[0] || !sinceQuery(m_cursor, query, sizeof(query))) query[0] = '\0';
+    m_fetch.setQuery(query);
+
+    char headers[HttpFetch::HEADERS_LEN] = "";
+    int n = 0;
+    m_conditional = m_etag[0] != '\0';
+    if (m_conditional) n = snprintf(headers, sizeof(headers), "If-None-Match: %s\r\n", m_etag);
+    if (m_msgpack) {
+        snprintf(headers + n, sizeof(headers) - n,
+                 "Accept: application/msgpack, application/json;q=0.5\r\n");
+    }
+    m_fetch.setHeaders(headers);
+    m_fetch.setHeaderSink(onHeader);
+
+    m_pendingEtag[0] = '\0';
+    m_parser.begin(backBuffer());
+    return m_fetch.start(now, onBody, this);
+}
+
+CosmaniaPoll::Result CosmaniaPoll::poll(uint32_t now) {
+    HttpFetch::State state = m_fetch.poll(now);
+    if (state != HttpFetch::DONE && state != HttpFetch::FAILED) return BUSY;
+    Result result = complete(state, now);
+    m_fetch.abort();                // back to IDLE until the next start()
+    return result;
+}
+
+// Runs once per finished request (DONE or FAILED)
+CosmaniaPoll::Result CosmaniaPoll::complete(HttpFetch::State state, uint32_t now) {
+    m_lastMs     = m_fetch.elapsedMs(now);
+    m_lastBytes  = m_fetch.bodyBytes();
+    m_lastStatus = m_fetch.status();
+    m_lastError  = m_fetch.error();
+    m_lastReused = m_fetch.reused();
+    m_lastPacked = m_parser.format() == StatusParser::MSGPACK;
+    m_lastDelta  = false;
+    m_lastChanged = false;
+
+    Result result;
+    if (state == HttpFetch::DONE && m_lastStatus == 304 && m_conditional) {
+        // Front is still current; only a reconnect is news
+        if (!m_status[m_front].connected || m_status[m_front].stale) {
+            markFresh(backBuffer(), now);
+            publish();
+        }
+        return NOT_MODIFIED;
+    } else if (state == HttpFetch::DONE && m_lastStatus == 200) {
+        if (m_parser.finish()) {
+            CosmaniaStatus& back = m_status[m_front ^ 1];
+            markFresh(back, now);
+            m_lastChanged = !sameContent(back, m_status[m_front]);
+            publish();
+            memcpy(m_etag, m_pendingEtag, sizeof(m_etag));
+            memcpy(m_cursor, m_parser.cursor(), sizeof(m_cursor));
+            m_lastDelta = m_parser.delta();
+            return UPDATED;
+        }
+        result = PARSE_ERROR;
+    } else if (state == HttpFetch::FAILED && m_lastError == HttpFetch::ERR_SINK) {
+        result = PARSE_ERROR;       // parser rejected the body mid-stream
+    } else if (state == HttpFetch::DONE) {
+        result = HTTP_ERROR;
+    } else {
+        result = NET_ERROR;
+    }
+
+    // The server may have lost our cursor or changed format: resync fully
+    if (result != NET_ERROR) forget();
+    disconnect();
+    return result;
+}
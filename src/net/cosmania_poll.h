@@ -0,0 +1,125 @@
+#pragma once
+#include "http_fetch.h"
+#include "status_parser.h"
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Cosmania Poll -- One /status request at a time, published atomically
+// Platform-neutral (tools/net_bench/ runs it against a stub server). Owns
+// the HttpFetch, the StatusParser and a double-buffered CosmaniaStatus:
+// the body streams into the back half, which becomes the front only once
+// the parse is complete, so status() never shows a half-written poll.
+//
+// Polls are conditional: the last ETag goes back as If-None-Match, and a
+// 304 is answered without touching the parser or the status. If the last
+// body carried a cursor, it goes back as ?since= and the server may answer
+// with only the agents that changed. Any HTTP or parse error forgets both,
+// so the next poll fetches a full status.
+//
+// With setMsgpack(), the request prefers application/msgpack; the body is
+// parsed in whichever format the response's Content-Type names.
+//
+// restore() seeds the front with a cached snapshot marked stale, so the
+// screens have something to show before the link is up; anything a poll
+// or push publishes clears stale.
+// ==========================================================================
+
+class CosmaniaPoll {
+public:
+    static constexpr size_t ETAG_LEN = 48;      // longer ETags are not used
+
+    enum Result : uint8_t {
+        BUSY,               // request in flight
+        UPDATED,            // 200, parsed and published
+        NOT_MODIFIED,       // 304 to our If-None-Match
+        HTTP_ERROR,         // any other status
+        NET_ERROR,          // see lastError()
+        PARSE_ERROR,        // body was not a usable status
+    };
+
+    // Full URL of the /status endpoint
+    bool setUrl(const char* url) { return m_fetch.setUrl(url); }
+    void setTimeout(uint32_t ms) { m_fetch.setTimeout(ms); }
+    void setKeepAlive(bool on) { m_fetch.setKeepAlive(on); }
+    void setMsgpack(bool on) { m_msgpack = on; }
+
+    // Starts a request unless one is in flight; false if no URL is set
+    bool   start(uint32_t now);
+    Result poll(uint32_t now);
+    bool   busy() const { return m_fetch.busy(); }
+
+    // Drops the request in flight and any kept-alive connection
+    void   abort() { m_fetch.disconnect(); }
+
+    // Call between polls: closes a kept-alive connection left idle too long
+    void   idle(uint32_t now) { m_fetch.closeIdle(now); }
+
+    // Publishes connected = false (no-op if already disconnected, or if
+    // the front is a stale snapshot: a failed poll doesn't age it)
+    void disconnect();
+
+    // Warm start: publishes a cached snapshot with stale set, before any
+    // poll has. connected says whether the state layer may act on it; a
+    // poll that lands replaces it and clears stale. False once a poll or
+    // push has published, or while a request is in flight
+    bool restore(const CosmaniaStatus& snapshot, bool connected);
+    // Re-publishes a stale front with connected changed; no-op otherwise
+    void trustStale(bool connected);
+
+    // Drops the ETag and cursor: the next poll is a full fetch
+    void forget();
+
+    // Updates from elsewhere (CosmaniaPush), only while no request is in
+    // flight: edit() hands out the back half as a copy of the front,
+    // commit() publishes it along with the cursor it brings us up to.
+    // The ETag no longer matches and is dropped
+    CosmaniaStatus& edit() { return backBuffer(); }
+    void commit(uint32_t now, const char* cursor);
+
+    const CosmaniaStatus& status() const { return m_status[m_front]; }
+
+    // Last finished request
+    bool     lastDelta() const   { return m_lastDelta; }
+    bool     lastChanged() const { return m_lastChanged; }  // published different content
+    int      lastStatus() const  { return m_lastStatus; }
+    HttpFetch::Error lastError() const { return m_lastError; }
+    uint32_t lastMs() const      { return m_lastMs; }
+    uint32_t lastBytes() const   { return m_lastBytes; }
+    bool     lastReused() const  { return m_lastReused; }    // on a kept connection
+    bool     lastPacked() const  { return m_lastPacked; }    // body was MessagePack
+
+    const char* etag() const   { return m_etag; }
+    const char* cursor() const { return m_cursor; }
+
+    const HttpFetch& fetch() const { return m_fetch; }
+
+private:
+    static bool onBody(void* ctx, const uint8_t* data, size_t len);
+    static void onHeader(void* ctx, const char* name, const char* value);
+
+    CosmaniaStatus& backBuffer();
+    void   publish();
+    Result complete(HttpFetch::State state, uint32_t now);
+
+    HttpFetch      m_fetch;
+    StatusParser   m_parser;
+    CosmaniaStatus m_status[2];
+    uint8_t        m_front = 0;
+
+    char     m_etag[ETAG_LEN]        = {0};     // validator of the front
+    char     m_pendingEtag[ETAG_LEN] = {0};     // from the response in flight
+    char     m_cursor[StatusParser::TOKEN_MAX + 1] = {0};
+    bool     m_conditional = false;             // request sent If-None-Match
+    bool     m_msgpack     = false;             // ask for MessagePack
+
+    bool     m_lastDelta  = false;
+    bool     m_lastChanged = false;
+    int      m_lastStatus = 0;
+    HttpFetch::Error m_lastError = HttpFetch::ERR_NONE;
+    uint32_t m_lastMs     = 0;
+    uint32_t m_lastBytes  = 0;
+    bool     m_lastReused = false;
+    bool     m_lastPacked = false;
+};
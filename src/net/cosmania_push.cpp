@@ -0,0 +1,252 @@
+#include "cosmania_push.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+// ==========================================================================
+// Cosmania Push -- SSE line parser feeding StatusParser
+// Lines are split on CR, LF or CRLF. "data" values are never buffered:
+// they stream into the parser as they arrive, with the newline that joins
+// data lines fed as JSON whitespace. Other field values are short (event
+// type, id, retry) and kept in one small buffer. A blank line dispatches
+// the event. An event that fails to parse has left the status unknown, so
+// the stream is dropped and the next one starts from a full status.
+// ==========================================================================
+
+bool CosmaniaPush::setUrl(const char* url) {
+    m_fetch.setTimeout(0);                  // a stream has no end to wait for
+    m_fetch.setIdleTimeout(IDLE_MS);
+    return m_fetch.setUrl(url);
+}
+
+void CosmaniaPush::connect(uint32_t now) {
+    if (m_fetch.busy() || now - m_downMs < m_retryMs) return;
+
+    char headers[HttpFetch::HEADERS_LEN];
+    int n = snprintf(headers, sizeof(headers), "Accept: text/event-stream\r\n");
+    if (m_lastId[0]) snprintf(headers + n, sizeof(headers) - n, "Last-Event-ID: %s\r\n", m_lastId);
+    m_fetch.setHeaders(headers);
+
+    m_line     = LN_START;
+    m_cr       = false;
+    m_type[0]  = '\0';
+    m_parsing  = false;
+    m_skipData = false;
+    m_live     = false;
+    if (!m_fetch.start(now, onBody, this)) backOff(now);
+}
+
+CosmaniaPush::Event CosmaniaPush::poll(uint32_t now) {
+    if (!m_fetch.busy()) return NONE;
+    m_nowMs = now;
+    uint32_t events = m_stats.events;
+
+    HttpFetch::State state = m_fetch.poll(now);
+    if (!m_live && state == HttpFetch::BODY && m_fetch.status() == 200) {
+        m_live     = true;
+        m_attempts = 0;
+        m_stats.connects++;
+    }
+    if (state == HttpFetch::DONE || state == HttpFetch::FAILED) {
+        bool wasLive = m_live;
+        m_fetch.abort();
+        m_live    = false;
+        m_parsing = false;
+        backOff(now);
+        if (wasLive) {
+            m_stats.drops++;
+            return DROPPED;
+        }
+        return NONE;
+    }
+    return m_stats.events != events ? APPLIED : NONE;
+}
+
+void CosmaniaPush::stop() {
+    m_fetch.disconnect();
+    m_live    = false;
+    m_parsing = false;
+}
+
+uint32_t CosmaniaPush::retryInMs(uint32_t now) const {
+    if (m_fetch.busy()) return 0;
+    uint32_t elapsed = now - m_downMs;
+    return elapsed >= m_retryMs ? 0 : m_retryMs - elapsed;
+}
+
+// Doubles per failed attempt from the server's retry (or RETRY_MIN_MS),
+// half of it fixed and half random
+void CosmaniaPush::backOff(uint32_t now) {
+    uint32_t wait = m_serverRetryMs ? m_serverRetryMs : RETRY_MIN_MS;
+    for (uint8_t i = 0; i < m_attempts && wait < RETRY_MAX_MS; i++) wait *= 2;
+    if (wait > RETRY_MAX_MS) wait = RETRY_MAX_MS;
+    if (m_attempts < UINT8_MAX) m_attempts++;
+    m_downMs  = now;
+    m_retryMs = wait / 2 + nextRandom() % (wait / 2 + 1);
+}
+
+// xorshift32, as in PollScheduler
+uint32_t CosmaniaPush::nextRandom() {
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 17;
+    m_rng ^= m_rng << 5;
+    return m_rng;
+}
+
+// -- SSE -------------------------------------------------------------------
+
+bool CosmaniaPush::onBody(void* ctx, const uint8_t* data, size_t len) {
+    return static_cast<CosmaniaPush*>(ctx)->feed(data, len);
+}
+
+bool CosmaniaPush::feed(const uint8_t* data, size_t len) {
+    m_stats.bytes += len;
+    size_t i = 0;
+    while (i < len) {
+        // Data values run straight into the parser up to the line end
+        if (m_line == LN_VALUE && m_isData) {
+            size_t end = i;
+            while (end < len && data[end] != '\n' && data[end] != '\r') end++;
+            if (m_parsing && end > i && !m_parser.feed(data + i, end - i)) {
+                m_parsing  = false;
+                m_skipData = true;
+                m_resync   = true;
+            }
+            i = end;
+            if (i == len) break;
+        }
+
+        char c = static_cast<char>(data[i++]);
+        if (c == '\n' && m_cr) {            // LF of a CRLF
+            m_cr = false;
+            continue;
+        }
+        m_cr = c == '\r';
+        if (c == '\r' || c == '\n') {
+            lineDone();
+            if (m_resync) break;
+            continue;
+        }
+
+        switch (m_line) {
+            case LN_START:
+                if (c == ':') {
+                    m_line = LN_COMMENT;
+                    m_stats.heartbeats++;
+                    break;
+                }
+                m_fieldLen = 0;
+                m_line     = LN_FIELD;
+                // fall through
+            case LN_FIELD:
+                if (c == ':') {
+                    fieldDone();
+                    m_line = LN_VALUE_START;
+                } else if (m_fieldLen < FIELD_LEN) {
+                    m_field[m_fieldLen++] = c;
+                }
+                break;
+            case LN_VALUE_START:
+                m_line = LN_VALUE;
+                if (c == ' ') break;        // one optional space after ':'
+                if (m_isData) {
+                    i--;                    // first data byte: stream it above
+                    break;
+                }
+                // fall through
+            case LN_VALUE:
+                if (m_valueLen < VALUE_LEN + 1) m_value[m_valueLen++] = c;
+                break;
+            case LN_COMMENT:
+                break;
+        }
+    }
+
+    if (m_resync) {
+        // The status no longer matches any cursor: start over from full
+        m_resync    = false;
+        m_lastId[0] = '\0';
+        m_target.forget();
+        m_stats.badEvents++;
+        return false;
+    }
+    return true;
+}
+
+void CosmaniaPush::lineDone() {
+    switch (m_line) {
+        case LN_START:
+            dispatch();
+            break;
+        case LN_FIELD:                      // field name alone: empty value
+            fieldDone();
+            valueDone();
+            break;
+        case LN_VALUE_START:
+        case LN_VALUE:
+            valueDone();
+            break;
+        case LN_COMMENT:
+            break;
+    }
+    m_line = LN_START;
+}
+
+void CosmaniaPush::fieldDone() {
+    m_field[m_fieldLen] = '\0';
+    m_isData   = strcmp(m_field, "data") == 0;
+    m_valueLen = 0;
+    if (!m_isData || m_parsing || m_skipData) return;
+
+    // First data line of the event: a status document, or nothing we use
+    if (m_type[0] != '\0' && strcmp(m_type, "status") != 0) {
+        m_skipData = true;
+        return;
+    }
+    if (m_target.busy()) m_target.abort();  // the stream supersedes a poll
+    m_parser.begin(m_target.edit());
+    m_parsing = true;
+}
+
+void CosmaniaPush::valueDone() {
+    if (m_isData) {
+        static const uint8_t NEWLINE = '\n';
+        if (m_parsing && !m_parser.feed(&NEWLINE, 1)) {
+            m_parsing  = false;
+            m_skipData = true;
+            m_resync   = true;
+        }
+        return;
+    }
+
+    bool whole = m_valueLen <= VALUE_LEN;
+    if (!whole) m_valueLen = VALUE_LEN;
+    m_value[m_valueLen] = '\0';
+    if (strcmp(m_field, "event") == 0) {
+        memcpy(m_type, m_value, m_valueLen + 1);
+    } else if (strcmp(m_field, "id") == 0) {
+        // A cut-off id would resume from the wrong point: forget it instead
+        if (whole) memcpy(m_lastId, m_value, m_valueLen + 1);
+        else       m_lastId[0] = '\0';
+    } else if (strcmp(m_field, "retry") == 0) {
+        char* end;
+        unsigned long ms = strtoul(m_value, &end, 10);
+        if (end != m_value && *end == '\0') m_serverRetryMs = ms < RETRY_MAX_MS ? ms : RETRY_MAX_MS;
+    }
+}
+
+void CosmaniaPush::dispatch() {
+    if (m_parsing) {
+        if (m_parser.finish()) {
+            m_target.commit(m_nowMs, m_parser.cursor()[0] ? m_parser.cursor() : m_lastId);
+            m_stats.events++;
+            m_stats.lastEventMs = m_nowMs;
+        } else {
+            m_resync = true;                // data ended mid-document
+        }
+    }
+    m_parsing  = false;
+    m_skipData = false;
+    m_type[0]  = '\0';
+}
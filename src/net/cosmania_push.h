@@ -0,0 +1,107 @@
+#pragma once
+#include "cosmania_poll.h"
+#include "http_fetch.h"
+#include "status_parser.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Cosmania Push -- Server-Sent Events from /events, applied as they land
+// Platform-neutral (tools/net_bench/ runs it against a stand-in server).
+// Holds one long-lived HttpFetch on the stream; every "status" event is a
+// /status document (full, or a delta with "delta": true) and is streamed
+// into a StatusParser on the target CosmaniaPoll's back buffer, then
+// committed, so the front status moves the moment the server says so.
+//
+// The event id is the server's cursor: it is sent back as Last-Event-ID on
+// reconnect (the server resumes with a delta) and handed to the poller,
+// whose fallback ?since= polls pick up from the same point. The server
+// sends a comment line at least every HEARTBEAT_MS; a stream quiet for
+// longer than IDLE_MS is dropped. Reconnects back off from RETRY_MIN_MS
+// (or the server's "retry:") to RETRY_MAX_MS with jitter.
+// ==========================================================================
+
+class CosmaniaPush {
+public:
+    static constexpr uint32_t HEARTBEAT_MS = 30000;
+    static constexpr uint32_t IDLE_MS      = 3 * HEARTBEAT_MS;
+    static constexpr uint32_t RETRY_MIN_MS = 5000;
+    static constexpr uint32_t RETRY_MAX_MS = 5UL * 60 * 1000;
+    static constexpr size_t   FIELD_LEN    = 8;     // "event", "data", "id", "retry"
+    static constexpr size_t   VALUE_LEN    = StatusParser::TOKEN_MAX;
+
+    enum Event : uint8_t {
+        NONE,
+        APPLIED,            // a status event was published
+        DROPPED,            // stream ended or failed; polling should take over
+    };
+
+    struct Stats {
+        uint32_t connects    = 0;   // streams opened (200 response)
+        uint32_t drops       = 0;
+        uint32_t events      = 0;   // status events applied
+        uint32_t badEvents   = 0;   // status events that did not parse
+        uint32_t heartbeats  = 0;   // comment lines
+        uint32_t bytes       = 0;
+        uint32_t lastEventMs = 0;
+    };
+
+    explicit CosmaniaPush(CosmaniaPoll& target) : m_target(target) {}
+
+    // Full URL of the /events endpoint
+    bool setUrl(const char* url);
+    void setIdleTimeout(uint32_t ms) { m_fetch.setIdleTimeout(ms); }
+    void seed(uint32_t value) { m_rng = value ? value : 0x9E3779B9u; }
+
+    // Opens the stream if it is down and the reconnect wait has passed
+    void  connect(uint32_t now);
+    Event poll(uint32_t now);
+    void  stop();
+
+    bool  live() const { return m_live; }           // stream open and flowing
+    bool  active() const { return m_fetch.busy(); } // connecting or live
+    uint32_t retryInMs(uint32_t now) const;
+    const char* lastId() const { return m_lastId; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    enum Line : uint8_t { LN_START, LN_FIELD, LN_VALUE_START, LN_VALUE, LN_COMMENT };
+
+    static bool onBody(void* ctx, const uint8_t* data, size_t len);
+    bool  feed(const uint8_t* data, size_t len);
+    void  lineDone();
+    void  fieldDone();
+    void  valueDone();
+    void  dispatch();
+    void  backOff(uint32_t now);
+    uint32_t nextRandom();
+
+    CosmaniaPoll& m_target;
+    HttpFetch     m_fetch;
+    StatusParser  m_parser;
+
+    bool     m_live     = false;
+    uint32_t m_nowMs    = 0;
+    uint32_t m_downMs   = 0;        // when the stream went down
+    uint32_t m_retryMs  = 0;        // wait before the next connect
+    uint32_t m_serverRetryMs = 0;   // from "retry:", 0 = none
+    uint8_t  m_attempts = 0;        // connects since the stream was last live
+    uint32_t m_rng      = 0x9E3779B9u;
+    Stats    m_stats;
+
+    // SSE line state
+    Line     m_line     = LN_START;
+    char     m_field[FIELD_LEN + 1];
+    uint8_t  m_fieldLen = 0;
+    char     m_value[VALUE_LEN + 1];  // one byte spare: detects a cut-off value
+    uint8_t  m_valueLen = 0;
+    bool     m_isData   = false;    // value being read is a data line
+    bool     m_cr       = false;    // last byte was CR (CRLF counts once)
+
+    // Event being assembled
+    char     m_type[VALUE_LEN + 1];
+    bool     m_parsing  = false;    // data is going into m_parser
+    bool     m_skipData = false;    // data of an event we don't use
+    bool     m_resync   = false;    // an event failed: drop the stream
+    char     m_lastId[VALUE_LEN + 1] = {0};
+};
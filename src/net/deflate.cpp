@@ -0,0 +1,179 @@
+#include "deflate.h"
+#include <cstring>
+
+// ==========================================================================
+// Deflate -- greedy LZ77 + fixed Huffman, stored-block fallback
+// Matches are found through m_head / m_prev chains (3-byte hash, newest
+// first, at most MAX_CHAIN tried) and taken greedily. Bits go out LSB
+// first as deflate wants; Huffman codes are bit-reversed on the way.
+// ==========================================================================
+
+static const uint16_t LEN_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t LEN_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+static constexpr size_t MIN_MATCH = 3;
+static constexpr size_t MAX_MATCH = 258;
+
+namespace {
+
+struct BitWriter {
+    uint8_t* out;
+    size_t   cap;
+    size_t   pos  = 0;
+    uint32_t bits = 0;
+    int      n    = 0;
+    bool     overflow = false;
+
+    BitWriter(uint8_t* o, size_t c) : out(o), cap(c) {}
+
+    void put(uint32_t value, int count) {
+        bits |= value << n;
+        n += count;
+        while (n >= 8) {
+            if (pos < cap) out[pos++] = static_cast<uint8_t>(bits);
+            else           overflow = true;
+            bits >>= 8;
+            n -= 8;
+        }
+    }
+
+    // Huffman codes are defined MSB first
+    void code(uint32_t value, int count) {
+        uint32_t r = 0;
+        for (int i = 0; i < count; i++) r |= ((value >> i) & 1) << (count - 1 - i);
+        put(r, count);
+    }
+
+    void flush() { if (n > 0) put(0, 8 - n); }
+};
+
+}  // namespace
+
+static void literal(BitWriter& bw, unsigned sym) {
+    if (sym < 144)      bw.code(0x30 + sym, 8);
+    else if (sym < 256) bw.code(0x190 + sym - 144, 9);
+    else if (sym < 280) bw.code(sym - 256, 7);
+    else                bw.code(0xC0 + sym - 280, 8);
+}
+
+static void match(BitWriter& bw, size_t len, size_t dist) {
+    int i = 28;
+    while (LEN_BASE[i] > len) i--;
+    literal(bw, 257 + i);
+    bw.put(static_cast<uint32_t>(len - LEN_BASE[i]), LEN_EXTRA[i]);
+
+    int d = 29;
+    while (DIST_BASE[d] > dist) d--;
+    bw.code(d, 5);
+    bw.put(static_cast<uint32_t>(dist - DIST_BASE[d]), DIST_EXTRA[d]);
+}
+
+static inline uint32_t hash3(const uint8_t* p) {
+    uint32_t v = (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+    return (v * 2654435761u) >> (32 - Deflate::HASH_BITS);
+}
+
+uint32_t Deflate::adler32(const uint8_t* data, size_t len) {
+    uint32_t a = 1, b = 0;
+    while (len > 0) {
+        size_t n = len < 5552 ? len : 5552;     // largest run before b can overflow
+        len -= n;
+        while (n--) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+// One final fixed-Huffman block; 0 if it doesn't fit in cap
+size_t Deflate::huffman(const uint8_t* in, size_t len, uint8_t* out, size_t cap) {
+    BitWriter bw(out, cap);
+    bw.put(1, 1);                   // BFINAL
+    bw.put(1, 2);                   // BTYPE = fixed Huffman
+    memset(m_head, 0, sizeof(m_head));
+
+    auto insert = [&](size_t pos) {
+        uint32_t h = hash3(in + pos);
+        m_prev[pos] = m_head[h];
+        m_head[h]   = static_cast<uint16_t>(pos + 1);
+    };
+
+    size_t i = 0;
+    while (i < len && !bw.overflow) {
+        size_t bestLen = 0, bestDist = 0;
+        if (i + MIN_MATCH <= len) {
+            size_t maxLen = len - i < MAX_MATCH ? len - i : MAX_MATCH;
+            uint16_t cand = m_head[hash3(in + i)];
+            for (int chain = MAX_CHAIN; cand && chain > 0; chain--) {
+                size_t p = cand - 1;
+                if (in[p + bestLen] == in[i + bestLen]) {
+                    size_t l = 0;
+                    while (l < maxLen && in[p + l] == in[i + l]) l++;
+                    if (l > bestLen) {
+                        bestLen  = l;
+                        bestDist = i - p;
+                        if (l == maxLen) break;
+                    }
+                }
+                cand = m_prev[p];
+            }
+            insert(i);
+        }
+        if (bestLen >= MIN_MATCH) {
+            match(bw, bestLen, bestDist);
+            for (size_t k = 1; k < bestLen && i + k + MIN_MATCH <= len; k++) insert(i + k);
+            i += bestLen;
+        } else {
+            literal(bw, in[i]);
+            i++;
+        }
+    }
+    literal(bw, 256);               // end of block
+    bw.flush();
+    return bw.overflow ? 0 : bw.pos;
+}
+
+size_t Deflate::compress(const uint8_t* in, size_t len, uint8_t* out, size_t cap) {
+    if (len > INPUT_MAX || cap < bound(len)) return 0;
+    out[0] = 0x78;                  // deflate, 32 KB window
+    out[1] = 0x01;                  // no dictionary, check bits
+    size_t pos = 2;
+
+    // Only worth it if it beats the stored block
+    size_t n = huffman(in, len, out + pos, len + 5);
+    if (n > 0 && n < len + 5) {
+        pos += n;
+    } else {
+        out[pos++] = 0x01;          // BFINAL, BTYPE = stored
+        out[pos++] = static_cast<uint8_t>(len);
+        out[pos++] = static_cast<uint8_t>(len >> 8);
+        out[pos++] = static_cast<uint8_t>(~len);
+        out[pos++] = static_cast<uint8_t>(~len >> 8);
+        memcpy(out + pos, in, len);
+        pos += len;
+    }
+
+    uint32_t adler = adler32(in, len);
+    out[pos++] = static_cast<uint8_t>(adler >> 24);
+    out[pos++] = static_cast<uint8_t>(adler >> 16);
+    out[pos++] = static_cast<uint8_t>(adler >> 8);
+    out[pos++] = static_cast<uint8_t>(adler);
+    return pos;
+}
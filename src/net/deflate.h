@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Deflate -- One-shot zlib (RFC 1950/1951) compressor for small buffers
+// Platform-neutral, no allocation: LZ77 over a hash-chained window the
+// size of the input, coded with the fixed Huffman tables (no dynamic
+// trees to build or send, which is what small telemetry frames want).
+// Output that would not beat a stored block is sent stored, so a frame
+// never grows by more than STORED_OVERHEAD. Any zlib inflate (servers,
+// `Content-Encoding: deflate`) reads the result.
+// ==========================================================================
+
+class Deflate {
+public:
+    static constexpr size_t INPUT_MAX       = 4096;     // longest input (window)
+    static constexpr size_t STORED_OVERHEAD = 11;       // zlib header, block header, adler32
+    static constexpr int    HASH_BITS       = 10;
+    static constexpr int    MAX_CHAIN       = 16;       // candidates tried per position
+
+    // Largest output for `len` input bytes
+    static constexpr size_t bound(size_t len) { return len + STORED_OVERHEAD; }
+
+    // Returns bytes written to `out`, 0 if len > INPUT_MAX or cap < bound(len)
+    size_t compress(const uint8_t* in, size_t len, uint8_t* out, size_t cap);
+
+    static uint32_t adler32(const uint8_t* data, size_t len);
+
+private:
+    size_t huffman(const uint8_t* in, size_t len, uint8_t* out, size_t cap);
+
+    uint16_t m_head[1 << HASH_BITS];    // newest position + 1 per hash, 0 = none
+    uint16_t m_prev[INPUT_MAX];         // previous position + 1 with the same hash
+};
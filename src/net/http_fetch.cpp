@@ -0,0 +1,451 @@
+#include "http_fetch.h"
+#include "net_resolve.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#if defined(ARDUINO)
+#include <lwip/sockets.h>
+#else
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0          // lwIP never raises SIGPIPE
+#endif
+
+// ==========================================================================
+// HTTP Fetch -- resolve -> connect -> send -> headers -> body, one poll()
+// at a time. The socket is non-blocking throughout: connect completes via
+// select() with a zero timeout, send/recv stop at EAGAIN. Whether a DONE
+// response's socket is kept is settled at the end of the poll() that
+// finished it, once any bytes past the response would have shown up.
+// ==========================================================================
+
+static const char* const ERROR_NAMES[] = {
+    "none", "url", "dns", "socket", "connect", "send",
+    "timeout", "closed", "protocol", "sink",
+};
+static_assert(sizeof(ERROR_NAMES) / sizeof(ERROR_NAMES[0]) == HttpFetch::ERR_SINK + 1,
+              "ERROR_NAMES out of sync with HttpFetch::Error");
+
+const char* HttpFetch::errorName(Error e) {
+    return e <= ERR_SINK ? ERROR_NAMES[e] : "?";
+}
+
+bool HttpFetch::setUrl(const char* url) {
+    disconnect();
+    m_host[0] = '\0';
+    m_addr    = 0;
+    if (!url || strncmp(url, "http://", 7) != 0) return false;
+
+    const char* host = url + 7;
+    size_t hostLen = strcspn(host, ":/");
+    if (hostLen == 0 || hostLen >= HOST_LEN) return false;
+
+    const char* rest = host + hostLen;
+    uint16_t port = 80;
+    if (*rest == ':') {
+        char* end;
+        unsigned long p = strtoul(rest + 1, &end, 10);
+        if (end == rest + 1 || p == 0 || p > 65535) return false;
+        port = static_cast<uint16_t>(p);
+        rest = end;
+    }
+    const char* path = *rest ? rest : "/";
+    if (*path != '/' || strlen(path) >= PATH_LEN) return false;
+
+    memcpy(m_host, host, hostLen);
+    m_host[hostLen] = '\0';
+    strcpy(m_path, path);
+    m_port = port;
+    return true;
+}
+
+bool HttpFetch::setQuery(const char* query) {
+    if (strlen(query) >= QUERY_LEN) return false;
+    strcpy(m_query, query);
+    return true;
+}
+
+bool HttpFetch::setHeaders(const char* lines) {
+    if (strlen(lines) >= HEADERS_LEN) return false;
+    strcpy(m_headers, lines);
+    return true;
+}
+
+bool HttpFetch::start(uint32_t now, BodySink sink, void* ctx) {
+    abort();
+    if (m_host[0] == '\0') {
+        m_error = ERR_URL;
+        m_state = FAILED;
+        return false;
+    }
+    m_sink       = sink;
+    m_ctx        = ctx;
+    m_startMs    = now;
+    m_rxMs       = now;
+    m_error      = ERR_NONE;
+    m_status     = 0;
+    m_statusSeen = false;
+    m_lineLen    = 0;
+    m_framing    = FRAME_CLOSE;
+    m_chunkState = CHUNK_SIZE;
+    m_remaining  = 0;
+    m_bodyBytes  = 0;
+    m_reusable   = false;
+    buildRequest();
+    m_state = reuseSocket() ? SENDING : RESOLVING;
+    return true;
+}
+
+void HttpFetch::abort() {
+    if (m_state == RESOLVING) NetResolve::cancel();
+    if (busy()) closeSocket();      // a finished request's socket may be kept
+    m_state = IDLE;
+}
+
+void HttpFetch::disconnect() {
+    abort();
+    closeSocket();
+}
+
+void HttpFetch::closeIdle(uint32_t now) {
+    if (!busy() && m_fd >= 0 && now - m_idleMs >= IDLE_MS) closeSocket();
+}
+
+HttpFetch::State HttpFetch::poll(uint32_t now) {
+    if (!busy()) return m_state;
+    if (m_timeoutMs && now - m_startMs >= m_timeoutMs) return fail(ERR_TIMEOUT);
+    if (m_idleTimeoutMs && now - m_rxMs >= m_idleTimeoutMs) return fail(ERR_TIMEOUT);
+
+    if (m_state == RESOLVING) {
+        uint32_t ipv4 = m_addr;
+        if (ipv4 == 0 || now - m_addrMs >= DNS_TTL_MS) {
+            switch (NetResolve::lookup(m_host, ipv4)) {
+                case NetResolve::RESOLVE_PENDING: return m_state;
+                case NetResolve::RESOLVE_FAILED:  m_lookups++; return fail(ERR_DNS);
+                case NetResolve::RESOLVE_OK:      m_lookups++; break;
+            }
+            m_addr   = ipv4;
+            m_addrMs = now;
+        }
+        if (!openSocket(ipv4)) return m_state;
+    }
+
+    if (m_state == CONNECTING) {
+        fd_set wr;
+        FD_ZERO(&wr);
+        FD_SET(m_fd, &wr);
+        timeval tv = { 0, 0 };
+        if (select(m_fd + 1, nullptr, &wr, nullptr, &tv) <= 0) return m_state;
+
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+            return fail(ERR_CONNECT);
+        }
+        m_state = SENDING;
+    }
+
+    if (m_state == SENDING) {
+        // Request head, then the body (if any)
+        bool head = m_reqSent < m_reqLen;
+        const void* data = head ? static_cast<const void*>(m_req + m_reqSent)
+                                : static_cast<const void*>(m_body + m_bodySent);
+        size_t left = head ? m_reqLen - m_reqSent : m_bodyLen - m_bodySent;
+        ssize_t n = left ? send(m_fd, data, left, MSG_DONTWAIT | MSG_NOSIGNAL) : 0;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return m_state;
+            if (retryFresh()) return m_state;
+            return fail(ERR_SEND);
+        }
+        (head ? m_reqSent : m_bodySent) += static_cast<size_t>(n);
+        if (m_reqSent < m_reqLen || m_bodySent < m_bodyLen) return m_state;
+        m_state = HEADERS;
+    }
+
+    readSome(now);
+    if (m_state == DONE) {
+        if (m_keepAlive && m_reusable) m_idleMs = now;
+        else                           closeSocket();
+    }
+    return m_state;
+}
+
+// -- Socket ----------------------------------------------------------------
+
+bool HttpFetch::openSocket(uint32_t ipv4) {
+    m_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_fd < 0) {
+        fail(ERR_SOCKET);
+        return false;
+    }
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(m_port);
+    addr.sin_addr.s_addr = ipv4;
+    if (connect(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 &&
+        errno != EINPROGRESS) {
+        fail(ERR_CONNECT);
+        return false;
+    }
+    m_connects++;
+    m_state = CONNECTING;
+    return true;
+}
+
+// A kept socket is reused if it is still quiet: no EOF from the server,
+// no stray bytes, not idle past IDLE_MS
+bool HttpFetch::reuseSocket() {
+    m_reused = false;
+    if (m_fd < 0) return false;
+    uint8_t b;
+    ssize_t n = recv(m_fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    bool quiet = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    if (!m_keepAlive || !quiet || m_startMs - m_idleMs >= IDLE_MS) {
+        closeSocket();
+        return false;
+    }
+    m_reused = true;
+    m_reuses++;
+    return true;
+}
+
+// The server may drop a kept connection just as it is reused; that shows
+// as a send error or EOF before any of the response. Go again on a fresh
+// connection (once: a fresh connection is never m_reused)
+bool HttpFetch::retryFresh() {
+    if (!m_reused || m_statusSeen || m_lineLen > 0) return false;
+    closeSocket();
+    m_reused   = false;
+    m_reqSent  = 0;
+    m_bodySent = 0;
+    m_retries++;
+    m_state   = RESOLVING;
+    return true;
+}
+
+void HttpFetch::closeSocket() {
+    if (m_fd >= 0) close(m_fd);
+    m_fd = -1;
+}
+
+void HttpFetch::buildRequest() {
+    char hostHdr[HOST_LEN + 8];
+    if (m_port == 80) snprintf(hostHdr, sizeof(hostHdr), "%s", m_host);
+    else              snprintf(hostHdr, sizeof(hostHdr), "%s:%u", m_host, m_port);
+
+    char lengthHdr[32] = "";
+    if (m_body) snprintf(lengthHdr, sizeof(lengthHdr), "Content-Length: %u\r\n",
+                         static_cast<unsigned>(m_bodyLen));
+
+    int n = snprintf(m_req, sizeof(m_req),
+                     "%s %s%s%s HTTP/1.1\r\n"
+                     "Host: %s\r\n"
+                     "User-Agent: tamafi/0.1\r\n"
+                     "Connection: %s\r\n"
+                     "%s%s"
+                     "\r\n",
+                     m_body ? "POST" : "GET",
+                     m_path, m_query[0] ? "?" : "", m_query, hostHdr,
+                     m_keepAlive ? "keep-alive" : "close", lengthHdr, m_headers);
+    m_reqLen   = n > 0 && static_cast<size_t>(n) < sizeof(m_req) ? n : 0;
+    m_reqSent  = 0;
+    m_bodySent = 0;
+}
+
+HttpFetch::State HttpFetch::fail(Error e) {
+    if (m_state == RESOLVING) NetResolve::cancel();
+    if (e == ERR_CONNECT) m_addr = 0;       // the host may have moved
+    closeSocket();
+    m_error = e;
+    m_state = FAILED;
+    return m_state;
+}
+
+HttpFetch::State HttpFetch::finish() {
+    m_state = DONE;
+    return m_state;
+}
+
+// -- Receive ---------------------------------------------------------------
+
+bool HttpFetch::readSome(uint32_t now) {
+    uint8_t buf[READ_CHUNK];
+    size_t budget = READ_BUDGET;
+    while (budget > 0 && (m_state == HEADERS || m_state == BODY)) {
+        ssize_t n = recv(m_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0) {
+            m_rxMs = now;
+            if (!consume(buf, static_cast<size_t>(n))) return false;
+            budget -= static_cast<size_t>(n) < budget ? static_cast<size_t>(n) : budget;
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+
+        // Orderly close (or reset): only complete for read-until-close bodies
+        if (n == 0 && m_state == BODY && m_framing == FRAME_CLOSE) {
+            m_reusable = false;
+            finish();
+            return true;
+        }
+        if (retryFresh()) return true;
+        fail(ERR_CLOSED);
+        return false;
+    }
+    return true;
+}
+
+// Feeds received bytes through the header parser, then the body framing
+bool HttpFetch::consume(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i < len && m_state == HEADERS) {
+        char c = static_cast<char>(data[i++]);
+        if (c != '\n') {
+            if (m_lineLen < LINE_LEN - 1) m_line[m_lineLen++] = c;
+            continue;
+        }
+        if (m_lineLen > 0 && m_line[m_lineLen - 1] == '\r') m_lineLen--;
+        m_line[m_lineLen] = '\0';
+        bool ok = headerLine();
+        m_lineLen = 0;
+        if (!ok) return false;
+    }
+    if (i < len && m_state == BODY) return body(data + i, len - i);
+    if (i < len && m_state == DONE) m_reusable = false;    // bytes past the response
+    return m_state != FAILED;
+}
+
+bool HttpFetch::headerLine() {
+    if (!m_statusSeen) {
+        // "HTTP/1.x NNN reason"
+        if (strncmp(m_line, "HTTP/1.", 7) != 0 || m_lineLen < 12 || m_line[8] != ' ') {
+            fail(ERR_PROTOCOL);
+            return false;
+        }
+        m_status = atoi(m_line + 9);
+        m_statusSeen = true;
+        m_reusable = m_line[7] == '1';      // HTTP/1.1 is persistent by default
+        return true;
+    }
+
+    if (m_lineLen > 0) {
+        if (m_headerSink) {
+            char* colon = strchr(m_line, ':');
+            if (colon) {
+                *colon = '\0';
+                const char* value = colon + 1;
+                while (*value == ' ' || *value == '\t') value++;
+                m_headerSink(m_ctx, m_line, value);
+                *colon = ':';
+            }
+        }
+        if (strncasecmp(m_line, "Connection:", 11) == 0) {
+            const char* value = m_line + 11;
+            while (*value == ' ' || *value == '\t') value++;
+            if (strncasecmp(value, "close", 5) == 0) m_reusable = false;
+        } else if (strncasecmp(m_line, "Content-Length:", 15) == 0) {
+            m_framing   = FRAME_LENGTH;
+            m_remaining = strtoul(m_line + 15, nullptr, 10);
+        } else if (strncasecmp(m_line, "Transfer-Encoding:", 18) == 0 &&
+                   strstr(m_line + 18, "chunked")) {
+            m_framing = FRAME_CHUNKED;
+        }
+        return true;
+    }
+
+    // Blank line: end of headers. 1xx interim responses start over.
+    if (m_status >= 100 && m_status < 200) {
+        m_statusSeen = false;
+        m_framing = FRAME_CLOSE;
+        return true;
+    }
+    m_state = BODY;
+    if (m_status == 204 || m_status == 304 ||
+        (m_framing == FRAME_LENGTH && m_remaining == 0)) {
+        finish();
+    }
+    return true;
+}
+
+bool HttpFetch::body(const uint8_t* data, size_t len) {
+    if (m_framing == FRAME_CHUNKED) return chunked(data, len);
+
+    if (m_framing == FRAME_LENGTH) {
+        if (len > m_remaining) {
+            len = m_remaining;
+            m_reusable = false;
+        }
+        m_remaining -= len;
+    }
+    m_bodyBytes += len;
+    if (m_status >= 200 && m_status < 300 && m_sink && len > 0 && !m_sink(m_ctx, data, len)) {
+        fail(ERR_SINK);
+        return false;
+    }
+    if (m_framing == FRAME_LENGTH && m_remaining == 0) finish();
+    return true;
+}
+
+bool HttpFetch::chunked(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i < len && m_state == BODY) {
+        if (m_chunkState == CHUNK_DATA) {
+            size_t n = len - i < m_remaining ? len - i : m_remaining;
+            m_remaining -= n;
+            m_bodyBytes += n;
+            if (m_status >= 200 && m_status < 300 && m_sink && !m_sink(m_ctx, data + i, n)) {
+                fail(ERR_SINK);
+                return false;
+            }
+            i += n;
+            if (m_remaining == 0) m_chunkState = CHUNK_DATA_END;
+            continue;
+        }
+
+        // Size line, CRLF after data, trailers: all line-based
+        char c = static_cast<char>(data[i++]);
+        if (c != '\n') {
+            if (m_lineLen < LINE_LEN - 1) m_line[m_lineLen++] = c;
+            continue;
+        }
+        if (m_lineLen > 0 && m_line[m_lineLen - 1] == '\r') m_lineLen--;
+        m_line[m_lineLen] = '\0';
+        size_t lineLen = m_lineLen;
+        m_lineLen = 0;
+
+        switch (m_chunkState) {
+            case CHUNK_SIZE: {
+                char* end;
+                unsigned long size = strtoul(m_line, &end, 16);
+                if (end == m_line) {
+                    fail(ERR_PROTOCOL);
+                    return false;
+                }
+                m_remaining  = size;
+                m_chunkState = size ? CHUNK_DATA : CHUNK_TRAILER;
+                break;
+            }
+            case CHUNK_DATA_END:
+                m_chunkState = CHUNK_SIZE;
+                break;
+            case CHUNK_TRAILER:
+                if (lineLen == 0) finish();
+                break;
+            default:
+                break;
+        }
+    }
+    if (i < len && m_state == DONE) m_reusable = false;
+    return m_state != FAILED;
+}
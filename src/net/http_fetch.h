@@ -0,0 +1,177 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// HTTP Fetch -- Non-blocking HTTP/1.1 GET state machine
+// Platform-neutral (BSD sockets; lwIP on device, POSIX on the host, where
+// tools/net_bench/ runs it against a scripted server). Every poll() does
+// at most one step of work per state and a bounded amount of reading, so
+// a slow or dead server costs the caller nothing but the poll itself.
+// Body bytes go to a sink as they arrive (Content-Length, chunked or
+// read-until-close framing already removed); response headers can go to
+// a second sink. A request body (setBody) turns the GET into a POST.
+// Plain http:// only.
+//
+// With keep-alive on, a cleanly framed HTTP/1.1 response leaves its socket
+// open for the next start(), which then skips DNS and the handshake. The
+// resolved address is cached too. A kept connection the server has since
+// dropped is caught before reuse, or on the first send / read, and the
+// request quietly goes out again on a fresh one.
+// ==========================================================================
+
+class HttpFetch {
+public:
+    static constexpr size_t   HOST_LEN    = 64;
+    static constexpr size_t   PATH_LEN    = 96;
+    static constexpr size_t   QUERY_LEN   = 64;
+    static constexpr size_t   HEADERS_LEN = 128;    // extra request header lines
+    static constexpr size_t   LINE_LEN    = 128;    // longest header line kept
+    static constexpr size_t   READ_CHUNK  = 512;    // bytes per recv()
+    static constexpr size_t   READ_BUDGET = 4096;   // bytes per poll()
+    static constexpr uint32_t TIMEOUT_MS  = 5000;
+    static constexpr uint32_t IDLE_MS     = 60000;  // kept connection lifetime
+    static constexpr uint32_t DNS_TTL_MS  = 10UL * 60 * 1000;
+
+    enum State : uint8_t {
+        IDLE,
+        RESOLVING,
+        CONNECTING,
+        SENDING,
+        HEADERS,
+        BODY,
+        DONE,           // response complete; see status()
+        FAILED,         // see error()
+    };
+
+    enum Error : uint8_t {
+        ERR_NONE,
+        ERR_URL,
+        ERR_DNS,
+        ERR_SOCKET,
+        ERR_CONNECT,
+        ERR_SEND,
+        ERR_TIMEOUT,
+        ERR_CLOSED,     // peer closed before the body was complete
+        ERR_PROTOCOL,
+        ERR_SINK,       // sink refused the body
+    };
+
+    // Receives 2xx body bytes in arrival order; return false to abort
+    using BodySink = bool (*)(void* ctx, const uint8_t* data, size_t len);
+
+    // Receives each response header (any status), same ctx as the body sink
+    using HeaderSink = void (*)(void* ctx, const char* name, const char* value);
+
+    HttpFetch() = default;
+    ~HttpFetch() { disconnect(); }
+    HttpFetch(const HttpFetch&) = delete;
+    HttpFetch& operator=(const HttpFetch&) = delete;
+
+    // http://host[:port]/path
+    bool setUrl(const char* url);
+    // Whole-request deadline (0 = none) and, for long-lived streams, the
+    // longest gap between received bytes (0 = none); both fail ERR_TIMEOUT
+    void setTimeout(uint32_t ms) { m_timeoutMs = ms; }
+    void setIdleTimeout(uint32_t ms) { m_idleTimeoutMs = ms; }
+    void setKeepAlive(bool on) { m_keepAlive = on; }
+
+    // Per-request extras, applied by the next start(): a query string
+    // (without '?', "" for none) and CRLF-terminated header lines
+    bool setQuery(const char* query);
+    bool setHeaders(const char* lines);
+    // Request body for the next start() (nullptr: none, a GET). Sent as a
+    // POST with Content-Length; the buffer must outlive the request
+    void setBody(const uint8_t* data, size_t len) { m_body = data; m_bodyLen = data ? len : 0; }
+    void setHeaderSink(HeaderSink sink) { m_headerSink = sink; }
+
+    // Starts a request (aborting any in flight); false if no URL is set
+    bool  start(uint32_t now, BodySink sink, void* ctx);
+    State poll(uint32_t now);
+
+    // abort() cancels a request in flight, back to IDLE; a kept-alive
+    // connection from a finished one stays open. disconnect() closes that
+    // too; closeIdle() does once it has been idle for IDLE_MS
+    void  abort();
+    void  disconnect();
+    void  closeIdle(uint32_t now);
+
+    bool  busy() const { return m_state != IDLE && m_state != DONE && m_state != FAILED; }
+    State state() const { return m_state; }
+    Error error() const { return m_error; }
+    int   status() const { return m_status; }
+    uint32_t bodyBytes() const { return m_bodyBytes; }
+    uint32_t elapsedMs(uint32_t now) const { return now - m_startMs; }
+    bool  reused() const { return m_reused; }       // request went on a kept connection
+    bool  connected() const { return m_fd >= 0; }
+
+    // Since construction
+    uint32_t connects() const { return m_connects; }    // TCP handshakes
+    uint32_t reuses() const   { return m_reuses; }
+    uint32_t lookups() const  { return m_lookups; }     // DNS queries
+    uint32_t retries() const  { return m_retries; }     // stale kept connections
+
+    static const char* errorName(Error e);
+
+private:
+    enum Framing : uint8_t { FRAME_LENGTH, FRAME_CHUNKED, FRAME_CLOSE };
+    enum ChunkState : uint8_t { CHUNK_SIZE, CHUNK_DATA, CHUNK_DATA_END, CHUNK_TRAILER };
+
+    State fail(Error e);
+    State finish();
+    void  closeSocket();
+    bool  openSocket(uint32_t ipv4);
+    bool  reuseSocket();
+    bool  retryFresh();
+    void  buildRequest();
+    bool  readSome(uint32_t now);
+    bool  consume(const uint8_t* data, size_t len);
+    bool  headerLine();
+    bool  body(const uint8_t* data, size_t len);
+    bool  chunked(const uint8_t* data, size_t len);
+
+    char     m_host[HOST_LEN] = {0};
+    char     m_path[PATH_LEN] = {0};
+    char     m_query[QUERY_LEN] = {0};
+    char     m_headers[HEADERS_LEN] = {0};
+    uint16_t m_port      = 80;
+    uint32_t m_timeoutMs = TIMEOUT_MS;
+    uint32_t m_idleTimeoutMs = 0;
+    bool     m_keepAlive = false;
+
+    BodySink m_sink      = nullptr;
+    HeaderSink m_headerSink = nullptr;
+    void*    m_ctx       = nullptr;
+    int      m_fd        = -1;
+    State    m_state     = IDLE;
+    Error    m_error     = ERR_NONE;
+    uint32_t m_startMs   = 0;
+    uint32_t m_rxMs      = 0;       // last byte received (or start)
+
+    bool     m_reused    = false;
+    bool     m_reusable  = false;   // response allows keeping the socket
+    uint32_t m_idleMs    = 0;       // kept socket idle since
+    uint32_t m_addr      = 0;       // cached IPv4, network order; 0 = none
+    uint32_t m_addrMs    = 0;
+    uint32_t m_connects  = 0;
+    uint32_t m_reuses    = 0;
+    uint32_t m_lookups   = 0;
+    uint32_t m_retries   = 0;
+
+    char     m_req[HOST_LEN + PATH_LEN + QUERY_LEN + HEADERS_LEN + 128];
+    size_t   m_reqLen    = 0;
+    size_t   m_reqSent   = 0;
+    const uint8_t* m_body = nullptr;
+    size_t   m_bodyLen   = 0;
+    size_t   m_bodySent  = 0;
+
+    char     m_line[LINE_LEN];
+    size_t   m_lineLen   = 0;
+    bool     m_statusSeen = false;
+    int      m_status    = 0;
+
+    Framing    m_framing    = FRAME_CLOSE;
+    ChunkState m_chunkState = CHUNK_SIZE;
+    uint32_t   m_remaining  = 0;        // Content-Length or current chunk left
+    uint32_t   m_bodyBytes  = 0;
+};
@@ -0,0 +1,77 @@
+#include "metrics_export.h"
+
+// ==========================================================================
+// Metrics Export -- MetricsServer glue: link gating, scrape-time gauges
+// ==========================================================================
+
+#if FEATURE_METRICS
+
+#include "metrics_server.h"
+#include "wifi_manager.h"
+#include <Arduino.h>
+#include <WiFi.h>
+
+static MetricsServer s_server;
+static const PetState*         s_pet   = nullptr;
+static const RadioEnvironment* s_radio = nullptr;
+
+static void collect(void*) {
+    Metrics::set(Metrics::HEAP_FREE_BYTES, ESP.getFreeHeap());
+    Metrics::set(Metrics::HEAP_MIN_FREE_BYTES, ESP.getMinFreeHeap());
+    Metrics::set(Metrics::UPTIME_SECONDS, millis() / 1000);
+    if (s_radio) {
+        const RadioEnvironment& r = *s_radio;
+        Metrics::set(Metrics::BLE_DEVICES, r.bleDeviceCount);
+        Metrics::set(Metrics::BLE_SCANNERS, r.bleScannerCount);
+        Metrics::set(Metrics::PROBE_REQUESTS, r.probeCount);
+        Metrics::set(Metrics::PROBERS, r.uniqueProbers);
+        Metrics::set(Metrics::DEAUTHS, r.deauthCount);
+        Metrics::set(Metrics::THREATS, r.threatCount);
+        Metrics::set(Metrics::SAFETY_SCORE, r.safetyScore);
+    }
+    if (s_pet) {
+        const PetState& p = *s_pet;
+        Metrics::set(Metrics::PET_HUNGER, p.hunger);
+        Metrics::set(Metrics::PET_HAPPINESS, p.happiness);
+        Metrics::set(Metrics::PET_HEALTH, p.health);
+        Metrics::set(Metrics::PET_AGE_MINUTES, p.ageDays * 1440 + p.ageHours * 60 + p.ageMinutes);
+        Metrics::set(Metrics::PET_ALIVE, p.alive ? 1 : 0);
+    }
+}
+
+void MetricsExport::tick(unsigned long now, const PetState& pet, const RadioEnvironment& radio) {
+    s_pet   = &pet;
+    s_radio = &radio;
+    if (!s_server.listening()) {
+        if (!WifiManager::isConnected()) return;
+        if (!s_server.begin(METRICS_PORT)) {
+            Serial.printf("[metrics] can't listen on port %u\n", (unsigned)METRICS_PORT);
+            return;
+        }
+        s_server.setCollector(collect, nullptr);
+        IPAddress ip = WiFi.localIP();
+        Serial.printf("[metrics] serving http://%u.%u.%u.%u:%u/metrics\n",
+                      ip[0], ip[1], ip[2], ip[3], (unsigned)s_server.port());
+    }
+    s_server.poll(now);
+}
+
+void MetricsExport::printStats() {
+    const MetricsServer::Stats& st = s_server.stats();
+    Serial.printf("[metrics] port %u %s: %lu scrapes (%lu complete), %lu other requests, "
+                  "%lu timeouts, %lu refused, %lu bytes\n",
+                  (unsigned)METRICS_PORT, s_server.listening() ? "listening" : "not listening",
+                  (unsigned long)st.scrapes, (unsigned long)st.completed,
+                  (unsigned long)st.notFound, (unsigned long)st.timeouts,
+                  (unsigned long)st.refused, (unsigned long)st.bytes);
+}
+
+#else
+
+// -- Stubs when metrics disabled -------------------------------------------
+#include <Arduino.h>
+
+void MetricsExport::tick(unsigned long, const PetState&, const RadioEnvironment&) {}
+void MetricsExport::printStats() { Serial.println("[metrics] disabled"); }
+
+#endif
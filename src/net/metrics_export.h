@@ -0,0 +1,20 @@
+#pragma once
+#include "config.h"
+#include "types.h"
+
+// ==========================================================================
+// Metrics Export -- Serves the Metrics registry at :METRICS_PORT/metrics
+// The server starts listening the first time the STA link is up and is
+// polled from the loop's network ticks. Gauges that only matter when
+// someone looks (heap, uptime, radio environment, pet stats) are copied
+// in at the start of each scrape; everything else is updated in place by
+// the module that owns it.
+// Compiles to no-op when FEATURE_METRICS == 0
+// ==========================================================================
+
+namespace MetricsExport {
+
+void tick(unsigned long now, const PetState& pet, const RadioEnvironment& radio);
+void printStats();
+
+}  // namespace MetricsExport
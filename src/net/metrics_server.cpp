@@ -0,0 +1,197 @@
+#include "metrics_server.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+
+#if defined(ARDUINO)
+#include <lwip/sockets.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0          // lwIP never raises SIGPIPE
+#endif
+
+// ==========================================================================
+// Metrics Server -- accept -> read request -> send, one poll() at a time
+// The request is only read as far as its first line; anything after it is
+// drained and dropped while the response goes out, so closing the socket
+// never resets a connection with unread bytes in it (which could cost the
+// scraper the tail of the response).
+// ==========================================================================
+
+static const char OK_HEAD[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Connection: close\r\n\r\n";
+static const char NOT_FOUND[] =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\nContent-Length: 10\r\nConnection: close\r\n\r\n"
+    "not found\n";
+static const char NOT_ALLOWED[] =
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+bool MetricsServer::begin(uint16_t port) {
+    stop();
+    m_listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenFd < 0) return false;
+    int on = 1;
+    setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    socklen_t len = sizeof(addr);
+    if (bind(m_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(m_listenFd, CLIENTS) != 0 ||
+        getsockname(m_listenFd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        stop();
+        return false;
+    }
+    setNonBlocking(m_listenFd);
+    m_port = ntohs(addr.sin_port);
+    return true;
+}
+
+void MetricsServer::stop() {
+    for (Client& c : m_clients) close(c);
+    if (m_listenFd >= 0) ::close(m_listenFd);
+    m_listenFd = -1;
+    m_port     = 0;
+}
+
+int MetricsServer::active() const {
+    int n = 0;
+    for (const Client& c : m_clients) n += c.phase != FREE;
+    return n;
+}
+
+void MetricsServer::poll(uint32_t now) {
+    if (m_listenFd < 0) return;
+    accept(now);
+    for (Client& c : m_clients) {
+        if (c.phase == READING) readRequest(c, now);
+        if (c.phase == SENDING) sendSome(c, now);
+        if (c.phase != FREE && now - c.lastMs > CLIENT_TIMEOUT_MS) {
+            m_stats.timeouts++;
+            close(c);
+        }
+    }
+}
+
+void MetricsServer::accept(uint32_t now) {
+    int fd = ::accept(m_listenFd, nullptr, nullptr);
+    if (fd < 0) return;                 // EAGAIN: nobody waiting
+    for (Client& c : m_clients) {
+        if (c.phase != FREE) continue;
+        setNonBlocking(fd);
+        c.fd         = fd;
+        c.phase      = READING;
+        c.lastMs     = now;
+        c.requestLen = 0;
+        c.outLen     = 0;
+        c.outPos     = 0;
+        c.metrics    = false;
+        m_stats.accepted++;
+        return;
+    }
+    m_stats.refused++;
+    ::close(fd);
+}
+
+void MetricsServer::readRequest(Client& c, uint32_t now) {
+    ssize_t n = recv(c.fd, c.request + c.requestLen, REQUEST_LEN - c.requestLen, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        close(c);
+        return;
+    }
+    if (n < 0) return;
+    c.requestLen += n;
+    c.lastMs = now;
+    c.request[c.requestLen] = '\0';
+    if (!strchr(c.request, '\n')) {
+        if (c.requestLen == REQUEST_LEN) close(c);  // no request line fits
+        return;
+    }
+    respond(c);
+}
+
+void MetricsServer::respond(Client& c) {
+    // "GET /metrics HTTP/1.1": method, then the path up to ' ' or '?'
+    char* path = strchr(c.request, ' ');
+    bool  get  = path && path - c.request == 3 && memcmp(c.request, "GET", 3) == 0;
+    size_t pathLen = 0;
+    if (path) {
+        path++;
+        pathLen = strcspn(path, " ?\r\n");
+    }
+
+    const char* head;
+    if (!get) {
+        head = NOT_ALLOWED;
+        m_stats.notFound++;
+    } else if (pathLen == 8 && memcmp(path, "/metrics", 8) == 0) {
+        head = OK_HEAD;
+        if (m_collect) m_collect(m_collectCtx);
+        Metrics::inc(Metrics::SCRAPES);
+        c.metrics = true;
+        c.cursor  = Metrics::Cursor();
+        m_stats.scrapes++;
+    } else {
+        head = NOT_FOUND;
+        m_stats.notFound++;
+    }
+    size_t len = strlen(head);
+    memcpy(c.out, head, len);
+    c.outLen = len;
+    c.outPos = 0;
+    c.phase  = SENDING;
+}
+
+void MetricsServer::sendSome(Client& c, uint32_t now) {
+    // Whatever else the client sent (headers, a body) is not needed
+    char discard[64];
+    for (int i = 0; i < 4 && recv(c.fd, discard, sizeof(discard), 0) > 0; i++) {}
+
+    size_t budget = SEND_BUDGET;
+    while (budget > 0) {
+        if (c.outPos == c.outLen) {
+            c.outLen = c.metrics && !c.cursor.done() ? Metrics::render(c.cursor, c.out, OUT_LEN) : 0;
+            c.outPos = 0;
+            if (c.outLen == 0) {
+                if (c.metrics) m_stats.completed++;
+                close(c);
+                return;
+            }
+        }
+        size_t want = c.outLen - c.outPos;
+        if (want > budget) want = budget;
+        ssize_t n = send(c.fd, c.out + c.outPos, want, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) close(c);
+            return;
+        }
+        c.outPos += n;
+        c.lastMs  = now;
+        budget   -= n;
+        m_stats.bytes += n;
+    }
+}
+
+void MetricsServer::close(Client& c) {
+    if (c.fd >= 0) ::close(c.fd);
+    c.fd    = -1;
+    c.phase = FREE;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "../sys/metrics.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Metrics Server -- GET /metrics over plain HTTP, polled from loop()
+// Platform-neutral (BSD sockets; lwIP on device, POSIX on the host, where
+// tools/metrics_bench/ scrapes it over loopback). Non-blocking like
+// HttpFetch: each poll() accepts at most one connection, reads what has
+// arrived and sends at most SEND_BUDGET bytes, rendering the registry a
+// buffer at a time as the socket drains. A slow scraper only makes the
+// scrape take longer; a silent one is dropped after CLIENT_TIMEOUT_MS.
+// One response per connection (Connection: close, no Content-Length).
+// ==========================================================================
+
+class MetricsServer {
+public:
+    static constexpr int      CLIENTS     = 2;
+    static constexpr size_t   REQUEST_LEN = 128;    // request line + headers we look at
+    static constexpr size_t   OUT_LEN     = 512;    // >= Metrics::LINE_MAX
+    static constexpr size_t   SEND_BUDGET = 2048;   // bytes per poll()
+    static constexpr uint32_t CLIENT_TIMEOUT_MS = 3000;
+
+    // Called when a /metrics request is accepted, before anything is
+    // rendered: the place to refresh gauges that are only read on scrape
+    using Collector = void (*)(void* ctx);
+
+    struct Stats {
+        uint32_t accepted  = 0;
+        uint32_t scrapes   = 0;     // 200s started
+        uint32_t completed = 0;     // ... and fully sent
+        uint32_t notFound  = 0;     // 404 / 405
+        uint32_t timeouts  = 0;
+        uint32_t refused   = 0;     // every client slot busy
+        uint32_t bytes     = 0;
+    };
+
+    MetricsServer() = default;
+    ~MetricsServer() { stop(); }
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listens on all interfaces; port 0 picks a free one (see port())
+    bool begin(uint16_t port);
+    void stop();
+    void poll(uint32_t now);
+
+    void setCollector(Collector fn, void* ctx) { m_collect = fn; m_collectCtx = ctx; }
+
+    bool     listening() const { return m_listenFd >= 0; }
+    uint16_t port() const { return m_port; }
+    int      active() const;    // connections open
+    const Stats& stats() const { return m_stats; }
+
+private:
+    enum Phase : uint8_t { FREE, READING, SENDING };
+
+    struct Client {
+        int      fd    = -1;
+        Phase    phase = FREE;
+        uint32_t lastMs = 0;        // last progress, for the timeout
+        char     request[REQUEST_LEN + 1];
+        uint16_t requestLen = 0;
+        bool     metrics = false;   // body is the registry, else `out` is all
+        Metrics::Cursor cursor;
+        char     out[OUT_LEN];
+        uint16_t outLen = 0;
+        uint16_t outPos = 0;
+    };
+
+    void accept(uint32_t now);
+    void readRequest(Client& c, uint32_t now);
+    void respond(Client& c);
+    void sendSome(Client& c, uint32_t now);
+    void close(Client& c);
+
+    int       m_listenFd = -1;
+    uint16_t  m_port     = 0;
+    Client    m_clients[CLIENTS];
+    Collector m_collect    = nullptr;
+    void*     m_collectCtx = nullptr;
+    Stats     m_stats;
+};
@@ -0,0 +1,89 @@
+#include "net_resolve.h"
+#include <lwip/dns.h>
+#include <lwip/inet.h>
+#include <lwip/priv/tcpip_priv.h>
+#include <cstring>
+
+// ==========================================================================
+// Net Resolve -- lwIP dns_gethostbyname on the tcpip thread
+// The query is started through tcpip_api_call (lwIP core isn't locked for
+// us); the answer arrives in dnsFound on the tcpip thread. A generation
+// number drops answers for a lookup that was cancelled or replaced.
+// ==========================================================================
+
+enum LookupState : uint8_t { LOOKUP_IDLE, LOOKUP_PENDING, LOOKUP_OK, LOOKUP_FAILED };
+
+static volatile uint8_t  s_state = LOOKUP_IDLE;
+static volatile uint32_t s_addr  = 0;
+static volatile uint32_t s_gen   = 0;
+static char s_host[64] = {0};
+
+struct DnsCall {
+    struct tcpip_api_call_data call;
+    const char* host;
+    ip_addr_t   addr;
+    err_t       err;
+    uint32_t    gen;
+};
+
+static void dnsFound(const char*, const ip_addr_t* ip, void* arg) {
+    if (reinterpret_cast<uintptr_t>(arg) != s_gen) return;
+    if (ip && IP_IS_V4(ip)) {
+        s_addr  = ip_2_ip4(ip)->addr;
+        s_state = LOOKUP_OK;
+    } else {
+        s_state = LOOKUP_FAILED;
+    }
+}
+
+static err_t dnsStart(struct tcpip_api_call_data* c) {
+    DnsCall* d = reinterpret_cast<DnsCall*>(c);
+    d->err = dns_gethostbyname_addrtype(d->host, &d->addr, dnsFound,
+                                        reinterpret_cast<void*>(static_cast<uintptr_t>(d->gen)),
+                                        LWIP_DNS_ADDRTYPE_IPV4);
+    return ERR_OK;
+}
+
+NetResolve::Result NetResolve::lookup(const char* host, uint32_t& ipv4) {
+    // New host (or first call): numeric shortcut, else start a query
+    if (s_state == LOOKUP_IDLE || strcmp(host, s_host) != 0) {
+        cancel();
+        strncpy(s_host, host, sizeof(s_host) - 1);
+        s_host[sizeof(s_host) - 1] = '\0';
+
+        ip4_addr_t numeric;
+        if (ip4addr_aton(host, &numeric)) {
+            s_addr  = numeric.addr;
+            s_state = LOOKUP_OK;
+        } else {
+            DnsCall d = {};
+            d.host = s_host;
+            d.gen  = s_gen;
+            s_state = LOOKUP_PENDING;
+            tcpip_api_call(dnsStart, &d.call);
+            if (d.err == ERR_OK) {                  // answered from the cache
+                s_addr  = ip_2_ip4(&d.addr)->addr;
+                s_state = LOOKUP_OK;
+            } else if (d.err != ERR_INPROGRESS) {
+                s_state = LOOKUP_FAILED;
+            }
+        }
+    }
+
+    switch (s_state) {
+        case LOOKUP_OK:
+            ipv4 = s_addr;
+            s_state = LOOKUP_IDLE;                  // next call looks up afresh
+            return RESOLVE_OK;
+        case LOOKUP_FAILED:
+            s_state = LOOKUP_IDLE;
+            return RESOLVE_FAILED;
+        default:
+            return RESOLVE_PENDING;
+    }
+}
+
+void NetResolve::cancel() {
+    s_gen   = s_gen + 1;
+    s_state = LOOKUP_IDLE;
+}
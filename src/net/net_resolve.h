@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+// ==========================================================================
+// Net Resolve -- Non-blocking IPv4 host lookup
+// lookup() starts a query on the first call and reports PENDING until the
+// answer (or failure) is in; call it again each tick with the same host.
+// Dotted-quad hosts resolve immediately. One lookup in flight at a time.
+// Device: lwIP DNS callback (net_resolve.cpp); host: getaddrinfo
+// (tools/host/net_resolve_host.cpp).
+// ==========================================================================
+
+namespace NetResolve {
+
+enum Result : uint8_t {
+    RESOLVE_PENDING,
+    RESOLVE_OK,
+    RESOLVE_FAILED,
+};
+
+// ipv4 is in network byte order (ready for sockaddr_in::sin_addr)
+Result lookup(const char* host, uint32_t& ipv4);
+void   cancel();
+
+}  // namespace NetResolve
@@ -0,0 +1,70 @@
+#include "poll_scheduler.h"
+
+// ==========================================================================
+// Poll Scheduler -- interval from context, jittered exponential backoff
+// ==========================================================================
+
+static constexpr float   CHANGE_ALPHA  = 0.25f;     // EWMA weight of a poll
+static constexpr uint8_t FAILURES_MAX  = 16;        // doubling stops well before
+
+uint32_t PollScheduler::interval(const Inputs& in) const {
+    float ms = static_cast<float>(m_baseMs);
+
+    switch (in.zone) {
+        case LOC_WORK:   ms *= 2.0f;        break;
+        case LOC_TRAVEL: ms /= 3.0f;        break;
+        default:                            break;
+    }
+    switch (in.tier) {
+        case TIER_YELLOW: ms *= 0.75f;      break;
+        case TIER_RED:
+        case TIER_BLACK:  ms *= 0.5f;       break;
+        default:                            break;
+    }
+    if (in.displayAsleep)                   ms *= 4.0f;
+    else if (in.screen == SCREEN_DASHBOARD) ms *= 0.5f;
+
+    if (in.batteryPct >= 0 && in.batteryPct <= 10)      ms *= 4.0f;
+    else if (in.batteryPct >= 0 && in.batteryPct <= 25) ms *= 2.0f;
+
+    ms *= 1.5f - m_changeRate;
+
+    if (ms < MIN_MS) return MIN_MS;
+    if (ms > MAX_MS) return MAX_MS;
+    return static_cast<uint32_t>(ms);
+}
+
+uint32_t PollScheduler::waitMs(uint32_t now, const Inputs& in) const {
+    if (m_forced) return 0;
+    uint32_t wait    = m_failures ? m_backoffMs : interval(in);
+    uint32_t elapsed = now - m_lastMs;
+    return elapsed >= wait ? 0 : wait - elapsed;
+}
+
+void PollScheduler::started(uint32_t now) {
+    m_lastMs = now;
+    m_forced = false;
+}
+
+void PollScheduler::succeeded(bool changed) {
+    m_failures   = 0;
+    m_backoffMs  = 0;
+    m_changeRate += ((changed ? 1.0f : 0.0f) - m_changeRate) * CHANGE_ALPHA;
+}
+
+void PollScheduler::failed(const Inputs& in) {
+    if (m_failures < FAILURES_MAX) m_failures++;
+    uint32_t cap  = BACKOFF_MAX_MS;
+    uint32_t wait = interval(in);
+    for (uint8_t i = 0; i < m_failures && wait < cap; i++) wait *= 2;
+    if (wait > cap) wait = cap;
+    m_backoffMs = wait / 2 + nextRandom() % (wait / 2 + 1);
+}
+
+// xorshift32, as in PetLogic: cheap and deterministic for a given seed
+uint32_t PollScheduler::nextRandom() {
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 17;
+    m_rng ^= m_rng << 5;
+    return m_rng;
+}
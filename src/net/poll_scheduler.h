@@ -0,0 +1,64 @@
+#pragma once
+#include "types.h"
+#include <cstdint>
+
+// ==========================================================================
+// Poll Scheduler -- When to poll Cosmania next
+// Platform-neutral (tools/net_bench/ replays a day of scenarios through
+// it). The interval starts from the configured base and is scaled by
+// context, the way the zones in types.h describe:
+//   zone       HOME x1, WORK x2, TRAVEL x1/3, UNKNOWN x1
+//   tier       YELLOW x3/4, RED / BLACK x1/2 (spend is moving)
+//   screen     DASHBOARD x1/2, display asleep x4
+//   battery    <= 25% x2, <= 10% x4
+//   changes    x1/2 .. x3/2 as the recent share of polls that changed
+//              anything goes from all to none
+// and clamped to [MIN_MS, MAX_MS]. Failures back off exponentially from
+// the current interval with equal jitter (half fixed, half random), so a
+// server coming back is not met by every device at once.
+// ==========================================================================
+
+class PollScheduler {
+public:
+    static constexpr uint32_t MIN_MS         = 5000;
+    static constexpr uint32_t MAX_MS         = 10UL * 60 * 1000;
+    static constexpr uint32_t BACKOFF_MAX_MS = 15UL * 60 * 1000;
+
+    struct Inputs {
+        LocationZone zone          = LOC_HOME;
+        BudgetTier   tier          = TIER_UNKNOWN;
+        Screen       screen        = SCREEN_HOME;
+        bool         displayAsleep = false;
+        int          batteryPct    = -1;    // -1 = unknown / on USB
+    };
+
+    void setBase(uint32_t ms) { m_baseMs = ms; }
+    void seed(uint32_t value) { m_rng = value ? value : 0x9E3779B9u; }
+
+    // Interval for this context, without backoff
+    uint32_t interval(const Inputs& in) const;
+
+    // Milliseconds until the next poll is due (0 = now)
+    uint32_t waitMs(uint32_t now, const Inputs& in) const;
+    bool     due(uint32_t now, const Inputs& in) const { return waitMs(now, in) == 0; }
+
+    void started(uint32_t now);
+    void succeeded(bool changed);
+    void failed(const Inputs& in);
+    void pollNow() { m_forced = true; }
+
+    uint8_t  failures() const   { return m_failures; }
+    uint32_t backoffMs() const  { return m_backoffMs; }
+    float    changeRate() const { return m_changeRate; }
+
+private:
+    uint32_t nextRandom();
+
+    uint32_t m_baseMs     = 30000;
+    uint32_t m_lastMs     = 0;          // start of the last poll
+    uint32_t m_backoffMs  = 0;          // wait after the last failure
+    uint32_t m_rng        = 0x9E3779B9u;
+    float    m_changeRate = 0.5f;       // EWMA of "poll changed something"
+    uint8_t  m_failures   = 0;
+    bool     m_forced     = true;       // first poll is due at once
+};
@@ -0,0 +1,626 @@
+#include "status_parser.h"
+#include <cstdlib>
+#include <cstring>
+
+// ==========================================================================
+// Status Parser -- a lexer per format + a role per open container
+// The lexer validates the whole document; the roles decide what is kept:
+//   root object      budgetTier, totalDailyBudget, totalDailySpend,
+//                    cursor, delta
+//   root.agents[]    first 7 objects -> staged AgentInfo slots
+//   root.removed[]   names dropped from the status
+//   root.recentErrors[]  elements counted
+// Agents are staged and applied when the root object closes, once it is
+// known whether they replace the list or update it. In a full body,
+// missing or mistyped fields fall back to the AgentInfo / CosmaniaStatus
+// defaults; in a delta they keep the previous value.
+//
+// The MessagePack lexer keeps a count of items left per container in
+// place of JSON's brackets: a container closes when its last item does.
+// Map keys that are not strings are read and ignored, like unknown keys;
+// bin and ext values are skipped without being stored.
+// ==========================================================================
+
+static constexpr int AGENT_SLOTS = StatusParser::AGENT_SLOTS;
+
+struct KeyName {
+    const char* name;
+    uint8_t     field;
+};
+
+// -- Budget tier string -> enum -------------------------------------------
+static BudgetTier parseTier(const char* str) {
+    if (strcmp(str, "GREEN")  == 0) return TIER_GREEN;
+    if (strcmp(str, "YELLOW") == 0) return TIER_YELLOW;
+    if (strcmp(str, "RED")    == 0) return TIER_RED;
+    if (strcmp(str, "BLACK")  == 0) return TIER_BLACK;
+    return TIER_UNKNOWN;
+}
+
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Agent names are kept to the width of AgentInfo::name
+static void copyName(char (&dst)[sizeof(AgentInfo::name)], const char* src, size_t len) {
+    size_t n = len < sizeof(dst) - 1 ? len : sizeof(dst) - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void StatusParser::begin(CosmaniaStatus& out, Format format) {
+    m_out = &out;
+    m_stagedCount = 0;
+    m_present     = 0;
+    m_delta       = false;
+    m_cursor[0]   = '\0';
+
+    m_depth    = 0;
+    m_field    = F_NONE;
+    m_tokenLen = 0;
+    setFormat(format);
+}
+
+void StatusParser::setFormat(Format format) {
+    m_format = format;
+    m_lex    = format == MSGPACK ? M_HEAD : L_VALUE;
+}
+
+bool StatusParser::feed(const uint8_t* data, size_t len) {
+    if (m_lex == L_ERROR) return false;
+    if (m_format == MSGPACK) return feedPack(data, len);
+    for (size_t i = 0; i < len; i++) {
+        if (!step(static_cast<char>(data[i]))) return false;
+    }
+    return true;
+}
+
+bool StatusParser::fail() {
+    m_lex = L_ERROR;
+    return false;
+}
+
+void StatusParser::tokenChar(char c) {
+    if (m_tokenLen < TOKEN_MAX) m_token[m_tokenLen++] = c;
+}
+
+// -- JSON ------------------------------------------------------------------
+
+bool StatusParser::step(char c) {
+    switch (m_lex) {
+        case L_STRING:
+            if (c == '"') {
+                m_token[m_tokenLen] = '\0';
+                if (m_isKey) {
+                    keyDone();
+                    m_lex = L_COLON;
+                } else {
+                    stringDone();
+                    m_lex = L_AFTER_VALUE;
+                }
+                return true;
+            }
+            if (c == '\\') {
+                m_lex = L_STRING_ESC;
+                return true;
+            }
+            if (static_cast<uint8_t>(c) < 0x20) return fail();
+            tokenChar(c);
+            return true;
+
+        case L_STRING_ESC:
+            switch (c) {
+                case '"': case '\\': case '/': tokenChar(c); break;
+                case 'b': tokenChar('\b'); break;
+                case 'f': tokenChar('\f'); break;
+                case 'n': tokenChar('\n'); break;
+                case 'r': tokenChar('\r'); break;
+                case 't': tokenChar('\t'); break;
+                case 'u':
+                    m_hex     = 0;
+                    m_hexLeft = 4;
+                    m_lex     = L_STRING_HEX;
+                    return true;
+                default:
+                    return fail();
+            }
+            m_lex = L_STRING;
+            return true;
+
+        case L_STRING_HEX: {
+            int v = hexValue(c);
+            if (v < 0) return fail();
+            m_hex = static_cast<uint16_t>(m_hex << 4 | v);
+            if (--m_hexLeft == 0) {
+                // ASCII only: agent names and tiers never need more
+                tokenChar(m_hex < 0x80 ? static_cast<char>(m_hex) : '?');
+                m_lex = L_STRING;
+            }
+            return true;
+        }
+
+        case L_LITERAL:
+            if (isDigit(c) || (c >= 'a' && c <= 'z') || c == '.' || c == '+' || c == '-' ||
+                c == 'E') {
+                tokenChar(c);
+                return true;
+            }
+            m_token[m_tokenLen] = '\0';
+            m_lex = L_AFTER_VALUE;
+            literalDone();
+            if (m_lex == L_ERROR) return false;
+            break;                  // the delimiter is handled below
+
+        default:
+            break;
+    }
+
+    if (isSpace(c)) return true;
+
+    switch (m_lex) {
+        case L_VALUE_OR_END:
+            if (c == ']') return endContainer(false);
+            // fall through
+        case L_VALUE:
+            if (c == '{') return beginContainer(true);
+            if (c == '[') return beginContainer(false);
+            if (m_depth == 0) return fail();        // root must be an object
+            if (c == '"') {
+                valueStarted();
+                m_isKey    = false;
+                m_tokenLen = 0;
+                m_lex      = L_STRING;
+                return true;
+            }
+            if (c == '-' || isDigit(c) || c == 't' || c == 'f' || c == 'n') {
+                valueStarted();
+                m_tokenLen = 0;
+                tokenChar(c);
+                m_lex = L_LITERAL;
+                return true;
+            }
+            return fail();
+
+        case L_KEY_OR_END:
+            if (c == '}') return endContainer(true);
+            // fall through
+        case L_KEY:
+            if (c != '"') return fail();
+            m_isKey    = true;
+            m_tokenLen = 0;
+            m_lex      = L_STRING;
+            return true;
+
+        case L_COLON:
+            if (c != ':') return fail();
+            m_lex = L_VALUE;
+            return true;
+
+        case L_AFTER_VALUE:
+            if (c == ',') {
+                m_lex = m_stack[m_depth - 1].object ? L_KEY : L_VALUE;
+                return true;
+            }
+            if (c == '}') return endContainer(true);
+            if (c == ']') return endContainer(false);
+            return fail();
+
+        case L_DONE:
+            return true;            // trailing bytes are ignored
+
+        default:
+            return fail();
+    }
+}
+
+bool StatusParser::beginContainer(bool object) {
+    if (!openContainer(object, 0)) return false;
+    m_lex = object ? L_KEY_OR_END : L_VALUE_OR_END;
+    return true;
+}
+
+bool StatusParser::endContainer(bool object) {
+    if (m_depth == 0 || m_stack[m_depth - 1].object != object) return fail();
+    closeContainer();
+    m_lex = m_depth == 0 ? L_DONE : L_AFTER_VALUE;
+    return true;
+}
+
+void StatusParser::literalDone() {
+    Scalar kind  = S_NUMBER;
+    float number = 0.0f;
+    if (strcmp(m_token, "true") == 0) {
+        kind = S_TRUE;
+    } else if (strcmp(m_token, "false") == 0) {
+        kind = S_FALSE;
+    } else if (strcmp(m_token, "null") == 0) {
+        kind = S_NULL;
+    } else {
+        char* end;
+        number = strtof(m_token, &end);
+        if (end == m_token || *end != '\0') {
+            fail();
+            return;
+        }
+    }
+    scalarDone(kind, number);
+}
+
+// -- MessagePack -----------------------------------------------------------
+
+bool StatusParser::feedPack(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (m_lex == M_STR || m_lex == M_SKIP) {
+            // Payload runs: taken whole, not a byte per step
+            size_t n = len - i < m_left ? len - i : m_left;
+            if (m_lex == M_STR) {
+                for (size_t k = 0; k < n; k++) tokenChar(static_cast<char>(data[i + k]));
+            }
+            i      += n;
+            m_left -= n;
+            if (m_left > 0) continue;
+            if (m_lex == M_STR) {
+                m_token[m_tokenLen] = '\0';
+                if (m_isKey) keyDone();
+                else         stringDone();
+            }
+            if (!packItemDone()) return false;
+            continue;
+        }
+
+        uint8_t b = data[i++];
+        bool ok;
+        switch (m_lex) {
+            case M_HEAD:
+                ok = packHead(b);
+                break;
+            case M_ARG:
+                m_arg = m_arg << 8 | b;
+                ok = --m_argLeft > 0 || packArg();
+                break;
+            case L_DONE:
+                ok = true;          // trailing bytes are ignored
+                break;
+            default:
+                ok = fail();
+                break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// Bytes of length / value after types 0xC4..0xDF (0: fixext, taken whole)
+static const uint8_t PACK_ARG_BYTES[] = {
+    1, 2, 4,            // bin 8/16/32
+    1, 2, 4,            // ext 8/16/32
+    4, 8,               // float 32/64
+    1, 2, 4, 8,         // uint 8..64
+    1, 2, 4, 8,         // int 8..64
+    0, 0, 0, 0, 0,      // fixext 1..16
+    1, 2, 4,            // str 8/16/32
+    2, 4,               // array 16/32
+    2, 4,               // map 16/32
+};
+
+bool StatusParser::packHead(uint8_t b) {
+    bool map = (b & 0xF0) == 0x80 || b == 0xDE || b == 0xDF;
+    if (m_depth == 0 && !map) return fail();            // root must be a map
+    const Frame* top = m_depth ? &m_stack[m_depth - 1] : nullptr;
+    m_isKey = top && top->object && top->items % 2 == 0;
+
+    if (b <= 0x7F) return packScalar(S_NUMBER, b);
+    if (b >= 0xE0) return packScalar(S_NUMBER, static_cast<int8_t>(b));
+    if (b <= 0x8F) return packContainer(true, b & 0x0F);
+    if (b <= 0x9F) return packContainer(false, b & 0x0F);
+    if (b <= 0xBF) return packString(b & 0x1F);
+    switch (b) {
+        case 0xC0: return packScalar(S_NULL, 0.0f);
+        case 0xC1: return fail();                       // never used
+        case 0xC2: return packScalar(S_FALSE, 0.0f);
+        case 0xC3: return packScalar(S_TRUE, 0.0f);
+        case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+            return packSkip(1 + (1u << (b - 0xD4)));    // type byte + data
+        default:
+            break;
+    }
+    m_packType = b;
+    m_argLeft  = PACK_ARG_BYTES[b - 0xC4];
+    m_arg      = 0;
+    m_lex      = M_ARG;
+    return true;
+}
+
+// The bytes after m_packType are in: big-endian in m_arg
+bool StatusParser::packArg() {
+    uint8_t  b     = m_packType;
+    uint32_t arg32 = static_cast<uint32_t>(m_arg);
+    if (b <= 0xC6) return packSkip(arg32);
+    if (b <= 0xC9) return arg32 < UINT32_MAX ? packSkip(arg32 + 1) : fail();
+    if (b == 0xCA) {
+        float f;
+        memcpy(&f, &arg32, sizeof(f));
+        return packScalar(S_NUMBER, f);
+    }
+    if (b == 0xCB) {
+        double d;
+        memcpy(&d, &m_arg, sizeof(d));
+        return packScalar(S_NUMBER, static_cast<float>(d));
+    }
+    if (b <= 0xCF) return packScalar(S_NUMBER, static_cast<float>(m_arg));
+    if (b <= 0xD3) {
+        // Sign-extend from the width that was read
+        int bits = 8 << (b - 0xD0);
+        int64_t v = bits == 64 ? static_cast<int64_t>(m_arg)
+                               : static_cast<int64_t>(m_arg << (64 - bits)) >> (64 - bits);
+        return packScalar(S_NUMBER, static_cast<float>(v));
+    }
+    if (b <= 0xDB) return packString(arg32);
+    if (b <= 0xDD) return packContainer(false, arg32);
+    return packContainer(true, arg32);
+}
+
+bool StatusParser::packString(uint32_t len) {
+    if (!m_isKey) valueStarted();
+    m_tokenLen = 0;
+    m_left     = len;
+    m_lex      = M_STR;
+    if (len > 0) return true;
+    m_token[0] = '\0';
+    if (m_isKey) keyDone();
+    else         stringDone();
+    return packItemDone();
+}
+
+bool StatusParser::packSkip(uint32_t len) {
+    if (m_isKey) m_field = F_NONE;
+    else         valueStarted();
+    m_left = len;
+    m_lex  = M_SKIP;
+    return len > 0 || packItemDone();
+}
+
+bool StatusParser::packContainer(bool object, uint32_t count) {
+    if (m_isKey) return fail();                         // keys are scalars
+    if (object && count > UINT32_MAX / 2) return fail();
+    uint32_t items = object ? count * 2 : count;
+    if (!openContainer(object, items)) return false;
+    m_lex = M_HEAD;
+    if (items > 0) return true;
+    closeContainer();
+    return packItemDone();
+}
+
+bool StatusParser::packScalar(Scalar kind, float number) {
+    if (m_isKey) {
+        m_field = F_NONE;                               // not a key we know
+    } else {
+        valueStarted();
+        scalarDone(kind, number);
+    }
+    return packItemDone();
+}
+
+// An item finished: count it off, closing every container it completes
+bool StatusParser::packItemDone() {
+    m_lex = M_HEAD;
+    while (m_depth > 0) {
+        if (--m_stack[m_depth - 1].items > 0) return true;
+        closeContainer();
+    }
+    m_lex = L_DONE;
+    return true;
+}
+
+// -- Containers ------------------------------------------------------------
+
+StatusParser::Role StatusParser::childRole(bool object) const {
+    const Frame& top = m_stack[m_depth - 1];
+    switch (top.role) {
+        case R_ROOT:
+            if (!object && m_field == F_AGENTS) return R_AGENTS;
+            if (!object && m_field == F_ERRORS) return R_ERRORS;
+            if (!object && m_field == F_REMOVED) return R_REMOVED;
+            return R_SKIP;
+        case R_AGENTS:
+            return object && m_stagedCount < AGENT_SLOTS ? R_AGENT : R_SKIP;
+        default:
+            return R_SKIP;
+    }
+}
+
+bool StatusParser::openContainer(bool object, uint32_t items) {
+    Role role = R_ROOT;
+    if (m_depth == 0) {
+        if (!object) return fail();
+    } else {
+        valueStarted();
+        role = childRole(object);
+    }
+    if (m_depth >= DEPTH_MAX) return fail();
+
+    if (role == R_AGENT) {
+        m_staged[m_stagedCount]    = AgentInfo();
+        m_stagedSet[m_stagedCount] = 0;
+    }
+    if (role == R_ERRORS) {
+        m_out->errorCount = 0;
+        m_present |= P_ERRORS;
+    }
+    m_stack[m_depth++] = { object, role, items };
+    m_field = F_NONE;
+    return true;
+}
+
+void StatusParser::closeContainer() {
+    Role role = m_stack[--m_depth].role;
+    if (role == R_AGENT) m_stagedCount++;
+    if (role == R_ROOT)  finishRoot();
+    m_field = F_NONE;
+}
+
+// A value (of any type) starts in the current container
+void StatusParser::valueStarted() {
+    if (m_stack[m_depth - 1].role == R_ERRORS && m_out->errorCount < UINT8_MAX) {
+        m_out->errorCount++;
+    }
+}
+
+void StatusParser::removeAgent(const char* name) {
+    char key[sizeof(AgentInfo::name)];
+    copyName(key, name, strlen(name));
+    CosmaniaStatus& out = *m_out;
+    for (int i = 0; i < out.agentCount; i++) {
+        if (strcmp(out.agents[i].name, key) != 0) continue;
+        for (int j = i + 1; j < out.agentCount; j++) out.agents[j - 1] = out.agents[j];
+        out.agentCount--;
+        return;
+    }
+}
+
+// A delta names only what changed: copy the fields it carried. An agent
+// new to `into` starts from the defaults, as in a full body
+void StatusParser::mergeAgent(AgentInfo& into, int staged) const {
+    const AgentInfo& from = m_staged[staged];
+    uint8_t set = m_stagedSet[staged];
+    if (set & A_OVERDUE)     into.overdue      = from.overdue;
+    if (set & A_OVER_BUDGET) into.overBudget   = from.overBudget;
+    if (set & A_COST)        into.todayCostUsd = from.todayCostUsd;
+    if (set & A_RUNS)        into.todayRuns    = from.todayRuns;
+    if (set & A_MINUTES)     into.minutesSince = from.minutesSince;
+}
+
+// Root object closed: apply the staged agents and recount
+void StatusParser::finishRoot() {
+    CosmaniaStatus& out = *m_out;
+    if (!m_delta) {
+        if (!(m_present & P_TIER))   out.budgetTier       = TIER_UNKNOWN;
+        if (!(m_present & P_BUDGET)) out.totalDailyBudget = 0.0f;
+        if (!(m_present & P_SPEND))  out.totalDailySpend  = 0.0f;
+        if (!(m_present & P_ERRORS)) out.errorCount       = 0;
+        for (int i = 0; i < m_stagedCount; i++) out.agents[i] = m_staged[i];
+        out.agentCount = m_stagedCount;
+    } else {
+        for (int i = 0; i < m_stagedCount; i++) {
+            int slot = 0;
+            while (slot < out.agentCount && strcmp(out.agents[slot].name, m_staged[i].name) != 0) {
+                slot++;
+            }
+            if (slot == AGENT_SLOTS) continue;      // full: same cut as a full body
+            if (slot == out.agentCount) {
+                out.agents[slot] = m_staged[i];
+                out.agentCount++;
+            } else {
+                mergeAgent(out.agents[slot], i);
+            }
+        }
+    }
+
+    out.overdueCount = 0;
+    out.activeCount  = 0;
+    for (int i = 0; i < out.agentCount; i++) {
+        if (out.agents[i].overdue) out.overdueCount++;
+        if (out.agents[i].todayRuns > 0) out.activeCount++;
+    }
+}
+
+// -- Values ----------------------------------------------------------------
+
+void StatusParser::keyDone() {
+    static const KeyName ROOT_KEYS[] = {
+        { "budgetTier",       F_BUDGET_TIER },
+        { "totalDailyBudget", F_DAILY_BUDGET },
+        { "totalDailySpend",  F_DAILY_SPEND },
+        { "agents",           F_AGENTS },
+        { "recentErrors",     F_ERRORS },
+        { "cursor",           F_CURSOR },
+        { "delta",            F_DELTA },
+        { "removed",          F_REMOVED },
+    };
+    static const KeyName AGENT_KEYS[] = {
+        { "name",                F_NAME },
+        { "overdue",             F_OVERDUE },
+        { "overBudget",          F_OVER_BUDGET },
+        { "todayCostUsd",        F_COST },
+        { "todayRuns",           F_RUNS },
+        { "minutesSinceLastRun", F_MINUTES },
+    };
+
+    const KeyName* keys = nullptr;
+    size_t count = 0;
+    switch (m_stack[m_depth - 1].role) {
+        case R_ROOT:  keys = ROOT_KEYS;  count = sizeof(ROOT_KEYS) / sizeof(ROOT_KEYS[0]);   break;
+        case R_AGENT: keys = AGENT_KEYS; count = sizeof(AGENT_KEYS) / sizeof(AGENT_KEYS[0]); break;
+        default: break;
+    }
+
+    m_field = F_NONE;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(m_token, keys[i].name) == 0) {
+            m_field = static_cast<Field>(keys[i].field);
+            break;
+        }
+    }
+}
+
+void StatusParser::stringDone() {
+    Role role = m_stack[m_depth - 1].role;
+    if (role == R_REMOVED) {
+        removeAgent(m_token);
+        return;
+    }
+    if (!m_stack[m_depth - 1].object) return;
+
+    if (m_field == F_BUDGET_TIER) {
+        m_out->budgetTier = parseTier(m_token);
+        m_present |= P_TIER;
+    } else if (m_field == F_NAME) {
+        copyName(m_staged[m_stagedCount].name, m_token, m_tokenLen);
+    } else if (m_field == F_CURSOR) {
+        // A truncated cursor would name the wrong point: drop it
+        if (m_tokenLen < TOKEN_MAX) memcpy(m_cursor, m_token, m_tokenLen + 1);
+    }
+}
+
+void StatusParser::scalarDone(Scalar kind, float number) {
+    bool isTrue   = kind == S_TRUE;
+    bool isBool   = isTrue || kind == S_FALSE;
+    bool isNumber = kind == S_NUMBER;
+    if (!m_stack[m_depth - 1].object) return;
+
+    int staged = m_stagedCount < AGENT_SLOTS ? m_stagedCount : 0;
+    AgentInfo& info = m_staged[staged];
+    uint8_t& set    = m_stagedSet[staged];
+    switch (m_field) {
+        case F_DAILY_BUDGET:
+            if (isNumber) { m_out->totalDailyBudget = number; m_present |= P_BUDGET; }
+            break;
+        case F_DAILY_SPEND:
+            if (isNumber) { m_out->totalDailySpend = number; m_present |= P_SPEND; }
+            break;
+        case F_DELTA:        if (isBool)   m_delta = isTrue;                    break;
+        case F_OVERDUE:
+            if (isBool) { info.overdue = isTrue; set |= A_OVERDUE; }
+            break;
+        case F_OVER_BUDGET:
+            if (isBool) { info.overBudget = isTrue; set |= A_OVER_BUDGET; }
+            break;
+        case F_COST:
+            if (isNumber) { info.todayCostUsd = number; set |= A_COST; }
+            break;
+        case F_RUNS:
+            if (isNumber) { info.todayRuns = static_cast<int>(number); set |= A_RUNS; }
+            break;
+        case F_MINUTES:
+            if (isNumber) { info.minutesSince = static_cast<int>(number); set |= A_MINUTES; }
+            break;
+        default: break;
+    }
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Status Parser -- Streaming parse of the Cosmania /status document
+// Platform-neutral (tools/net_bench/ runs it on recorded payloads). Bytes
+// are fed as they come off the socket, in any split; fields are written
+// straight into a CosmaniaStatus and its AgentInfo slots. Only the keys
+// the device uses are decoded, recentErrors is counted without being
+// stored, everything else is skipped. State is this object: a nesting
+// stack, one short token buffer and the agent slots being staged,
+// whatever the body size.
+//
+// The body is JSON or, when the server answers our Accept with
+// application/msgpack, the same document in MessagePack: no number text
+// to convert and no quoting to scan, keys and strings come length-first.
+// Both lexers drive the same roles and fields, so a body means the same
+// thing in either format.
+//
+// A body is either a full status or, with "delta": true, only what changed
+// since the "cursor" the client sent back: agents listed are upserted by
+// name, "removed" names are dropped, absent scalars keep their value --
+// in a listed agent too, whose fields not in the delta stay as they were.
+// ==========================================================================
+
+class StatusParser {
+public:
+    static constexpr int    DEPTH_MAX   = 16;
+    static constexpr size_t TOKEN_MAX   = 32;   // longer strings are truncated
+    static constexpr int    AGENT_SLOTS = sizeof(CosmaniaStatus::agents) / sizeof(AgentInfo);
+
+    enum Format : uint8_t { JSON, MSGPACK };
+
+    // `out` holds the status the body applies to: a full body replaces the
+    // fields a poll fills (budget, agents, counts), a delta merges into
+    // them. connected / lastPollMs / version are left to the caller
+    void begin(CosmaniaStatus& out, Format format = JSON);
+
+    // Changes the format after begin() but before the first feed(), once
+    // the response's Content-Type is known
+    void   setFormat(Format format);
+    Format format() const { return m_format; }
+
+    // False once the input is not a valid document (the rest is then ignored)
+    bool feed(const uint8_t* data, size_t len);
+
+    // True if a complete top-level object was parsed
+    bool finish() const { return m_lex == L_DONE; }
+    bool failed() const { return m_lex == L_ERROR; }
+
+    // After finish(): whether the body was a delta, and the cursor it
+    // carried ("" if none, or too long to have been kept whole)
+    bool delta() const { return m_delta; }
+    const char* cursor() const { return m_cursor; }
+
+private:
+    enum Lex : uint8_t {
+        L_VALUE,            // expecting a value
+        L_VALUE_OR_END,     // after '['
+        L_KEY_OR_END,       // after '{'
+        L_KEY,              // after ',' in an object
+        L_COLON,
+        L_AFTER_VALUE,
+        L_STRING,
+        L_STRING_ESC,
+        L_STRING_HEX,
+        L_LITERAL,          // number / true / false / null
+        M_HEAD,             // MessagePack: expecting a type byte
+        M_ARG,              // ... reading its length / value bytes
+        M_STR,              // ... string bytes
+        M_SKIP,             // ... bin / ext bytes
+        L_DONE,
+        L_ERROR,
+    };
+
+    // What a container is, as far as CosmaniaStatus is concerned
+    enum Role : uint8_t { R_ROOT, R_AGENTS, R_AGENT, R_ERRORS, R_REMOVED, R_SKIP };
+
+    // Keys that map to a field
+    enum Field : uint8_t {
+        F_NONE,
+        F_BUDGET_TIER, F_DAILY_BUDGET, F_DAILY_SPEND, F_AGENTS, F_ERRORS,
+        F_CURSOR, F_DELTA, F_REMOVED,
+        F_NAME, F_OVERDUE, F_OVER_BUDGET, F_COST, F_RUNS, F_MINUTES,
+    };
+
+    // Root fields seen in this body (a full body defaults the rest)
+    enum Present : uint8_t {
+        P_TIER   = 1 << 0,
+        P_BUDGET = 1 << 1,
+        P_SPEND  = 1 << 2,
+        P_ERRORS = 1 << 3,
+    };
+
+    // Agent fields seen in a staged agent (a delta merges only these)
+    enum AgentPresent : uint8_t {
+        A_OVERDUE     = 1 << 0,
+        A_OVER_BUDGET = 1 << 1,
+        A_COST        = 1 << 2,
+        A_RUNS        = 1 << 3,
+        A_MINUTES     = 1 << 4,
+    };
+
+    // A value that is neither string nor container
+    enum Scalar : uint8_t { S_NULL, S_FALSE, S_TRUE, S_NUMBER };
+
+    struct Frame {
+        bool     object;
+        Role     role;
+        uint32_t items;     // MessagePack: keys + values still to come
+    };
+
+    bool fail();
+    void tokenChar(char c);
+
+    // JSON lexer
+    bool step(char c);
+    bool beginContainer(bool object);
+    bool endContainer(bool object);
+    void literalDone();
+
+    // MessagePack lexer
+    bool feedPack(const uint8_t* data, size_t len);
+    bool packHead(uint8_t b);
+    bool packArg();
+    bool packString(uint32_t len);
+    bool packSkip(uint32_t len);
+    bool packContainer(bool object, uint32_t count);
+    bool packScalar(Scalar kind, float number);
+    bool packItemDone();
+
+    // Document: what either lexer found, applied to the status
+    bool openContainer(bool object, uint32_t items);
+    void closeContainer();
+    void valueStarted();
+    void keyDone();
+    void stringDone();
+    void scalarDone(Scalar kind, float number);
+    Role childRole(bool object) const;
+    void removeAgent(const char* name);
+    void mergeAgent(AgentInfo& into, int staged) const;
+    void finishRoot();
+
+    CosmaniaStatus* m_out = nullptr;
+    Format   m_format    = JSON;
+    Frame    m_stack[DEPTH_MAX];
+    int      m_depth     = 0;
+    Lex      m_lex       = L_ERROR;
+    bool     m_isKey     = false;
+    Field    m_field     = F_NONE;      // key of the value being parsed
+    uint8_t  m_hexLeft   = 0;
+    uint16_t m_hex       = 0;
+    char     m_token[TOKEN_MAX + 1];
+    uint8_t  m_tokenLen  = 0;
+    uint8_t  m_packType  = 0;           // MessagePack type byte awaiting M_ARG
+    uint8_t  m_argLeft   = 0;
+    uint64_t m_arg       = 0;
+    uint32_t m_left      = 0;           // M_STR / M_SKIP bytes to go
+
+    AgentInfo m_staged[AGENT_SLOTS];        // agents[] of this body
+    uint8_t  m_stagedSet[AGENT_SLOTS];      // AgentPresent bits of each
+    uint8_t  m_stagedCount = 0;
+    uint8_t  m_present   = 0;
+    bool     m_delta     = false;
+    char     m_cursor[TOKEN_MAX + 1];
+};
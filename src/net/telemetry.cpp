@@ -0,0 +1,144 @@
+#include "telemetry.h"
+
+// ==========================================================================
+// Telemetry -- event sampling glue around TelemetryQueue
+// ==========================================================================
+
+#if FEATURE_TELEMETRY
+
+#include "telemetry_queue.h"
+#include "wifi_manager.h"
+#include "../hal/flash_region.h"
+#include "../state/threat_detect.h"
+#include <Arduino.h>
+#include <cstring>
+#include <time.h>
+
+static FlashRegion    s_flash;
+static TelemetrySpill s_spill;
+static TelemetryQueue s_queue;
+static bool           s_enabled = false;
+
+static unsigned long s_lastPetMs   = 0;
+static unsigned long s_lastRadioMs = 0;
+static int32_t       s_petKey      = -1;    // mood / stage / alive last sent
+static int32_t       s_radio[8];
+static bool          s_radioSent   = false;
+static uint8_t       s_threatSent[THREAT_IMSI_PATTERN + 1];  // severity + 1, 0 = not active
+
+// Epoch seconds once the clock is set, seconds since boot before that
+static uint32_t clockS(unsigned long now) {
+    time_t wall = time(nullptr);
+    return wall > static_cast<time_t>(EPOCH_VALID_MIN) ? static_cast<uint32_t>(wall) : now / 1000;
+}
+
+void Telemetry::init(const char* baseUrl) {
+    if (!baseUrl || baseUrl[0] == '\0') return;
+    char url[HttpFetch::HOST_LEN + HttpFetch::PATH_LEN + 16];
+    snprintf(url, sizeof(url), "%s%s", baseUrl, TELEMETRY_PATH);
+
+    uint32_t device = static_cast<uint32_t>(ESP.getEfuseMac() >> 16);
+    if (!s_queue.begin(url, device, esp_random())) {
+        Serial.printf("[telemetry] bad url %s, disabled\n", url);
+        return;
+    }
+    s_queue.setThresholds(TELEMETRY_MIN_BYTES, TELEMETRY_MAX_AGE_S);
+    if (s_flash.open("telemetry") && s_spill.mount(s_flash)) {
+        s_queue.setSpill(&s_spill);
+        Serial.printf("[telemetry] %d/%d frames waiting in flash\n",
+                      s_spill.pending(), s_spill.capacity());
+    } else {
+        Serial.println("[telemetry] no partition, offline batches stay in RAM");
+    }
+    s_enabled = true;
+}
+
+void Telemetry::tick(unsigned long now, const PetState& pet, const RadioEnvironment& radio) {
+    if (!s_enabled) return;
+    uint32_t t = clockS(now);
+
+    // Pet: periodic, or right away when its mood / stage / life changes
+    int32_t key = pet.mood | (pet.stage << 8) | (pet.alive << 16) | (pet.hatched << 17);
+    if (key != s_petKey || now - s_lastPetMs >= TELEMETRY_PET_S * 1000UL) {
+        int32_t f[] = {
+            pet.hunger, pet.happiness, pet.health, pet.mood, pet.stage,
+            static_cast<int32_t>(pet.ageDays * 1440 + pet.ageHours * 60 + pet.ageMinutes),
+            (pet.alive ? 1 : 0) | (pet.hatched ? 2 : 0),
+        };
+        s_queue.record(TelemetryQueue::PET, t, f, sizeof(f) / sizeof(f[0]));
+        s_petKey    = key;
+        s_lastPetMs = now;
+    }
+
+    // Radio environment: on change, rate-limited
+    int32_t r[] = {
+        radio.bleDeviceCount, radio.bleScannerCount, radio.probeCount, radio.uniqueProbers,
+        radio.deauthCount, radio.threatCount, radio.safetyScore, radio.worstThreat,
+    };
+    static_assert(sizeof(r) == sizeof(s_radio), "radio fields out of sync");
+    if ((!s_radioSent || memcmp(r, s_radio, sizeof(r)) != 0) &&
+        now - s_lastRadioMs >= TELEMETRY_RADIO_S * 1000UL) {
+        s_queue.record(TelemetryQueue::RADIO, t, r, sizeof(r) / sizeof(r[0]));
+        memcpy(s_radio, r, sizeof(r));
+        s_radioSent   = true;
+        s_lastRadioMs = now;
+    }
+
+    // Threats: new, or escalated since last sent (refreshes are not events)
+    uint8_t active[sizeof(s_threatSent)] = {0};
+    const ThreatEntry* threats = ThreatDetect::threats();
+    for (int i = 0; i < ThreatDetect::threatCount(); i++) {
+        const ThreatEntry& e = threats[i];
+        if (e.type >= sizeof(active)) continue;
+        uint8_t level = e.severity + 1;
+        if (level > active[e.type]) active[e.type] = level;
+        if (level > s_threatSent[e.type]) {
+            int32_t f[] = { e.type, e.severity };
+            s_queue.record(TelemetryQueue::THREAT, t, f, 2);
+        }
+    }
+    memcpy(s_threatSent, active, sizeof(active));
+
+    s_queue.poll(now, t, WifiManager::isConnected());
+}
+
+void Telemetry::flush() {
+    s_queue.flush();
+}
+
+void Telemetry::printStats() {
+    if (!s_enabled) {
+        Serial.println("[telemetry] not configured");
+        return;
+    }
+    const TelemetryQueue::Stats& st = s_queue.stats();
+    Serial.printf("[telemetry] batch %u B / %u events (%d%% full), outbox %s, flash %d/%d\n",
+                  (unsigned)s_queue.batchBytes(), (unsigned)s_queue.batchEvents(),
+                  s_queue.occupancy(),
+                  s_queue.uploading() ? "sending" : s_queue.outboxFull() ? "waiting" : "empty",
+                  s_spill.pending(), s_spill.capacity());
+    Serial.printf("[telemetry] %lu events, %lu dropped, %lu batches, %lu uploads, "
+                  "%lu failures, %lu rejected, %lu spilled, %lu restored\n",
+                  (unsigned long)st.events, (unsigned long)st.dropped,
+                  (unsigned long)st.batches, (unsigned long)st.uploads,
+                  (unsigned long)st.failures, (unsigned long)st.rejected,
+                  (unsigned long)st.spilled, (unsigned long)st.restored);
+    if (st.sealedEvents) {
+        Serial.printf("[telemetry] bytes/event: %.1f raw, %.1f msgpack, %.1f deflated\n",
+                      (double)st.rawBytes / st.events,
+                      (double)st.packedBytes / st.sealedEvents,
+                      (double)s_queue.bytesPerEvent());
+    }
+}
+
+#else
+
+// -- Stubs when telemetry disabled -----------------------------------------
+#include <Arduino.h>
+
+void Telemetry::init(const char*) {}
+void Telemetry::tick(unsigned long, const PetState&, const RadioEnvironment&) {}
+void Telemetry::flush() {}
+void Telemetry::printStats() { Serial.println("[telemetry] disabled"); }
+
+#endif
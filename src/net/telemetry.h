@@ -0,0 +1,23 @@
+#pragma once
+#include "config.h"
+#include "types.h"
+
+// ==========================================================================
+// Telemetry -- Pet, radio and threat events pushed upstream to Cosmania
+// Feeds a TelemetryQueue POSTing to <cosmania url>TELEMETRY_PATH: a pet
+// sample every TELEMETRY_PET_S and on mood / stage / life changes, the
+// radio environment when it changes (at most every TELEMETRY_RADIO_S), and
+// each threat as it appears or escalates. Uploads only go out while the
+// STA link is up; batches sealed offline wait on the "telemetry"
+// partition.
+// Compiles to no-op when FEATURE_TELEMETRY == 0
+// ==========================================================================
+
+namespace Telemetry {
+
+void init(const char* baseUrl);
+void tick(unsigned long now, const PetState& pet, const RadioEnvironment& radio);
+void flush();               // upload what is batched at the next chance
+void printStats();
+
+}  // namespace Telemetry
@@ -0,0 +1,207 @@
+#include "telemetry_queue.h"
+#include <cstring>
+
+// ==========================================================================
+// Telemetry Queue -- record -> seal -> (spill) -> POST
+// The batch buffer keeps HEAD_ROOM spare bytes in front of the events so
+// the header can be written right-aligned against them at seal time and
+// the whole document deflated in one pass, without a second copy.
+// ==========================================================================
+
+static const char UPLOAD_HEADERS[] =
+    "Content-Type: application/msgpack\r\n"
+    "Content-Encoding: deflate\r\n";
+
+// -- MessagePack -----------------------------------------------------------
+static size_t packInt(uint8_t* p, int32_t v) {
+    if (v >= 0 && v <= 127) { p[0] = static_cast<uint8_t>(v); return 1; }      // fixint
+    if (v < 0 && v >= -32)  { p[0] = static_cast<uint8_t>(v); return 1; }      // negative fixint
+    if (v >= -128 && v <= 127) { p[0] = 0xd0; p[1] = static_cast<uint8_t>(v); return 2; }
+    if (v >= -32768 && v <= 32767) {
+        p[0] = 0xd1; p[1] = static_cast<uint8_t>(v >> 8); p[2] = static_cast<uint8_t>(v);
+        return 3;
+    }
+    uint32_t u = static_cast<uint32_t>(v);
+    p[0] = 0xd2;
+    p[1] = u >> 24; p[2] = u >> 16; p[3] = u >> 8; p[4] = u;
+    return 5;
+}
+
+static size_t packUint(uint8_t* p, uint32_t v) {
+    if (v <= 127)    { p[0] = static_cast<uint8_t>(v); return 1; }
+    if (v <= 0xFF)   { p[0] = 0xcc; p[1] = v; return 2; }
+    if (v <= 0xFFFF) { p[0] = 0xcd; p[1] = v >> 8; p[2] = v; return 3; }
+    p[0] = 0xce;
+    p[1] = v >> 24; p[2] = v >> 16; p[3] = v >> 8; p[4] = v;
+    return 5;
+}
+
+static size_t packStr(uint8_t* p, const char* s) {
+    size_t n = strlen(s);               // keys only: always a fixstr
+    p[0] = 0xa0 | n;
+    memcpy(p + 1, s, n);
+    return n + 1;
+}
+
+// -- Queue -----------------------------------------------------------------
+bool TelemetryQueue::begin(const char* url, uint32_t deviceId, uint32_t bootId) {
+    m_device = deviceId;
+    m_boot   = bootId;
+    m_rng    = bootId ? bootId : 1;
+    m_http.setKeepAlive(false);         // uploads are minutes apart
+    m_http.setHeaders(UPLOAD_HEADERS);
+    return m_http.setUrl(url);
+}
+
+bool TelemetryQueue::record(Kind kind, uint32_t timeS, const int32_t* fields, int count) {
+    if (kind >= KIND_COUNT || count < 0 || count > FIELDS_MAX) return false;
+    if (m_batchLen + EVENT_MAX > BATCH_LEN && !makeRoom()) {
+        m_stats.dropped++;
+        return false;
+    }
+    if (m_events == 0) {
+        m_t0    = timeS;
+        m_lastS = timeS;
+        memset(m_last, 0, sizeof(m_last));
+    }
+
+    uint8_t* start = m_batch + HEAD_ROOM + m_batchLen;
+    uint8_t* p = start;
+    *p++ = 0x90 | (2 + count);          // fixarray
+    *p++ = kind;
+    p += packInt(p, static_cast<int32_t>(timeS - m_lastS));
+    for (int i = 0; i < count; i++) {
+        uint32_t d = static_cast<uint32_t>(fields[i]) - static_cast<uint32_t>(m_last[kind][i]);
+        p += packInt(p, static_cast<int32_t>(d));
+        m_last[kind][i] = fields[i];
+    }
+    m_lastS     = timeS;
+    m_batchLen += p - start;
+    m_events++;
+    m_stats.events++;
+    m_stats.rawBytes += 5 + 4 * count;
+    return true;
+}
+
+void TelemetryQueue::poll(uint32_t nowMs, uint32_t nowS, bool linkUp) {
+    m_linkUp = linkUp;
+    if (m_http.busy()) {
+        HttpFetch::State st = m_http.poll(nowMs);
+        if (st == HttpFetch::DONE || st == HttpFetch::FAILED) finish(nowMs);
+        return;
+    }
+
+    bool big = m_events > 0 && (m_flush || m_batchLen >= m_minBytes);
+    if (!linkUp) {
+        // Offline: full-sized batches go straight to flash so RAM can
+        // refill. Age doesn't count here; it only bounds upload latency.
+        if (big && m_spill && (m_frameLen == 0 || park())) {
+            seal();
+            park();
+        }
+        return;
+    }
+
+    if (m_frameLen == 0 && m_spill && m_spill->pending() > 0) restore();
+    if (m_frameLen == 0 && (big || (m_events > 0 && nowS - m_t0 >= m_maxAgeS))) seal();
+    if (m_frameLen == 0 || (m_backoffMs && nowMs - m_failedMs < m_waitMs)) return;
+
+    m_http.setBody(m_frame, m_frameLen);
+    m_http.start(nowMs, nullptr, nullptr);
+}
+
+float TelemetryQueue::bytesPerEvent() const {
+    return m_stats.sealedEvents ? static_cast<float>(m_stats.frameBytes) / m_stats.sealedEvents : 0;
+}
+
+// The batch is full: seal it now, parking the outbox frame first if need be
+bool TelemetryQueue::makeRoom() {
+    if (m_http.busy()) return false;    // the outbox is on the wire
+    if (m_frameLen > 0 && !park()) return false;
+    seal();
+    if (!m_linkUp && m_spill) park();
+    return true;
+}
+
+size_t TelemetryQueue::header(uint8_t* out) const {
+    uint8_t* p = out;
+    *p++ = 0x86;                        // fixmap, 6 pairs
+    p += packStr(p, "v");    p += packUint(p, 1);
+    p += packStr(p, "dev");  p += packUint(p, m_device);
+    p += packStr(p, "boot"); p += packUint(p, m_boot);
+    p += packStr(p, "seq");  p += packUint(p, m_seq);
+    p += packStr(p, "t0");   p += packUint(p, m_t0);
+    p += packStr(p, "ev");
+    *p++ = 0xdd;                        // array32: events follow
+    p[0] = m_events >> 24; p[1] = m_events >> 16; p[2] = m_events >> 8; p[3] = m_events;
+    return p + 4 - out;
+}
+
+void TelemetryQueue::seal() {
+    uint8_t hdr[HEAD_ROOM];
+    size_t  h = header(hdr);
+    uint8_t* doc = m_batch + HEAD_ROOM - h;
+    memcpy(doc, hdr, h);
+
+    m_frameLen  = m_deflate.compress(doc, h + m_batchLen, m_frame, FRAME_LEN);
+    m_frameId   = 0;
+    m_stats.batches++;
+    m_stats.sealedEvents += m_events;
+    m_stats.packedBytes  += h + m_batchLen;
+    m_stats.frameBytes   += m_frameLen;
+
+    m_seq++;
+    m_batchLen = 0;
+    m_events   = 0;
+    m_flush    = false;
+}
+
+// Outbox -> flash. A frame read back from flash is still there.
+bool TelemetryQueue::park() {
+    if (m_frameLen == 0) return true;
+    if (m_frameId == 0) {
+        if (!m_spill || !m_spill->push(m_frame, m_frameLen)) return false;
+        m_stats.spilled++;
+    }
+    m_frameLen = 0;
+    m_frameId  = 0;
+    return true;
+}
+
+void TelemetryQueue::restore() {
+    uint32_t id;
+    size_t n = m_spill->oldest(m_frame, FRAME_LEN, id);
+    if (n == 0) return;
+    m_frameLen  = n;
+    m_frameId   = id;
+    m_stats.restored++;
+}
+
+void TelemetryQueue::finish(uint32_t nowMs) {
+    int  status = m_http.state() == HttpFetch::DONE ? m_http.status() : 0;
+    bool ok     = status >= 200 && status < 300;
+    bool reject = status >= 400 && status < 500 && status != 408 && status != 429;
+    if (ok || reject) {
+        if (ok) {
+            m_stats.uploads++;
+            m_stats.sentBytes += m_frameLen;
+        } else {
+            m_stats.rejected++;
+        }
+        if (m_frameId && m_spill) m_spill->ack(m_frameId);
+        m_frameLen  = 0;
+        m_frameId   = 0;
+        m_backoffMs = 0;
+        return;
+    }
+
+    // Retry in [backoff / 2, backoff)
+    m_stats.failures++;
+    m_backoffMs = m_backoffMs == 0 ? RETRY_MIN_MS
+                : m_backoffMs >= RETRY_MAX_MS / 2 ? RETRY_MAX_MS : m_backoffMs * 2;
+    m_rng ^= m_rng << 13;
+    m_rng ^= m_rng >> 17;
+    m_rng ^= m_rng << 5;
+    m_waitMs   = m_backoffMs / 2 + m_rng % (m_backoffMs / 2);
+    m_failedMs = nowMs;
+}
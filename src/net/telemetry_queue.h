@@ -0,0 +1,129 @@
+#pragma once
+#include "deflate.h"
+#include "http_fetch.h"
+#include "telemetry_spill.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Telemetry Queue -- Batched, compressed event upload to Cosmania
+// Platform-neutral (tools/telemetry_bench/ runs it against a local mock
+// endpoint). Events are MessagePack-encoded into a bounded RAM batch as
+// they are recorded:
+//
+//   [kind, dt, d0, d1, ...]     dt  = seconds since the previous event
+//                               dN  = field N minus the same field of the
+//                                     previous event of this kind (mod 2^32)
+//
+// Deltas restart from zero with every batch, so each frame decodes alone.
+// Sealing prepends a header map
+//
+//   {"v": 1, "dev": id, "boot": id, "seq": n, "t0": s, "ev": [events...]}
+//
+// (t0 is epoch seconds once the clock is set, seconds since boot before
+// that), deflates the lot into the outbox frame, and the frame is POSTed
+// as application/msgpack with Content-Encoding: deflate.
+//
+// While the link is up a batch is sealed and POSTed once it holds
+// minBytes or its first event is maxAgeS old. Offline, batches of
+// minBytes are sealed into a TelemetrySpill (if one is attached) and come
+// back oldest first when the link returns; without one the batch fills
+// and new events are dropped. A failed POST retries from RETRY_MIN_MS
+// backing off to RETRY_MAX_MS with jitter; a 4xx other than 408 / 429
+// drops the frame.
+// ==========================================================================
+
+class TelemetryQueue {
+public:
+    enum Kind : uint8_t { PET, RADIO, THREAT, KIND_COUNT };
+
+    static constexpr int      FIELDS_MAX   = 8;
+    static constexpr size_t   BATCH_LEN    = 2048;  // encoded events
+    static constexpr size_t   HEAD_ROOM    = 48;    // longest header map
+    static constexpr size_t   EVENT_MAX    = 2 + 5 + FIELDS_MAX * 5;
+    static constexpr size_t   FRAME_LEN    = Deflate::bound(HEAD_ROOM + BATCH_LEN);
+    static constexpr uint32_t RETRY_MIN_MS = 15000;
+    static constexpr uint32_t RETRY_MAX_MS = 10UL * 60 * 1000;
+
+    static_assert(FRAME_LEN <= TelemetrySpill::FRAME_MAX, "frame must fit a spill sector");
+
+    struct Stats {
+        uint32_t events       = 0;  // recorded
+        uint32_t dropped      = 0;  // no room anywhere
+        uint32_t batches      = 0;  // sealed
+        uint32_t sealedEvents = 0;
+        uint32_t spilled      = 0;  // frames written to flash
+        uint32_t restored     = 0;  // ... and read back for upload
+        uint32_t uploads      = 0;  // 2xx
+        uint32_t failures     = 0;  // network errors, 5xx, 408, 429
+        uint32_t rejected     = 0;  // other 4xx; frame dropped
+        uint64_t rawBytes     = 0;  // events as fixed-width records (u32 time, u8 kind, i32 fields)
+        uint64_t packedBytes  = 0;  // sealed MessagePack, header included
+        uint64_t frameBytes   = 0;  // after deflate
+        uint64_t sentBytes    = 0;  // acknowledged frames
+    };
+
+    TelemetryQueue() = default;
+    TelemetryQueue(const TelemetryQueue&) = delete;
+    TelemetryQueue& operator=(const TelemetryQueue&) = delete;
+
+    // Upload URL and the ids every frame carries; false if the URL is bad
+    bool begin(const char* url, uint32_t deviceId, uint32_t bootId);
+    void setSpill(TelemetrySpill* spill) { m_spill = spill; }
+    void setThresholds(size_t minBytes, uint32_t maxAgeS) { m_minBytes = minBytes; m_maxAgeS = maxAgeS; }
+
+    // False (and counted as dropped) if there is no room for the event
+    bool record(Kind kind, uint32_t timeS, const int32_t* fields, int count);
+    // Seal whatever is batched at the next poll(), thresholds aside
+    void flush() { m_flush = true; }
+
+    void poll(uint32_t nowMs, uint32_t nowS, bool linkUp);
+
+    size_t   batchBytes() const { return m_batchLen; }
+    uint32_t batchEvents() const { return m_events; }
+    int      occupancy() const { return static_cast<int>(m_batchLen * 100 / BATCH_LEN); }    // %
+    bool     outboxFull() const { return m_frameLen > 0; }
+    bool     uploading() const { return m_http.busy(); }
+    uint32_t nextSeq() const { return m_seq; }
+    float    bytesPerEvent() const;     // deflated bytes per sealed event
+    const Stats& stats() const { return m_stats; }
+    const HttpFetch& http() const { return m_http; }
+
+private:
+    bool   makeRoom();
+    void   seal();
+    bool   park();
+    void   restore();
+    void   finish(uint32_t nowMs);
+    size_t header(uint8_t* out) const;
+
+    HttpFetch       m_http;
+    Deflate         m_deflate;
+    TelemetrySpill* m_spill = nullptr;
+    uint32_t m_device   = 0;
+    uint32_t m_boot     = 0;
+    uint32_t m_seq      = 0;
+    size_t   m_minBytes = 1024;
+    uint32_t m_maxAgeS  = 300;
+    bool     m_linkUp   = false;
+    bool     m_flush    = false;
+
+    // Batch: events from m_batch + HEAD_ROOM, the header goes in front
+    uint8_t  m_batch[HEAD_ROOM + BATCH_LEN];
+    size_t   m_batchLen = 0;
+    uint32_t m_events   = 0;
+    uint32_t m_t0       = 0;
+    uint32_t m_lastS    = 0;
+    int32_t  m_last[KIND_COUNT][FIELDS_MAX] = {};
+
+    // Outbox: the one frame being (or waiting to be) POSTed
+    uint8_t  m_frame[FRAME_LEN];
+    size_t   m_frameLen  = 0;
+    uint32_t m_frameId   = 0;       // spill id if read back from flash
+    uint32_t m_backoffMs = 0;       // 0 = not backing off
+    uint32_t m_waitMs    = 0;
+    uint32_t m_failedMs  = 0;
+    uint32_t m_rng       = 1;
+
+    Stats    m_stats;
+};
@@ -0,0 +1,116 @@
+#include "telemetry_spill.h"
+#include "../sys/journal_codec.h"
+#include <cstring>
+
+// ==========================================================================
+// Telemetry Spill -- sector ring, RAM index of pending seqs
+// ==========================================================================
+
+static constexpr uint32_t MAGIC      = 0x314D4C54;  // "TLM1"
+static constexpr uint8_t  STATE_SENT = 0x00;
+static constexpr size_t   STATE_AT   = 12;
+
+using JournalCodec::crc16;
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void putU32(uint8_t* p, uint32_t v) { putU16(p, v); putU16(p + 2, v >> 16); }
+static uint16_t getU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t getU32(const uint8_t* p) { return getU16(p) | (uint32_t(getU16(p + 2)) << 16); }
+
+bool TelemetrySpill::mount(FlashRegion& flash) {
+    m_flash   = &flash;
+    m_sectors = static_cast<int>(flash.sectorCount());
+    if (m_sectors > MAX_SECTORS) m_sectors = MAX_SECTORS;
+    m_head    = 0;
+    m_nextSeq = 1;
+    memset(m_seq, 0, sizeof(m_seq));
+    if (m_sectors < 2) return false;
+
+    // Headers only; a frame's CRC is checked when it is read for upload
+    uint32_t newest = 0;
+    for (int s = 0; s < m_sectors; s++) {
+        uint8_t h[HEADER_SIZE];
+        if (!flash.read(s * FlashRegion::SECTOR_SIZE, h, sizeof(h))) return false;
+        uint32_t seq = getU32(h + 4);
+        if (getU32(h) != MAGIC || seq == 0 || getU16(h + 8) > FRAME_MAX) continue;
+        if (seq >= newest) {
+            newest = seq;
+            m_head = (s + 1) % m_sectors;
+        }
+        if (h[STATE_AT] != STATE_SENT) m_seq[s] = seq;
+    }
+    m_nextSeq = newest + 1;
+    return true;
+}
+
+bool TelemetrySpill::push(const uint8_t* frame, size_t len) {
+    if (!m_flash || len > FRAME_MAX) return false;
+    int s = m_head;
+    if (m_seq[s]) m_stats.overwritten++;
+    m_seq[s] = 0;
+    m_head = (s + 1) % m_sectors;       // a failed sector is skipped next time
+
+    uint32_t base = s * FlashRegion::SECTOR_SIZE;
+    uint8_t h[HEADER_SIZE];
+    memset(h, 0xFF, sizeof(h));
+    putU32(h, MAGIC);
+    putU32(h + 4, m_nextSeq);
+    putU16(h + 8, static_cast<uint16_t>(len));
+    putU16(h + 10, crc16(frame, len));
+    if (!m_flash->eraseSector(s) ||
+        !m_flash->write(base + HEADER_SIZE, frame, len) ||
+        !m_flash->write(base, h, sizeof(h))) {
+        return false;
+    }
+    m_seq[s] = m_nextSeq++;
+    m_stats.writes++;
+    return true;
+}
+
+size_t TelemetrySpill::oldest(uint8_t* buf, size_t cap, uint32_t& id) {
+    for (;;) {
+        int best = -1;
+        for (int s = 0; s < m_sectors; s++) {
+            if (m_seq[s] && (best < 0 || m_seq[s] < m_seq[best])) best = s;
+        }
+        if (best < 0) return 0;
+
+        uint32_t base = best * FlashRegion::SECTOR_SIZE;
+        uint8_t h[HEADER_SIZE];
+        size_t len = 0;
+        bool ok = m_flash->read(base, h, sizeof(h));
+        if (ok) {
+            len = getU16(h + 8);
+            ok  = len <= cap && m_flash->read(base + HEADER_SIZE, buf, len) &&
+                  crc16(buf, len) == getU16(h + 10);
+        }
+        if (ok) {
+            id = m_seq[best];
+            return len;
+        }
+        m_stats.corrupt++;
+        m_seq[best] = 0;
+    }
+}
+
+void TelemetrySpill::ack(uint32_t id) {
+    int s = find(id);
+    if (s < 0) return;                  // overwritten since it was read
+    const uint8_t sent = STATE_SENT;
+    m_flash->write(s * FlashRegion::SECTOR_SIZE + STATE_AT, &sent, 1);
+    m_seq[s] = 0;
+    m_stats.acks++;
+}
+
+int TelemetrySpill::pending() const {
+    int n = 0;
+    for (int s = 0; s < m_sectors; s++) n += m_seq[s] != 0;
+    return n;
+}
+
+int TelemetrySpill::find(uint32_t id) const {
+    for (int s = 0; s < m_sectors; s++) {
+        if (id && m_seq[s] == id) return s;
+    }
+    return -1;
+}
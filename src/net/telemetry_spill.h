@@ -0,0 +1,57 @@
+#pragma once
+#include "../hal/flash_region.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Telemetry Spill -- Ring of sealed telemetry frames on a raw partition
+// Platform-neutral (the firmware runs it on the "telemetry" partition,
+// tools/telemetry_bench/ on a file-backed emulator). One frame per 4 KB
+// sector: a 16 B header then the frame as it will be POSTed.
+//
+//   [u32 magic][u32 seq][u16 len][u16 crc16 of frame][u8 state][3 B 0xFF]
+//
+// The frame is programmed before the header, so a cut mid-write leaves a
+// sector with no magic. Acking a frame programs `state` from 0xFF to 0x00
+// instead of erasing, so a frame is sent at least once across power
+// cycles (the server dedups on the frame's boot id + seq). When every
+// sector is pending the oldest frame is overwritten.
+// ==========================================================================
+
+class TelemetrySpill {
+public:
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t FRAME_MAX   = FlashRegion::SECTOR_SIZE - HEADER_SIZE;
+    static constexpr int    MAX_SECTORS = 64;           // RAM index bound (256 KB)
+
+    struct Stats {
+        uint32_t writes      = 0;
+        uint32_t acks        = 0;
+        uint32_t overwritten = 0;   // pending frames lost to a full ring
+        uint32_t corrupt     = 0;   // failed the CRC when read back
+    };
+
+    bool mount(FlashRegion& flash);
+
+    // False if the frame is too long or the flash write failed
+    bool push(const uint8_t* frame, size_t len);
+
+    // Copies the oldest pending frame into buf; returns its length (0 if
+    // none is pending) and its id for ack()
+    size_t oldest(uint8_t* buf, size_t cap, uint32_t& id);
+    void   ack(uint32_t id);
+
+    int pending() const;
+    int capacity() const { return m_sectors; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    int  find(uint32_t id) const;
+
+    FlashRegion* m_flash   = nullptr;
+    int          m_sectors = 0;
+    int          m_head    = 0;             // next sector to write
+    uint32_t     m_nextSeq = 1;
+    uint32_t     m_seq[MAX_SECTORS] = {};   // pending frame per sector, 0 = none
+    Stats        m_stats;
+};
@@ -1,16 +1,322 @@
 #include "wifi_manager.h"
 #include "config.h"
+#include "../sys/metrics.h"
 #include <WiFi.h>
+#include <Preferences.h>
+#include <esp_netif.h>
+#include <esp_netif_net_stack.h>
+#include <lwip/netif.h>
+#include <lwip/pbuf.h>
+#include <lwip/priv/tcpip_priv.h>
+#include <cstddef>
+#include <cstring>
+#include <time.h>
 
 // ==========================================================================
 // WiFi Manager -- STA mode for Cosmania polling
 // Separate from wifi_radio.h (scan-only HAL for feeding mechanic)
+//
+// Connects take one of two paths:
+//   fast   WiFi.begin() with the cached BSSID + channel: no scan of every
+//          channel. With a fresh cached lease (or WIFI_STATIC_IP) the
+//          address is configured up front, so there is no DHCP either.
+//          Given FAST_TIMEOUT_MS; on failure the cache is set aside.
+//          A reused lease may have been handed on since, so it is only
+//          configured after an RFC 5227 probe of WIFI_ARP_PROBE_MS on the
+//          bare link; if another host answers, it is dropped for DHCP.
+//   scan   plain WiFi.begin(): full scan + DHCP, retried every
+//          RECONNECT_INTERVAL.
+// A lost link is retried at once rather than on the next interval. Every
+// connect rewrites the cache (only if it changed, to spare the flash) and
+// its latency goes into a small ring for percentiles.
 // ==========================================================================
 
 static const char* s_ssid = nullptr;
 static const char* s_pass = nullptr;
 static unsigned long s_lastReconnect = 0;
+static bool s_ntpStarted = false;
 static constexpr unsigned long RECONNECT_INTERVAL = 10000;
+static constexpr unsigned long FAST_TIMEOUT_MS    = 2500;
+
+// -- Link cache ------------------------------------------------------------
+struct LinkCache {
+    uint32_t magic;
+    uint32_t ssidHash;      // cache of another network is ignored
+    uint8_t  bssid[6];
+    uint8_t  channel;       // 0 = no cached AP
+    uint8_t  reserved;
+    uint32_t ip, gateway, mask, dns;    // 0 = no lease
+    uint32_t leaseAt;       // epoch s the lease was handed out, 0 = unknown
+    uint32_t check;         // FNV-1a of the fields above
+};
+
+static constexpr uint32_t CACHE_MAGIC = 0x574C4331;     // "WLC1"
+static const char* const  CACHE_KEY   = "link";
+
+static Preferences s_prefs;
+static LinkCache s_cache;
+static LinkCache s_saved;           // what NVS holds
+
+// FNV-1a, as for MAC hashes in the radio modules
+static uint32_t fnv1a(const void* data, size_t len, uint32_t h = 2166136261u) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t cacheCheck(const LinkCache& c) {
+    return fnv1a(&c, offsetof(LinkCache, check));
+}
+
+static void loadCache() {
+    memset(&s_cache, 0, sizeof(s_cache));
+    LinkCache c;
+    bool ok = s_prefs.getBytesLength(CACHE_KEY) == sizeof(c) &&
+              s_prefs.getBytes(CACHE_KEY, &c, sizeof(c)) == sizeof(c) &&
+              c.magic == CACHE_MAGIC && c.check == cacheCheck(c) &&
+              c.ssidHash == fnv1a(s_ssid, strlen(s_ssid));
+    if (ok) s_cache = c;
+    s_saved = s_cache;
+}
+
+static void saveCache() {
+    s_cache.magic    = CACHE_MAGIC;
+    s_cache.ssidHash = fnv1a(s_ssid, strlen(s_ssid));
+    s_cache.check    = cacheCheck(s_cache);
+    if (memcmp(&s_cache, &s_saved, sizeof(s_cache)) == 0) return;
+    if (s_prefs.putBytes(CACHE_KEY, &s_cache, sizeof(s_cache)) == sizeof(s_cache)) s_saved = s_cache;
+}
+
+// -- Address ---------------------------------------------------------------
+
+static uint32_t s_leaseMs   = 0;        // millis() the lease was handed out
+static bool     s_leaseHere = false;    // ... this boot (else only leaseAt)
+
+static bool haveStatic() {
+    return WIFI_STATIC_IP[0] != '\0';
+}
+
+static bool leaseFresh() {
+    if (WIFI_LEASE_REUSE_S == 0 || s_cache.ip == 0) return false;
+    if (s_leaseHere) return millis() - s_leaseMs < WIFI_LEASE_REUSE_S * 1000UL;
+    time_t t = time(nullptr);
+    return s_cache.leaseAt && t > static_cast<time_t>(EPOCH_VALID_MIN) &&
+           static_cast<uint32_t>(t) - s_cache.leaseAt < WIFI_LEASE_REUSE_S;
+}
+
+// Static, reused lease or DHCP; true if DHCP is skipped
+static bool configAddress(bool reuseLease) {
+    if (haveStatic()) {
+        IPAddress ip, gateway, mask, dns;
+        ip.fromString(WIFI_STATIC_IP);
+        gateway.fromString(WIFI_STATIC_GATEWAY);
+        mask.fromString(WIFI_STATIC_MASK);
+        if (!dns.fromString(WIFI_STATIC_DNS)) dns = gateway;
+        WiFi.config(ip, gateway, mask, dns);
+        return true;
+    }
+    if (reuseLease && leaseFresh()) {
+        WiFi.config(IPAddress(s_cache.ip), IPAddress(s_cache.gateway),
+                    IPAddress(s_cache.mask), IPAddress(s_cache.dns));
+        return true;
+    }
+    WiFi.config(IPAddress(), IPAddress(), IPAddress());     // 0.0.0.0: DHCP
+    return false;
+}
+
+// -- Lease probe -----------------------------------------------------------
+// RFC 5227: a reused lease isn't configured until it has been probed. The
+// link comes up with no address and ARP requests for the lease go out
+// from 0.0.0.0, so no neighbour's cache learns anything from them. Any
+// ARP from another MAC that claims the address, or probes for it too,
+// means it was handed on. Frames are watched by wrapping the STA netif's
+// input, which runs in the driver's task; sending and (un)wrapping run
+// on the tcpip thread, as NetResolve's calls do.
+
+static constexpr uint8_t ARP_PROBES = 2;        // across WIFI_ARP_PROBE_MS
+static constexpr size_t  ARP_FRAME  = 42;       // Ethernet + ARP for IPv4
+
+static volatile uint32_t s_probeIp    = 0;      // address under probe
+static volatile bool     s_probeHeard = false;  // another host answered for it
+static netif_input_fn    s_netifInput = nullptr;
+static uint8_t           s_ourMac[6];
+
+static esp_netif_t* staHandle() {
+    return esp_netif_get_handle_from_ifkey("WIFI_STA_DEF");
+}
+
+static err_t probeInput(struct pbuf* p, struct netif* n) {
+    const uint8_t* f = static_cast<const uint8_t*>(p->payload);
+    if (p->len >= ARP_FRAME && f[12] == 0x08 && f[13] == 0x06 &&
+        memcmp(f + 22, s_ourMac, sizeof(s_ourMac)) != 0) {
+        uint32_t sender, target;
+        memcpy(&sender, f + 28, 4);
+        memcpy(&target, f + 38, 4);
+        uint32_t ip = s_probeIp;
+        // Its holder answering or announcing, or another host probing for it
+        if (sender == ip || (sender == 0 && target == ip)) s_probeHeard = true;
+    }
+    return s_netifInput(p, n);
+}
+
+// Request for the lease from 0.0.0.0, target MAC unknown
+static void sendProbe(struct netif* n) {
+    struct pbuf* p = pbuf_alloc(PBUF_RAW, ARP_FRAME, PBUF_RAM);
+    if (!p) return;
+    static const uint8_t ARP_HEAD[8] = { 0, 1, 0x08, 0x00, 6, 4, 0, 1 };
+    uint8_t* f = static_cast<uint8_t*>(p->payload);
+    uint32_t ip = s_probeIp;
+    memset(f, 0xFF, 6);
+    memcpy(f + 6, n->hwaddr, 6);
+    f[12] = 0x08;
+    f[13] = 0x06;
+    memcpy(f + 14, ARP_HEAD, sizeof(ARP_HEAD));
+    memcpy(f + 22, n->hwaddr, 6);
+    memset(f + 28, 0, 10);
+    memcpy(f + 38, &ip, 4);
+    n->linkoutput(n, p);
+    pbuf_free(p);
+}
+
+struct ProbeCall {
+    struct tcpip_api_call_data call;
+    bool send;          // else stop watching
+};
+
+static err_t probeRun(struct tcpip_api_call_data* c) {
+    ProbeCall* pc = reinterpret_cast<ProbeCall*>(c);
+    esp_netif_t* sta = staHandle();
+    struct netif* n = sta ? static_cast<struct netif*>(esp_netif_get_netif_impl(sta)) : nullptr;
+    if (!n) return ERR_OK;
+    if (!pc->send) {
+        if (n->input == probeInput) n->input = s_netifInput;
+        return ERR_OK;
+    }
+    if (n->input != probeInput) {
+        memcpy(s_ourMac, n->hwaddr, sizeof(s_ourMac));
+        s_netifInput = n->input;        // left set: a frame may still be in probeInput
+        n->input     = probeInput;
+    }
+    sendProbe(n);
+    return ERR_OK;
+}
+
+static void probeCall(bool send) {
+    ProbeCall pc = {};
+    pc.send = send;
+    tcpip_api_call(probeRun, &pc.call);
+}
+
+// -- Attempts --------------------------------------------------------------
+
+enum Attempt : uint8_t { A_NONE, A_FAST, A_SCAN };
+
+static Attempt  s_attempt   = A_NONE;
+static uint32_t s_attemptMs = 0;
+static bool     s_noDhcp    = false;    // attempt's address is preset
+static bool     s_up        = false;
+static uint32_t s_upMs      = 0;        // link came up
+static volatile uint32_t s_gotIpMs = 0; // set by the event task
+static volatile uint32_t s_assocMs = 0; // ... associated, 0 = not (yet)
+static bool     s_probing   = false;    // reused lease awaits its probe
+static uint32_t s_probeMs   = 0;        // first probe sent, 0 = not yet
+static uint8_t  s_probesSent = 0;
+
+static WifiManager::Stats s_stats;
+static uint16_t s_latency[WifiManager::LATENCY_SAMPLES];
+static int      s_latencyCount = 0;
+static int      s_latencyNext  = 0;
+
+static void startAttempt(uint32_t now) {
+    if (s_probing && s_probeMs) probeCall(false);      // cut short
+    WiFi.disconnect();
+    s_gotIpMs    = 0;
+    s_assocMs    = 0;
+    s_probeMs    = 0;
+    s_probesSent = 0;
+    s_probeHeard = false;
+    s_probeIp    = s_cache.ip;
+    s_attemptMs  = now;
+    s_lastReconnect = now;
+    if (s_cache.channel) {
+        // A lease to reuse is held back, and DHCP with it, until probed
+        s_attempt = A_FAST;
+        s_probing = WIFI_ARP_PROBE_MS && !haveStatic() && leaseFresh();
+        s_noDhcp  = configAddress(!s_probing) || s_probing;
+        WiFi.begin(s_ssid, s_pass, s_cache.channel, s_cache.bssid);
+        if (s_probing) esp_netif_dhcpc_stop(staHandle());
+    } else {
+        s_attempt = A_SCAN;
+        s_probing = false;
+        s_noDhcp  = configAddress(false);
+        WiFi.begin(s_ssid, s_pass);
+    }
+}
+
+// Associated with no address: probe, then configure the lease or give it up
+static void probeLease(uint32_t now) {
+    if (!s_probeMs) s_probeMs = now | 1;
+    uint32_t waited = now - s_probeMs;
+    if (!s_probeHeard && waited < WIFI_ARP_PROBE_MS) {
+        if (s_probesSent < ARP_PROBES && waited >= WIFI_ARP_PROBE_MS * s_probesSent / ARP_PROBES) {
+            probeCall(true);
+            s_probesSent++;
+        }
+        return;
+    }
+    probeCall(false);
+    s_probing = false;
+    if (s_probeHeard) {
+        IPAddress ip(s_cache.ip);
+        Serial.printf("[wifi] cached lease %u.%u.%u.%u is taken, asking DHCP\n",
+                      ip[0], ip[1], ip[2], ip[3]);
+        s_stats.leaseTaken++;
+        s_cache.ip = 0;
+        saveCache();
+        startAttempt(now);
+        return;
+    }
+    s_noDhcp = configAddress(true);     // nobody answered: ours again
+}
+
+static void linkUp(uint32_t now) {
+    uint32_t gotAt = s_gotIpMs;
+    uint32_t ms = (gotAt && gotAt - s_attemptMs <= now - s_attemptMs ? gotAt : now) - s_attemptMs;
+
+    s_stats.connects++;
+    s_stats.lastMs = ms;
+    Metrics::inc(Metrics::WIFI_CONNECTS);
+    Metrics::observe(Metrics::WIFI_CONNECT_SECONDS, ms);
+    if (s_attempt == A_FAST) s_stats.fastOk++;
+    else                     s_stats.scanOk++;
+    if (s_noDhcp) s_stats.noDhcp++;
+    s_latency[s_latencyNext] = ms > UINT16_MAX ? UINT16_MAX : ms;
+    s_latencyNext = (s_latencyNext + 1) % WifiManager::LATENCY_SAMPLES;
+    if (s_latencyCount < WifiManager::LATENCY_SAMPLES) s_latencyCount++;
+
+    memcpy(s_cache.bssid, WiFi.BSSID(), sizeof(s_cache.bssid));
+    s_cache.channel = static_cast<uint8_t>(WiFi.channel());
+    if (!s_noDhcp && !haveStatic()) {
+        s_cache.ip      = WiFi.localIP();
+        s_cache.gateway = WiFi.gatewayIP();
+        s_cache.mask    = WiFi.subnetMask();
+        s_cache.dns     = WiFi.dnsIP();
+        s_cache.leaseAt = 0;                // stamped once the clock is set
+        s_leaseMs   = now;
+        s_leaseHere = true;
+    }
+    saveCache();
+
+    Serial.printf("[wifi] up in %lu ms (%s%s), channel %u\n", (unsigned long)ms,
+                  s_attempt == A_FAST ? "fast" : "scan", s_noDhcp ? ", no DHCP" : "",
+                  (unsigned)s_cache.channel);
+    s_attempt = A_NONE;
+    s_up      = true;
+    s_upMs    = now;
+}
 
 void WifiManager::init(const char* ssid, const char* pass) {
     s_ssid = ssid;
@@ -18,28 +324,133 @@ void WifiManager::init(const char* ssid, const char* pass) {
 
     if (!ssid || ssid[0] == '\0') return;
 
+    s_prefs.begin("wifi", false);
+    loadCache();
+    WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) { s_gotIpMs = millis(); },
+                 ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) { s_assocMs = millis(); },
+                 ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) { s_assocMs = 0; },
+                 ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
     WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, pass);
-    s_lastReconnect = millis();
+    startAttempt(millis());
 }
 
 void WifiManager::tick() {
     if (!s_ssid || s_ssid[0] == '\0') return;
-    if (WiFi.status() == WL_CONNECTED) return;
+    uint32_t now = millis();
+    int status = WiFi.status();
+    if (status == WL_CONNECTED) {
+        if (!s_up) linkUp(now);
+        // Wall clock for offline catch-up; SNTP keeps it synced from here
+        if (!s_ntpStarted) {
+            configTime(0, 0, "pool.ntp.org", "time.google.com");
+            s_ntpStarted = true;
+        }
+        // Stamp this boot's lease once the clock is set, so it can be
+        // reused after a restart too
+        if (s_leaseHere && s_cache.leaseAt == 0) {
+            time_t t = time(nullptr);
+            if (t > static_cast<time_t>(EPOCH_VALID_MIN)) {
+                s_cache.leaseAt = static_cast<uint32_t>(t) - (now - s_leaseMs) / 1000;
+                saveCache();
+            }
+        }
+        return;
+    }
 
-    unsigned long now = millis();
-    if (now - s_lastReconnect >= RECONNECT_INTERVAL) {
-        s_lastReconnect = now;
-        WiFi.disconnect();
-        WiFi.begin(s_ssid, s_pass);
+    if (s_up) {
+        // Lost the link: reconnect now, not on the next interval
+        uint32_t upS = (now - s_upMs) / 1000;
+        if (upS > s_stats.longestUpS) s_stats.longestUpS = upS;
+        Serial.printf("[wifi] down after %lu s up\n", (unsigned long)upS);
+        s_up = false;
+        s_stats.drops++;
+        Metrics::inc(Metrics::WIFI_DROPS);
+        startAttempt(now);
+        return;
+    }
+
+    if (s_probing && s_assocMs) {
+        probeLease(now);
+        return;
+    }
+
+    if (s_attempt == A_FAST) {
+        // The probe's wait doesn't count against the AP
+        bool refused = status == WL_NO_SSID_AVAIL || status == WL_CONNECT_FAILED;
+        uint32_t allowed = FAST_TIMEOUT_MS + (s_probeMs ? WIFI_ARP_PROBE_MS : 0);
+        if (!refused && now - s_attemptMs < allowed) return;
+        // AP gone, moved channel or lease taken: scan + DHCP from here
+        s_stats.fastFailed++;
+        s_cache.channel = 0;
+        s_cache.ip      = 0;
+        startAttempt(now);
+        return;
     }
+
+    if (now - s_lastReconnect >= RECONNECT_INTERVAL) startAttempt(now);
 }
 
+// Only once linkUp() has run: never from a lease still under probe
 bool WifiManager::isConnected() {
-    return WiFi.status() == WL_CONNECTED;
+    return s_up && WiFi.status() == WL_CONNECTED;
 }
 
 int WifiManager::rssi() {
     if (!isConnected()) return -100;
     return WiFi.RSSI();
 }
+
+uint32_t WifiManager::uptimeS() {
+    return s_up ? (millis() - s_upMs) / 1000 : 0;
+}
+
+// -- Latency ---------------------------------------------------------------
+
+uint32_t WifiManager::latencyPercentile(uint8_t pct) {
+    if (s_latencyCount == 0) return 0;
+    uint16_t sorted[LATENCY_SAMPLES];
+    memcpy(sorted, s_latency, sizeof(sorted));
+    // Insertion sort: 32 entries, only on demand
+    for (int i = 1; i < s_latencyCount; i++) {
+        uint16_t v = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > v) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    int idx = (s_latencyCount * pct + 99) / 100 - 1;       // nearest rank
+    if (idx < 0) idx = 0;
+    if (idx >= s_latencyCount) idx = s_latencyCount - 1;
+    return sorted[idx];
+}
+
+int WifiManager::latencySamples() {
+    return s_latencyCount;
+}
+
+const WifiManager::Stats& WifiManager::stats() {
+    return s_stats;
+}
+
+void WifiManager::printStats() {
+    Serial.printf("[wifi] %lu connects: %lu fast, %lu after scan, %lu fast fell back, "
+                  "%lu without DHCP (%lu leases taken), %lu drops\n",
+                  (unsigned long)s_stats.connects, (unsigned long)s_stats.fastOk,
+                  (unsigned long)s_stats.scanOk, (unsigned long)s_stats.fastFailed,
+                  (unsigned long)s_stats.noDhcp, (unsigned long)s_stats.leaseTaken,
+                  (unsigned long)s_stats.drops);
+    Serial.printf("[wifi] link up %lu s, longest before a drop %lu s\n",
+                  (unsigned long)uptimeS(), (unsigned long)s_stats.longestUpS);
+    Serial.printf("[wifi] connect ms over %d: p50 %lu, p90 %lu, max %lu, last %lu\n",
+                  s_latencyCount, (unsigned long)latencyPercentile(50),
+                  (unsigned long)latencyPercentile(90), (unsigned long)latencyPercentile(100),
+                  (unsigned long)s_stats.lastMs);
+    Serial.printf("[wifi] cached AP %02x:%02x:%02x:%02x:%02x:%02x ch %u, lease %s\n",
+                  s_cache.bssid[0], s_cache.bssid[1], s_cache.bssid[2], s_cache.bssid[3],
+                  s_cache.bssid[4], s_cache.bssid[5], (unsigned)s_cache.channel,
+                  haveStatic() ? "static" : leaseFresh() ? "reusable" : "none");
+}
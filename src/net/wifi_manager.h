@@ -1,15 +1,41 @@
 #pragma once
+#include <cstdint>
 
 // ==========================================================================
 // WiFi Manager -- STA connect/reconnect, credential storage
+// The last good link (BSSID, channel, DHCP lease) is kept in NVS; a
+// reconnect first tries that AP on that channel, skipping the scan, and
+// only falls back to a full scan + DHCP if it doesn't come up.
 // ==========================================================================
 
 namespace WifiManager {
 
+static constexpr int LATENCY_SAMPLES = 32;
+
+struct Stats {
+    uint32_t connects    = 0;   // links established
+    uint32_t fastOk      = 0;   // ... straight to the cached AP + channel
+    uint32_t scanOk      = 0;   // ... after a full scan
+    uint32_t fastFailed  = 0;   // fast attempts that fell back to a scan
+    uint32_t noDhcp      = 0;   // connects on a reused lease or static IP
+    uint32_t leaseTaken  = 0;   // reused leases another host answered for
+    uint32_t drops       = 0;   // link lost after being up
+    uint32_t lastMs      = 0;   // latency of the last connect
+    uint32_t longestUpS  = 0;   // longest link uptime that ended
+};
+
 void init(const char* ssid, const char* pass);
 void tick();        // Call periodically -- handles reconnect
 
 bool isConnected();
 int rssi();         // Current signal strength
+uint32_t uptimeS(); // Current link's uptime, 0 if down
+
+// Attempt start -> IP, over the last LATENCY_SAMPLES connects (0 if none)
+uint32_t latencyPercentile(uint8_t pct);
+int      latencySamples();
+
+const Stats& stats();
+void printStats();
 
 }  // namespace WifiManager
@@ -12,18 +12,68 @@
 //   ADULT    -> ELDER     : ageDays >= 180, all agents uptimePct > 80%
 //
 // Falls back to time-based when Cosmania not connected (pet survives
-// on WiFi feeding but never evolves past LARVA without Cosmania).
+// on WiFi feeding but never evolves past LARVA without Cosmania); that
+// includes a warm-start snapshot past COSMANIA_STALE_MAX_S.
 // ==========================================================================
 
-static bool agentHasRuns(const CosmaniaStatus& c, const char* name) {
-    for (int i = 0; i < c.agentCount; i++) {
-        if (strncmp(c.agents[i].name, name, 15) == 0 && c.agents[i].todayRuns > 0)
-            return true;
+// -- Milestone agents, resolved to indices once per Cosmania poll ----------
+enum MilestoneAgent { AGENT_SENTINEL, AGENT_DREAMER, AGENT_CODER, MILESTONE_AGENTS };
+static const char* const MILESTONE_NAMES[MILESTONE_AGENTS] = { "sentinel", "dreamer", "coder" };
+
+static int8_t   s_agentIdx[MILESTONE_AGENTS] = { -1, -1, -1 };
+static uint32_t s_agentVersion = 0;
+static bool     s_agentValid   = false;
+
+static void resolveAgents(const CosmaniaStatus& c) {
+    if (s_agentValid && s_agentVersion == c.version) return;
+    for (int m = 0; m < MILESTONE_AGENTS; m++) {
+        s_agentIdx[m] = -1;
+        for (int i = 0; i < c.agentCount; i++) {
+            if (strncmp(c.agents[i].name, MILESTONE_NAMES[m], 15) == 0) {
+                s_agentIdx[m] = i;
+                break;
+            }
+        }
     }
-    return false;
+    s_agentVersion = c.version;
+    s_agentValid   = true;
+}
+
+static bool agentHasRuns(const CosmaniaStatus& c, MilestoneAgent agent) {
+    int idx = s_agentIdx[agent];
+    return idx >= 0 && idx < c.agentCount && c.agents[idx].todayRuns > 0;
 }
 
+// -- Input fingerprint -----------------------------------------------------
+struct EvolutionInputs {
+    uint32_t cosmaniaVersion;
+    uint32_t ageDays;
+    EvolutionStage stage;
+    bool avgAbove40;        // fallback LARVA condition
+};
+
+static EvolutionInputs s_last;
+static bool     s_valid      = false;
+static uint32_t s_recomputed = 0;
+static uint32_t s_skipped    = 0;
+
 void Evolution::update(PetState& pet, const CosmaniaStatus& cosmania) {
+    EvolutionInputs in;
+    in.cosmaniaVersion = cosmania.version;
+    in.ageDays         = pet.ageDays;
+    in.stage           = pet.stage;
+    in.avgAbove40      = (pet.hunger + pet.happiness + pet.health) / 3 > 40;
+
+    if (s_valid && in.cosmaniaVersion == s_last.cosmaniaVersion &&
+        in.ageDays == s_last.ageDays && in.stage == s_last.stage &&
+        in.avgAbove40 == s_last.avgAbove40) {
+        s_skipped++;
+        return;
+    }
+    s_last  = in;
+    s_valid = true;
+    s_recomputed++;
+
     uint32_t ageDays = pet.ageDays;
 
     // Never regress. Check from highest to lowest.
@@ -49,9 +99,11 @@ void Evolution::update(PetState& pet, const CosmaniaStatus& cosmania) {
             return;
         }
 
+        resolveAgents(cosmania);
+
         // LARVA -> NYMPH: dreamer AND coder have todayRuns > 0
-        if (agentHasRuns(cosmania, "dreamer") &&
-            agentHasRuns(cosmania, "coder") &&
+        if (agentHasRuns(cosmania, AGENT_DREAMER) &&
+            agentHasRuns(cosmania, AGENT_CODER) &&
             pet.stage < STAGE_NYMPH) {
             pet.stage = STAGE_NYMPH;
             Sound::discover();
@@ -59,7 +111,7 @@ void Evolution::update(PetState& pet, const CosmaniaStatus& cosmania) {
         }
 
         // EGG -> LARVA: sentinel todayRuns > 0
-        if (agentHasRuns(cosmania, "sentinel") && pet.stage < STAGE_LARVA) {
+        if (agentHasRuns(cosmania, AGENT_SENTINEL) && pet.stage < STAGE_LARVA) {
             pet.stage = STAGE_LARVA;
             Sound::discover();
             return;
@@ -67,14 +119,23 @@ void Evolution::update(PetState& pet, const CosmaniaStatus& cosmania) {
     } else {
         // Fallback: time-based for survival without Cosmania
         // Can only reach LARVA without Cosmania data
-        int avg = (pet.hunger + pet.happiness + pet.health) / 3;
-        if (avg > 40 && ageDays >= 1 && pet.stage < STAGE_LARVA) {
+        if (in.avgAbove40 && ageDays >= 1 && pet.stage < STAGE_LARVA) {
             pet.stage = STAGE_LARVA;
             Sound::discover();
         }
     }
 }
 
+void Evolution::reset() {
+    s_valid      = false;
+    s_agentValid = false;
+}
+
+void Evolution::stats(uint32_t& recomputed, uint32_t& skipped) {
+    recomputed = s_recomputed;
+    skipped    = s_skipped;
+}
+
 const char* Evolution::stageName(EvolutionStage stage) {
     switch (stage) {
         case STAGE_EGG:      return "EGG";
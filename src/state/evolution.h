@@ -3,10 +3,15 @@
 
 // ==========================================================================
 // Evolution -- Stage engine (milestone-based, never regresses)
+// Skips evaluation while its inputs (Cosmania version, stage, age, stat
+// average band) are unchanged.
 // ==========================================================================
 
 namespace Evolution {
 void update(PetState& pet, const CosmaniaStatus& cosmania);
 
+void reset();       // Drop cached inputs (new pet / replay segment)
+void stats(uint32_t& recomputed, uint32_t& skipped);
+
 const char* stageName(EvolutionStage stage);
 }
@@ -4,9 +4,50 @@
 // ==========================================================================
 // Mood -- Priority-based mood selection (Cosmania-driven)
 // Priority: SICK > ANGRY > ANXIOUS > WORKING > HUNGRY > SLEEPY > HAPPY > CONTENT
-// Falls back to WiFi/local state when Cosmania not connected.
+// Falls back to WiFi/local state when Cosmania not connected. A cached
+// warm-start snapshot only reads as connected while younger than
+// COSMANIA_STALE_MAX_S (CosmaniaClient decides), so an old one is ignored.
 // ==========================================================================
 
+// -- Input fingerprint -----------------------------------------------------
+struct MoodInputs {
+    uint32_t wifiVersion;
+    uint32_t cosmaniaVersion;
+    uint32_t radioVersion;
+    uint8_t  petBits;       // the stat thresholds below
+    uint8_t  scanBits;      // no-WiFi staleness (30 s / 60 s)
+};
+
+static MoodInputs s_last;
+static bool       s_valid = false;
+static Mood       s_mood  = MOOD_CONTENT;
+static uint32_t   s_recomputed = 0;
+static uint32_t   s_skipped    = 0;
+
+static MoodInputs fingerprint(const PetState& pet, const WifiStats& wifi,
+                              const CosmaniaStatus& cosmania,
+                              const RadioEnvironment& radio,
+                              unsigned long lastScanTime, unsigned long now) {
+    MoodInputs in;
+    in.wifiVersion     = wifi.version;
+    in.cosmaniaVersion = cosmania.version;
+    in.radioVersion    = radio.version;
+    in.petBits = (pet.hunger < 25 ? 0x01 : 0) | (pet.health < 25 ? 0x02 : 0) |
+                 (pet.happiness > 60 ? 0x04 : 0) | (pet.happiness > 80 ? 0x08 : 0);
+    in.scanBits = 0;
+    if (wifi.netCount == 0 && lastScanTime > 0) {
+        if (now - lastScanTime > 30000) in.scanBits |= 0x01;
+        if (now - lastScanTime > 60000) in.scanBits |= 0x02;
+    }
+    return in;
+}
+
+static bool sameInputs(const MoodInputs& a, const MoodInputs& b) {
+    return a.wifiVersion == b.wifiVersion && a.cosmaniaVersion == b.cosmaniaVersion &&
+           a.radioVersion == b.radioVersion && a.petBits == b.petBits &&
+           a.scanBits == b.scanBits;
+}
+
 static bool anyAgentRecentlyActive(const CosmaniaStatus& c) {
     for (int i = 0; i < c.agentCount; i++) {
         if (c.agents[i].minutesSince >= 0 && c.agents[i].minutesSince < 5)
@@ -15,73 +56,61 @@ static bool anyAgentRecentlyActive(const CosmaniaStatus& c) {
     return false;
 }
 
-void MoodLogic::update(PetState& pet, const WifiStats& wifi,
-                       const CosmaniaStatus& cosmania,
-                       const RadioEnvironment& radio,
-                       unsigned long lastScanTime) {
-    unsigned long now = millis();
-
+static Mood evaluate(const PetState& pet, const WifiStats& wifi,
+                     const CosmaniaStatus& cosmania,
+                     const RadioEnvironment& radio,
+                     unsigned long lastScanTime, unsigned long now) {
     // -- Radio-driven moods (highest priority -- physical safety) ----------
     if (radio.safetyScore < 40) {
         // Critical radio environment overrides everything
-        pet.mood = MOOD_SICK;
-        return;
+        return MOOD_SICK;
     }
 
     // -- Cosmania-driven moods (when connected) ----------------------------
     if (cosmania.connected) {
         // SICK: budgetTier RED or BLACK
         if (cosmania.budgetTier == TIER_RED || cosmania.budgetTier == TIER_BLACK) {
-            pet.mood = MOOD_SICK;
-            return;
+            return MOOD_SICK;
         }
 
         // ANGRY: errorCount >= 3
         if (cosmania.errorCount >= 3) {
-            pet.mood = MOOD_ANGRY;
-            return;
+            return MOOD_ANGRY;
         }
 
         // ANXIOUS: budgetTier YELLOW, overdueCount >= 2, or radio below 80
         if (cosmania.budgetTier == TIER_YELLOW || cosmania.overdueCount >= 2 ||
             radio.safetyScore < 80) {
-            pet.mood = MOOD_ANXIOUS;
-            return;
+            return MOOD_ANXIOUS;
         }
 
         // WORKING: any agent ran within last 5 minutes
         if (anyAgentRecentlyActive(cosmania)) {
-            pet.mood = MOOD_WORKING;
-            return;
+            return MOOD_WORKING;
         }
 
         // HUNGRY: low hunger (WiFi mechanic still drives this)
         if (pet.hunger < 25) {
-            pet.mood = MOOD_HUNGRY;
-            return;
+            return MOOD_HUNGRY;
         }
 
         // SLEEPY: no agents active today
         if (cosmania.activeCount == 0) {
-            pet.mood = MOOD_SLEEPY;
-            return;
+            return MOOD_SLEEPY;
         }
 
         // HAPPY: GREEN tier, no overdue, good stats
         if (cosmania.budgetTier == TIER_GREEN &&
             cosmania.overdueCount == 0 && pet.happiness > 60) {
-            pet.mood = MOOD_HAPPY;
-            return;
+            return MOOD_HAPPY;
         }
 
         // CONTENT: GREEN tier, no overdue
         if (cosmania.budgetTier == TIER_GREEN && cosmania.overdueCount == 0) {
-            pet.mood = MOOD_CONTENT;
-            return;
+            return MOOD_CONTENT;
         }
 
-        pet.mood = MOOD_CONTENT;
-        return;
+        return MOOD_CONTENT;
     }
 
     // -- Fallback: WiFi/local state only (no Cosmania connection) ----------
@@ -90,28 +119,51 @@ void MoodLogic::update(PetState& pet, const WifiStats& wifi,
     if (pet.health < 25 ||
         (wifi.netCount == 0 && lastScanTime > 0 &&
          (now - lastScanTime) > 60000)) {
-        pet.mood = MOOD_SICK;
-        return;
+        return MOOD_SICK;
     }
 
     // HUNGRY
     if (pet.hunger < 25) {
-        pet.mood = MOOD_HUNGRY;
-        return;
+        return MOOD_HUNGRY;
     }
 
     // HAPPY: good stats + WiFi-rich environment
     if (pet.happiness > 80 && wifi.netCount > 8) {
-        pet.mood = MOOD_HAPPY;
-        return;
+        return MOOD_HAPPY;
     }
 
     // SLEEPY: no WiFi for a while
     if (wifi.netCount == 0 && lastScanTime > 0 &&
         (now - lastScanTime) > 30000) {
-        pet.mood = MOOD_SLEEPY;
+        return MOOD_SLEEPY;
+    }
+
+    return MOOD_CONTENT;
+}
+
+void MoodLogic::update(PetState& pet, const WifiStats& wifi,
+                       const CosmaniaStatus& cosmania,
+                       const RadioEnvironment& radio,
+                       unsigned long lastScanTime, unsigned long now) {
+    MoodInputs in = fingerprint(pet, wifi, cosmania, radio, lastScanTime, now);
+    if (s_valid && sameInputs(in, s_last)) {
+        s_skipped++;
+        pet.mood = s_mood;
         return;
     }
 
-    pet.mood = MOOD_CONTENT;
+    s_mood  = evaluate(pet, wifi, cosmania, radio, lastScanTime, now);
+    s_last  = in;
+    s_valid = true;
+    s_recomputed++;
+    pet.mood = s_mood;
+}
+
+void MoodLogic::reset() {
+    s_valid = false;
+}
+
+void MoodLogic::stats(uint32_t& recomputed, uint32_t& skipped) {
+    recomputed = s_recomputed;
+    skipped    = s_skipped;
 }
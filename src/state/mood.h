@@ -3,9 +3,15 @@
 
 // ==========================================================================
 // MoodLogic -- Determines pet mood from Cosmania status + local state
+// Re-evaluated only when an input fingerprint changes (source versions +
+// the stat thresholds mood reads); otherwise the cached mood is reused.
 // ==========================================================================
 
 namespace MoodLogic {
 void update(PetState& pet, const WifiStats& wifi, const CosmaniaStatus& cosmania,
-            const RadioEnvironment& radio, unsigned long lastScanTime);
+            const RadioEnvironment& radio, unsigned long lastScanTime,
+            unsigned long now);
+
+void reset();       // Drop the cached result (new pet / replay segment)
+void stats(uint32_t& recomputed, uint32_t& skipped);
 }
@@ -5,6 +5,7 @@
 #include "../hal/sound.h"
 #include "../hal/leds.h"
 #include "../hal/wifi_radio.h"
+#include "../sys/journal.h"
 #include <Arduino.h>
 
 // ==========================================================================
@@ -35,8 +36,22 @@ static uint8_t s_curiosity = 70;
 static uint8_t s_activity  = 60;
 static uint8_t s_stress    = 40;
 
-void PetLogic::init(Context& ctx) {
-    unsigned long now = millis();
+// -- Deterministic PRNG (xorshift32, seeded at boot, journaled) ------------
+static uint32_t s_rng = 0x9E3779B9u;
+
+static long rnd(long lo, long hi) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    if (hi <= lo) return lo;
+    return lo + static_cast<long>(s_rng % static_cast<uint32_t>(hi - lo));
+}
+
+void PetLogic::seed(uint32_t value) {
+    s_rng = value ? value : 0x9E3779B9u;
+}
+
+void PetLogic::init(Context& ctx, unsigned long now) {
     s_hungerTimer    = now;
     s_happyTimer     = now;
     s_healthTimer    = now;
@@ -45,19 +60,71 @@ void PetLogic::init(Context& ctx) {
     s_restAnimTime   = now;
     s_hungerFrameTime = now;
     s_lastScanTime   = 0;
+    s_decisionInterval = 10000;
+    s_restPhaseStart = 0;
+    s_hungerEffect   = false;
+    s_hungerFrame    = 0;
+    MoodLogic::reset();
+    Evolution::reset();
+
+    // Defaults match a cold boot so a replayed segment starts identically
+    s_curiosity = 70;
+    s_activity  = 60;
+    s_stress    = 40;
 
     // Randomize traits on first boot (stage == EGG means fresh)
     if (ctx.pet->stage == STAGE_EGG && !ctx.pet->hatched) {
-        s_curiosity = random(40, 90);
-        s_activity  = random(30, 90);
-        s_stress    = random(20, 80);
+        s_curiosity = rnd(40, 90);
+        s_activity  = rnd(30, 90);
+        s_stress    = rnd(20, 80);
+    }
+}
+
+// -- Decay rules -----------------------------------------------------------
+// Which branch each stat follows right now. Shared by the per-tick path and
+// catchUp() so the closed form can never drift from the live behaviour.
+struct DecayRules {
+    bool happyTrend;    // GREEN + no errors: happiness trends toward 90
+    int  happyDrop;     // otherwise: points lost per HAPPINESS_DECAY_MS
+    bool healthTarget;  // Cosmania connected: health moves toward target
+    int  target;
+};
+
+static DecayRules decayRules(const PetLogic::Context& ctx, unsigned long now) {
+    DecayRules r = { false, 1, false, 70 };
+
+    if (ctx.cosmania && ctx.cosmania->connected) {
+        // Cosmania-driven happiness trends
+        BudgetTier tier = ctx.cosmania->budgetTier;
+        if (tier == TIER_GREEN && ctx.cosmania->errorCount == 0) {
+            r.happyTrend = true;
+        } else if (tier == TIER_YELLOW || ctx.cosmania->overdueCount > 0) {
+            r.happyDrop = 2;
+        } else if (tier == TIER_RED || tier == TIER_BLACK) {
+            r.happyDrop = 3;
+        }
+
+        // Cosmania-driven health: budgetTier sets target
+        r.healthTarget = true;
+        switch (tier) {
+            case TIER_GREEN:  r.target = 90; break;
+            case TIER_YELLOW: r.target = 65; break;
+            case TIER_RED:    r.target = 30; break;
+            case TIER_BLACK:  r.target = 10; break;
+            default:          r.target = 70; break;
+        }
+    } else if (ctx.wifi->netCount == 0 && s_lastScanTime > 0 &&
+               (now - s_lastScanTime) > 30000) {
+        // Disconnected: faster decay
+        r.happyDrop = 3;
     }
+    return r;
 }
 
 // -- Stat decay ------------------------------------------------------------
-static void decayStats(PetLogic::Context& ctx) {
-    unsigned long now = millis();
+static void decayStats(PetLogic::Context& ctx, unsigned long now) {
     PetState& p = *ctx.pet;
+    DecayRules r = decayRules(ctx, now);
 
     if (now - s_hungerTimer >= HUNGER_DECAY_MS) {
         p.hunger = max(0, p.hunger - 2);
@@ -65,43 +132,19 @@ static void decayStats(PetLogic::Context& ctx) {
     }
 
     if (now - s_happyTimer >= HAPPINESS_DECAY_MS) {
-        // Cosmania-driven happiness trends
-        if (ctx.cosmania && ctx.cosmania->connected) {
-            BudgetTier tier = ctx.cosmania->budgetTier;
-            if (tier == TIER_GREEN && ctx.cosmania->errorCount == 0) {
-                // GREEN + no errors: trend toward 90
-                if (p.happiness < 90) p.happiness = min(100, p.happiness + 1);
-                else p.happiness = max(0, p.happiness - 1);
-            } else if (tier == TIER_YELLOW || ctx.cosmania->overdueCount > 0) {
-                p.happiness = max(0, p.happiness - 2);
-            } else if (tier == TIER_RED || tier == TIER_BLACK) {
-                p.happiness = max(0, p.happiness - 3);
-            } else {
-                p.happiness = max(0, p.happiness - 1);
-            }
-        } else if (ctx.wifi->netCount == 0 && s_lastScanTime > 0 &&
-                   (now - s_lastScanTime) > 30000) {
-            // Disconnected: faster decay
-            p.happiness = max(0, p.happiness - 3);
+        if (r.happyTrend) {
+            if (p.happiness < 90) p.happiness = min(100, p.happiness + 1);
+            else p.happiness = max(0, p.happiness - 1);
         } else {
-            p.happiness = max(0, p.happiness - 1);
+            p.happiness = max(0, p.happiness - r.happyDrop);
         }
         s_happyTimer = now;
     }
 
     if (now - s_healthTimer >= HEALTH_DECAY_MS) {
-        // Cosmania-driven health: budgetTier sets target
-        if (ctx.cosmania && ctx.cosmania->connected) {
-            int target = 70;
-            switch (ctx.cosmania->budgetTier) {
-                case TIER_GREEN:  target = 90; break;
-                case TIER_YELLOW: target = 65; break;
-                case TIER_RED:    target = 30; break;
-                case TIER_BLACK:  target = 10; break;
-                default:          target = 70; break;
-            }
-            if (p.health > target) p.health = max(0, p.health - 2);
-            else if (p.health < target) p.health = min(100, p.health + 1);
+        if (r.healthTarget) {
+            if (p.health > r.target) p.health = max(0, p.health - 2);
+            else if (p.health < r.target) p.health = min(100, p.health + 1);
         } else if (p.hunger < 20 || p.happiness < 20) {
             p.health = max(0, p.health - 2);
         } else {
@@ -125,8 +168,132 @@ static void decayStats(PetLogic::Context& ctx) {
     }
 }
 
+// -- Closed-form catch-up --------------------------------------------------
+// Each stat is a fixed-period timer; "phase" is how far into its period the
+// timer already was, so step n (1-based) lands at n * period - phase ms.
+
+static uint32_t catchUpTimer(unsigned long& timer, unsigned long now,
+                             uint32_t elapsed, uint32_t period, uint32_t& phase) {
+    phase = now - timer;
+    if (phase >= period) phase = period - 1;    // overdue: first step is immediate
+    uint64_t span = static_cast<uint64_t>(elapsed) + phase;
+    timer = now - static_cast<unsigned long>(span % period);
+    return static_cast<uint32_t>(span / period);
+}
+
+static int64_t stepTime(uint32_t n, uint32_t period, uint32_t phase) {
+    if (n == 0) return 0;
+    return static_cast<int64_t>(n) * period - phase;
+}
+
+// First step n >= 1 that lands at or after time t
+static uint32_t firstStepFrom(int64_t t, uint32_t period, uint32_t phase) {
+    int64_t n = (t + phase + period - 1) / static_cast<int64_t>(period);
+    return n < 1 ? 1 : static_cast<uint32_t>(n);
+}
+
+static uint32_t ceilDiv(uint32_t a, uint32_t b) { return (a + b - 1) / b; }
+
+static int dropBy(int value, int perStep, uint32_t steps) {
+    int64_t v = value - static_cast<int64_t>(perStep) * steps;
+    return v < 0 ? 0 : static_cast<int>(v);
+}
+
+// Steps until a value dropping perStep per step first goes below `below`
+static uint32_t stepsBelow(int value, int perStep, int below) {
+    if (value < below) return 0;
+    return ceilDiv(static_cast<uint32_t>(value - below + 1), perStep);
+}
+
+void PetLogic::catchUp(Context& ctx, uint32_t elapsedMs, unsigned long now) {
+    PetState& p = *ctx.pet;
+    if (!p.alive || elapsedMs == 0) return;
+
+    DecayRules r = decayRules(ctx, now);
+
+    uint32_t phHunger, phHappy, phHealth, phAge;
+    uint32_t nHunger = catchUpTimer(s_hungerTimer, now, elapsedMs, HUNGER_DECAY_MS,    phHunger);
+    uint32_t nHappy  = catchUpTimer(s_happyTimer,  now, elapsedMs, HAPPINESS_DECAY_MS, phHappy);
+    uint32_t nHealth = catchUpTimer(s_healthTimer, now, elapsedMs, HEALTH_DECAY_MS,    phHealth);
+    uint32_t nAge    = catchUpTimer(s_ageTimer,    now, elapsedMs, AGE_TICK_MS,        phAge);
+
+    const int hunger0 = p.hunger, happy0 = p.happiness, health0 = p.health;
+
+    // Hunger: -2 per step
+    int hunger = dropBy(hunger0, 2, nHunger);
+
+    // Happiness: trend toward 90 (then 89/90 oscillation) or a fixed drop
+    int happy;
+    if (r.happyTrend) {
+        uint32_t reach = happy0 < 90 ? 90 - happy0 : happy0 - 89;
+        if (nHappy <= reach) {
+            happy = happy0 < 90 ? happy0 + nHappy : happy0 - nHappy;
+        } else {
+            bool odd = (nHappy - reach) & 1;
+            int landed = happy0 < 90 ? 90 : 89;
+            happy = odd ? (landed == 90 ? 89 : 90) : landed;
+        }
+    } else {
+        happy = dropBy(happy0, r.happyDrop, nHappy);
+    }
+
+    // Health: toward the Cosmania target, or -1 until hunger/happiness
+    // fall below 20 and -2 after that
+    int health;
+    uint32_t healthZeroStep = 0;            // 0: never reaches zero here
+    if (r.healthTarget) {
+        if (health0 > r.target) {
+            uint32_t down = ceilDiv(health0 - r.target, 2);
+            if (nHealth < down) {
+                health = health0 - 2 * nHealth;
+            } else {
+                health = health0 - 2 * down;            // target or target-1
+                if (health < r.target && nHealth > down) health = r.target;
+            }
+        } else {
+            uint32_t up = r.target - health0;
+            health = nHealth < up ? health0 + static_cast<int>(nHealth) : r.target;
+        }
+    } else {
+        // Disconnected branch: happiness only ever drops here
+        int64_t lowAt = min(stepTime(stepsBelow(hunger0, 2, 20), HUNGER_DECAY_MS, phHunger),
+                            stepTime(stepsBelow(happy0, r.happyDrop, 20),
+                                     HAPPINESS_DECAY_MS, phHappy));
+        uint32_t slow = firstStepFrom(lowAt, HEALTH_DECAY_MS, phHealth) - 1;
+
+        if (static_cast<uint32_t>(health0) <= slow) {
+            healthZeroStep = health0;
+        } else {
+            healthZeroStep = slow + ceilDiv(health0 - slow, 2);
+        }
+
+        uint32_t slowSteps = min(nHealth, slow);
+        health = dropBy(dropBy(health0, 1, slowSteps), 2, nHealth - slowSteps);
+    }
+
+    // Death: the live tick stops once all three hit zero, so does aging
+    if (hunger <= 0 && happy <= 0 && health <= 0) {
+        int64_t deadAt = stepTime(ceilDiv(hunger0, 2), HUNGER_DECAY_MS, phHunger);
+        deadAt = max(deadAt, stepTime(ceilDiv(happy0, r.happyDrop), HAPPINESS_DECAY_MS, phHappy));
+        deadAt = max(deadAt, stepTime(healthZeroStep, HEALTH_DECAY_MS, phHealth));
+        nAge = static_cast<uint32_t>((max<int64_t>(deadAt, 0) + phAge) / AGE_TICK_MS);
+        p.alive = false;
+        LEDs::sad();
+    }
+
+    p.hunger    = hunger;
+    p.happiness = happy;
+    p.health    = health;
+
+    // Age: normalise total minutes
+    uint64_t minutes = p.ageMinutes + 60ULL * p.ageHours + 1440ULL * p.ageDays + nAge;
+    p.ageDays    = static_cast<uint32_t>(minutes / 1440);
+    p.ageHours   = static_cast<uint32_t>((minutes / 60) % 24);
+    p.ageMinutes = static_cast<uint32_t>(minutes % 60);
+}
+
 // -- WiFi feeding ----------------------------------------------------------
-void PetLogic::resolveHunt(Context& ctx) {
+void PetLogic::resolveHunt(Context& ctx, unsigned long now) {
     PetState& p = *ctx.pet;
     WifiStats& w = *ctx.wifi;
 
@@ -154,7 +321,7 @@ void PetLogic::resolveHunt(Context& ctx) {
 
     s_hungerEffect    = true;
     s_hungerFrame     = 0;
-    s_hungerFrameTime = millis();
+    s_hungerFrameTime = now;
 }
 
 void PetLogic::resolveDiscover(Context& ctx) {
@@ -166,7 +333,11 @@ void PetLogic::resolveDiscover(Context& ctx) {
         p.hunger    = max(0, p.hunger - 3);
         Sound::badFeed();
     } else {
-        int curiosity = w.hiddenCount * 4 + w.openCount * 3 + w.netCount;
+        // Networks never heard before are the find; familiar ones count
+        // for a little, and less than anything that changed since last time
+        int familiar  = max(0, w.netCount - w.newCount);
+        int curiosity = w.newCount * 6 + w.changedCount * 2 + w.hiddenCount * 4 +
+                        w.openCount * 3 + familiar / 2;
         int happyDelta = min(35, curiosity / 2);
         p.happiness = min(100, p.happiness + happyDelta);
         p.hunger    = max(0, p.hunger - 5);
@@ -175,10 +346,9 @@ void PetLogic::resolveDiscover(Context& ctx) {
 }
 
 // -- Rest state machine ----------------------------------------------------
-static void stepRest(PetLogic::Context& ctx) {
+static void stepRest(PetLogic::Context& ctx, unsigned long now) {
     if (*ctx.activity != ACT_REST || *ctx.restPhase == REST_NONE) return;
 
-    unsigned long now = millis();
     PetState& p = *ctx.pet;
 
     switch (*ctx.restPhase) {
@@ -236,21 +406,20 @@ static void stepRest(PetLogic::Context& ctx) {
 }
 
 // -- Autonomous decisions --------------------------------------------------
-static void decideActivity(PetLogic::Context& ctx) {
+static void decideActivity(PetLogic::Context& ctx, unsigned long now) {
     if (*ctx.activity != ACT_NONE || *ctx.restPhase != REST_NONE) return;
 
-    unsigned long now = millis();
     if (now - s_decisionTimer < s_decisionInterval) return;
 
     s_decisionTimer = now;
-    s_decisionInterval = random(DECISION_INTERVAL_MIN, DECISION_INTERVAL_MAX);
+    s_decisionInterval = rnd(DECISION_INTERVAL_MIN, DECISION_INTERVAL_MAX);
 
     PetState& p = *ctx.pet;
     WifiStats& w = *ctx.wifi;
 
     int desireHunt = (100 - p.hunger) + s_curiosity / 2;
     int desireDisc = s_curiosity + w.hiddenCount * 10 + w.openCount * 6 +
-                     w.netCount * 2 + random(0, 20);
+                     w.netCount * 2 + rnd(0, 20);
     int desireRest = (100 - p.health) + s_stress / 2;
     int desireIdle = 10;
 
@@ -286,21 +455,20 @@ static void decideActivity(PetLogic::Context& ctx) {
         *ctx.activity         = ACT_REST;
         *ctx.restPhase        = REST_ENTER;
         *ctx.restFrameIndex   = 4;
-        *ctx.restDurationMs   = random(REST_MIN_DURATION, REST_MAX_DURATION);
+        *ctx.restDurationMs   = rnd(REST_MIN_DURATION, REST_MAX_DURATION);
         *ctx.restStatsApplied = false;
-        s_restAnimTime        = millis();
-        s_restPhaseStart      = millis();
+        s_restAnimTime        = now;
+        s_restPhaseStart      = now;
         Sound::restStart();
         LEDs::rest();
     }
 }
 
 // -- Main tick -------------------------------------------------------------
-void PetLogic::tick(Context& ctx) {
-    decayStats(ctx);
+void PetLogic::tick(Context& ctx, unsigned long now) {
+    decayStats(ctx, now);
 
     // Hunger effect animation
-    unsigned long now = millis();
     if (s_hungerEffect && now - s_hungerFrameTime >= HUNGER_EFFECT_DELAY) {
         s_hungerFrameTime = now;
         s_hungerFrame++;
@@ -314,8 +482,9 @@ void PetLogic::tick(Context& ctx) {
     if (*ctx.activity == ACT_HUNT || *ctx.activity == ACT_DISCOVER) {
         if (WifiRadio::isScanDone()) {
             *ctx.wifi = WifiRadio::getResults();
-            s_lastScanTime = millis();
-            if (*ctx.activity == ACT_HUNT)      resolveHunt(ctx);
+            Journal::wifiScan(now, *ctx.wifi);
+            s_lastScanTime = now;
+            if (*ctx.activity == ACT_HUNT)      resolveHunt(ctx, now);
             else if (*ctx.activity == ACT_DISCOVER) resolveDiscover(ctx);
             *ctx.activity = ACT_NONE;
             LEDs::off();
@@ -323,12 +492,12 @@ void PetLogic::tick(Context& ctx) {
     }
 
     // Rest
-    stepRest(ctx);
+    stepRest(ctx, now);
 
     // Mood + evolution (Cosmania-driven when connected, radio-aware)
     const CosmaniaStatus& cs = ctx.cosmania ? *ctx.cosmania : CosmaniaStatus();
     const RadioEnvironment& re = ctx.radio ? *ctx.radio : RadioEnvironment();
-    MoodLogic::update(*ctx.pet, *ctx.wifi, cs, re, s_lastScanTime);
+    MoodLogic::update(*ctx.pet, *ctx.wifi, cs, re, s_lastScanTime, now);
     Evolution::update(*ctx.pet, cs);
 
     // Death check
@@ -339,10 +508,10 @@ void PetLogic::tick(Context& ctx) {
     }
 
     // Autonomous decisions (only when on home screen, idle)
-    decideActivity(ctx);
+    decideActivity(ctx, now);
 }
 
-void PetLogic::resetPet(Context& ctx, bool fullReset) {
+void PetLogic::resetPet(Context& ctx, bool fullReset, unsigned long now) {
     ctx.pet->hunger    = 70;
     ctx.pet->happiness = 70;
     ctx.pet->health    = 70;
@@ -359,7 +528,6 @@ void PetLogic::resetPet(Context& ctx, bool fullReset) {
     s_lastScanTime = 0;
     LEDs::off();
 
-    unsigned long now = millis();
     s_hungerTimer   = now;
     s_happyTimer    = now;
     s_healthTimer   = now;
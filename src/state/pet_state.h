@@ -20,14 +20,21 @@ struct Context {
     const RadioEnvironment* radio;
 };
 
-void init(Context& ctx);
-void tick(Context& ctx);       // Call at LOGIC_TICK_MS intervals
+// All entry points take the clock explicitly so a journal can replay them
+void seed(uint32_t value);     // PRNG seed for decisions/traits (call before init)
+void init(Context& ctx, unsigned long now);
+void tick(Context& ctx, unsigned long now);    // Call at LOGIC_TICK_MS intervals
+
+// Apply elapsedMs of stat decay + aging in O(1) (sleep, power loss).
+// Equivalent to ticking through the gap with the current Cosmania/WiFi
+// inputs held constant; timer phases carry over so nothing is lost.
+void catchUp(Context& ctx, uint32_t elapsedMs, unsigned long now);
 
 // WiFi feeding results
-void resolveHunt(Context& ctx);
+void resolveHunt(Context& ctx, unsigned long now);
 void resolveDiscover(Context& ctx);
 
 // Reset
-void resetPet(Context& ctx, bool fullReset);
+void resetPet(Context& ctx, bool fullReset, unsigned long now);
 
 }  // namespace PetLogic
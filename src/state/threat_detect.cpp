@@ -10,7 +10,8 @@
 // Threat Detection -- Pattern matching against known threat signatures
 //
 // Detects locally (no network):
-//   1. Rogue BLE scanner:    device scanning at rate > threshold
+//   1. Rogue BLE scanner:    device advertising at rate > threshold
+//                            (a decayed per-minute rate, see BLE::scanRate)
 //   2. Evil twin WiFi AP:    (future -- needs known network list)
 //   3. Deauth attack:        deauth frame count > threshold in window
 //   4. Mass BLE enumeration: many scan requests from single source
@@ -71,11 +72,20 @@ void ThreatDetect::init() {
     s_lastEvalMs = 0;
 }
 
+static bool sameEnvironment(const RadioEnvironment& a, const RadioEnvironment& b) {
+    return a.bleDeviceCount == b.bleDeviceCount &&
+           a.bleScannerCount == b.bleScannerCount &&
+           a.probeCount == b.probeCount && a.uniqueProbers == b.uniqueProbers &&
+           a.deauthCount == b.deauthCount && a.threatCount == b.threatCount &&
+           a.worstThreat == b.worstThreat && a.safetyScore == b.safetyScore;
+}
+
 void ThreatDetect::evaluate() {
+    RadioEnvironment prev = s_env;
     expireThreats();
 
     // -- Gather BLE data ---------------------------------------------------
-    s_env.bleDeviceCount = BLE::deviceCount();
+    s_env.bleDeviceCount = BLE::distinctDevices(RADIO_COUNT_WINDOW_S);
     s_env.bleScannerCount = BLE::scannerCount();
 
     // Check for rogue BLE scanners
@@ -83,14 +93,16 @@ void ThreatDetect::evaluate() {
         const BleDevice* d = BLE::device(i);
         if (!d) continue;
 
-        if (d->scanRate >= ROGUE_SCAN_THRESHOLD) {
+        // Adverts per minute right now, not a count since first seen
+        float rate = BLE::scanRate(*d);
+        if (rate >= ROGUE_SCAN_THRESHOLD) {
             char detail[48];
             snprintf(detail, sizeof(detail), "BLE scanner: %d/min RSSI:%d",
-                     d->scanRate, d->rssi);
+                     static_cast<int>(rate), d->rssi);
             addThreat(THREAT_ROGUE_SCANNER, THREAT_WARNING, detail);
         }
 
-        if (d->scanRate >= MASS_ENUM_THRESHOLD) {
+        if (rate >= MASS_ENUM_THRESHOLD) {
             addThreat(THREAT_MASS_ENUM, THREAT_CRITICAL,
                       "Mass BLE enumeration detected");
         }
@@ -139,6 +151,9 @@ void ThreatDetect::evaluate() {
 
     if (score < 0) score = 0;
     s_env.safetyScore = score;
+
+    // Consumers (mood) skip work until something actually changed
+    if (!sameEnvironment(prev, s_env)) s_env.version = prev.version + 1;
 }
 
 void ThreatDetect::tick() {
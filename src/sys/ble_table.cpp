@@ -0,0 +1,136 @@
+#include "ble_table.h"
+#include <new>
+
+// ==========================================================================
+// BLE Table -- index, LRU list and in-place eviction
+// The address hash is already FNV-1a, but its low bits are its weakest,
+// so the index slot comes from a Fibonacci multiply's top bits. Storage
+// is devices, then the index, then the links: each part stays aligned.
+// ==========================================================================
+
+static constexpr uint32_t FIB = 0x9E3779B9u;
+
+uint32_t BleTable::keyOf(const uint8_t addrHash[4]) {
+    return static_cast<uint32_t>(addrHash[0]) << 24 | static_cast<uint32_t>(addrHash[1]) << 16 |
+           static_cast<uint32_t>(addrHash[2]) << 8 | addrHash[3];
+}
+
+// A power of two at least twice the capacity: probe runs stay short
+uint32_t BleTable::indexSizeFor(uint32_t capacity) {
+    uint32_t size = 16;
+    while (size < capacity * 2) size <<= 1;
+    return size;
+}
+
+size_t BleTable::bytesFor(uint32_t capacity) {
+    return capacity * sizeof(BleDevice) + indexSizeFor(capacity) * sizeof(Slot) +
+           capacity * sizeof(Link);
+}
+
+bool BleTable::init(void* storage, uint32_t capacity) {
+    if (!storage || capacity < CAPACITY_MIN || capacity > CAPACITY_MAX) return false;
+    uint32_t indexSize = indexSizeFor(capacity);
+    uint8_t* p = static_cast<uint8_t*>(storage);
+    m_devices  = reinterpret_cast<BleDevice*>(p);
+    m_index    = reinterpret_cast<Slot*>(p + capacity * sizeof(BleDevice));
+    m_links    = reinterpret_cast<Link*>(p + capacity * sizeof(BleDevice) + indexSize * sizeof(Slot));
+    m_capacity = capacity;
+    m_mask     = indexSize - 1;
+    m_shift    = 32;
+    for (uint32_t s = indexSize; s > 1; s >>= 1) m_shift--;
+    clear();
+    return true;
+}
+
+void BleTable::clear() {
+    for (uint32_t i = 0; i <= m_mask && m_index; i++) m_index[i].device = NONE;
+    m_count = 0;
+    m_head  = NONE;
+    m_tail  = NONE;
+}
+
+uint32_t BleTable::home(uint32_t key) const { return (key * FIB) >> m_shift; }
+
+uint32_t BleTable::locate(uint32_t key) const {
+    uint32_t i = home(key);
+    while (m_index[i].device != NONE && m_index[i].key != key) i = (i + 1) & m_mask;
+    return i;
+}
+
+const BleDevice* BleTable::find(const uint8_t addrHash[4]) const {
+    if (!m_capacity) return nullptr;
+    const Slot& s = m_index[locate(keyOf(addrHash))];
+    return s.device == NONE ? nullptr : &m_devices[s.device];
+}
+
+// -- LRU list --------------------------------------------------------------
+
+void BleTable::unlink(uint16_t d) {
+    Link& l = m_links[d];
+    if (l.prev != NONE) m_links[l.prev].next = l.next;
+    else                m_head = l.next;
+    if (l.next != NONE) m_links[l.next].prev = l.prev;
+    else                m_tail = l.prev;
+}
+
+void BleTable::pushFront(uint16_t d) {
+    m_links[d].prev = NONE;
+    m_links[d].next = m_head;
+    if (m_head != NONE) m_links[m_head].prev = d;
+    else                m_tail = d;
+    m_head = d;
+}
+
+// -- Upsert ----------------------------------------------------------------
+
+BleDevice* BleTable::upsert(const uint8_t addrHash[4], bool& created) {
+    created = false;
+    if (!m_capacity) return nullptr;
+    uint32_t key = keyOf(addrHash);
+    uint32_t i   = locate(key);
+    uint16_t d   = m_index[i].device;
+
+    if (d != NONE) {
+        if (d != m_head) {
+            unlink(d);
+            pushFront(d);
+        }
+        m_stats.updates++;
+        return &m_devices[d];
+    }
+
+    if (m_count < m_capacity) {
+        d = static_cast<uint16_t>(m_count++);
+    } else {
+        // Reuse the least recent device's slot; its index entry goes, and
+        // the backward shift may move the empty slot found above
+        d = m_tail;
+        unlink(d);
+        removeAt(locate(keyOf(m_devices[d].addrHash)));
+        i = locate(key);
+        m_stats.evictions++;
+    }
+    m_index[i].key    = key;
+    m_index[i].device = d;
+    pushFront(d);
+
+    BleDevice* dev = new (&m_devices[d]) BleDevice();
+    for (int k = 0; k < 4; k++) dev->addrHash[k] = addrHash[k];
+    m_stats.inserts++;
+    created = true;
+    return dev;
+}
+
+// Backward-shift delete: pull later members of the probe run into the hole
+void BleTable::removeAt(uint32_t i) {
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & m_mask; m_index[j].device != NONE; j = (j + 1) & m_mask) {
+        uint32_t h = home(m_index[j].key);
+        // Move j back only if its home is not cyclically in (hole, j]
+        bool stays = hole <= j ? (hole < h && h <= j) : (hole < h || h <= j);
+        if (stays) continue;
+        m_index[hole] = m_index[j];
+        hole = j;
+    }
+    m_index[hole].device = NONE;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "types.h"
+
+// ==========================================================================
+// BLE Table -- Every BLE device heard, keyed on its address hash
+// Platform-neutral (no Arduino deps): BLE::tick() feeds it on the device
+// with what the scan callback heard, tools/ble_table_bench/ drives it
+// with synthetic adverts. Not thread-safe: one context owns it.
+//
+// Devices sit in a dense array that never moves or reorders: entries()
+// with size() is the stable iteration API BLE::devices() hands out. An
+// open-addressing index (linear probing, at most half full, backward-
+// shift deletes) maps the hash to a device, and an intrusive LRU list
+// threads the devices most recent first. A hit, a miss and an eviction
+// are all O(1): a full table reuses the least recently heard device's
+// slot in place. Everything lives in one caller-supplied block (PSRAM on
+// the device when there is any) of bytesFor(capacity).
+// ==========================================================================
+
+class BleTable {
+public:
+    static constexpr uint32_t CAPACITY_MIN = 8;
+    static constexpr uint32_t CAPACITY_MAX = 0xFFFE;    // 16-bit links
+
+    struct Stats {
+        uint32_t inserts   = 0;
+        uint32_t updates   = 0;
+        uint32_t evictions = 0;
+    };
+
+    static size_t bytesFor(uint32_t capacity);
+
+    // `storage` holds bytesFor(capacity), 4-byte aligned; capacity in
+    // [CAPACITY_MIN, CAPACITY_MAX], any value. false if not
+    bool init(void* storage, uint32_t capacity);
+    void clear();
+
+    // The device with this address hash, made the most recent. If there
+    // is none, a fresh BleDevice with addrHash set -- in the least recent
+    // device's slot when the table is full -- and `created` is true
+    BleDevice* upsert(const uint8_t addrHash[4], bool& created);
+
+    const BleDevice* find(const uint8_t addrHash[4]) const;
+
+    // Dense, slot order: [0, size()). A slot changes device only by
+    // eviction, and clear() empties the lot
+    const BleDevice* entries() const { return m_devices; }
+    BleDevice*       entries()       { return m_devices; }
+
+    // Most recently heard first
+    template <typename Fn>
+    void forEachRecent(Fn fn) const {
+        for (uint16_t i = m_head; i != NONE; i = m_links[i].next) fn(m_devices[i]);
+    }
+
+    const BleDevice* oldest() const { return m_tail == NONE ? nullptr : &m_devices[m_tail]; }
+
+    uint32_t size() const     { return m_count; }
+    uint32_t capacity() const { return m_capacity; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    static constexpr uint16_t NONE = 0xFFFF;
+
+    struct Link {
+        uint16_t prev, next;    // towards the head / the tail
+    };
+    struct Slot {
+        uint32_t key;           // addrHash, so probes don't touch devices
+        uint16_t device;        // NONE = empty
+    };
+
+    static uint32_t keyOf(const uint8_t addrHash[4]);
+    static uint32_t indexSizeFor(uint32_t capacity);
+    uint32_t home(uint32_t key) const;
+    uint32_t locate(uint32_t key) const;    // its slot, or the empty one ending the run
+    void     removeAt(uint32_t i);
+    void     unlink(uint16_t d);
+    void     pushFront(uint16_t d);
+
+    BleDevice* m_devices  = nullptr;
+    Slot*      m_index    = nullptr;
+    Link*      m_links    = nullptr;
+    uint32_t   m_capacity = 0;
+    uint32_t   m_mask     = 0;          // index size - 1
+    uint8_t    m_shift    = 0;          // 32 - log2(index size)
+    uint32_t   m_count    = 0;
+    uint16_t   m_head     = NONE;       // most recent
+    uint16_t   m_tail     = NONE;       // least recent: next to go
+    Stats      m_stats;
+};
@@ -0,0 +1,172 @@
+#include "boot.h"
+#include <Arduino.h>
+#include <atomic>
+
+// ==========================================================================
+// Boot -- Stage scheduler + timings
+// s_done is the only state both cores write; a stage's Timing is filled
+// in before its bit is published, so anyone who sees the bit sees it.
+// ==========================================================================
+
+static constexpr uint32_t TASK_STACK    = 8192;    // BLEDevice::init is stack-hungry
+static constexpr UBaseType_t TASK_PRIO  = 1;
+static constexpr BaseType_t TASK_CORE   = 0;       // loop() runs on core 1
+
+static const Boot::Stage* s_stages = nullptr;
+static int      s_count = 0;
+static Boot::Timing s_timing[Boot::MAX_STAGES];
+
+static std::atomic<uint32_t> s_done{0};
+static uint32_t s_fgPending     = 0;    // foreground stages not yet run
+static uint32_t s_requiredMask  = 0;    // non-deferred stages
+static uint32_t s_allMask       = 0;
+
+static uint32_t s_firstFrameUs  = 0;
+static uint32_t s_interactiveUs = 0;
+static uint32_t s_completeUs    = 0;
+
+static inline uint32_t bit(int i) { return 1u << i; }
+
+static bool depsMet(int i, uint32_t done) {
+    return (s_stages[i].deps & done) == s_stages[i].deps;
+}
+
+static void runStage(int i) {
+    Boot::Timing& t = s_timing[i];
+    t.startUs = micros();
+    s_stages[i].run();
+    t.durUs = micros() - t.startUs;
+    t.core  = static_cast<uint8_t>(xPortGetCoreID());
+    s_done.fetch_or(bit(i));
+    Serial.printf("[boot] %-8s %7lu us  core %u\n", s_stages[i].name,
+                  (unsigned long)t.durUs, t.core);
+}
+
+// First pending stage (table order) whose dependencies are done
+static int nextReady(uint32_t pending) {
+    uint32_t done = s_done.load();
+    for (int i = 0; i < s_count; i++) {
+        if ((pending & bit(i)) && depsMet(i, done)) return i;
+    }
+    return -1;
+}
+
+static void bootTask(void* arg) {
+    uint32_t pending = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(arg));
+    while (pending) {
+        int i = nextReady(pending);
+        if (i < 0) {
+            vTaskDelay(1);          // waiting on a foreground dependency
+            continue;
+        }
+        pending &= ~bit(i);
+        runStage(i);
+    }
+    vTaskDelete(nullptr);
+}
+
+void Boot::firstFrame() {
+    s_firstFrameUs = micros();
+    Serial.printf("[boot] first frame at %lu ms\n", (unsigned long)(s_firstFrameUs / 1000));
+}
+
+void Boot::start(const Stage* stages, int count) {
+    if (count > MAX_STAGES) count = MAX_STAGES;
+    s_stages = stages;
+    s_count  = count;
+
+    uint32_t bgPending = 0;
+    for (int i = 0; i < count; i++) {
+        // Dependencies must point backwards, or the stage could never run
+        if (stages[i].deps >> i) {
+            Serial.printf("[boot] %s depends on a later stage\n", stages[i].name);
+        }
+        s_allMask |= bit(i);
+        if (!(stages[i].flags & STAGE_DEFERRED))   s_requiredMask |= bit(i);
+        if (stages[i].flags & STAGE_BACKGROUND)    bgPending |= bit(i);
+        else                                       s_fgPending |= bit(i);
+    }
+
+    if (bgPending) {
+        BaseType_t ok = xTaskCreatePinnedToCore(
+            bootTask, "boot", TASK_STACK,
+            reinterpret_cast<void*>(static_cast<uintptr_t>(bgPending)),
+            TASK_PRIO, nullptr, TASK_CORE);
+        if (ok != pdPASS) {
+            // No task: run them inline from step() instead
+            Serial.println("[boot] task create failed, running serially");
+            s_fgPending |= bgPending;
+        }
+    }
+}
+
+void Boot::step() {
+    if (s_fgPending) {
+        int i = nextReady(s_fgPending);
+        if (i >= 0) {
+            s_fgPending &= ~bit(i);
+            runStage(i);
+        }
+    }
+
+    uint32_t done = s_done.load();
+    if (!s_interactiveUs && (done & s_requiredMask) == s_requiredMask) {
+        s_interactiveUs = micros();
+        Serial.printf("[boot] interactive at %lu ms\n", (unsigned long)(s_interactiveUs / 1000));
+    }
+    if (!s_completeUs && done == s_allMask) {
+        // Finish time of the last stage, whichever core ran it
+        for (int i = 0; i < s_count; i++) {
+            uint32_t end = s_timing[i].startUs + s_timing[i].durUs;
+            if (end > s_completeUs) s_completeUs = end;
+        }
+        Serial.printf("[boot] complete at %lu ms\n", (unsigned long)(s_completeUs / 1000));
+    }
+}
+
+bool Boot::ready(int stage)  { return s_done.load() & bit(stage); }
+bool Boot::interactive()     { return s_interactiveUs != 0; }
+bool Boot::complete()        { return s_completeUs != 0; }
+
+int Boot::stageCount() { return s_count; }
+int Boot::stagesDone() { return __builtin_popcount(s_done.load()); }
+const Boot::Stage&  Boot::stage(int i)  { return s_stages[i]; }
+const Boot::Timing& Boot::timing(int i) { return s_timing[i]; }
+
+int Boot::slowestStage() {
+    uint32_t done = s_done.load();
+    int worst = -1;
+    for (int i = 0; i < s_count; i++) {
+        if (!(done & bit(i))) continue;
+        if (worst < 0 || s_timing[i].durUs > s_timing[worst].durUs) worst = i;
+    }
+    return worst;
+}
+
+uint32_t Boot::firstFrameUs()  { return s_firstFrameUs; }
+uint32_t Boot::interactiveUs() { return s_interactiveUs; }
+uint32_t Boot::completeUs()    { return s_completeUs; }
+
+void Boot::printStats() {
+    uint32_t done = s_done.load();
+    Serial.printf("  %-8s %-2s %8s %8s  core\n", "stage", "", "start ms", "dur ms");
+    for (int i = 0; i < s_count; i++) {
+        const Stage& st = s_stages[i];
+        char kind[4] = {
+            (st.flags & STAGE_BACKGROUND) ? 'B' : '-',
+            (st.flags & STAGE_DEFERRED) ? 'D' : '-',
+            '\0',
+        };
+        if (!(done & bit(i))) {
+            Serial.printf("  %-8s %s   pending\n", st.name, kind);
+            continue;
+        }
+        const Timing& t = s_timing[i];
+        Serial.printf("  %-8s %s %8.1f %8.1f  %u\n", st.name, kind,
+                      t.startUs / 1000.0f, t.durUs / 1000.0f, t.core);
+    }
+    Serial.printf("[boot] first frame %lu ms, interactive %lu ms, complete %lu ms\n",
+                  (unsigned long)(s_firstFrameUs / 1000),
+                  (unsigned long)(s_interactiveUs / 1000),
+                  (unsigned long)(s_completeUs / 1000));
+}
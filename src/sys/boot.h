@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+
+// ==========================================================================
+// Boot -- Staged subsystem bring-up after the first frame
+// setup() only brings up the display and draws the boot screen; every
+// other init is a Stage with a dependency mask. Foreground stages run one
+// per loop() pass (the boot screen keeps drawing in between), background
+// stages run on a FreeRTOS task on the other core, so a blocking bus probe
+// or radio stack bring-up overlaps the rest of boot. Deferred stages don't
+// hold up input: the game goes interactive once every non-deferred stage
+// is done, and the loop skips a deferred module's tick until ready().
+// Per-stage timings are kept for the console and the sysinfo screen.
+// ==========================================================================
+
+namespace Boot {
+
+static constexpr int MAX_STAGES = 32;      // one bit each in the masks
+
+enum StageFlags : uint8_t {
+    STAGE_BACKGROUND = 0x01,    // run on the boot task, not in loop()
+    STAGE_DEFERRED   = 0x02,    // not needed before input is accepted
+};
+
+struct Stage {
+    const char* name;
+    void      (*run)();
+    uint32_t    deps;           // bit i = stage i must finish first (i < own index)
+    uint8_t     flags;          // StageFlags
+};
+
+struct Timing {
+    uint32_t startUs;           // micros() since reset
+    uint32_t durUs;
+    uint8_t  core;
+};
+
+// Call right after the first frame is pushed to the panel
+void firstFrame();
+
+// Takes the stage table (static storage) and starts the background task
+void start(const Stage* stages, int count);
+
+// Runs the next ready foreground stage, if any; call once per loop()
+void step();
+
+bool ready(int stage);
+bool interactive();             // every non-deferred stage done
+bool complete();                // every stage done
+
+int           stageCount();
+int           stagesDone();
+const Stage&  stage(int i);
+const Timing& timing(int i);
+int           slowestStage();   // -1 before any stage ran
+
+// 0 until reached
+uint32_t firstFrameUs();
+uint32_t interactiveUs();
+uint32_t completeUs();
+
+void printStats();
+
+}  // namespace Boot
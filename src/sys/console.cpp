@@ -0,0 +1,192 @@
+#include "console.h"
+#include "profiler.h"
+#include "journal.h"
+#include "history.h"
+#include "boot.h"
+#include "../state/mood.h"
+#include "../state/evolution.h"
+#include "../hal/storage.h"
+#include "../hal/storage_codec.h"
+#include "../hal/wifi_radio.h"
+#include "../hal/wifi_promisc.h"
+#include "../hal/ble.h"
+#include "../net/cosmania_client.h"
+#include "../net/wifi_manager.h"
+#include "../net/metrics_export.h"
+#include "../net/telemetry.h"
+#include <Arduino.h>
+#include <cstdlib>
+#include <cstring>
+
+// ==========================================================================
+// Console -- Serial command reader + dispatch table
+// ==========================================================================
+
+static constexpr int LINE_MAX = 48;
+static char s_line[LINE_MAX];
+static int  s_lineLen = 0;
+
+struct Command {
+    const char* name;
+    void (*run)(const char* args);
+    const char* help;
+};
+
+static void cmdHelp(const char* args);
+
+static void cmdProf(const char* args) {
+    if (strcmp(args, "reset") == 0) {
+        Profiler::reset();
+        Serial.println("[prof] reset");
+        return;
+    }
+    Profiler::dump();
+}
+
+static void cmdJournal(const char* args) {
+    if (strcmp(args, "flush") == 0) Journal::flush();
+    Journal::printStats();
+}
+
+static void cmdEval(const char*) {
+    uint32_t recomputed, skipped;
+    MoodLogic::stats(recomputed, skipped);
+    Serial.printf("[eval] mood      %lu recomputed %lu skipped\n",
+                  (unsigned long)recomputed, (unsigned long)skipped);
+    Evolution::stats(recomputed, skipped);
+    Serial.printf("[eval] evolution %lu recomputed %lu skipped\n",
+                  (unsigned long)recomputed, (unsigned long)skipped);
+}
+
+static void cmdStorage(const char* args) {
+    if (strcmp(args, "fields") == 0) {
+        for (int i = 0; i < StorageCodec::FIELD_COUNT; i++) {
+            const StorageCodec::Field& f = StorageCodec::FIELDS[i];
+            Serial.printf("  %3u %-20s %3u B x%u  v%u\n", f.tag, f.name,
+                          f.size, f.count, f.since);
+        }
+        return;
+    }
+    const Storage::Stats& st = Storage::stats();
+    Serial.printf("[storage] %lu written %lu skipped %lu failed %lu corrupt slots\n",
+                  (unsigned long)st.written, (unsigned long)st.skipped,
+                  (unsigned long)st.failed, (unsigned long)st.corruptSlots);
+}
+
+static void cmdHistory(const char* args) {
+    if (*args) {
+        History::printRecent(millis(), strtoul(args, nullptr, 10));
+        return;
+    }
+    History::printStats();
+}
+
+static void cmdBoot(const char*) {
+    Boot::printStats();
+}
+
+static void cmdNet(const char*) {
+    WifiManager::printStats();
+    CosmaniaClient::printStats();
+    MetricsExport::printStats();
+    Telemetry::printStats();
+}
+
+static void cmdUpload(const char* args) {
+    if (strcmp(args, "flush") == 0) {
+        Telemetry::flush();
+        Serial.println("[telemetry] batch sealed for upload at the next chance");
+        return;
+    }
+    Telemetry::printStats();
+}
+
+static void cmdNets(const char*) {
+    WifiRadio::printTable();
+}
+
+static void cmdProbes(const char*) {
+    Serial.printf("[promisc] %s: %lu probes drained, %lu dropped (ring full), "
+                  "window %d, %d unique over %ds\n",
+                  WifiPromisc::isEnabled() ? "capturing" : "off",
+                  (unsigned long)WifiPromisc::probeTotal(),
+                  (unsigned long)WifiPromisc::probeOverflows(),
+                  WifiPromisc::probeCount(), WifiPromisc::uniqueProbers(), RADIO_COUNT_WINDOW_S);
+}
+
+static void cmdBle(const char*) {
+    BLE::printStats();
+}
+
+static void cmdCrowd(const char*) {
+    static const uint32_t WINDOWS[] = { 60, 300, 900 };
+    Serial.printf("[crowd] %-8s %6s %6s %6s  (HLL, ~9%% error)\n", "distinct", "1m", "5m", "15m");
+    Serial.printf("[crowd] %-8s", "probers");
+    for (uint32_t w : WINDOWS) Serial.printf(" %6lu", (unsigned long)WifiPromisc::distinctProbers(w));
+    Serial.printf("\n[crowd] %-8s", "ble");
+    for (uint32_t w : WINDOWS) Serial.printf(" %6lu", (unsigned long)BLE::distinctDevices(w));
+    Serial.printf("  (table %d/%d)\n", BLE::deviceCount(), BLE::deviceCapacity());
+}
+
+static const Command COMMANDS[] = {
+    { "help",    cmdHelp,    "list commands" },
+    { "prof",    cmdProf,    "loop profile table [reset]" },
+    { "journal", cmdJournal, "input journal stats [flush]" },
+    { "eval",    cmdEval,    "mood/evolution recompute vs skip counts" },
+    { "storage", cmdStorage, "NVS blob writes vs skipped saves [fields]" },
+    { "history", cmdHistory, "history store stats [minutes: recent samples]" },
+    { "boot",    cmdBoot,    "per-stage boot timings, first frame, interactive" },
+    { "net",     cmdNet,     "WiFi connect latency, Cosmania polls, /metrics scrapes, uploads" },
+    { "nets",    cmdNets,    "networks heard across scans, last scan diff" },
+    { "upload",  cmdUpload,  "telemetry queue occupancy, bytes/event [flush]" },
+    { "probes",  cmdProbes,  "probe capture: drained, dropped on overflow, unique" },
+    { "ble",     cmdBle,     "BLE device table: size, inserts, updates, evictions" },
+    { "crowd",   cmdCrowd,   "distinct probers / BLE devices over 1, 5, 15 min" },
+};
+static constexpr int COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static void cmdHelp(const char*) {
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        Serial.printf("  %-8s %s\n", COMMANDS[i].name, COMMANDS[i].help);
+    }
+}
+
+static void dispatch(char* line) {
+    // Split "name args..." at the first space
+    char* args = strchr(line, ' ');
+    if (args) {
+        *args++ = '\0';
+        while (*args == ' ') args++;
+    } else {
+        args = line + strlen(line);
+    }
+
+    if (line[0] == '\0') return;
+
+    for (int i = 0; i < COMMAND_COUNT; i++) {
+        if (strcmp(line, COMMANDS[i].name) == 0) {
+            COMMANDS[i].run(args);
+            return;
+        }
+    }
+    Serial.printf("[console] unknown: %s\n", line);
+}
+
+void Console::init() {
+    s_lineLen = 0;
+}
+
+void Console::tick() {
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c < 0) break;
+
+        if (c == '\n' || c == '\r') {
+            s_line[s_lineLen] = '\0';
+            s_lineLen = 0;
+            dispatch(s_line);
+        } else if (s_lineLen < LINE_MAX - 1) {
+            s_line[s_lineLen++] = static_cast<char>(c);
+        }
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// ==========================================================================
+// Console -- Line-based serial commands (diagnostics)
+// Type "help" in the monitor for the command list.
+// ==========================================================================
+
+namespace Console {
+
+void init();
+void tick();    // Non-blocking: drains Serial, dispatches complete lines
+
+}  // namespace Console
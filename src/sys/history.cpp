@@ -0,0 +1,151 @@
+#include "history.h"
+
+// ==========================================================================
+// History -- sampling + clock glue around HistoryStore
+// ==========================================================================
+
+#if FEATURE_HISTORY
+
+#include "../hal/flash_region.h"
+#include <Arduino.h>
+#include <time.h>
+
+static FlashRegion  s_flash;
+static HistoryStore s_store;
+static bool         s_enabled = false;
+
+static unsigned long s_lastSampleMs = 0;
+static uint32_t      s_baseS   = 0;     // history clock at s_baseMs
+static unsigned long s_baseMs  = 0;
+
+static uint8_t clampByte(int v) {
+    return static_cast<uint8_t>(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+static uint16_t cents(float usd) {
+    float c = usd * 100.0f + 0.5f;
+    return static_cast<uint16_t>(c < 0 ? 0 : c > 65535 ? 65535 : c);
+}
+
+uint32_t History::clock(unsigned long now) {
+    time_t wall = time(nullptr);
+    uint32_t t = s_baseS + (now - s_baseMs) / 1000;
+    if (wall > static_cast<time_t>(EPOCH_VALID_MIN) && static_cast<uint32_t>(wall) > t) {
+        // Clock just got set (or drifted ahead): rebase on it
+        t = static_cast<uint32_t>(wall);
+        s_baseS  = t;
+        s_baseMs = now;
+    }
+    return t;
+}
+
+void History::init(unsigned long now) {
+    s_enabled = s_flash.open("history") && s_store.mount(s_flash);
+    if (!s_enabled) {
+        Serial.println("[history] no partition, disabled");
+        return;
+    }
+    s_baseS  = s_store.newestTime();
+    s_baseMs = now;
+    s_lastSampleMs = now;
+    Serial.printf("[history] %lu samples, %d raw + %d compacted segments\n",
+                  (unsigned long)s_store.sampleCount(),
+                  s_store.segmentsUsed(0), s_store.segmentsUsed(1));
+}
+
+void History::tick(unsigned long now, const PetState& pet, const CosmaniaStatus& cosmania,
+                   const RadioEnvironment& radio, const WifiStats& wifi) {
+    if (!s_enabled || now - s_lastSampleMs < HISTORY_SAMPLE_MS) return;
+    s_lastSampleMs = now;
+
+    HistorySample s;
+    s.time        = clock(now);
+    s.hunger      = clampByte(pet.hunger);
+    s.happiness   = clampByte(pet.happiness);
+    s.health      = clampByte(pet.health);
+    s.mood        = pet.mood;
+    s.stage       = pet.stage;
+    s.flags       = (pet.alive ? HistorySample::FLAG_ALIVE : 0) |
+                    (pet.hatched ? HistorySample::FLAG_HATCHED : 0) |
+                    (cosmania.connected ? HistorySample::FLAG_COSMANIA : 0);
+    s.safetyScore = radio.safetyScore;
+    s.threatCount = clampByte(radio.threatCount);
+    s.worstThreat = radio.worstThreat;
+    s.netCount    = clampByte(wifi.netCount);
+    s.avgRSSI     = static_cast<int8_t>(wifi.avgRSSI < -128 ? -128 : wifi.avgRSSI > 0 ? 0 : wifi.avgRSSI);
+    s.bleDevices  = clampByte(radio.bleDeviceCount);
+    s.probeCount  = clampByte(radio.probeCount);
+    s.budgetTier  = cosmania.budgetTier;
+    s.spendCents  = cents(cosmania.totalDailySpend);
+    s.budgetCents = cents(cosmania.totalDailyBudget);
+    s_store.append(s);
+}
+
+int History::query(uint32_t from, uint32_t to, HistorySample* out, int maxOut) {
+    return s_enabled ? s_store.query(from, to, out, maxOut) : 0;
+}
+
+void History::printStats() {
+    if (!s_enabled) {
+        Serial.println("[history] disabled");
+        return;
+    }
+    const HistoryStore::Stats& st = s_store.stats();
+    Serial.printf("[history] %lu samples %lu..%lu segments %d raw %d compacted %d free\n",
+                  (unsigned long)s_store.sampleCount(),
+                  (unsigned long)s_store.oldestTime(), (unsigned long)s_store.newestTime(),
+                  s_store.segmentsUsed(0), s_store.segmentsUsed(1),
+                  s_store.segmentCount() - s_store.segmentsUsed(0) - s_store.segmentsUsed(1));
+    Serial.printf("[history] appends %lu compactions %lu drops %lu erases %lu torn %lu errors %lu\n",
+                  (unsigned long)st.appends, (unsigned long)st.compactions,
+                  (unsigned long)st.drops, (unsigned long)st.erases,
+                  (unsigned long)st.tornRecords, (unsigned long)st.errors);
+}
+
+// The newest ROWS samples of the span. query() fills oldest first, so
+// page through the span and keep the last ROWS in a ring
+void History::printRecent(unsigned long now, uint32_t minutes) {
+    static constexpr int ROWS = 32;
+    HistorySample rows[ROWS], page[ROWS];
+    uint32_t to = clock(now);
+    uint32_t span = minutes * 60;
+    uint32_t from = to > span ? to - span : 0;
+    uint32_t total = 0;
+    int next = 0;
+    for (;;) {
+        int n = query(from, to, page, ROWS);
+        for (int i = 0; i < n; i++) {
+            rows[next] = page[i];
+            next = (next + 1) % ROWS;
+        }
+        total += n;
+        if (n < ROWS || page[n - 1].time >= to) break;
+        from = page[n - 1].time + 1;
+    }
+
+    Serial.println("  time        span hun hap hea mood safe thr ble spend");
+    if (total > ROWS) Serial.printf("  ... (%lu older, newest %d shown)\n",
+                                    (unsigned long)(total - ROWS), ROWS);
+    int shown = total < ROWS ? static_cast<int>(total) : ROWS;
+    for (int i = 0; i < shown; i++) {
+        const HistorySample& s = rows[total < ROWS ? i : (next + i) % ROWS];
+        Serial.printf("  %10lu %5u %3u %3u %3u %4u %4u %3u %3u %5u\n",
+                      (unsigned long)s.time, s.spanS, s.hunger, s.happiness, s.health,
+                      s.mood, s.safetyScore, s.threatCount, s.bleDevices, s.spendCents);
+    }
+}
+
+#else
+
+// -- Stubs when history disabled -------------------------------------------
+#include <Arduino.h>
+
+void History::init(unsigned long) {}
+void History::tick(unsigned long, const PetState&, const CosmaniaStatus&,
+                   const RadioEnvironment&, const WifiStats&) {}
+int History::query(uint32_t, uint32_t, HistorySample*, int) { return 0; }
+uint32_t History::clock(unsigned long) { return 0; }
+void History::printStats() { Serial.println("[history] disabled"); }
+void History::printRecent(unsigned long, uint32_t) {}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include "config.h"
+#include "types.h"
+#include "history_store.h"
+
+// ==========================================================================
+// History -- Minute-resolution time series of pet, radio and budget state
+// Samples the loop's globals every HISTORY_SAMPLE_MS into a HistoryStore
+// on the "history" partition; older data is kept as 15-minute averages.
+// Timestamps are epoch seconds once the clock is set; before that they
+// continue from the newest stored sample, so the series stays monotonic.
+// Compiles to no-op when FEATURE_HISTORY == 0
+// ==========================================================================
+
+namespace History {
+
+void init(unsigned long now);
+void tick(unsigned long now, const PetState& pet, const CosmaniaStatus& cosmania,
+          const RadioEnvironment& radio, const WifiStats& wifi);
+
+// Samples with from <= time <= to (history clock, s), oldest first
+int query(uint32_t from, uint32_t to, HistorySample* out, int maxOut);
+uint32_t clock(unsigned long now);
+
+void printStats();
+void printRecent(unsigned long now, uint32_t minutes);   // the newest 32 of the last `minutes`
+
+}  // namespace History
@@ -0,0 +1,515 @@
+#include "history_store.h"
+#include "journal_codec.h"
+#include <cstring>
+
+// ==========================================================================
+// History Store -- segment ring, compaction, time-indexed range queries
+//
+// Header slot: [u32 magic][u32 seq][u8 level][u8 -][u16 -][u32 srcMaxSeq]
+//              ... [u16 crc16 @30]
+// Sample slot: [u32 time][u16 span] 14 x u8 [u16 spend][u16 budget]
+//              6 B reserved (0xFF) [u16 crc16 @30]
+// A blank slot reads time 0xFFFFFFFF; slots are programmed in order, so
+// the used count of a segment is a binary search.
+// ==========================================================================
+
+static constexpr uint32_t SEG_MAGIC = 0x54534948;   // "HIST"
+static constexpr uint32_t BLANK     = 0xFFFFFFFF;
+static constexpr uint32_t CRC_AT    = 30;
+static constexpr int      READ_BATCH = 8;           // slots per flash read
+
+using JournalCodec::crc16;
+
+static uint16_t getU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+static void putU16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static void seal(uint8_t* rec) {
+    putU16(rec + CRC_AT, crc16(rec, CRC_AT));
+}
+static bool sealed(const uint8_t* rec) {
+    return getU16(rec + CRC_AT) == crc16(rec, CRC_AT);
+}
+
+static void encode(const HistorySample& s, uint8_t* rec) {
+    memset(rec, 0xFF, HistoryStore::RECORD_SIZE);
+    putU32(rec, s.time);
+    putU16(rec + 4, s.spanS);
+    rec[6]  = s.hunger;
+    rec[7]  = s.happiness;
+    rec[8]  = s.health;
+    rec[9]  = s.mood;
+    rec[10] = s.stage;
+    rec[11] = s.flags;
+    rec[12] = s.safetyScore;
+    rec[13] = s.threatCount;
+    rec[14] = s.worstThreat;
+    rec[15] = s.netCount;
+    rec[16] = static_cast<uint8_t>(s.avgRSSI);
+    rec[17] = s.bleDevices;
+    rec[18] = s.probeCount;
+    rec[19] = s.budgetTier;
+    putU16(rec + 20, s.spendCents);
+    putU16(rec + 22, s.budgetCents);
+    seal(rec);
+}
+
+static void decode(const uint8_t* rec, HistorySample& s) {
+    s.time        = getU32(rec);
+    s.spanS       = getU16(rec + 4);
+    s.hunger      = rec[6];
+    s.happiness   = rec[7];
+    s.health      = rec[8];
+    s.mood        = rec[9];
+    s.stage       = rec[10];
+    s.flags       = rec[11];
+    s.safetyScore = rec[12];
+    s.threatCount = rec[13];
+    s.worstThreat = rec[14];
+    s.netCount    = rec[15];
+    s.avgRSSI     = static_cast<int8_t>(rec[16]);
+    s.bleDevices  = rec[17];
+    s.probeCount  = rec[18];
+    s.budgetTier  = rec[19];
+    s.spendCents  = getU16(rec + 20);
+    s.budgetCents = getU16(rec + 22);
+}
+
+// -- Slot access -----------------------------------------------------------
+uint32_t HistoryStore::slotOffset(int seg, uint32_t slot) const {
+    return seg * FlashRegion::SECTOR_SIZE + (slot + 1) * RECORD_SIZE;
+}
+
+uint32_t HistoryStore::slotTime(int seg, uint32_t slot) const {
+    uint8_t b[4];
+    if (!m_flash->read(slotOffset(seg, slot), b, sizeof(b))) return BLANK;
+    return getU32(b);
+}
+
+bool HistoryStore::readRecord(int seg, uint32_t slot, HistorySample& s) const {
+    uint8_t rec[RECORD_SIZE];
+    if (!m_flash->read(slotOffset(seg, slot), rec, sizeof(rec)) || !sealed(rec)) return false;
+    decode(rec, s);
+    return true;
+}
+
+// Used count by binary search for the first blank slot, then the newest
+// record that passes its CRC (a torn append leaves at most one bad slot)
+void HistoryStore::scanSegment(int seg) {
+    Segment& sg = m_segs[seg];
+    uint32_t lo = 0, hi = SLOTS;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (slotTime(seg, mid) == BLANK) hi = mid;
+        else lo = mid + 1;
+    }
+    sg.count = static_cast<uint8_t>(lo);
+    sg.first = sg.last = 0;
+    if (sg.count == 0) return;
+
+    sg.first = slotTime(seg, 0);
+    for (int slot = sg.count - 1; slot >= 0; slot--) {
+        HistorySample s;
+        if (readRecord(seg, slot, s)) {
+            sg.last = s.time;
+            return;
+        }
+    }
+    sg.last = sg.first;
+}
+
+// -- Allocation ------------------------------------------------------------
+bool HistoryStore::prepare(int seg) {
+    if (m_segs[seg].state == SEG_FREE) return true;
+    m_stats.erases++;
+    if (!m_flash->eraseSector(seg)) {
+        m_stats.errors++;
+        return false;
+    }
+    m_segs[seg].state = SEG_FREE;
+    return true;
+}
+
+int HistoryStore::freeCount() const {
+    int n = 0;
+    for (int i = 0; i < m_segCount; i++) {
+        if (m_segs[i].state != SEG_USED) n++;
+    }
+    return n;
+}
+
+int HistoryStore::takeFree() {
+    for (int k = 0; k < m_segCount; k++) {
+        int seg = (m_cursor + k) % m_segCount;
+        if (m_segs[seg].state == SEG_USED) continue;
+        m_cursor = (seg + 1) % m_segCount;
+        return prepare(seg) ? seg : -1;
+    }
+    return -1;
+}
+
+void HistoryStore::drop(int seg) {
+    m_segs[seg].state = SEG_DIRTY;
+    prepare(seg);
+    m_stats.drops++;
+}
+
+bool HistoryStore::ensureFree() {
+    while (freeCount() < FREE_RESERVE) {
+        if (freeCount() > 0 && compact()) continue;
+
+        // Nothing left to merge: give up the oldest data (by time, since
+        // a level-1 segment's seq is newer than the samples it holds)
+        int oldest = -1;
+        for (int i = 0; i < m_segCount; i++) {
+            const Segment& sg = m_segs[i];
+            if (sg.state != SEG_USED || i == m_head) continue;
+            if (oldest < 0 || sg.first < m_segs[oldest].first) oldest = i;
+        }
+        if (oldest < 0) return freeCount() > 0;
+        drop(oldest);
+    }
+    return true;
+}
+
+// -- Compaction ------------------------------------------------------------
+struct Bucket {
+    uint32_t start = 0;
+    uint32_t n     = 0;
+    uint32_t hunger = 0, happiness = 0, health = 0;
+    uint32_t net = 0, ble = 0, probes = 0;
+    int32_t  rssi = 0;
+    HistorySample agg;              // min/max/last fields accumulate here
+
+    void add(const HistorySample& s) {
+        if (n == 0) {
+            agg = s;
+        } else {
+            if (s.safetyScore < agg.safetyScore) agg.safetyScore = s.safetyScore;
+            if (s.threatCount > agg.threatCount) agg.threatCount = s.threatCount;
+            if (s.worstThreat > agg.worstThreat) agg.worstThreat = s.worstThreat;
+            agg.mood        = s.mood;
+            agg.stage       = s.stage;
+            agg.flags       = s.flags;
+            agg.budgetTier  = s.budgetTier;
+            agg.spendCents  = s.spendCents;
+            agg.budgetCents = s.budgetCents;
+        }
+        hunger += s.hunger; happiness += s.happiness; health += s.health;
+        net += s.netCount; ble += s.bleDevices; probes += s.probeCount;
+        rssi += s.avgRSSI;
+        n++;
+    }
+
+    HistorySample finish(uint32_t spanS) const {
+        HistorySample s = agg;
+        s.time       = start;
+        s.spanS      = static_cast<uint16_t>(spanS);
+        s.hunger     = static_cast<uint8_t>((hunger + n / 2) / n);
+        s.happiness  = static_cast<uint8_t>((happiness + n / 2) / n);
+        s.health     = static_cast<uint8_t>((health + n / 2) / n);
+        s.netCount   = static_cast<uint8_t>((net + n / 2) / n);
+        s.bleDevices = static_cast<uint8_t>((ble + n / 2) / n);
+        s.probeCount = static_cast<uint8_t>((probes + n / 2) / n);
+        s.avgRSSI    = static_cast<int8_t>(rssi / static_cast<int32_t>(n));
+        return s;
+    }
+};
+
+// Merges the oldest level-0 segments into one level-1 segment. The output
+// header (listing the newest source seq) is programmed after its records;
+// mount() erases any level-0 segment such a header covers.
+bool HistoryStore::compact() {
+    int src[COMPACT_FANIN];
+    int nsrc = 0;
+
+    // Oldest closed level-0 segments, by seq, while their span fits; the
+    // newest RAW_KEEP stay at full resolution
+    int eligible = segmentsUsed(0) - RAW_KEEP;
+    bool taken[MAX_SEGMENTS] = {};
+    while (nsrc < COMPACT_FANIN && nsrc < eligible) {
+        int next = -1;
+        for (int i = 0; i < m_segCount; i++) {
+            const Segment& sg = m_segs[i];
+            if (taken[i] || sg.state != SEG_USED || sg.level != 0 || i == m_head) continue;
+            if (next < 0 || sg.seq < m_segs[next].seq) next = i;
+        }
+        if (next < 0) break;
+        if (nsrc > 0) {
+            uint32_t span = m_segs[next].last / BUCKET_S - m_segs[src[0]].first / BUCKET_S + 1;
+            if (span > SLOTS) break;
+        }
+        taken[next] = true;
+        src[nsrc++] = next;
+    }
+    if (nsrc < 2) return false;
+
+    int out = takeFree();
+    if (out < 0) return false;
+
+    uint32_t emitted = 0;
+    uint32_t first = 0, last = 0;
+    uint32_t srcMaxSeq = 0;
+    bool ok = true;
+    Bucket b;
+
+    auto emit = [&]() {
+        if (b.n == 0 || emitted >= SLOTS) return;
+        uint8_t rec[RECORD_SIZE];
+        HistorySample s = b.finish(BUCKET_S);
+        encode(s, rec);
+        if (!m_flash->write(slotOffset(out, emitted), rec, sizeof(rec))) ok = false;
+        if (emitted == 0) first = s.time;
+        last = s.time;
+        emitted++;
+    };
+
+    for (int k = 0; k < nsrc && ok; k++) {
+        int seg = src[k];
+        if (m_segs[seg].seq > srcMaxSeq) srcMaxSeq = m_segs[seg].seq;
+
+        uint8_t buf[RECORD_SIZE * READ_BATCH];
+        for (uint32_t slot = 0; slot < m_segs[seg].count; slot += READ_BATCH) {
+            uint32_t n = m_segs[seg].count - slot;
+            if (n > READ_BATCH) n = READ_BATCH;
+            if (!m_flash->read(slotOffset(seg, slot), buf, n * RECORD_SIZE)) {
+                ok = false;
+                break;
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                const uint8_t* rec = buf + i * RECORD_SIZE;
+                if (!sealed(rec)) continue;
+                HistorySample s;
+                decode(rec, s);
+                uint32_t start = s.time - s.time % BUCKET_S;
+                if (b.n > 0 && start != b.start) {
+                    emit();
+                    b = Bucket();
+                }
+                b.start = start;
+                b.add(s);
+            }
+        }
+    }
+    emit();
+
+    uint8_t hdr[RECORD_SIZE];
+    memset(hdr, 0xFF, sizeof(hdr));
+    putU32(hdr, SEG_MAGIC);
+    putU32(hdr + 4, m_nextSeq);
+    hdr[8] = 1;
+    putU32(hdr + 12, srcMaxSeq);
+    seal(hdr);
+    if (!ok || !m_flash->write(out * FlashRegion::SECTOR_SIZE, hdr, sizeof(hdr))) {
+        m_segs[out].state = SEG_DIRTY;      // partial output: erase on reuse
+        m_stats.errors++;
+        return false;
+    }
+
+    m_segs[out] = { m_nextSeq++, first, last, static_cast<uint8_t>(emitted), 1, SEG_USED };
+    for (int k = 0; k < nsrc; k++) {
+        m_segs[src[k]].state = SEG_DIRTY;
+        prepare(src[k]);
+    }
+    m_stats.compactions++;
+    return true;
+}
+
+// -- Public ----------------------------------------------------------------
+bool HistoryStore::mount(FlashRegion& flash) {
+    m_flash    = &flash;
+    m_segCount = static_cast<int>(flash.sectorCount());
+    if (m_segCount > MAX_SEGMENTS) m_segCount = MAX_SEGMENTS;
+    m_head     = -1;
+    m_cursor   = 0;
+    m_nextSeq  = 1;
+    if (m_segCount < FREE_RESERVE + 2) return false;
+
+    uint32_t srcMaxSeq = 0;
+    bool anySrc = false;
+    for (int i = 0; i < m_segCount; i++) {
+        Segment& sg = m_segs[i];
+        sg = { 0, 0, 0, 0, 0, SEG_DIRTY };      // unknown contents: erase before use
+
+        uint8_t hdr[RECORD_SIZE];
+        if (!flash.read(i * FlashRegion::SECTOR_SIZE, hdr, sizeof(hdr))) continue;
+        if (getU32(hdr) != SEG_MAGIC || !sealed(hdr)) continue;
+
+        sg.seq   = getU32(hdr + 4);
+        sg.level = hdr[8];
+        sg.state = SEG_USED;
+        if (sg.seq >= m_nextSeq) m_nextSeq = sg.seq + 1;
+        if (sg.level == 1) {
+            uint32_t covered = getU32(hdr + 12);
+            if (!anySrc || covered > srcMaxSeq) srcMaxSeq = covered;
+            anySrc = true;
+        }
+        scanSegment(i);
+    }
+
+    // A compaction cut short after its header landed: drop the sources
+    for (int i = 0; i < m_segCount && anySrc; i++) {
+        Segment& sg = m_segs[i];
+        if (sg.state == SEG_USED && sg.level == 0 && sg.seq <= srcMaxSeq) {
+            sg.state = SEG_DIRTY;
+            prepare(i);
+            m_stats.recovered++;
+        }
+    }
+
+    // Resume the newest level-0 segment if it has room
+    int newest = -1;
+    for (int i = 0; i < m_segCount; i++) {
+        const Segment& sg = m_segs[i];
+        if (sg.state != SEG_USED || sg.level != 0) continue;
+        if (newest < 0 || sg.seq > m_segs[newest].seq) newest = i;
+    }
+    if (newest >= 0 && m_segs[newest].count < SLOTS) m_head = newest;
+    m_cursor = newest >= 0 ? (newest + 1) % m_segCount : 0;
+    return true;
+}
+
+bool HistoryStore::openHead() {
+    m_head = -1;
+    if (!ensureFree()) return false;
+    int seg = takeFree();
+    if (seg < 0) return false;
+
+    uint8_t hdr[RECORD_SIZE];
+    memset(hdr, 0xFF, sizeof(hdr));
+    putU32(hdr, SEG_MAGIC);
+    putU32(hdr + 4, m_nextSeq);
+    hdr[8] = 0;
+    seal(hdr);
+    if (!m_flash->write(seg * FlashRegion::SECTOR_SIZE, hdr, sizeof(hdr))) {
+        m_segs[seg].state = SEG_DIRTY;
+        m_stats.errors++;
+        return false;
+    }
+    m_segs[seg] = { m_nextSeq++, 0, 0, 0, 0, SEG_USED };
+    m_head = seg;
+    return true;
+}
+
+bool HistoryStore::append(const HistorySample& sample) {
+    if (!m_flash) return false;
+    if (m_head < 0 || m_segs[m_head].count >= SLOTS) {
+        if (!openHead()) return false;
+    }
+
+    // Queries rely on time order: never step backwards
+    HistorySample s = sample;
+    uint32_t newest = newestTime();
+    if (s.time < newest) s.time = newest;
+
+    uint8_t rec[RECORD_SIZE];
+    encode(s, rec);
+    Segment& sg = m_segs[m_head];
+    bool ok = m_flash->write(slotOffset(m_head, sg.count), rec, sizeof(rec));
+    if (sg.count == 0) sg.first = s.time;
+    sg.count++;                     // a failed program still consumes the slot
+    if (!ok) {
+        m_stats.errors++;
+        return false;
+    }
+    sg.last = s.time;
+    m_stats.appends++;
+    return true;
+}
+
+int HistoryStore::query(uint32_t from, uint32_t to, HistorySample* out, int maxOut) const {
+    if (!m_flash || from > to) return 0;
+
+    // Overlapping segments in time order (insertion sort; <= MAX_SEGMENTS)
+    int order[MAX_SEGMENTS];
+    int n = 0;
+    for (int i = 0; i < m_segCount; i++) {
+        const Segment& sg = m_segs[i];
+        if (sg.state != SEG_USED || sg.count == 0) continue;
+        if (sg.last < from || sg.first > to) continue;
+        int j = n++;
+        while (j > 0 && m_segs[order[j - 1]].first > sg.first) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    int written = 0;
+    for (int k = 0; k < n && written < maxOut; k++) {
+        int seg = order[k];
+        uint32_t count = m_segs[seg].count;
+
+        uint32_t lo = 0, hi = count;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (slotTime(seg, mid) < from) lo = mid + 1;
+            else hi = mid;
+        }
+
+        uint8_t buf[RECORD_SIZE * READ_BATCH];
+        bool done = false;
+        for (uint32_t slot = lo; slot < count && !done; slot += READ_BATCH) {
+            uint32_t batch = count - slot;
+            if (batch > READ_BATCH) batch = READ_BATCH;
+            if (!m_flash->read(slotOffset(seg, slot), buf, batch * RECORD_SIZE)) break;
+            for (uint32_t i = 0; i < batch; i++) {
+                const uint8_t* rec = buf + i * RECORD_SIZE;
+                if (!sealed(rec)) {
+                    m_stats.tornRecords++;
+                    continue;
+                }
+                HistorySample s;
+                decode(rec, s);
+                if (s.time > to || written >= maxOut) {
+                    done = true;
+                    break;
+                }
+                if (s.time >= from) out[written++] = s;
+            }
+        }
+    }
+    return written;
+}
+
+uint32_t HistoryStore::oldestTime() const {
+    uint32_t t = 0;
+    bool any = false;
+    for (int i = 0; i < m_segCount; i++) {
+        const Segment& sg = m_segs[i];
+        if (sg.state != SEG_USED || sg.count == 0) continue;
+        if (!any || sg.first < t) t = sg.first;
+        any = true;
+    }
+    return t;
+}
+
+uint32_t HistoryStore::newestTime() const {
+    uint32_t t = 0;
+    for (int i = 0; i < m_segCount; i++) {
+        const Segment& sg = m_segs[i];
+        if (sg.state == SEG_USED && sg.count > 0 && sg.last > t) t = sg.last;
+    }
+    return t;
+}
+
+uint32_t HistoryStore::sampleCount() const {
+    uint32_t n = 0;
+    for (int i = 0; i < m_segCount; i++) {
+        if (m_segs[i].state == SEG_USED) n += m_segs[i].count;
+    }
+    return n;
+}
+
+int HistoryStore::segmentsUsed(int level) const {
+    int n = 0;
+    for (int i = 0; i < m_segCount; i++) {
+        if (m_segs[i].state == SEG_USED && m_segs[i].level == level) n++;
+    }
+    return n;
+}
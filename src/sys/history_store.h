@@ -0,0 +1,115 @@
+#pragma once
+#include "../hal/flash_region.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// History Store -- Append-only time series on a raw flash partition
+// Platform-neutral (no Arduino deps): the firmware runs it on the
+// "history" partition, tools/history_bench/ on a file-backed emulator.
+//
+// Each 4 KB sector is one segment: a 32 B header slot + 127 fixed 32 B
+// sample slots, each with its own CRC-16. Raw samples (level 0) append to
+// the head segment; when free sectors run low the oldest level-0
+// segments (beyond the newest RAW_KEEP) are averaged into 15-minute
+// buckets and rewritten as one level-1 segment (records first, header
+// last, then sources erased). Once nothing is eligible for compaction the
+// oldest segment is dropped.
+// A RAM index (seq, level, first/last time per segment) drives range
+// queries: overlapping segments in time order, binary search inside.
+// ==========================================================================
+
+// One sample, quantized to bytes (the flash record is 32 B incl. CRC)
+struct HistorySample {
+    uint32_t time        = 0;   // s, monotonic (epoch once the clock is set)
+    uint16_t spanS       = 0;   // seconds averaged into this sample, 0 = raw
+    uint8_t  hunger      = 0;
+    uint8_t  happiness   = 0;
+    uint8_t  health      = 0;
+    uint8_t  mood        = 0;
+    uint8_t  stage       = 0;
+    uint8_t  flags       = 0;   // FLAG_*
+    uint8_t  safetyScore = 100;
+    uint8_t  threatCount = 0;
+    uint8_t  worstThreat = 0;
+    uint8_t  netCount    = 0;
+    int8_t   avgRSSI     = -100;
+    uint8_t  bleDevices  = 0;
+    uint8_t  probeCount  = 0;
+    uint8_t  budgetTier  = 0;
+    uint16_t spendCents  = 0;   // Cosmania daily spend
+    uint16_t budgetCents = 0;   // Cosmania daily budget
+
+    static constexpr uint8_t FLAG_ALIVE    = 0x01;
+    static constexpr uint8_t FLAG_HATCHED  = 0x02;
+    static constexpr uint8_t FLAG_COSMANIA = 0x04;     // connected
+};
+
+class HistoryStore {
+public:
+    static constexpr size_t   RECORD_SIZE      = 32;
+    static constexpr uint32_t SLOTS            = FlashRegion::SECTOR_SIZE / RECORD_SIZE - 1;
+    static constexpr int      MAX_SEGMENTS     = 128;      // RAM index bound (512 KB)
+    static constexpr uint32_t BUCKET_S         = 15 * 60;  // level-1 resolution
+    static constexpr int      COMPACT_FANIN    = 16;       // max sources per compaction
+    static constexpr int      RAW_KEEP         = 24;       // newest level-0 segments never merged
+    static constexpr int      FREE_RESERVE     = 2;        // new head + compaction output
+
+    struct Stats {
+        uint32_t appends      = 0;
+        uint32_t compactions  = 0;
+        uint32_t drops        = 0;     // segments discarded without compaction
+        uint32_t erases       = 0;
+        uint32_t tornRecords  = 0;     // CRC-bad slots skipped by queries
+        uint32_t recovered    = 0;     // half-done compactions finished at mount
+        uint32_t errors       = 0;
+    };
+
+    // Scans every segment header and rebuilds the index. Finishes a
+    // compaction interrupted by power loss. False if the region is unusable.
+    bool mount(FlashRegion& flash);
+
+    bool append(const HistorySample& s);
+
+    // Samples with from <= time <= to, oldest first; returns count written
+    int query(uint32_t from, uint32_t to, HistorySample* out, int maxOut) const;
+
+    uint32_t oldestTime() const;
+    uint32_t newestTime() const;
+    uint32_t sampleCount() const;
+    int      segmentsUsed(int level) const;
+    int      segmentCount() const { return m_segCount; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    enum SegState : uint8_t { SEG_FREE, SEG_DIRTY, SEG_USED };
+
+    struct Segment {
+        uint32_t seq;
+        uint32_t first;             // time of slot 0
+        uint32_t last;              // time of the newest valid record
+        uint8_t  count;             // slots consumed (incl. torn)
+        uint8_t  level;
+        SegState state;
+    };
+
+    bool     prepare(int seg);      // erase unless known blank
+    int      takeFree();
+    int      freeCount() const;
+    bool     ensureFree();
+    bool     compact();
+    void     drop(int seg);
+    bool     openHead();
+    void     scanSegment(int seg);
+    bool     readRecord(int seg, uint32_t slot, HistorySample& s) const;
+    uint32_t slotTime(int seg, uint32_t slot) const;
+    uint32_t slotOffset(int seg, uint32_t slot) const;
+
+    FlashRegion* m_flash    = nullptr;
+    Segment  m_segs[MAX_SEGMENTS];
+    int      m_segCount     = 0;
+    int      m_head         = -1;
+    int      m_cursor       = 0;        // round-robin allocation spreads wear
+    uint32_t m_nextSeq      = 1;
+    mutable Stats m_stats;
+};
@@ -0,0 +1,340 @@
+#include "journal.h"
+
+// ==========================================================================
+// Journal -- RAM page + flash ring writer
+//
+// Records accumulate in a 256 B page; full pages are programmed into the
+// next slot of the "journal" partition, erasing each 4 KB sector as the
+// head enters it. Every page is self-describing (seq + base time + CRC),
+// so a torn write on power loss costs one page and the ring can be read
+// back from any point. Logic ticks (10 Hz) are batched into nibble-packed
+// runs: ~0.5 B per tick, so the 2 MB partition holds several days.
+// ==========================================================================
+
+#if FEATURE_JOURNAL
+
+#include "journal_codec.h"
+#include "../hal/flash_region.h"
+#include <Arduino.h>
+#include <cstring>
+
+using namespace JournalCodec;
+
+static constexpr uint32_t PAGES_PER_SECTOR = FlashRegion::SECTOR_SIZE / PAGE_SIZE;
+static constexpr unsigned long FLUSH_INTERVAL_MS = 60000;
+
+static FlashRegion s_flash;
+static bool        s_enabled = false;
+
+// -- Current RAM page ------------------------------------------------------
+static uint8_t  s_page[PAGE_SIZE];
+static size_t   s_pageLen    = PAGE_HEADER;
+static uint32_t s_pageBaseMs = 0;
+static uint32_t s_pagePrevMs = 0;
+
+// -- Ring position ---------------------------------------------------------
+static uint32_t s_headPage = 0;     // next page slot to program
+static uint32_t s_nextSeq  = 1;
+static unsigned long s_lastFlushMs = 0;
+
+// -- Pending tick run ------------------------------------------------------
+static uint32_t s_encTickMs  = 0;   // last tick already in the page stream
+static uint32_t s_runLastMs  = 0;
+static uint8_t  s_run[TICK_RUN_MAX];
+static int      s_runCount   = 0;
+
+// -- Dedupe of polled snapshots --------------------------------------------
+static uint8_t  s_lastRadio[32];
+static size_t   s_lastRadioLen   = 0;
+static uint32_t s_lastCosmania   = UINT32_MAX;
+
+// -- Stats -----------------------------------------------------------------
+static uint32_t s_pagesWritten = 0;
+static uint32_t s_sectorErases = 0;
+static uint32_t s_records      = 0;
+static uint32_t s_writeErrors  = 0;
+
+static uint16_t pageLen(const uint8_t* hdr) { return hdr[0] | (hdr[1] << 8); }
+static uint32_t pageSeq(const uint8_t* hdr) {
+    return hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) | (static_cast<uint32_t>(hdr[7]) << 24);
+}
+
+static size_t varintLen(uint32_t v) {
+    size_t n = 1;
+    while (v >= 0x80) { v >>= 7; n++; }
+    return n;
+}
+
+static void startPage() {
+    memset(s_page, 0xFF, sizeof(s_page));
+    s_pageLen    = PAGE_HEADER;
+    s_pageBaseMs = s_encTickMs;
+    s_pagePrevMs = s_encTickMs;
+}
+
+static void writePage() {
+    if (s_pageLen == PAGE_HEADER) return;
+
+    sealPage(s_page, static_cast<uint16_t>(s_pageLen), s_nextSeq, s_pageBaseMs);
+
+    uint32_t totalPages = s_flash.size() / PAGE_SIZE;
+    if (s_headPage % PAGES_PER_SECTOR == 0) {
+        if (s_flash.eraseSector(s_headPage / PAGES_PER_SECTOR)) s_sectorErases++;
+        else s_writeErrors++;
+    }
+    if (s_flash.write(s_headPage * PAGE_SIZE, s_page, PAGE_SIZE)) s_pagesWritten++;
+    else s_writeErrors++;
+
+    s_nextSeq++;
+    s_headPage = (s_headPage + 1) % totalPages;
+    startPage();
+}
+
+// Append [type][body] (untimed) or [type][dt][body] (timed)
+static void append(RecordType type, bool timed, uint32_t t,
+                   const uint8_t* body, size_t n) {
+    size_t need = 1 + (timed ? varintLen(t - s_pagePrevMs) : 0) + n;
+    if (s_pageLen + need > PAGE_SIZE) {
+        writePage();
+        need = 1 + (timed ? varintLen(t - s_pagePrevMs) : 0) + n;
+        if (s_pageLen + need > PAGE_SIZE) return;   // record larger than a page
+    }
+
+    Buf b(s_page + s_pageLen, PAGE_SIZE - s_pageLen);
+    b.put(type);
+    if (timed) {
+        b.varint(t - s_pagePrevMs);
+        s_pagePrevMs = t;
+    }
+    b.bytes(body, n);
+    s_pageLen += b.len;
+    s_records++;
+}
+
+static void flushTicks() {
+    if (s_runCount == 0) return;
+
+    uint8_t body[1 + TICK_RUN_MAX / 2];
+    body[0] = static_cast<uint8_t>(s_runCount);
+    size_t n = 1;
+    for (int i = 0; i < s_runCount; i += 2) {
+        uint8_t lo = s_run[i];
+        uint8_t hi = (i + 1 < s_runCount) ? s_run[i + 1] : 0;
+        body[n++] = static_cast<uint8_t>(lo | (hi << 4));
+    }
+
+    // Tick runs are relative to the previous encoded tick, which becomes
+    // the page base if this run opens a new page
+    append(REC_TICKS, false, 0, body, n);
+    s_encTickMs  = s_runLastMs;
+    s_pagePrevMs = s_runLastMs;
+    s_runCount   = 0;
+}
+
+// Timed record: pending ticks go first so replay order matches the loop
+static void record(RecordType type, unsigned long now, const Buf& body) {
+    if (!s_enabled || !body.ok) return;
+    flushTicks();
+    append(type, true, now, body.data, body.len);
+}
+
+void Journal::init(uint32_t seed, const PetState& pet, unsigned long now) {
+    s_enabled = s_flash.open("journal");
+    if (!s_enabled) {
+        Serial.println("[journal] no partition, disabled");
+        return;
+    }
+
+    // Find the head: newest sector by seq, then its first blank page; a
+    // blank ring starts over at page 0 (init may run again, e.g. on the host)
+    s_headPage = 0;
+    s_nextSeq  = 1;
+    uint32_t sectors = s_flash.sectorCount();
+    uint32_t newestSector = 0;
+    uint32_t newestSeq = 0;
+    bool found = false;
+    for (uint32_t s = 0; s < sectors; s++) {
+        uint8_t hdr[PAGE_HEADER];
+        if (!s_flash.read(s * FlashRegion::SECTOR_SIZE, hdr, sizeof(hdr))) continue;
+        uint16_t len = pageLen(hdr);
+        if (len < PAGE_HEADER || len > PAGE_SIZE) continue;
+        if (!found || pageSeq(hdr) > newestSeq) {
+            newestSeq = pageSeq(hdr);
+            newestSector = s;
+            found = true;
+        }
+    }
+
+    if (found) {
+        uint32_t page = newestSector * PAGES_PER_SECTOR;
+        uint32_t end  = page + PAGES_PER_SECTOR;
+        uint32_t lastSeq = newestSeq;
+        for (; page < end; page++) {
+            uint8_t hdr[PAGE_HEADER];
+            s_flash.read(page * PAGE_SIZE, hdr, sizeof(hdr));
+            if (pageLen(hdr) == 0xFFFF) break;      // blank: head goes here
+            if (pageSeq(hdr) > lastSeq) lastSeq = pageSeq(hdr);
+        }
+        s_headPage = page % (sectors * PAGES_PER_SECTOR);
+        s_nextSeq  = lastSeq + 1;
+    }
+
+    s_encTickMs  = now;
+    s_runCount   = 0;
+    s_lastFlushMs = now;
+    startPage();
+
+    uint8_t buf[32];
+    Buf b(buf, sizeof(buf));
+    encodeBoot(b, seed, pet);
+    record(REC_BOOT, now, b);
+
+    Serial.printf("[journal] head page %lu seq %lu\n",
+                  (unsigned long)s_headPage, (unsigned long)s_nextSeq);
+}
+
+void Journal::tick(unsigned long now) {
+    if (!s_enabled) return;
+    if (now - s_lastFlushMs < FLUSH_INTERVAL_MS) return;
+    s_lastFlushMs = now;
+    flush();
+}
+
+void Journal::logicTick(unsigned long now) {
+    if (!s_enabled) return;
+
+    uint32_t last = s_runCount ? s_runLastMs : s_encTickMs;
+    uint32_t dt = now - last;
+
+    if (dt >= LOGIC_TICK_MS && dt - LOGIC_TICK_MS <= TICK_NIBBLE_MAX) {
+        s_run[s_runCount++] = static_cast<uint8_t>(dt - LOGIC_TICK_MS);
+        s_runLastMs = now;
+        if (s_runCount == TICK_RUN_MAX) flushTicks();
+        return;
+    }
+
+    // Irregular gap (boot, screen change): explicit delta
+    flushTicks();
+    uint8_t buf[5];
+    Buf b(buf, sizeof(buf));
+    b.varint(dt);
+    append(REC_TICK, false, 0, buf, b.len);
+    s_encTickMs  = now;
+    s_pagePrevMs = now;
+}
+
+void Journal::buttons(unsigned long now, uint8_t mask) {
+    if (mask == 0) return;
+    uint8_t buf[1];
+    Buf b(buf, sizeof(buf));
+    b.put(mask);
+    record(REC_BUTTONS, now, b);
+}
+
+void Journal::wifiScan(unsigned long now, const WifiStats& wifi) {
+    uint8_t buf[48];
+    Buf b(buf, sizeof(buf));
+    encodeWifi(b, wifi);
+    record(REC_WIFI_DIFF, now, b);
+}
+
+void Journal::cosmania(unsigned long now, const CosmaniaStatus& status) {
+    if (!s_enabled) return;
+    if (status.version == s_lastCosmania) return;
+    s_lastCosmania = status.version;
+
+    uint8_t buf[PAGE_SIZE - PAGE_HEADER - 8];
+    Buf b(buf, sizeof(buf));
+    encodeCosmania(b, status);
+    record(REC_COSMANIA, now, b);
+}
+
+void Journal::radio(unsigned long now, const RadioEnvironment& env) {
+    if (!s_enabled) return;
+    uint8_t buf[sizeof(s_lastRadio)];
+    Buf b(buf, sizeof(buf));
+    encodeRadio(b, env);
+    if (b.len == s_lastRadioLen && memcmp(buf, s_lastRadio, b.len) == 0) return;
+    memcpy(s_lastRadio, buf, b.len);
+    s_lastRadioLen = b.len;
+    record(REC_RADIO, now, b);
+}
+
+void Journal::nfcTap(unsigned long now, uint8_t tap, const uint8_t* uid, uint8_t uidLen) {
+    uint8_t buf[16];
+    Buf b(buf, sizeof(buf));
+    encodeNfc(b, tap, uid, uidLen);
+    record(REC_NFC, now, b);
+}
+
+void Journal::petReset(unsigned long now, bool fullReset) {
+    uint8_t buf[1];
+    Buf b(buf, sizeof(buf));
+    b.put(fullReset ? 1 : 0);
+    record(REC_RESET, now, b);
+}
+
+void Journal::petSnapshot(unsigned long now, const PetState& pet) {
+    uint8_t buf[32];
+    Buf b(buf, sizeof(buf));
+    encodePet(b, pet);
+    record(REC_PET, now, b);
+}
+
+void Journal::catchUp(unsigned long now, uint32_t elapsedMs) {
+    uint8_t buf[5];
+    Buf b(buf, sizeof(buf));
+    b.varint(elapsedMs);
+    record(REC_CATCHUP, now, b);
+}
+
+void Journal::checkpoint(unsigned long now, const PetState& pet) {
+    uint8_t buf[32];
+    Buf b(buf, sizeof(buf));
+    encodePet(b, pet);
+    record(REC_CHECK, now, b);
+}
+
+void Journal::flush() {
+    if (!s_enabled) return;
+    flushTicks();
+    writePage();
+}
+
+void Journal::printStats() {
+    if (!s_enabled) {
+        Serial.println("[journal] disabled");
+        return;
+    }
+    Serial.printf("[journal] head %lu/%lu seq %lu pages %lu erases %lu records %lu errors %lu page %u B\n",
+                  (unsigned long)s_headPage,
+                  (unsigned long)(s_flash.size() / PAGE_SIZE),
+                  (unsigned long)s_nextSeq,
+                  (unsigned long)s_pagesWritten,
+                  (unsigned long)s_sectorErases,
+                  (unsigned long)s_records,
+                  (unsigned long)s_writeErrors,
+                  (unsigned)s_pageLen);
+}
+
+#else
+
+// -- Stubs when journal disabled -------------------------------------------
+#include <Arduino.h>
+
+void Journal::init(uint32_t, const PetState&, unsigned long) {}
+void Journal::tick(unsigned long) {}
+void Journal::logicTick(unsigned long) {}
+void Journal::buttons(unsigned long, uint8_t) {}
+void Journal::wifiScan(unsigned long, const WifiStats&) {}
+void Journal::cosmania(unsigned long, const CosmaniaStatus&) {}
+void Journal::radio(unsigned long, const RadioEnvironment&) {}
+void Journal::nfcTap(unsigned long, uint8_t, const uint8_t*, uint8_t) {}
+void Journal::petReset(unsigned long, bool) {}
+void Journal::petSnapshot(unsigned long, const PetState&) {}
+void Journal::catchUp(unsigned long, uint32_t) {}
+void Journal::checkpoint(unsigned long, const PetState&) {}
+void Journal::flush() {}
+void Journal::printStats() { Serial.println("[journal] disabled"); }
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include "config.h"
+#include "types.h"
+
+// ==========================================================================
+// Journal -- Input recording for deterministic replay
+// Appends every external input to the state layer (buttons, scans, Cosmania
+// polls, radio snapshots, NFC taps, logic clock ticks) to a flash ring on
+// the "journal" partition. tools/replay/ feeds a dump back through
+// PetLogic::tick and reproduces the PetState sequence.
+// Compiles to no-op when FEATURE_JOURNAL == 0
+// ==========================================================================
+
+namespace Journal {
+
+// Opens the ring and writes the BOOT record (seed + loaded pet)
+void init(uint32_t seed, const PetState& pet, unsigned long now);
+void tick(unsigned long now);           // Periodic flush of a partial page
+
+// -- Inputs ----------------------------------------------------------------
+void logicTick(unsigned long now);      // Right before PetLogic::tick(now)
+void buttons(unsigned long now, uint8_t mask);
+void wifiScan(unsigned long now, const WifiStats& wifi);
+void cosmania(unsigned long now, const CosmaniaStatus& status);  // per version
+void radio(unsigned long now, const RadioEnvironment& env);      // deduped
+void nfcTap(unsigned long now, uint8_t tap, const uint8_t* uid, uint8_t uidLen);
+
+// -- State written outside PetLogic ----------------------------------------
+void petReset(unsigned long now, bool fullReset);
+void petSnapshot(unsigned long now, const PetState& pet);
+void catchUp(unsigned long now, uint32_t elapsedMs);
+
+// Replay compares its state against these (e.g. at every auto-save)
+void checkpoint(unsigned long now, const PetState& pet);
+
+void flush();
+void printStats();
+
+}  // namespace Journal
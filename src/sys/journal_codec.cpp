@@ -0,0 +1,364 @@
+#include "journal_codec.h"
+#include "config.h"
+#include <cstring>
+
+// ==========================================================================
+// Journal Codec -- varint/zigzag encoders, page framing, page decoder
+// ==========================================================================
+
+using namespace JournalCodec;
+
+// -- Buf -------------------------------------------------------------------
+void Buf::bytes(const void* src, size_t n) {
+    if (len + n > cap) {
+        ok = false;
+        return;
+    }
+    memcpy(data + len, src, n);
+    len += n;
+}
+
+void Buf::varint(uint32_t v) {
+    while (v >= 0x80) {
+        put(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    put(static_cast<uint8_t>(v));
+}
+
+void Buf::f32(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put(bits & 0xFF);
+    put((bits >> 8) & 0xFF);
+    put((bits >> 16) & 0xFF);
+    put((bits >> 24) & 0xFF);
+}
+
+// -- Record bodies ---------------------------------------------------------
+void JournalCodec::encodePet(Buf& b, const PetState& pet) {
+    b.svarint(pet.hunger);
+    b.svarint(pet.happiness);
+    b.svarint(pet.health);
+    b.varint(pet.ageMinutes);
+    b.varint(pet.ageHours);
+    b.varint(pet.ageDays);
+    b.put(static_cast<uint8_t>(pet.stage));
+    b.put(static_cast<uint8_t>(pet.mood));
+    b.put((pet.alive ? 0x01 : 0) | (pet.hatched ? 0x02 : 0));
+}
+
+void JournalCodec::encodeBoot(Buf& b, uint32_t seed, const PetState& pet) {
+    b.varint(seed);
+    encodePet(b, pet);
+}
+
+void JournalCodec::encodeWifi(Buf& b, const WifiStats& w) {
+    b.svarint(w.netCount);
+    b.svarint(w.strongCount);
+    b.svarint(w.hiddenCount);
+    b.svarint(w.avgRSSI);
+    b.svarint(w.openCount);
+    b.svarint(w.wpaCount);
+    b.varint(w.newCount);
+    b.varint(w.goneCount);
+    b.varint(w.changedCount);
+    b.varint(w.knownCount);
+}
+
+void JournalCodec::encodeCosmania(Buf& b, const CosmaniaStatus& c) {
+    b.put((c.connected ? 0x01 : 0) | (c.stale ? 0x02 : 0));
+    b.put(static_cast<uint8_t>(c.budgetTier));
+    b.f32(c.totalDailyBudget);
+    b.f32(c.totalDailySpend);
+    b.put(c.errorCount);
+    b.put(c.overdueCount);
+    b.put(c.activeCount);
+    b.put(c.greenDaysStreak);
+
+    uint8_t count = c.agentCount > 7 ? 7 : c.agentCount;
+    b.put(count);
+    for (int i = 0; i < count; i++) {
+        const AgentInfo& a = c.agents[i];
+        uint8_t nameLen = static_cast<uint8_t>(strnlen(a.name, sizeof(a.name) - 1));
+        b.put(nameLen);
+        b.bytes(a.name, nameLen);
+        b.put((a.overdue ? 0x01 : 0) | (a.overBudget ? 0x02 : 0));
+        b.f32(a.todayCostUsd);
+        b.svarint(a.todayRuns);
+        b.svarint(a.minutesSince);
+    }
+}
+
+void JournalCodec::encodeRadio(Buf& b, const RadioEnvironment& r) {
+    b.svarint(r.bleDeviceCount);
+    b.svarint(r.bleScannerCount);
+    b.svarint(r.probeCount);
+    b.svarint(r.uniqueProbers);
+    b.svarint(r.deauthCount);
+    b.svarint(r.threatCount);
+    b.put(static_cast<uint8_t>(r.worstThreat));
+    b.put(r.safetyScore);
+}
+
+void JournalCodec::encodeNfc(Buf& b, uint8_t tap, const uint8_t* uid, uint8_t uidLen) {
+    if (uidLen > 7) uidLen = 7;
+    b.put(tap);
+    b.put(uidLen);
+    b.bytes(uid, uidLen);
+}
+
+// -- Pages -----------------------------------------------------------------
+uint16_t JournalCodec::crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021)
+                                 : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void putU16(uint8_t* p, uint16_t v) { p[0] = v & 0xFF; p[1] = v >> 8; }
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = v >> 24;
+}
+static uint16_t getU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static uint32_t getU32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void JournalCodec::sealPage(uint8_t* page, uint16_t len, uint32_t seq, uint32_t baseMs) {
+    putU16(page, len);
+    putU32(page + 4, seq);
+    putU32(page + 8, baseMs);
+    putU16(page + 2, crc16(page + 4, len - 4));
+}
+
+bool JournalCodec::readPageHeader(const uint8_t* page, PageHeader& out) {
+    out.len    = getU16(page);
+    out.crc    = getU16(page + 2);
+    out.seq    = getU32(page + 4);
+    out.baseMs = getU32(page + 8);
+    if (out.len < PAGE_HEADER || out.len > PAGE_SIZE) return false;    // blank (0xFFFF) or torn
+    return crc16(page + 4, out.len - 4) == out.crc;
+}
+
+// -- PageReader ------------------------------------------------------------
+PageReader::PageReader(const uint8_t* page)
+    : m_page(page), m_pos(PAGE_HEADER), m_end(getU16(page)),
+      m_prevMs(getU32(page + 8)), m_lastTickMs(getU32(page + 8)) {}
+
+PageReader::PageReader(const uint8_t* body, size_t len)
+    : m_page(body), m_pos(0), m_end(len), m_prevMs(0), m_lastTickMs(0) {}
+
+bool PageReader::byte(uint8_t& out) {
+    if (m_pos >= m_end) return false;
+    out = m_page[m_pos++];
+    return true;
+}
+
+bool PageReader::varint(uint32_t& out) {
+    out = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b;
+        if (!byte(b)) return false;
+        out |= static_cast<uint32_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool PageReader::svarint(int32_t& out) {
+    uint32_t v;
+    if (!varint(v)) return false;
+    out = static_cast<int32_t>((v >> 1) ^ (~(v & 1) + 1));
+    return true;
+}
+
+bool PageReader::f32(float& out) {
+    if (m_pos + 4 > m_end) return false;
+    uint32_t bits = getU32(m_page + m_pos);
+    m_pos += 4;
+    memcpy(&out, &bits, sizeof(out));
+    return true;
+}
+
+bool PageReader::pet(PetState& out) {
+    int32_t h, hp, he;
+    uint32_t m, hr, d;
+    uint8_t stage, mood, flags;
+    if (!svarint(h) || !svarint(hp) || !svarint(he)) return false;
+    if (!varint(m) || !varint(hr) || !varint(d)) return false;
+    if (!byte(stage) || !byte(mood) || !byte(flags)) return false;
+    out.hunger     = h;
+    out.happiness  = hp;
+    out.health     = he;
+    out.ageMinutes = m;
+    out.ageHours   = hr;
+    out.ageDays    = d;
+    out.stage      = static_cast<EvolutionStage>(stage);
+    out.mood       = static_cast<Mood>(mood);
+    out.alive      = flags & 0x01;
+    out.hatched    = flags & 0x02;
+    return true;
+}
+
+// encodeCosmania() body; lastPollMs is the caller's
+bool PageReader::cosmania(CosmaniaStatus& c) {
+    c = CosmaniaStatus();
+    uint8_t flags, tier, count;
+    if (!byte(flags) || !byte(tier)) return false;
+    if (!f32(c.totalDailyBudget) || !f32(c.totalDailySpend)) return false;
+    if (!byte(c.errorCount) || !byte(c.overdueCount) ||
+        !byte(c.activeCount) || !byte(c.greenDaysStreak)) return false;
+    if (!byte(count) || count > 7) return false;
+    c.connected  = flags & 0x01;
+    c.stale      = flags & 0x02;
+    c.budgetTier = static_cast<BudgetTier>(tier);
+    for (int i = 0; i < count; i++) {
+        AgentInfo& a = c.agents[i];
+        uint8_t nameLen, agentFlags;
+        int32_t runs, since;
+        if (!byte(nameLen) || nameLen >= sizeof(a.name)) return false;
+        if (m_pos + nameLen > m_end) return false;
+        memcpy(a.name, m_page + m_pos, nameLen);
+        a.name[nameLen] = '\0';
+        m_pos += nameLen;
+        if (!byte(agentFlags) || !f32(a.todayCostUsd)) return false;
+        if (!svarint(runs) || !svarint(since)) return false;
+        a.overdue      = agentFlags & 0x01;
+        a.overBudget   = agentFlags & 0x02;
+        a.todayRuns    = runs;
+        a.minutesSince = since;
+    }
+    c.agentCount = count;
+    return true;
+}
+
+bool JournalCodec::decodeCosmania(const uint8_t* body, size_t len, CosmaniaStatus& out) {
+    PageReader r(body, len);
+    return r.cosmania(out) && r.m_pos == len;
+}
+
+bool PageReader::next(Record& out) {
+    uint8_t type;
+    if (!byte(type)) return false;
+    out.type = static_cast<RecordType>(type);
+
+    // -- Ticks carry deltas from the previous tick -------------------------
+    if (out.type == REC_TICK) {
+        uint32_t dt;
+        if (!varint(dt)) return false;
+        m_lastTickMs += dt;
+        out.tickCount = 1;
+        out.tickMs[0] = m_lastTickMs;
+        out.timeMs = m_prevMs = m_lastTickMs;
+        return true;
+    }
+    if (out.type == REC_TICKS) {
+        uint8_t n;
+        if (!byte(n) || n == 0 || n > TICK_RUN_MAX) return false;
+        for (int i = 0; i < n; i += 2) {
+            uint8_t packed;
+            if (!byte(packed)) return false;
+            m_lastTickMs += LOGIC_TICK_MS + (packed & 0x0F);
+            out.tickMs[i] = m_lastTickMs;
+            if (i + 1 < n) {
+                m_lastTickMs += LOGIC_TICK_MS + (packed >> 4);
+                out.tickMs[i + 1] = m_lastTickMs;
+            }
+        }
+        out.tickCount = n;
+        out.timeMs = m_prevMs = m_lastTickMs;
+        return true;
+    }
+
+    // -- Everything else: [dt] body ----------------------------------------
+    uint32_t dt;
+    if (!varint(dt)) return false;
+    m_prevMs += dt;
+    out.timeMs = m_prevMs;
+    out.tickCount = 0;
+
+    switch (out.type) {
+        case REC_BOOT:
+            if (!varint(out.seed)) return false;
+            // BOOT restarts the clock: later ticks are relative to boot
+            m_lastTickMs = m_prevMs;
+            return pet(out.pet);
+
+        case REC_PET:
+        case REC_CHECK:
+            return pet(out.pet);
+
+        case REC_BUTTONS:
+            return byte(out.buttons);
+
+        case REC_CATCHUP:
+            return varint(out.elapsedMs);
+
+        case REC_RESET: {
+            uint8_t full;
+            if (!byte(full)) return false;
+            out.fullReset = full != 0;
+            return true;
+        }
+
+        case REC_WIFI:
+        case REC_WIFI_DIFF: {
+            int32_t v[6];
+            for (int i = 0; i < 6; i++) if (!svarint(v[i])) return false;
+            out.wifi = WifiStats();
+            out.wifi.netCount    = v[0];
+            out.wifi.strongCount = v[1];
+            out.wifi.hiddenCount = v[2];
+            out.wifi.avgRSSI     = v[3];
+            out.wifi.openCount   = v[4];
+            out.wifi.wpaCount    = v[5];
+            if (out.type == REC_WIFI) return true;
+            out.type = REC_WIFI;            // readers only deal with one kind
+            uint32_t d[4];
+            for (int i = 0; i < 4; i++) if (!varint(d[i])) return false;
+            out.wifi.newCount     = d[0];
+            out.wifi.goneCount    = d[1];
+            out.wifi.changedCount = d[2];
+            out.wifi.knownCount   = d[3];
+            return true;
+        }
+
+        case REC_COSMANIA:
+            if (!cosmania(out.cosmania)) return false;
+            out.cosmania.lastPollMs = out.timeMs;
+            return true;
+
+        case REC_RADIO: {
+            int32_t v[6];
+            uint8_t worst, score;
+            for (int i = 0; i < 6; i++) if (!svarint(v[i])) return false;
+            if (!byte(worst) || !byte(score)) return false;
+            RadioEnvironment& r = out.radio;
+            r.bleDeviceCount  = v[0];
+            r.bleScannerCount = v[1];
+            r.probeCount      = v[2];
+            r.uniqueProbers   = v[3];
+            r.deauthCount     = v[4];
+            r.threatCount     = v[5];
+            r.worstThreat     = static_cast<ThreatSeverity>(worst);
+            r.safetyScore     = score;
+            return true;
+        }
+
+        case REC_NFC:
+            if (!byte(out.tap) || !byte(out.uidLen) || out.uidLen > 7) return false;
+            if (m_pos + out.uidLen > m_end) return false;
+            memcpy(out.uid, m_page + m_pos, out.uidLen);
+            m_pos += out.uidLen;
+            return true;
+
+        default:
+            return false;   // unknown type: rest of page is undecodable
+    }
+}
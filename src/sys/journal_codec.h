@@ -0,0 +1,131 @@
+#pragma once
+#include "types.h"
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Journal Codec -- Compact binary encoding of state-layer inputs
+// Platform-neutral (no Arduino deps): linked into the firmware writer and
+// the host replay tool (tools/replay/).
+//
+// Page (256 B, one flash program unit):
+//   [u16 len][u16 crc16][u32 seq][u32 baseMs] records...
+//
+// Record: [u8 type][varint dt] body
+//   dt is relative to the previous record in the page (first: baseMs).
+//   REC_TICK/REC_TICKS instead carry deltas from the previous logic tick,
+//   and TICKS packs up to TICK_RUN_MAX ticks as 4-bit lateness nibbles
+//   (tick = lastTick + LOGIC_TICK_MS + nibble). Signed fields are zigzag
+//   varints; floats are raw IEEE-754 so replay is bit-exact.
+// ==========================================================================
+
+namespace JournalCodec {
+
+static constexpr size_t   PAGE_SIZE    = 256;
+static constexpr size_t   PAGE_HEADER  = 12;
+static constexpr int      TICK_RUN_MAX = 32;
+static constexpr uint32_t TICK_NIBBLE_MAX = 15;
+
+enum RecordType : uint8_t {
+    REC_BOOT = 1,       // seed + PetState snapshot; starts a replay segment
+    REC_TICK,           // one PetLogic::tick, explicit delta
+    REC_TICKS,          // run of ticks, nibble-packed lateness
+    REC_BUTTONS,        // pressed-edge bitmask
+    REC_WIFI,           // WifiStats consumed by a hunt/discover
+    REC_COSMANIA,       // CosmaniaStatus changed
+    REC_RADIO,          // RadioEnvironment changed
+    REC_NFC,            // NFC tap + UID
+    REC_RESET,          // PetLogic::resetPet(fullReset)
+    REC_PET,            // PetState overwritten outside PetLogic (hatch, reset)
+    REC_CHECK,          // PetState checkpoint for replay verification
+    REC_CATCHUP,        // PetLogic::catchUp(elapsedMs)
+    REC_WIFI_DIFF,      // REC_WIFI + NetTable diff counts; decodes as REC_WIFI
+};
+
+// -- Bounded byte writer ---------------------------------------------------
+struct Buf {
+    uint8_t* data;
+    size_t   cap;
+    size_t   len;
+    bool     ok;
+
+    Buf(uint8_t* d, size_t c) : data(d), cap(c), len(0), ok(true) {}
+
+    void put(uint8_t b) {
+        if (len < cap) data[len++] = b;
+        else ok = false;
+    }
+    void bytes(const void* src, size_t n);
+    void varint(uint32_t v);
+    void svarint(int32_t v) { varint((static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31)); }
+    void f32(float v);
+};
+
+// -- Record bodies ---------------------------------------------------------
+void encodeBoot(Buf& b, uint32_t seed, const PetState& pet);
+void encodePet(Buf& b, const PetState& pet);
+void encodeWifi(Buf& b, const WifiStats& w);
+void encodeCosmania(Buf& b, const CosmaniaStatus& c);
+void encodeRadio(Buf& b, const RadioEnvironment& r);
+void encodeNfc(Buf& b, uint8_t tap, const uint8_t* uid, uint8_t uidLen);
+
+// -- Pages -----------------------------------------------------------------
+struct PageHeader {
+    uint16_t len;       // bytes used including header
+    uint16_t crc;       // CRC-16/CCITT over bytes [4, len)
+    uint32_t seq;       // monotonically increasing page number
+    uint32_t baseMs;    // millis() of the last logic tick at page start
+};
+
+uint16_t crc16(const uint8_t* data, size_t len);
+void     sealPage(uint8_t* page, uint16_t len, uint32_t seq, uint32_t baseMs);
+bool     readPageHeader(const uint8_t* page, PageHeader& out);  // false if blank/corrupt
+
+// -- Decoding --------------------------------------------------------------
+struct Record {
+    RecordType type;
+    uint32_t timeMs;                    // absolute millis() of the record
+    uint32_t seed;
+    PetState pet;
+    WifiStats wifi;
+    CosmaniaStatus cosmania;
+    RadioEnvironment radio;
+    uint8_t buttons;
+    uint8_t tap;
+    uint8_t uid[7];
+    uint8_t uidLen;
+    bool fullReset;
+    uint32_t elapsedMs;                 // REC_CATCHUP
+    uint8_t tickCount;                  // REC_TICK(S): ticks in tickMs[]
+    uint32_t tickMs[TICK_RUN_MAX];
+};
+
+// A whole encodeCosmania() body of len bytes, outside any page (the
+// warm-start status cache); false if it is short, long or malformed
+bool decodeCosmania(const uint8_t* body, size_t len, CosmaniaStatus& out);
+
+class PageReader {
+public:
+    // page must have passed readPageHeader()
+    explicit PageReader(const uint8_t* page);
+    bool next(Record& out);             // false at end of page or on error
+
+private:
+    friend bool decodeCosmania(const uint8_t*, size_t, CosmaniaStatus&);
+    PageReader(const uint8_t* body, size_t len);    // bare record body
+
+    bool varint(uint32_t& out);
+    bool svarint(int32_t& out);
+    bool f32(float& out);
+    bool byte(uint8_t& out);
+    bool pet(PetState& out);
+    bool cosmania(CosmaniaStatus& out);
+
+    const uint8_t* m_page;
+    size_t   m_pos;
+    size_t   m_end;
+    uint32_t m_prevMs;
+    uint32_t m_lastTickMs;
+};
+
+}  // namespace JournalCodec
@@ -0,0 +1,229 @@
+#include "metrics.h"
+#include <cstdio>
+#include <cstring>
+
+// ==========================================================================
+// Metrics -- descriptor table, histogram buckets, text exposition
+// Counters and gauges are one word each in g_values. Histograms keep a
+// slot of per-bucket counts (not cumulative: an observation is one add)
+// plus a 64-bit sum; render() accumulates them into `le` buckets. Families
+// that share a name (the labelled error counters) are consecutive rows,
+// and only the first prints # HELP / # TYPE.
+// ==========================================================================
+
+namespace {
+
+const uint32_t LOOP_BOUNDS_US[]    = {500, 1000, 2000, 5000, 10000, 20000, 33000, 50000, 100000, 250000};
+const uint32_t CONNECT_BOUNDS_MS[] = {250, 500, 1000, 2000, 3000, 5000, 8000, 15000};
+const uint32_t POLL_BOUNDS_MS[]    = {50, 100, 200, 500, 1000, 2000, 5000};
+
+static_assert(sizeof(LOOP_BOUNDS_US) / sizeof(uint32_t) <= Metrics::HIST_BOUNDS &&
+              sizeof(CONNECT_BOUNDS_MS) / sizeof(uint32_t) <= Metrics::HIST_BOUNDS &&
+              sizeof(POLL_BOUNDS_MS) / sizeof(uint32_t) <= Metrics::HIST_BOUNDS,
+              "histogram has more buckets than Cursor::counts holds");
+
+#define BOUNDS(a) a, static_cast<uint8_t>(sizeof(a) / sizeof(a[0]))
+#define NO_BOUNDS nullptr, 0
+
+enum HistSlot : int8_t { H_NONE = -1, H_LOOP, H_CONNECT, H_POLL, H_COUNT };
+
+struct Row {
+    Metrics::Desc desc;
+    HistSlot      slot;
+};
+
+using Metrics::COUNTER;
+using Metrics::GAUGE;
+using Metrics::HISTOGRAM;
+
+const Row ROWS[] = {
+    {{"tamafi_loop_seconds", nullptr, "Time between loop() entries",
+      HISTOGRAM, BOUNDS(LOOP_BOUNDS_US), 1e-6}, H_LOOP},
+    {{"tamafi_heap_free_bytes", nullptr, "Free heap",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_heap_min_free_bytes", nullptr, "Lowest free heap since boot",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_uptime_seconds", nullptr, "Time since boot",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+
+    {{"tamafi_wifi_connects_total", nullptr, "WiFi links established",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_wifi_drops_total", nullptr, "WiFi links lost after being up",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_wifi_connect_seconds", nullptr, "WiFi connect latency, begin to IP",
+      HISTOGRAM, BOUNDS(CONNECT_BOUNDS_MS), 1e-3}, H_CONNECT},
+    {{"tamafi_wifi_scans_total", nullptr, "WiFi scans completed",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_wifi_networks", nullptr, "Networks heard in the last scan",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+
+    {{"tamafi_cosmania_polls_total", nullptr, "Cosmania /status requests started",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_cosmania_errors_total", "kind=\"net\"", "Cosmania polls that failed",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_cosmania_errors_total", "kind=\"http\"", nullptr,
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_cosmania_errors_total", "kind=\"parse\"", nullptr,
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_cosmania_poll_seconds", nullptr, "Cosmania /status request duration",
+      HISTOGRAM, BOUNDS(POLL_BOUNDS_MS), 1e-3}, H_POLL},
+
+    {{"tamafi_ble_devices", nullptr, "BLE devices in range",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_ble_scanners", nullptr, "BLE devices that look like scanners",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_ble_overflows_total", nullptr, "BLE adverts dropped with the capture ring full",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_probe_requests", nullptr, "Probe requests in the current window",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_probers", nullptr, "Distinct devices probing",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_probe_overflows_total", nullptr, "Probe requests dropped with the capture ring full",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_deauths", nullptr, "Deauth frames in the current window",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_threats", nullptr, "Active threats",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_safety_score", nullptr, "Radio safety score, 100 = safe",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+
+    {{"tamafi_pet_hunger", nullptr, "Pet hunger stat, 0-100",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_pet_happiness", nullptr, "Pet happiness stat, 0-100",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_pet_health", nullptr, "Pet health stat, 0-100",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_pet_age_minutes", nullptr, "Pet age",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+    {{"tamafi_pet_alive", nullptr, "1 while the pet is alive",
+      GAUGE, NO_BOUNDS, 1}, H_NONE},
+
+    {{"tamafi_scrapes_total", nullptr, "/metrics responses started",
+      COUNTER, NO_BOUNDS, 1}, H_NONE},
+};
+static_assert(sizeof(ROWS) / sizeof(ROWS[0]) == Metrics::COUNT, "ROWS out of sync with Metrics::Id");
+
+struct Hist {
+    std::atomic<uint32_t> buckets[Metrics::HIST_BOUNDS + 1];
+    std::atomic<uint64_t> sum;
+};
+Hist s_hist[H_COUNT];
+
+bool sameFamily(int id) {
+    return id > 0 && strcmp(ROWS[id].desc.name, ROWS[id - 1].desc.name) == 0;
+}
+
+}  // namespace
+
+std::atomic<uint32_t> Metrics::g_values[Metrics::COUNT];
+
+const Metrics::Desc& Metrics::desc(Id id) {
+    return ROWS[id].desc;
+}
+
+void Metrics::observeSlow(Id id, uint32_t raw) {
+    const Row& row = ROWS[id];
+    if (row.slot == H_NONE) return;
+    uint8_t b = 0;
+    while (b < row.desc.boundCount && raw > row.desc.bounds[b]) b++;
+    Hist& h = s_hist[row.slot];
+    h.buckets[b].fetch_add(1, std::memory_order_relaxed);
+    h.sum.fetch_add(raw, std::memory_order_relaxed);
+}
+
+uint32_t Metrics::value(Id id) {
+    return g_values[id].load(std::memory_order_relaxed);
+}
+
+uint32_t Metrics::count(Id id) {
+    const Row& row = ROWS[id];
+    if (row.slot == H_NONE) return 0;
+    uint32_t n = 0;
+    for (int b = 0; b <= row.desc.boundCount; b++) {
+        n += s_hist[row.slot].buckets[b].load(std::memory_order_relaxed);
+    }
+    return n;
+}
+
+void Metrics::reset() {
+    for (auto& v : g_values) v.store(0, std::memory_order_relaxed);
+    for (auto& h : s_hist) {
+        for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+        h.sum.store(0, std::memory_order_relaxed);
+    }
+}
+
+// -- Exposition --------------------------------------------------------------
+
+// Line numbers per row: 0 HELP, 1 TYPE, then one sample (counter, gauge)
+// or boundCount + 1 buckets, _sum, _count (histogram)
+static int writeLine(const Metrics::Cursor& c, char* out, size_t cap) {
+    const Row& row = ROWS[c.id];
+    const Metrics::Desc& d = row.desc;
+    static const char* const KIND_NAMES[] = {"counter", "gauge", "histogram"};
+
+    if (c.line == 0) return snprintf(out, cap, "# HELP %s %s\n", d.name, d.help ? d.help : "");
+    if (c.line == 1) return snprintf(out, cap, "# TYPE %s %s\n", d.name, KIND_NAMES[d.kind]);
+
+    if (d.kind != Metrics::HISTOGRAM) {
+        uint32_t v = Metrics::g_values[c.id].load(std::memory_order_relaxed);
+        const char* open  = d.labels ? "{" : "";
+        const char* close = d.labels ? "}" : "";
+        const char* lbl   = d.labels ? d.labels : "";
+        if (d.kind == Metrics::GAUGE) {
+            return snprintf(out, cap, "%s%s%s%s %ld\n", d.name, open, lbl, close,
+                            static_cast<long>(static_cast<int32_t>(v)));
+        }
+        return snprintf(out, cap, "%s%s%s%s %lu\n", d.name, open, lbl, close,
+                        static_cast<unsigned long>(v));
+    }
+
+    int b = c.line - 2;
+    uint32_t cumulative = 0;
+    for (int i = 0; i <= b && i <= d.boundCount; i++) cumulative += c.counts[i];
+    if (b < d.boundCount) {
+        return snprintf(out, cap, "%s_bucket{le=\"%.9g\"} %lu\n", d.name, d.bounds[b] * d.scale,
+                        static_cast<unsigned long>(cumulative));
+    }
+    if (b == d.boundCount) {
+        return snprintf(out, cap, "%s_bucket{le=\"+Inf\"} %lu\n", d.name,
+                        static_cast<unsigned long>(cumulative));
+    }
+    if (b == d.boundCount + 1) {
+        return snprintf(out, cap, "%s_sum %.9g\n", d.name, static_cast<double>(c.sum) * d.scale);
+    }
+    return snprintf(out, cap, "%s_count %lu\n", d.name, static_cast<unsigned long>(cumulative));
+}
+
+static int lineCount(const Row& row) {
+    return row.desc.kind == Metrics::HISTOGRAM ? 2 + row.desc.boundCount + 3 : 3;
+}
+
+size_t Metrics::render(Cursor& c, char* out, size_t cap) {
+    size_t len = 0;
+    if (!cap) return 0;
+    out[0] = '\0';
+    while (!c.done()) {
+        const Row& row = ROWS[c.id];
+        if (c.line < 2 && sameFamily(c.id)) c.line = 2;
+        if (c.line == 2 && row.slot != H_NONE) {
+            Hist& h = s_hist[row.slot];
+            for (int i = 0; i <= row.desc.boundCount; i++) {
+                c.counts[i] = h.buckets[i].load(std::memory_order_relaxed);
+            }
+            c.sum = h.sum.load(std::memory_order_relaxed);
+        }
+
+        int n = writeLine(c, out + len, cap - len);
+        if (n < 0 || static_cast<size_t>(n) >= cap - len) {
+            out[len] = '\0';            // didn't fit: next call
+            break;
+        }
+        len += n;
+        if (++c.line >= lineCount(row)) {
+            c.id++;
+            c.line = 0;
+        }
+    }
+    return len;
+}
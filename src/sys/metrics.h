@@ -0,0 +1,129 @@
+#pragma once
+#include "config.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Metrics -- Fixed registry of counters, gauges and histograms
+// Platform-neutral: MetricsServer (src/net/) serves it as Prometheus text
+// on the device, tools/metrics_bench/ scrapes it over loopback.
+//
+// Every metric is an Id with a row in the descriptor table. Updates are
+// relaxed atomics on static storage, so any task may make them and none
+// allocates; a histogram observation is a short bucket search plus two
+// adds. render() turns the registry into exposition text a few whole
+// lines at a time, so a scrape is spread over as many polls as it needs.
+// Updates compile to no-op when FEATURE_METRICS == 0
+// ==========================================================================
+
+namespace Metrics {
+
+enum Kind : uint8_t { COUNTER, GAUGE, HISTOGRAM };
+
+enum Id : uint8_t {
+    // Loop and memory
+    LOOP_SECONDS,           // histogram, us: loop() entry to entry
+    HEAP_FREE_BYTES,
+    HEAP_MIN_FREE_BYTES,
+    UPTIME_SECONDS,
+    // WiFi
+    WIFI_CONNECTS,
+    WIFI_DROPS,
+    WIFI_CONNECT_SECONDS,   // histogram, ms
+    WIFI_SCANS,
+    WIFI_NETWORKS,
+    // Cosmania
+    COSMANIA_POLLS,
+    COSMANIA_ERRORS_NET,
+    COSMANIA_ERRORS_HTTP,
+    COSMANIA_ERRORS_PARSE,
+    COSMANIA_POLL_SECONDS,  // histogram, ms
+    // Radio environment
+    BLE_DEVICES,
+    BLE_SCANNERS,
+    BLE_OVERFLOWS,          // counter: adverts heard with the ring full, dropped
+    PROBE_REQUESTS,
+    PROBERS,
+    PROBE_OVERFLOWS,        // counter: captured with the ring full, dropped
+    DEAUTHS,
+    THREATS,
+    SAFETY_SCORE,
+    // Pet
+    PET_HUNGER,
+    PET_HAPPINESS,
+    PET_HEALTH,
+    PET_AGE_MINUTES,
+    PET_ALIVE,
+    // The exporter itself
+    SCRAPES,
+    COUNT,
+};
+
+static constexpr int    HIST_BOUNDS = 10;   // most buckets a histogram has, +Inf aside
+static constexpr size_t LINE_MAX    = 160;  // longest line render() writes
+
+struct Desc {
+    const char*     name;       // counters end in _total; histograms get _bucket etc.
+    const char*     labels;     // `kind="net"` or nullptr
+    const char*     help;       // nullptr on later rows of a family
+    Kind            kind;
+    const uint32_t* bounds;     // histogram bucket upper bounds, raw unit
+    uint8_t         boundCount;
+    double          scale;      // raw unit -> exported unit
+};
+
+const Desc& desc(Id id);
+
+// -- Updates ---------------------------------------------------------------
+extern std::atomic<uint32_t> g_values[COUNT];
+
+void observeSlow(Id id, uint32_t raw);
+
+inline void inc(Id id, uint32_t n = 1) {
+#if FEATURE_METRICS
+    g_values[id].fetch_add(n, std::memory_order_relaxed);
+#else
+    (void)id; (void)n;
+#endif
+}
+
+inline void set(Id id, int32_t value) {
+#if FEATURE_METRICS
+    g_values[id].store(static_cast<uint32_t>(value), std::memory_order_relaxed);
+#else
+    (void)id; (void)value;
+#endif
+}
+
+// Histograms only; `raw` in the unit of the histogram's bounds
+inline void observe(Id id, uint32_t raw) {
+#if FEATURE_METRICS
+    observeSlow(id, raw);
+#else
+    (void)id; (void)raw;
+#endif
+}
+
+uint32_t value(Id id);          // counter / gauge (gauges as int32_t)
+uint32_t count(Id id);          // histogram observations
+void reset();
+
+// -- Exposition --------------------------------------------------------------
+// Where render() left off. A histogram's buckets are copied when its
+// first bucket line is due, so they add up even while observations land.
+struct Cursor {
+    uint8_t  id   = 0;
+    uint8_t  line = 0;
+    uint32_t counts[HIST_BOUNDS + 1];
+    uint64_t sum  = 0;
+
+    bool done() const { return id >= COUNT; }
+};
+
+// Appends whole lines to `out` while they fit; returns bytes written
+// (never more than cap - 1, NUL-terminated). cap >= LINE_MAX always
+// makes progress.
+size_t render(Cursor& cursor, char* out, size_t cap);
+
+}  // namespace Metrics
@@ -0,0 +1,174 @@
+#include "net_table.h"
+#include <cstring>
+
+// ==========================================================================
+// Net Table -- open addressing on a Fibonacci hash of the BSSID
+// MACs share their top three bytes per vendor, so all six are folded into
+// one 64-bit key and multiplied by 2^64 / phi; the top bits pick the slot.
+// Eviction runs once per scan, not per insert: it drops every entry with
+// the oldest lastSeen, then the next oldest, until the table is under
+// limit(). Entries heard in the same scan share a lastSeen, so that is a
+// pass or two over the slots, with no LRU list to keep.
+// ==========================================================================
+
+static constexpr uint64_t FIB = 0x9E3779B97F4A7C15ull;
+
+static uint64_t macKey(const uint8_t* mac) {
+    uint64_t k = 0;
+    for (int i = 0; i < 6; i++) k = k << 8 | mac[i];
+    return k;
+}
+
+bool NetTable::init(void* storage, uint32_t capacity) {
+    if (!storage || capacity < CAPACITY_MIN || (capacity & (capacity - 1)) != 0) return false;
+    m_slots    = static_cast<NetEntry*>(storage);
+    m_capacity = capacity;
+    m_mask     = capacity - 1;
+    m_shift    = 64;
+    for (uint32_t c = capacity; c > 1; c >>= 1) m_shift--;
+    clear();
+    return true;
+}
+
+void NetTable::clear() {
+    if (m_slots) memset(m_slots, 0, bytesFor(m_capacity));
+    m_count     = 0;
+    m_scanS     = 0;
+    m_prevScanS = 0;
+    m_diff      = Diff();
+}
+
+uint32_t NetTable::home(const uint8_t bssid[6]) const {
+    return static_cast<uint32_t>((macKey(bssid) * FIB) >> m_shift);
+}
+
+uint32_t NetTable::ssidHash(const char* ssid) {
+    if (!ssid || !ssid[0]) return 0;
+    uint32_t h = 2166136261u;
+    for (const char* p = ssid; *p; p++) {
+        h ^= static_cast<uint8_t>(*p);
+        h *= 16777619u;
+    }
+    return h ? h : 1;
+}
+
+const NetEntry* NetTable::find(const uint8_t bssid[6]) const {
+    if (!m_capacity) return nullptr;
+    for (uint32_t i = home(bssid);; i = (i + 1) & m_mask) {
+        const NetEntry& e = m_slots[i];
+        if (!e.lastSeen) return nullptr;
+        if (memcmp(e.bssid, bssid, 6) == 0) return &e;
+    }
+}
+
+// -- Scan ------------------------------------------------------------------
+
+void NetTable::beginScan(uint32_t nowS) {
+    // Two scans in the same second must still be told apart
+    m_prevScanS = m_scanS;
+    m_scanS     = nowS > m_scanS ? nowS : m_scanS + 1;
+    m_diff      = Diff();
+}
+
+void NetTable::observe(const uint8_t bssid[6], uint32_t ssidHash, uint8_t auth, uint8_t channel,
+                       int rssi) {
+    if (!m_capacity || !m_scanS) return;
+    int16_t q = static_cast<int16_t>(rssi * 256);
+    uint32_t i = home(bssid);
+    for (;; i = (i + 1) & m_mask) {
+        NetEntry& e = m_slots[i];
+        if (!e.lastSeen) break;
+        if (memcmp(e.bssid, bssid, 6) != 0) continue;
+
+        if (e.lastSeen == m_scanS) {        // heard twice in one scan
+            e.rssiQ8 = static_cast<int16_t>(e.rssiQ8 + (q - e.rssiQ8) / 4);
+            return;
+        }
+        int off = rssi - e.rssi();
+        bool moved = e.ssidHash != ssidHash || e.auth != auth || e.channel != channel ||
+                     off >= RSSI_CHANGE_DB || off <= -RSSI_CHANGE_DB;
+        e.flags    = moved ? NetEntry::F_CHANGED : 0;
+        e.ssidHash = ssidHash;
+        e.auth     = auth;
+        e.channel  = channel;
+        e.rssiQ8   = static_cast<int16_t>(e.rssiQ8 + (q - e.rssiQ8) / 4);
+        e.lastSeen = m_scanS;
+        if (e.scans < UINT8_MAX) e.scans++;
+        m_diff.heard++;
+        if (moved) m_diff.changed++;
+        return;
+    }
+
+    // One slot always stays empty so probes end
+    if (m_count + 1 >= m_capacity) {
+        m_stats.overflows++;
+        return;
+    }
+    NetEntry& e = m_slots[i];
+    memcpy(e.bssid, bssid, 6);
+    e.auth      = auth;
+    e.flags     = NetEntry::F_NEW;
+    e.ssidHash  = ssidHash;
+    e.firstSeen = m_scanS;
+    e.lastSeen  = m_scanS;
+    e.rssiQ8    = q;
+    e.channel   = channel;
+    e.scans     = 1;
+    m_count++;
+    m_stats.inserts++;
+    m_diff.heard++;
+    m_diff.added++;
+}
+
+const NetTable::Diff& NetTable::endScan() {
+    for (uint32_t i = 0; i < m_capacity; i++) {
+        NetEntry& e = m_slots[i];
+        if (!e.lastSeen || e.lastSeen == m_scanS) continue;
+        if (e.lastSeen == m_prevScanS) {
+            e.flags = NetEntry::F_GONE;
+            m_diff.gone++;
+        } else {
+            e.flags = 0;
+        }
+    }
+    if (m_count > limit()) evict();
+    m_stats.scans++;
+    return m_diff;
+}
+
+// -- Eviction --------------------------------------------------------------
+
+// Backward-shift delete: pull later members of the probe run into the hole
+void NetTable::removeAt(uint32_t i) {
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & m_mask; m_slots[j].lastSeen; j = (j + 1) & m_mask) {
+        uint32_t h = home(m_slots[j].bssid);
+        // Move j back only if its home is not cyclically in (hole, j]
+        bool stays = hole <= j ? (hole < h && h <= j) : (hole < h || h <= j);
+        if (stays) continue;
+        m_slots[hole] = m_slots[j];
+        hole = j;
+    }
+    memset(&m_slots[hole], 0, sizeof(NetEntry));
+    m_count--;
+}
+
+void NetTable::evict() {
+    while (m_count > limit()) {
+        uint32_t oldest = UINT32_MAX;
+        for (uint32_t i = 0; i < m_capacity; i++) {
+            uint32_t t = m_slots[i].lastSeen;
+            if (t && t < oldest) oldest = t;
+        }
+        if (oldest >= m_scanS) return;      // only this scan's left
+        // Deleting shifts entries back, so re-check a slot after a removal
+        for (uint32_t i = 0; i < m_capacity && m_count > limit();) {
+            if (m_slots[i].lastSeen == oldest) {
+                removeAt(i);
+                m_stats.evictions++;
+            } else {
+                i++;
+            }
+        }
+    }
+}
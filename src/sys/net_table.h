@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Net Table -- Every WiFi network heard, keyed on BSSID, across scans
+// Platform-neutral (no Arduino deps): WifiRadio feeds it scan results on
+// the device, tools/net_table_bench/ drives it with synthetic scans.
+//
+// Open addressing with linear probing over a caller-supplied array (PSRAM
+// on the device when there is any), power-of-two capacity, deletes by
+// backward shift so there are no tombstones. An entry is 24 B: when the
+// network was first and last heard, an RSSI EWMA, an SSID hash, auth
+// type and channel. Each scan is bracketed by beginScan() / endScan();
+// endScan() flags what is new, gone (heard last scan, not this one) and
+// changed, and evicts the least recently seen past 3/4 full.
+// ==========================================================================
+
+struct NetEntry {
+    uint8_t  bssid[6];
+    uint8_t  auth;          // wifi_auth_mode_t
+    uint8_t  flags;         // F_* for the last scan
+    uint32_t ssidHash;      // FNV-1a of the SSID, 0 = hidden
+    uint32_t firstSeen;     // s
+    uint32_t lastSeen;      // s, 0 = empty slot
+    int16_t  rssiQ8;        // EWMA, dBm * 256
+    uint8_t  channel;
+    uint8_t  scans;         // scans it was heard in (saturates)
+
+    static constexpr uint8_t F_NEW     = 0x01;
+    static constexpr uint8_t F_CHANGED = 0x02;  // SSID, auth, channel or RSSI moved
+    static constexpr uint8_t F_GONE    = 0x04;
+
+    int rssi() const { return rssiQ8 / 256; }
+};
+
+class NetTable {
+public:
+    static constexpr int      RSSI_CHANGE_DB = 10;  // off the EWMA by this = changed
+    static constexpr uint32_t CAPACITY_MIN   = 16;
+
+    struct Diff {
+        uint16_t heard   = 0;   // networks in this scan
+        uint16_t added   = 0;
+        uint16_t gone    = 0;
+        uint16_t changed = 0;
+    };
+
+    struct Stats {
+        uint32_t scans     = 0;
+        uint32_t inserts   = 0;
+        uint32_t evictions = 0;
+        uint32_t overflows = 0;  // dropped: table full mid-scan
+    };
+
+    static size_t bytesFor(uint32_t capacity) { return capacity * sizeof(NetEntry); }
+
+    // `storage` holds `capacity` entries (a power of two >= CAPACITY_MIN);
+    // false if it doesn't
+    bool init(void* storage, uint32_t capacity);
+    void clear();
+
+    // Times are seconds; a scan no later than the last one is moved a second on
+    void beginScan(uint32_t nowS);
+    void observe(const uint8_t bssid[6], uint32_t ssidHash, uint8_t auth, uint8_t channel,
+                 int rssi);
+    const Diff& endScan();
+
+    const NetEntry* find(const uint8_t bssid[6]) const;
+
+    // Every entry, flags as of the last endScan()
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (uint32_t i = 0; i < m_capacity; i++) {
+            if (m_slots[i].lastSeen) fn(m_slots[i]);
+        }
+    }
+
+    uint32_t size() const     { return m_count; }
+    uint32_t capacity() const { return m_capacity; }
+    uint32_t limit() const    { return m_capacity / 4 * 3; }
+    const Diff&  lastDiff() const { return m_diff; }
+    const Stats& stats() const    { return m_stats; }
+
+    static uint32_t ssidHash(const char* ssid);
+
+private:
+    uint32_t home(const uint8_t bssid[6]) const;
+    void     removeAt(uint32_t i);
+    void     evict();
+
+    NetEntry* m_slots    = nullptr;
+    uint32_t  m_capacity = 0;
+    uint32_t  m_mask     = 0;
+    uint8_t   m_shift    = 0;           // 64 - log2(capacity)
+    uint32_t  m_count    = 0;
+    uint32_t  m_scanS    = 0;           // this scan
+    uint32_t  m_prevScanS = 0;          // the one before
+    Diff      m_diff;
+    Stats     m_stats;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "config.h"
+#include <cstdint>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+// ==========================================================================
+// Profiler -- Scoped probes around loop() dispatch
+// CPU cycle counter on device, std::chrono on host. Fixed-size stats per
+// probe (count, total, max, log2 histogram for p99).
+// Compiles to no-op when FEATURE_PROFILER == 0
+// ==========================================================================
+
+namespace Profiler {
+
+enum Probe : uint8_t {
+    PROBE_LOOP,             // whole loop() iteration
+    PROBE_BUTTONS,
+    PROBE_SOUND,
+    PROBE_LEDS,
+    PROBE_NFC,
+    PROBE_GPS,
+    PROBE_HAPTICS,
+    PROBE_POWER,
+    PROBE_BLE,
+    PROBE_PROMISC,
+    PROBE_THREAT,
+    PROBE_WIFI_MGR,
+    PROBE_COSMANIA,
+    PROBE_NFC_ACTIONS,
+    PROBE_INPUT,
+    PROBE_PET_LOGIC,
+    PROBE_LOCATION,
+    PROBE_SAVE,
+    PROBE_HISTORY,
+    PROBE_METRICS,
+    PROBE_TELEMETRY,
+    PROBE_RENDER,
+    PROBE_COUNT,
+};
+
+static constexpr int BUCKET_COUNT = 32;    // bucket b = [2^b, 2^(b+1)) ticks
+
+void init();
+void record(Probe probe, uint32_t ticks);
+void reset();
+void dump();            // Sorted table (by total time) to Serial
+
+// Raw timestamp: CPU cycles on device, nanoseconds on host
+inline uint32_t ticks() {
+#if defined(ARDUINO)
+    return ESP.getCycleCount();
+#else
+    using namespace std::chrono;
+    return static_cast<uint32_t>(
+        duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// RAII probe: records elapsed ticks on scope exit
+class Scope {
+public:
+    explicit Scope(Probe probe) : m_probe(probe), m_start(ticks()) {}
+    ~Scope() { record(m_probe, ticks() - m_start); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    Probe    m_probe;
+    uint32_t m_start;
+};
+
+}  // namespace Profiler
+
+#define PROF_CONCAT_(a, b) a##b
+#define PROF_CONCAT(a, b)  PROF_CONCAT_(a, b)
+
+#if FEATURE_PROFILER
+#define PROF_SCOPE(probe) \
+    Profiler::Scope PROF_CONCAT(_profScope, __LINE__)(Profiler::probe)
+#else
+#define PROF_SCOPE(probe) do {} while (0)
+#endif
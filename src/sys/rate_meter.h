@@ -0,0 +1,33 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// ==========================================================================
+// Rate Meter -- Events per minute, exponentially decayed
+// Platform-neutral, header-only (tools/threat_replay/ runs it through
+// ThreatDetect on the host). One float per source plus the time of its
+// last event, which the caller already keeps:
+//
+//   hit()   on an event: decay to now, add one event's worth
+//   at()    on a read: decay to now
+//
+// Each event adds 60 / window per minute and the sum decays with time
+// constant `window`, so a steady rate reads as itself once a window or
+// two has passed, a burst of n reads n * 60 / window per minute and
+// then fades, and a source that goes quiet drops below any threshold
+// in a few windows instead of keeping its count forever. O(1) either
+// way: one expf().
+// ==========================================================================
+
+namespace RateMeter {
+
+inline float at(float rate, uint32_t lastMs, uint32_t nowMs, uint32_t windowMs) {
+    if (rate <= 0) return 0;
+    return rate * expf(-static_cast<float>(nowMs - lastMs) / windowMs);
+}
+
+inline float hit(float rate, uint32_t lastMs, uint32_t nowMs, uint32_t windowMs) {
+    return at(rate, lastMs, nowMs, windowMs) + 60000.0f / windowMs;
+}
+
+}  // namespace RateMeter
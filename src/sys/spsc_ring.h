@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// ==========================================================================
+// SPSC Ring -- Lock-free single-producer / single-consumer queue
+// Platform-neutral, header-only (tools/spsc_bench/ stress-tests it with
+// real threads). One producer context -- the WiFi task's promiscuous
+// callback on the device -- claim()s a slot, fills it in place and
+// publish()es it; one consumer -- loop() -- drain()s whatever is new, in
+// order, each item exactly once.
+//
+// Every slot carries a sequence number (Vyukov's bounded queue, minus the
+// CAS a single producer doesn't need). For the item at position p:
+//
+//   seq == p          free: the producer may fill it
+//   seq == p + 1      published: the consumer may copy it out
+//   seq == p + N      released: free again for position p + N
+//
+// Sequence stores are release, loads acquire, so an item is never seen
+// half-written and never overwritten while being copied. A full ring
+// drops the new item (the producer can't wait) and counts it in
+// overflows(). N must be a power of two; positions wrap at 2^32.
+// ==========================================================================
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "ring size must be a power of two");
+
+public:
+    SpscRing() { reset(); }
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Empties the ring; neither side may be running
+    void reset() {
+        for (uint32_t i = 0; i < N; i++) m_slots[i].seq.store(i, std::memory_order_relaxed);
+        m_head = 0;
+        m_tail = 0;
+        m_overflows.store(0, std::memory_order_relaxed);
+    }
+
+    // -- Producer ----------------------------------------------------------
+    // The next free slot to fill, or nullptr (counted) if the ring is full.
+    // Nothing is visible to the consumer until publish()
+    T* claim() {
+        Slot& s = m_slots[m_head & (N - 1)];
+        if (s.seq.load(std::memory_order_acquire) != m_head) {
+            // Only the producer writes the counter: no read-modify-write
+            m_overflows.store(m_overflows.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &s.item;
+    }
+
+    // Hands the slot from the last successful claim() to the consumer
+    void publish() {
+        m_slots[m_head & (N - 1)].seq.store(m_head + 1, std::memory_order_release);
+        m_head++;
+    }
+
+    // -- Consumer ----------------------------------------------------------
+    // Copies up to max new items into out, oldest first, and frees their
+    // slots; returns how many
+    uint32_t drain(T* out, uint32_t max) {
+        uint32_t n = 0;
+        while (n < max) {
+            Slot& s = m_slots[m_tail & (N - 1)];
+            if (s.seq.load(std::memory_order_acquire) != m_tail + 1) break;
+            out[n++] = s.item;
+            s.seq.store(m_tail + N, std::memory_order_release);
+            m_tail++;
+        }
+        return n;
+    }
+
+    uint32_t drained() const { return m_tail; }     // consumer side: items taken so far
+
+    // Either side; a snapshot, it may move on right after
+    uint32_t overflows() const { return m_overflows.load(std::memory_order_relaxed); }
+
+    static constexpr uint32_t capacity() { return N; }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        T item;
+    };
+
+    Slot     m_slots[N];
+    uint32_t m_head;                    // producer only: next position to fill
+    uint32_t m_tail;                    // consumer only: next position to take
+    std::atomic<uint32_t> m_overflows;  // written by the producer only
+};
@@ -0,0 +1,97 @@
+#include "window_hll.h"
+#include <cmath>
+
+// ==========================================================================
+// Window HLL -- bucket rotation and the estimate
+// Buckets rotate as a ring: each minute (block) that passes steps the
+// current index on and clears the slot it lands on, so after a long gap
+// everything has been cleared once and nothing stale is counted. The
+// index is published once its bucket is clear (release), so a feeder
+// never raises into the new bucket before the clear has reached it.
+// ==========================================================================
+
+void WindowHll::reset() {
+    for (int s = 0; s < SLOTS; s++) clearSlot(s);
+    m_fine.store(0, std::memory_order_relaxed);
+    m_coarse.store(0, std::memory_order_relaxed);
+    m_minute  = 0;
+    m_block   = 0;
+    m_started = false;
+}
+
+void WindowHll::clearSlot(int slot) {
+    for (auto& cell : m_regs[slot]) cell.store(0, std::memory_order_relaxed);
+}
+
+void WindowHll::advance(uint32_t nowS) {
+    uint32_t minute = nowS / FINE_S;
+    uint32_t block  = nowS / COARSE_S;
+    if (!m_started) {
+        // What was added before the first advance() counts as now
+        m_minute  = minute;
+        m_block   = block;
+        m_started = true;
+        return;
+    }
+
+    uint32_t steps = minute - m_minute;
+    if (steps > FINE_SLOTS) steps = FINE_SLOTS;
+    uint8_t fine = m_fine.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < steps; i++) {
+        fine = (fine + 1) % FINE_SLOTS;
+        clearSlot(fine);                // before the feeder can see it
+    }
+    m_fine.store(fine, std::memory_order_release);
+    m_minute = minute;
+
+    steps = block - m_block;
+    if (steps > COARSE_SLOTS) steps = COARSE_SLOTS;
+    uint8_t coarse = m_coarse.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < steps; i++) {
+        coarse = (coarse + 1) % COARSE_SLOTS;
+        clearSlot(FINE_SLOTS + coarse);
+    }
+    m_coarse.store(coarse, std::memory_order_release);
+    m_block = block;
+}
+
+uint32_t WindowHll::count(uint32_t windowS) const {
+    if (windowS < FINE_S) windowS = FINE_S;
+    if (windowS > WINDOW_MAX_S) windowS = WINDOW_MAX_S;
+
+    // The current bucket plus enough whole ones before it to span windowS
+    int base, ring, cur, spans;
+    if (windowS <= (FINE_SLOTS - 1) * FINE_S) {
+        base  = 0;
+        ring  = FINE_SLOTS;
+        cur   = m_fine.load(std::memory_order_relaxed);
+        spans = static_cast<int>((windowS + FINE_S - 1) / FINE_S) + 1;
+    } else {
+        base  = FINE_SLOTS;
+        ring  = COARSE_SLOTS;
+        cur   = m_coarse.load(std::memory_order_relaxed);
+        spans = static_cast<int>((windowS + COARSE_S - 1) / COARSE_S) + 1;
+    }
+
+    uint8_t merged[M] = {0};
+    for (int i = 0; i < spans; i++) {
+        const std::atomic<uint8_t>* regs = m_regs[base + (cur - i + ring) % ring];
+        for (int j = 0; j < M / 2; j++) {
+            uint8_t v  = regs[j].load(std::memory_order_relaxed);
+            uint8_t lo = v & 0x0F, hi = v >> 4;
+            if (lo > merged[2 * j])     merged[2 * j]     = lo;
+            if (hi > merged[2 * j + 1]) merged[2 * j + 1] = hi;
+        }
+    }
+
+    double sum   = 0;
+    int    zeros = 0;
+    for (int j = 0; j < M; j++) {
+        sum += ldexp(1.0, -merged[j]);
+        if (merged[j] == 0) zeros++;
+    }
+    const double alpha = 0.7213 / (1 + 1.079 / M);
+    double e = alpha * M * M / sum;
+    if (e <= 2.5 * M && zeros > 0) e = M * log(static_cast<double>(M) / zeros);    // linear counting
+    return static_cast<uint32_t>(e + 0.5);
+}
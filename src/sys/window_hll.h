@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// ==========================================================================
+// Window HLL -- Distinct devices over sliding 1 / 5 / 15 minute windows
+// Platform-neutral (tools/hll_bench/ checks it against exact counts).
+// A HyperLogLog sketch of M 4-bit registers per time bucket: FINE_SLOTS
+// one-minute buckets and COARSE_SLOTS five-minute ones, each id added to
+// the current bucket of both. A window is the register-wise max of the
+// buckets it spans, so
+//
+//   count(60)    the current minute and the one before     1 - 2 min
+//   count(300)   the current minute and the five before    5 - 6 min
+//   count(900)   the current block and the three before   15 - 20 min
+//
+// Standard error is 1.04 / sqrt(M) (~9%) whatever the crowd size, up to
+// RANGE distinct ids in a window, in SLOTS * M / 2 bytes. Past RANGE the
+// 4-bit registers saturate and the count reads low (-7% at 1M, -15% at
+// 2M) -- far beyond what either radio can hear in fifteen minutes.
+//
+// Feeders call add() -- capture callbacks, from their own tasks -- while
+// loop() calls advance() and count(). Nothing waits on either side:
+//
+//   - a register is raised by compare-and-swap on its byte, so a raise
+//     that races a clearSlot() of that byte retries on the cleared value
+//     instead of writing back what was there before
+//   - advance() clears a bucket before it publishes the bucket as
+//     current (release; add() loads the index acquire), so an add() that
+//     sees the new index sees it empty
+//   - an add() that read the index just before advance() moved it lands
+//     in the bucket before: the id counts from a minute earlier. Only a
+//     gap of a whole ring clears that bucket under it, and then it is
+//     the new id that goes, never an old one that stays
+//
+// A count() racing an add() just misses that one id. reset() needs both
+// sides stopped.
+// ==========================================================================
+
+class WindowHll {
+public:
+    static constexpr int      P            = 7;
+    static constexpr int      M            = 1 << P;    // registers per bucket
+    static constexpr uint32_t FINE_S       = 60;
+    static constexpr int      FINE_SLOTS   = 6;
+    static constexpr uint32_t COARSE_S     = 300;
+    static constexpr int      COARSE_SLOTS = 4;
+    static constexpr int      SLOTS        = FINE_SLOTS + COARSE_SLOTS;
+    static constexpr uint32_t WINDOW_MAX_S = (COARSE_SLOTS - 1) * COARSE_S;
+    static constexpr uint32_t RANGE        = 500000;   // see above
+
+    WindowHll() { reset(); }
+    WindowHll(const WindowHll&) = delete;
+    WindowHll& operator=(const WindowHll&) = delete;
+
+    void reset();
+
+    // Feeder: any 32-bit id hash (FNV-1a of the MAC is fine; it is
+    // remixed here)
+    void add(uint32_t id) {
+        uint32_t h   = mix(id);
+        uint32_t reg = h >> (32 - P);
+        uint32_t w   = h << P;
+        uint8_t  rho = w ? static_cast<uint8_t>(__builtin_clz(w) + 1) : 32 - P + 1;
+        if (rho > 15) rho = 15;
+        raise(m_fine.load(std::memory_order_acquire), reg, rho);
+        raise(FINE_SLOTS + m_coarse.load(std::memory_order_acquire), reg, rho);
+    }
+
+    // loop(): moves the current buckets on, clearing the ones reused
+    void advance(uint32_t nowS);
+
+    // loop(): estimated distinct ids over windowS (clamped to
+    // [FINE_S, WINDOW_MAX_S]); see the table above for what is covered
+    uint32_t count(uint32_t windowS) const;
+
+    static constexpr size_t bytes() { return SLOTS * M / 2; }
+
+private:
+    static uint32_t mix(uint32_t h) {          // murmur3 fmix32
+        h ^= h >> 16; h *= 0x85ebca6bu;
+        h ^= h >> 13; h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    // Max into one nibble; a failed CAS reloads `v` (cleared, or the
+    // other nibble raised) and tries again
+    void raise(int slot, uint32_t reg, uint8_t rho) {
+        std::atomic<uint8_t>& cell = m_regs[slot][reg >> 1];
+        int     shift = (reg & 1) * 4;
+        uint8_t v     = cell.load(std::memory_order_relaxed);
+        while (((v >> shift) & 0x0F) < rho) {
+            uint8_t next = static_cast<uint8_t>((v & ~(0x0F << shift)) | (rho << shift));
+            if (cell.compare_exchange_weak(v, next, std::memory_order_relaxed)) return;
+        }
+    }
+
+    void clearSlot(int slot);
+
+    std::atomic<uint8_t> m_regs[SLOTS][M / 2];  // two registers a byte
+    std::atomic<uint8_t> m_fine;                // slot of the current minute
+    std::atomic<uint8_t> m_coarse;              // ... and five-minute block
+    uint32_t m_minute  = 0;                     // minute / block they hold
+    uint32_t m_block   = 0;
+    bool     m_started = false;
+};
@@ -11,7 +11,7 @@ void Screens::agents(TFT_eSprite& fb, const CosmaniaStatus& status,
                      int selectedIndex) {
     fb.fillSprite(Theme::BG);
 
-    if (!status.connected || status.agentCount == 0) {
+    if ((!status.connected && !status.stale) || status.agentCount == 0) {
         Theme::drawHeader(fb, "AGENT DETAIL");
         Theme::drawCenteredGLCD(fb, 100, "NO DATA", Theme::FG_MUTED);
         fb.setTextColor(Theme::FG_MUTED);
@@ -32,6 +32,7 @@ void Screens::agents(TFT_eSprite& fb, const CosmaniaStatus& status,
         if (title[i] >= 'a' && title[i] <= 'z') title[i] -= 32;
     }
     Theme::drawHeader(fb, title);
+    if (status.stale) Theme::drawStaleTag(fb, status.savedAt);
 
     int y = 32;
     int step = 18;
@@ -1,6 +1,7 @@
 #include "boot.h"
 #include "../theme.h"
 #include "config.h"
+#include "../../sys/boot.h"
 #include <TFT_eSPI.h>
 
 // ==========================================================================
@@ -21,6 +22,13 @@ void Screens::boot(TFT_eSprite& fb) {
     // Divider
     Theme::drawRule(fb, 180, Theme::BORDER);
 
-    // Prompt
+    // Stage progress until input is accepted, then the prompt
+    if (!Boot::interactive()) {
+        int total = Boot::stageCount();
+        int pct = total ? Boot::stagesDone() * 100 / total : 0;
+        Theme::drawBar(fb, 60, 150, DISPLAY_W - 120, 6, pct, Theme::ACCENT);
+        Theme::drawCenteredGLCD(fb, 200, "LOADING", Theme::FG_MUTED);
+        return;
+    }
     Theme::drawCenteredGLCD(fb, 200, "> PRESS ANY BUTTON", Theme::FG);
 }
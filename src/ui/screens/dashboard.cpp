@@ -5,6 +5,7 @@
 
 // ==========================================================================
 // Dashboard screen -- All agents in compact rows
+// A warm-start snapshot is drawn like a live status, tagged STALE.
 // ==========================================================================
 
 static uint16_t tierColor(BudgetTier tier) {
@@ -31,7 +32,7 @@ void Screens::dashboard(TFT_eSprite& fb, const CosmaniaStatus& status) {
     fb.fillSprite(Theme::BG);
     Theme::drawHeader(fb, "AGENTS");
 
-    if (!status.connected) {
+    if (!status.connected && !status.stale) {
         Theme::drawCenteredGLCD(fb, 100, "NO CONNECTION", Theme::FG_MUTED);
         Theme::drawCenteredGLCD(fb, 120, "CONFIGURE WIFI + URL", Theme::FG_MUTED);
         fb.setTextColor(Theme::FG_MUTED);
@@ -41,6 +42,8 @@ void Screens::dashboard(TFT_eSprite& fb, const CosmaniaStatus& status) {
         return;
     }
 
+    if (status.stale) Theme::drawStaleTag(fb, status.savedAt);
+
     // Budget tier badge
     fb.setTextFont(1);
     fb.setTextColor(tierColor(status.budgetTier));
@@ -60,6 +60,7 @@ static uint16_t tierColor(BudgetTier t) {
 void Screens::glance(TFT_eSprite& fb, const PetState& pet,
                      const CosmaniaStatus& cosmania) {
     fb.fillSprite(Theme::BG);
+    if (cosmania.stale) Theme::drawStaleTag(fb, cosmania.savedAt);
 
     int y = 30;
 
@@ -95,7 +96,7 @@ void Screens::glance(TFT_eSprite& fb, const PetState& pet,
     y += 12;
 
     // Worst agent (first overdue, or highest cost)
-    if (cosmania.connected && cosmania.agentCount > 0) {
+    if ((cosmania.connected || cosmania.stale) && cosmania.agentCount > 0) {
         int worstIdx = -1;
         for (int i = 0; i < cosmania.agentCount; i++) {
             if (cosmania.agents[i].overdue) { worstIdx = i; break; }
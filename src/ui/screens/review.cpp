@@ -12,7 +12,7 @@ void Screens::review(TFT_eSprite& fb, const CosmaniaStatus& cosmania) {
     fb.fillSprite(Theme::BG);
     Theme::drawHeader(fb, "REVIEW");
 
-    if (!cosmania.connected) {
+    if (!cosmania.connected && !cosmania.stale) {
         Theme::drawCenteredGLCD(fb, 100, "NO CONNECTION", Theme::FG_MUTED);
         fb.setTextColor(Theme::FG_MUTED);
         fb.setTextDatum(BC_DATUM);
@@ -21,6 +21,8 @@ void Screens::review(TFT_eSprite& fb, const CosmaniaStatus& cosmania) {
         return;
     }
 
+    if (cosmania.stale) Theme::drawStaleTag(fb, cosmania.savedAt);
+
     int y = 30;
     int items = 0;
 
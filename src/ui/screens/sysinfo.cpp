@@ -1,11 +1,14 @@
 #include "sysinfo.h"
 #include "../theme.h"
 #include "config.h"
+#include "../../sys/boot.h"
+#include "../../net/wifi_manager.h"
 #include <Arduino.h>
 #include <TFT_eSPI.h>
 
 // ==========================================================================
-// System Info screen -- heap, uptime, firmware version
+// System Info screen -- heap, uptime, firmware version, boot timings,
+// WiFi connect latency
 // ==========================================================================
 
 void Screens::sysinfo(TFT_eSprite& fb) {
@@ -50,6 +53,38 @@ void Screens::sysinfo(TFT_eSprite& fb) {
     Theme::drawRule(fb, y + 4, Theme::BORDER);
     y += 14;
 
+    // Boot: time to first frame / to input / to every stage done
+    auto msRow = [&](const char* label, uint32_t us) {
+        char str[16];
+        if (us) snprintf(str, sizeof(str), "%lu MS", (unsigned long)(us / 1000));
+        else    snprintf(str, sizeof(str), "--");
+        row(label, str);
+    };
+    msRow("FIRST FRAME", Boot::firstFrameUs());
+    msRow("INTERACTIVE", Boot::interactiveUs());
+    msRow("BOOT DONE", Boot::completeUs());
+
+    int slow = Boot::slowestStage();
+    if (slow >= 0) {
+        char slowStr[24];
+        snprintf(slowStr, sizeof(slowStr), "%s %lu MS", Boot::stage(slow).name,
+                 (unsigned long)(Boot::timing(slow).durUs / 1000));
+        row("SLOWEST", slowStr);
+    }
+
+    #if FEATURE_COSMANIA
+    // WiFi: attempt -> IP over the recent connects
+    char wifiStr[24];
+    if (WifiManager::latencySamples() > 0) {
+        snprintf(wifiStr, sizeof(wifiStr), "%lu / %lu MS",
+                 (unsigned long)WifiManager::latencyPercentile(50),
+                 (unsigned long)WifiManager::latencyPercentile(90));
+    } else {
+        snprintf(wifiStr, sizeof(wifiStr), "--");
+    }
+    row("WIFI P50/P90", wifiStr);
+    #endif
+
     fb.setTextColor(Theme::FG_MUTED);
     fb.setTextDatum(BC_DATUM);
     fb.drawString("OK = BACK", DISPLAY_W / 2, DISPLAY_H - 8);
@@ -12,7 +12,7 @@ void Screens::wifiScan(TFT_eSprite& fb, const WifiStats& wifi) {
     Theme::drawHeader(fb, "ENVIRONMENT");
 
     int y = 32;
-    int step = 18;
+    int step = 17;
 
     fb.setTextFont(1);
     fb.setTextSize(1);
@@ -36,6 +36,8 @@ void Screens::wifiScan(TFT_eSprite& fb, const WifiStats& wifi) {
     row("HIDDEN",   wifi.hiddenCount, Theme::PURPLE);
     row("OPEN",     wifi.openCount, Theme::ORANGE);
     row("WPA",      wifi.wpaCount);
+    row("NEW",      wifi.newCount, Theme::ACCENT);
+    row("KNOWN",    wifi.knownCount);
     row("AVG RSSI", wifi.avgRSSI,
         wifi.avgRSSI > -60 ? Theme::GREEN :
         wifi.avgRSSI > -80 ? Theme::ORANGE : Theme::RED);
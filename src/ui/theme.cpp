@@ -1,6 +1,8 @@
 #include "theme.h"
 #include "config.h"
 #include <TFT_eSPI.h>
+#include <cstdio>
+#include <time.h>
 
 // ==========================================================================
 // Theme -- Drawing primitives for eri's dark-first aesthetic
@@ -51,6 +53,24 @@ void Theme::drawCenteredFont2(TFT_eSprite& fb, int y, const char* text,
     fb.setTextDatum(TL_DATUM);
 }
 
+void Theme::drawStaleTag(TFT_eSprite& fb, uint32_t savedAt) {
+    char label[16] = "STALE";
+    time_t now = time(nullptr);
+    if (savedAt && now > static_cast<time_t>(EPOCH_VALID_MIN) &&
+        static_cast<uint32_t>(now) >= savedAt) {
+        uint32_t min = (static_cast<uint32_t>(now) - savedAt) / 60;
+        if (min < 60)            snprintf(label, sizeof(label), "STALE %lum", (unsigned long)min);
+        else if (min < 48 * 60)  snprintf(label, sizeof(label), "STALE %luh", (unsigned long)(min / 60));
+        else                     snprintf(label, sizeof(label), "STALE %lud", (unsigned long)(min / 1440));
+    }
+    fb.setTextFont(1);
+    fb.setTextSize(1);
+    fb.setTextColor(ORANGE);
+    fb.setTextDatum(MR_DATUM);  // middle-right, on the header's text line
+    fb.drawString(label, DISPLAY_W - 8, 10);
+    fb.setTextDatum(TL_DATUM);
+}
+
 void Theme::drawMenuItem(TFT_eSprite& fb, int y, const char* label,
                          bool selected, uint16_t color) {
     fb.setTextFont(1);
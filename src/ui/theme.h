@@ -43,6 +43,10 @@ void drawCenteredGLCD(TFT_eSprite& fb, int y, const char* text,
 void drawCenteredFont2(TFT_eSprite& fb, int y, const char* text,
                        uint16_t color = FG);
 
+// Right end of the header strip: "STALE 12m" in ORANGE for a cached
+// Cosmania snapshot (savedAt epoch s, 0 = age unknown)
+void drawStaleTag(TFT_eSprite& fb, uint32_t savedAt);
+
 // Menu cursor line: "> LABEL" in GLCD
 void drawMenuItem(TFT_eSprite& fb, int y, const char* label,
                   bool selected, uint16_t color = FG);
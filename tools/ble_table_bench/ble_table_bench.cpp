@@ -0,0 +1,284 @@
+// ==========================================================================
+// ble_table_bench -- Host benchmark + consistency checks for BleTable
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Iinclude -Isrc -o ble_table_bench
+//       tools/ble_table_bench/ble_table_bench.cpp src/sys/ble_table.cpp
+//
+// Usage:
+//   ble_table_bench [ops]            default 4000000 in part 2
+//
+//   1. insert, update and evict rates at 64 / 2048 / 8192 devices, next
+//      to the linear table the scan callback used to keep (a findDevice()
+//      scan per advert, a second scan for the oldest when full)
+//   2. a rolling, bursty crowd many times the capacity run against a
+//      reference LRU (std::list + std::unordered_map): every advert must
+//      hit, insert or evict exactly as the reference does
+//   3. every few hundred adverts of (2): each device found from its home slot,
+//      the LRU list threads all of them, entries() dense and in place
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "config.h"
+#include "sys/ble_table.h"
+#include "sys/rate_meter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// -- Address hashes as the scan callback makes them ------------------------
+struct Hash {
+    uint8_t b[4];
+};
+
+static Hash hashFor(uint32_t n) {
+    uint8_t mac[6] = { 0xC0, 0x4E, uint8_t(n >> 24), uint8_t(n >> 16), uint8_t(n >> 8), uint8_t(n) };
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        h ^= mac[i];
+        h *= 16777619u;
+    }
+    return { { uint8_t(h >> 24), uint8_t(h >> 16), uint8_t(h >> 8), uint8_t(h) } };
+}
+
+static uint32_t keyOf(const uint8_t* b) {
+    return uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | b[3];
+}
+
+// What onResult does with the entry it gets back
+static void touch(BleDevice& d, bool created, uint32_t now) {
+    d.scanRate   = RateMeter::hit(created ? 0 : d.scanRate, d.lastSeenMs, now, BLE_RATE_WINDOW_MS);
+    d.lastSeenMs = now;
+}
+
+// -- The table as the callback kept it before ------------------------------
+struct LinearTable {
+    std::vector<BleDevice> devices;
+    int count = 0;
+
+    explicit LinearTable(uint32_t capacity) : devices(capacity) {}
+
+    void advert(const uint8_t* hash, uint32_t now) {
+        int idx = -1;
+        for (int i = 0; i < count; i++) {
+            if (memcmp(devices[i].addrHash, hash, 4) == 0) { idx = i; break; }
+        }
+        if (idx >= 0) {
+            touch(devices[idx], false, now);
+            return;
+        }
+        if (count < static_cast<int>(devices.size())) {
+            idx = count++;
+        } else {
+            uint32_t oldest = UINT32_MAX;
+            idx = 0;
+            for (int i = 0; i < count; i++) {
+                if (devices[i].lastSeenMs < oldest) {
+                    oldest = devices[i].lastSeenMs;
+                    idx = i;
+                }
+            }
+        }
+        memcpy(devices[idx].addrHash, hash, 4);
+        touch(devices[idx], true, now);
+    }
+};
+
+// -- 1. Rates --------------------------------------------------------------
+struct Rates {
+    double insertNs, updateNs, evictNs;
+};
+
+template <typename Advert>
+static Rates measure(uint32_t capacity, Advert advert) {
+    std::vector<Hash> fresh(capacity), again(capacity), churn(capacity);
+    for (uint32_t n = 0; n < capacity; n++) {
+        fresh[n] = hashFor(n);
+        again[n] = hashFor((n * 2654435761u) % capacity);
+        churn[n] = hashFor(capacity + n);
+    }
+    uint32_t now = 1;
+    Rates r;
+    double t0 = nowUs();
+    for (uint32_t n = 0; n < capacity; n++) advert(fresh[n].b, now++);
+    r.insertNs = (nowUs() - t0) * 1000 / capacity;
+
+    const int ROUNDS = capacity <= 256 ? 64 : 4;
+    t0 = nowUs();
+    for (int rep = 0; rep < ROUNDS; rep++)
+        for (uint32_t n = 0; n < capacity; n++) advert(again[n].b, now++);
+    r.updateNs = (nowUs() - t0) * 1000 / (capacity * static_cast<double>(ROUNDS));
+
+    t0 = nowUs();
+    for (uint32_t n = 0; n < capacity; n++) advert(churn[n].b, now++);
+    r.evictNs = (nowUs() - t0) * 1000 / capacity;
+    return r;
+}
+
+static void rates() {
+    printf("\n1. insert / update / evict (ns per advert)\n");
+    printf("  %8s %9s   %-26s %-26s\n", "devices", "bytes", "BleTable ins/upd/evict",
+           "linear ins/upd/evict");
+    static const uint32_t CAPACITIES[] = { 64, 2048, 8192 };
+    bool flat = true, faster = true;
+    double smallEvict = 0;
+    for (uint32_t capacity : CAPACITIES) {
+        std::vector<uint32_t> storage(BleTable::bytesFor(capacity) / 4 + 1);
+        BleTable t;
+        t.init(storage.data(), capacity);
+        Rates h = measure(capacity, [&](const uint8_t* hash, uint32_t now) {
+            bool created;
+            BleDevice* d = t.upsert(hash, created);
+            touch(*d, created, now);
+        });
+        LinearTable lin(capacity);
+        Rates l = measure(capacity, [&](const uint8_t* hash, uint32_t now) { lin.advert(hash, now); });
+        printf("  %8u %9zu   %6.1f %6.1f %6.1f        %8.1f %8.1f %8.1f\n", capacity,
+               BleTable::bytesFor(capacity), h.insertNs, h.updateNs, h.evictNs, l.insertNs,
+               l.updateNs, l.evictNs);
+        if (capacity == CAPACITIES[0]) smallEvict = h.evictNs;
+        // O(1): a 128x larger table costs no more than a cache miss or two
+        flat   = flat && h.evictNs <= smallEvict * 8 + 50;
+        faster = faster && h.updateNs < l.updateNs;
+        if (capacity == CAPACITIES[0]) {
+            check(t.size() == capacity && t.stats().evictions == capacity,
+                  "64: full, one eviction per new device");
+        }
+    }
+    check(faster, "updates faster than the linear scan, every size");
+    check(flat, "evict cost flat from 64 to 8192 devices");
+}
+
+// -- 2/3. Reference LRU ----------------------------------------------------
+struct ReferenceLru {
+    uint32_t capacity;
+    std::list<uint32_t> order;      // most recent first
+    std::unordered_map<uint32_t, std::list<uint32_t>::iterator> where;
+
+    // 0 = hit, 1 = insert, 2 = evicted `victim` to insert
+    int advert(uint32_t key, uint32_t& victim) {
+        auto it = where.find(key);
+        if (it != where.end()) {
+            order.splice(order.begin(), order, it->second);
+            return 0;
+        }
+        int what = 1;
+        if (order.size() == capacity) {
+            victim = order.back();
+            where.erase(victim);
+            order.pop_back();
+            what = 2;
+        }
+        order.push_front(key);
+        where[key] = order.begin();
+        return what;
+    }
+};
+
+static bool consistent(const BleTable& t, const ReferenceLru& ref) {
+    if (t.size() != ref.order.size()) return false;
+    // Every device reachable, each exactly once
+    std::unordered_set<uint32_t> keys;
+    for (uint32_t i = 0; i < t.size(); i++) {
+        const BleDevice& d = t.entries()[i];
+        if (t.find(d.addrHash) != &d) return false;
+        if (!keys.insert(keyOf(d.addrHash)).second) return false;
+    }
+    // The LRU list is the reference's order
+    auto it = ref.order.begin();
+    bool same = true;
+    uint32_t n = 0;
+    t.forEachRecent([&](const BleDevice& d) {
+        if (it == ref.order.end() || *it != keyOf(d.addrHash)) same = false;
+        else ++it;
+        n++;
+    });
+    return same && n == t.size() && it == ref.order.end();
+}
+
+static void againstReference(uint32_t ops) {
+    static const uint32_t CAPACITIES[] = { 8, 64, 2048 };
+    for (uint32_t capacity : CAPACITIES) {
+        printf("\n2. rolling crowd vs reference LRU, capacity %u, %u adverts\n", capacity, ops);
+        std::vector<uint32_t> storage(BleTable::bytesFor(capacity) / 4 + 1);
+        BleTable t;
+        t.init(storage.data(), capacity);
+        ReferenceLru ref{ capacity, {}, {} };
+        const BleDevice* base = t.entries();
+
+        // A crowd of 2x the capacity that drifts along the id space, some
+        // regulars that never leave, adverts in bursts from one device
+        uint32_t rng = 88172645u, now = 0, mismatches = 0, broken = 0;
+        uint32_t hits = 0, inserts = 0, evictions = 0;
+        const uint32_t crowd = capacity * 2;
+        double drift = 0;
+        for (uint32_t op = 0; op < ops;) {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            uint32_t id = rng % 16 == 0 ? rng % 4 : 1000000 + static_cast<uint32_t>(drift) + rng % crowd;
+            uint32_t burst = 1 + (rng >> 24) % 6;
+            for (uint32_t b = 0; b < burst && op < ops; b++, op++) {
+                Hash h = hashFor(id);
+                uint32_t victim = 0, oldestKey = t.oldest() ? keyOf(t.oldest()->addrHash) : 0;
+                int want = ref.advert(keyOf(h.b), victim);
+                bool created;
+                BleDevice* d = t.upsert(h.b, created);
+                touch(*d, created, now++);
+                int got = !created ? 0 : t.stats().evictions > evictions ? 2 : 1;
+                if (got != want || (want == 2 && victim != oldestKey)) mismatches++;
+                hits += got == 0;
+                inserts += got >= 1;
+                evictions += got == 2;
+            }
+            drift += capacity / 4096.0 + 0.01;
+            if (op % 256 < 6 && !consistent(t, ref)) broken++;
+        }
+        printf("  %u hits, %u inserts, %u evictions\n", hits, inserts, evictions);
+        check(mismatches == 0, "hit / insert / evict as the reference, in order");
+        check(evictions > capacity * 4, "many times the capacity evicted");
+        check(broken == 0 && consistent(t, ref), "index, LRU list and entries() consistent");
+        check(t.entries() == base && t.size() == capacity, "entries() never moved, stays dense");
+        check(t.stats().inserts == inserts && t.stats().updates == hits &&
+                  t.stats().evictions == evictions,
+              "stats match");
+    }
+
+    // clear() then refill: nothing of the old crowd left
+    std::vector<uint32_t> storage(BleTable::bytesFor(64) / 4 + 1);
+    BleTable t;
+    t.init(storage.data(), 64);
+    bool created;
+    for (uint32_t n = 0; n < 100; n++) t.upsert(hashFor(n).b, created);
+    t.clear();
+    uint32_t stale = 0;
+    for (uint32_t n = 0; n < 100; n++) stale += t.find(hashFor(n).b) != nullptr;
+    for (uint32_t n = 500; n < 530; n++) t.upsert(hashFor(n).b, created);
+    check(stale == 0 && t.size() == 30 && t.oldest() && keyOf(t.oldest()->addrHash) == keyOf(hashFor(500).b),
+          "clear() forgets everything, refills in order");
+}
+
+int main(int argc, char** argv) {
+    uint32_t ops = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4000000;
+    rates();
+    againstReference(ops);
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+// ==========================================================================
+// catchup_check -- PetLogic::catchUp() against ticking through the gap
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Itools/host -Iinclude -Isrc -o catchup_check
+//       tools/catchup_check/catchup_check.cpp src/state/pet_state.cpp
+//       src/state/mood.cpp src/state/evolution.cpp
+//
+// Usage:
+//   catchup_check [cases] [seed]         default 20000 cases, seed 1
+//
+// Each case boots the real state layer with random stats, Cosmania tier,
+// WiFi and timer phases, then covers a gap (100 ms .. 3 h, a few up to
+// 7 days) twice: once ticking every 100 ms with the inputs held constant,
+// once with one catchUp() call. The pet is then ticked on for two minutes
+// on both sides.
+//   1. hunger, happiness, health, age and alive equal right after the gap
+//   2. still equal at every tick of the two minutes after it (the timer
+//      phases carried over)
+//   3. every decay branch taken by some case: happiness trend / drops,
+//      health toward its target from above and below, the disconnected
+//      -1 / -2 switch, death inside the gap
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "state/pet_state.h"
+#include "hal/sound.h"
+#include "hal/leds.h"
+#include "hal/wifi_radio.h"
+#include "sys/journal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13; s_rng ^= s_rng >> 17; s_rng ^= s_rng << 5;
+    return s_rng % n;
+}
+
+// -- HAL stubs: one scan result on demand, never another -------------------
+static bool      s_scanReady = false;
+static WifiStats s_scan;
+
+void Sound::click() {}
+void Sound::goodFeed() {}
+void Sound::badFeed() {}
+void Sound::discover() {}
+void Sound::restStart() {}
+void Sound::restEnd() {}
+void Sound::hatch() {}
+
+void LEDs::off() {}
+void LEDs::happy() {}
+void LEDs::sad() {}
+void LEDs::wifi() {}
+void LEDs::rest() {}
+void LEDs::breathe(unsigned long) {}
+
+void WifiRadio::startScan() {}
+bool WifiRadio::isScanDone() { return s_scanReady; }
+WifiStats WifiRadio::getResults() {
+    s_scanReady = false;
+    return s_scan;
+}
+
+void Journal::wifiScan(unsigned long, const WifiStats&) {}
+
+// -- One case --------------------------------------------------------------
+struct Case {
+    uint32_t seed;
+    PetState pet;
+    CosmaniaStatus cosmania;
+    WifiStats scan;
+    bool scanned;           // a scan resolved in the prelude: arms the disconnected branch
+    uint32_t preludeMs;     // ticking before the gap, sets the timer phases
+    uint32_t gapMs;
+};
+
+struct World {
+    PetState pet;
+    WifiStats wifi;
+    CosmaniaStatus cosmania;
+    Settings settings;
+    Activity activity = ACT_NONE;
+    RestPhase restPhase = REST_NONE;
+    int restFrameIndex = 0;
+    unsigned long restDurationMs = 0;
+    bool restStatsApplied = false;
+    RadioEnvironment radio;
+    PetLogic::Context ctx;
+
+    World() {
+        ctx = { &pet, &wifi, &cosmania, &settings, &activity, &restPhase,
+                &restFrameIndex, &restDurationMs, &restStatsApplied, &radio };
+    }
+};
+
+static constexpr unsigned long T0 = 5000;
+static constexpr uint32_t AFTER_TICKS = 1200;      // two minutes at 10 Hz
+
+// Boot, prelude and the state the gap starts from. The activity is parked
+// on a hunt whose scan never finishes, so decisions, hunts and rest stay
+// out of the way and only decay, aging and death run
+static unsigned long start(World& w, const Case& c) {
+    w.pet      = c.pet;
+    w.cosmania = c.cosmania;
+    PetLogic::seed(c.seed);
+    PetLogic::init(w.ctx, T0);
+
+    unsigned long now = T0;
+    if (c.scanned) {
+        w.activity  = ACT_DISCOVER;
+        s_scan      = c.scan;
+        s_scanReady = true;
+        now += LOGIC_TICK_MS;
+        PetLogic::tick(w.ctx, now);
+    }
+    s_scanReady = false;
+    w.activity  = ACT_HUNT;
+    for (unsigned long end = now + c.preludeMs; now < end;) {
+        now += LOGIC_TICK_MS;
+        PetLogic::tick(w.ctx, now);
+    }
+    return now;
+}
+
+static bool same(const PetState& a, const PetState& b) {
+    return a.hunger == b.hunger && a.happiness == b.happiness && a.health == b.health &&
+           a.ageMinutes == b.ageMinutes && a.ageHours == b.ageHours &&
+           a.ageDays == b.ageDays && a.alive == b.alive;
+}
+
+static void print(const char* tag, const PetState& p) {
+    printf("    %s hunger %d happy %d health %d age %ud%uh%um alive %d\n", tag, p.hunger,
+           p.happiness, p.health, (unsigned)p.ageDays, (unsigned)p.ageHours,
+           (unsigned)p.ageMinutes, p.alive ? 1 : 0);
+}
+
+// Ticks on until dead or `ticks` done; the pet after each tick into `out`
+static uint32_t tickOn(World& w, unsigned long& now, uint32_t ticks,
+                       std::vector<PetState>* out = nullptr) {
+    uint32_t i = 0;
+    for (; i < ticks && w.pet.alive; i++) {
+        now += LOGIC_TICK_MS;
+        PetLogic::tick(w.ctx, now);
+        if (out) out->push_back(w.pet);
+    }
+    return i;
+}
+
+// -- Random cases ----------------------------------------------------------
+// Stats often start near the 20 / target thresholds where branches switch
+static int stat() {
+    switch (rnd(4)) {
+        case 0:  return static_cast<int>(rnd(101));
+        case 1:  return static_cast<int>(15 + rnd(10));
+        case 2:  return static_cast<int>(rnd(8));
+        default: return static_cast<int>(60 + rnd(41));
+    }
+}
+
+static Case randomCase() {
+    Case c;
+    c.seed = 1 + rnd(0x7FFFFFFF);
+    c.pet.hunger     = stat();
+    c.pet.happiness  = stat();
+    c.pet.health     = stat();
+    c.pet.ageMinutes = rnd(60);
+    c.pet.ageHours   = rnd(24);
+    c.pet.ageDays    = rnd(200);
+    c.pet.stage      = STAGE_LARVA;
+    c.pet.hatched    = true;
+
+    c.cosmania.connected = rnd(3) != 0;
+    if (c.cosmania.connected) {
+        c.cosmania.budgetTier   = static_cast<BudgetTier>(rnd(TIER_UNKNOWN + 1));
+        c.cosmania.errorCount   = rnd(3) == 0 ? static_cast<uint8_t>(1 + rnd(3)) : 0;
+        c.cosmania.overdueCount = rnd(3) == 0 ? static_cast<uint8_t>(1 + rnd(2)) : 0;
+    }
+    c.scanned = rnd(2) == 0;
+    c.scan.netCount = rnd(2) == 0 ? 0 : static_cast<int>(1 + rnd(20));
+    c.scan.avgRSSI  = -50 - static_cast<int>(rnd(40));
+
+    // Past the 30 s after a scan that the disconnected branch waits for,
+    // so the inputs are constant through the gap; any age timer phase
+    c.preludeMs = 31000 + LOGIC_TICK_MS * rnd(600);
+    uint32_t kind = rnd(100);
+    if (kind < 30)      c.gapMs = LOGIC_TICK_MS * (1 + rnd(600));           // <= 1 min
+    else if (kind < 31) c.gapMs = LOGIC_TICK_MS * (1 + rnd(7 * 864000));    // <= 7 days
+    else                c.gapMs = LOGIC_TICK_MS * (1 + rnd(108000));        // <= 3 h
+    return c;
+}
+
+// -- Which branches a case exercised ---------------------------------------
+enum Branch {
+    B_TREND, B_DROP1, B_DROP2, B_DROP3, B_HEALTH_DOWN, B_HEALTH_UP,
+    B_DISCONNECTED, B_SWITCH, B_DEATH, B_COUNT
+};
+
+static const char* BRANCH_NAMES[B_COUNT] = {
+    "happiness trend to 90", "happiness -1", "happiness -2", "happiness -3",
+    "health down to target", "health up to target", "disconnected decay",
+    "disconnected -1 -> -2 switch", "death inside the gap"
+};
+
+static int targetOf(BudgetTier tier) {
+    switch (tier) {
+        case TIER_GREEN:  return 90;
+        case TIER_YELLOW: return 65;
+        case TIER_RED:    return 30;
+        case TIER_BLACK:  return 10;
+        default:          return 70;
+    }
+}
+
+static uint32_t branches(const Case& c, const PetState& before, const PetState& after,
+                         const WifiStats& wifi) {
+    uint32_t b = 0;
+    const CosmaniaStatus& cs = c.cosmania;
+    if (cs.connected) {
+        if (cs.budgetTier == TIER_GREEN && cs.errorCount == 0) b |= 1u << B_TREND;
+        else if (cs.budgetTier == TIER_YELLOW || cs.overdueCount > 0) b |= 1u << B_DROP2;
+        else if (cs.budgetTier == TIER_RED || cs.budgetTier == TIER_BLACK) b |= 1u << B_DROP3;
+        else b |= 1u << B_DROP1;
+        int target = targetOf(cs.budgetTier);
+        if (before.health > target) b |= 1u << B_HEALTH_DOWN;
+        if (before.health < target) b |= 1u << B_HEALTH_UP;
+    } else if (c.scanned && wifi.netCount == 0) {
+        b |= 1u << B_DISCONNECTED | 1u << B_DROP3;
+    } else {
+        b |= 1u << B_DROP1;
+    }
+    if (!cs.connected && before.hunger >= 20 && before.happiness >= 20 && before.health > 0 &&
+        (after.hunger < 20 || after.happiness < 20)) {
+        b |= 1u << B_SWITCH;
+    }
+    if (before.alive && !after.alive) b |= 1u << B_DEATH;
+    return b;
+}
+
+int main(int argc, char** argv) {
+    uint32_t cases = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+    s_rng = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    if (s_rng == 0) s_rng = 1;
+
+    printf("\n%u random gaps: catchUp() vs 100 ms ticks\n", cases);
+    uint32_t gapWrong = 0, afterWrong = 0, covered[B_COUNT] = {};
+    uint64_t ticked = 0;
+    for (uint32_t i = 0; i < cases; i++) {
+        Case c = randomCase();
+
+        // Ticking through the gap
+        World brute;
+        unsigned long now = start(brute, c);
+        PetState before = brute.pet;
+        ticked += tickOn(brute, now, c.gapMs / LOGIC_TICK_MS);
+        PetState bruteEnd = brute.pet;
+        std::vector<PetState> bruteAfter;
+        tickOn(brute, now, AFTER_TICKS, &bruteAfter);
+
+        // The same boot, then one catchUp() over the gap
+        World closed;
+        now = start(closed, c);
+        PetLogic::catchUp(closed.ctx, c.gapMs, now);
+        PetState closedEnd = closed.pet;
+        std::vector<PetState> closedAfter;
+        tickOn(closed, now, AFTER_TICKS, &closedAfter);
+
+        bool gapOk = same(bruteEnd, closedEnd);
+        bool afterOk = bruteAfter.size() == closedAfter.size();
+        for (size_t t = 0; afterOk && t < bruteAfter.size(); t++)
+            afterOk = same(bruteAfter[t], closedAfter[t]);
+        gapWrong += !gapOk;
+        afterWrong += !afterOk;
+        if ((!gapOk || !afterOk) && gapWrong + afterWrong <= 3) {
+            printf("  case %u: seed %u, gap %u ms, connected %d tier %d, %s\n", i, c.seed,
+                   c.gapMs, c.cosmania.connected ? 1 : 0, (int)c.cosmania.budgetTier,
+                   gapOk ? "diverged after the gap" : "differs right after the gap");
+            print("start: ", before);
+            print("ticked:", bruteEnd);
+            print("closed:", closedEnd);
+        }
+
+        uint32_t b = branches(c, before, bruteEnd, brute.wifi);
+        for (int k = 0; k < B_COUNT; k++) covered[k] += (b >> k) & 1;
+    }
+
+    printf("  %llu ticks brute-forced\n", (unsigned long long)ticked);
+    bool all = true;
+    for (int k = 0; k < B_COUNT; k++) {
+        printf("  %-30s %6u cases\n", BRANCH_NAMES[k], covered[k]);
+        all = all && covered[k] > 0;
+    }
+    check(gapWrong == 0, "same pet right after every gap");
+    check(afterWrong == 0, "same pet every tick of the 2 min after");
+    check(all, "every decay branch covered");
+
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
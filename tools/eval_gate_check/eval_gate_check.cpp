@@ -0,0 +1,276 @@
+// ==========================================================================
+// eval_gate_check -- Fingerprint-gated mood / evolution vs evaluating always
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Itools/host -Iinclude -Isrc -o eval_gate_check
+//       tools/eval_gate_check/eval_gate_check.cpp src/state/pet_state.cpp
+//       src/state/mood.cpp src/state/evolution.cpp
+//
+// Usage:
+//   eval_gate_check [segments] [seed]    default 48 segments, seed 1
+//
+// Runs the real state layer through segments of 20 minutes of 10 Hz ticks
+// with scans, Cosmania polls and disconnects, radio changes, catch-ups and
+// pet edits made outside PetLogic, each producer bumping its version as
+// on the device. The same input stream runs twice: gated as shipped, then
+// with MoodLogic::reset() / Evolution::reset() before every tick so each
+// one evaluates from scratch.
+//   1. mood identical at every tick
+//   2. stage, and the rest of the pet, identical at every tick
+//   3. the gated pass skips most evaluations, the fresh pass none
+//   4. every mood and every stage reached somewhere in the run
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "state/pet_state.h"
+#include "state/mood.h"
+#include "state/evolution.h"
+#include "hal/sound.h"
+#include "hal/leds.h"
+#include "hal/wifi_radio.h"
+#include "sys/journal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+// Inputs only: PetLogic draws from its own seeded PRNG
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13; s_rng ^= s_rng >> 17; s_rng ^= s_rng << 5;
+    return s_rng % n;
+}
+
+static bool chance(uint32_t perMille) { return rnd(1000) < perMille; }
+
+// -- HAL stubs: a scan finishes 2-4 s after it starts ----------------------
+static unsigned long s_nowMs      = 0;
+static bool          s_scanArmed  = false;
+static unsigned long s_scanDoneMs = 0;
+static uint32_t      s_version    = 0;
+
+void Sound::click() {}
+void Sound::goodFeed() {}
+void Sound::badFeed() {}
+void Sound::discover() {}
+void Sound::restStart() {}
+void Sound::restEnd() {}
+void Sound::hatch() {}
+
+void LEDs::off() {}
+void LEDs::happy() {}
+void LEDs::sad() {}
+void LEDs::wifi() {}
+void LEDs::rest() {}
+void LEDs::breathe(unsigned long) {}
+
+void WifiRadio::startScan() {
+    s_scanArmed  = true;
+    s_scanDoneMs = s_nowMs + 2000 + rnd(2000);
+}
+bool WifiRadio::isScanDone() { return s_scanArmed && s_nowMs >= s_scanDoneMs; }
+WifiStats WifiRadio::getResults() {
+    s_scanArmed = false;
+    WifiStats w;
+    if (!chance(300)) {
+        w.netCount    = 1 + rnd(20);
+        w.strongCount = rnd(w.netCount + 1);
+        w.hiddenCount = rnd(3);
+        w.openCount   = rnd(w.netCount + 1);
+        w.avgRSSI     = -45 - static_cast<int>(rnd(45));
+    }
+    w.version = ++s_version;
+    return w;
+}
+
+void Journal::wifiScan(unsigned long, const WifiStats&) {}
+
+// -- The globals main.cpp hands PetLogic -----------------------------------
+struct World {
+    PetState pet;
+    WifiStats wifi;
+    CosmaniaStatus cosmania;
+    Settings settings;
+    Activity activity = ACT_NONE;
+    RestPhase restPhase = REST_NONE;
+    int restFrameIndex = 0;
+    unsigned long restDurationMs = 0;
+    bool restStatsApplied = false;
+    RadioEnvironment radio;
+    PetLogic::Context ctx;
+
+    World() {
+        ctx = { &pet, &wifi, &cosmania, &settings, &activity, &restPhase,
+                &restFrameIndex, &restDurationMs, &restStatsApplied, &radio };
+    }
+};
+
+// -- Producers -------------------------------------------------------------
+// A poll: mostly small edits to the last one, so milestones come and go
+static void pollCosmania(CosmaniaStatus& c) {
+    static const char* NAMES[] = { "sentinel", "dreamer", "coder", "scribe",
+                                   "auditor", "herald", "keeper" };
+    if (chance(80)) {
+        c.connected = false;                    // disconnect: version bumps too
+    } else {
+        c.connected = true;
+        if (c.agentCount == 0 || chance(100)) {
+            c.agentCount = static_cast<uint8_t>(rnd(8));
+            for (int i = 0; i < c.agentCount; i++) {
+                // Shuffled now and then, so the milestone indices move
+                const char* name = NAMES[(i + (chance(300) ? rnd(7) : 0)) % 7];
+                strncpy(c.agents[i].name, name, sizeof(c.agents[i].name) - 1);
+            }
+        }
+        if (chance(300)) c.budgetTier = static_cast<BudgetTier>(rnd(TIER_UNKNOWN + 1));
+        if (chance(200)) c.errorCount = static_cast<uint8_t>(rnd(5));
+        if (chance(200)) c.greenDaysStreak = static_cast<uint8_t>(rnd(9));
+        c.activeCount = c.overdueCount = 0;
+        for (int i = 0; i < c.agentCount; i++) {
+            AgentInfo& a = c.agents[i];
+            if (chance(200)) a.todayRuns = chance(500) ? 0 : static_cast<int>(1 + rnd(20));
+            if (chance(300)) a.minutesSince = chance(100) ? -1 : static_cast<int>(rnd(30));
+            if (chance(100)) a.overdue = !a.overdue;
+            c.activeCount += a.todayRuns > 0;
+            c.overdueCount += a.overdue;
+        }
+        if (chance(50)) c.activeCount = 7;      // the JUVENILE milestone
+    }
+    c.version = ++s_version;
+}
+
+static void changeRadio(RadioEnvironment& r) {
+    r.safetyScore = static_cast<uint8_t>(chance(200) ? rnd(40) : 40 + rnd(61));
+    r.threatCount = rnd(3);
+    r.version = ++s_version;
+}
+
+// -- One pass --------------------------------------------------------------
+struct Pass {
+    std::vector<PetState> pets;     // after every tick
+    uint32_t moodRecomputed = 0, moodSkipped = 0, evoRecomputed = 0, evoSkipped = 0;
+};
+
+static constexpr uint32_t SEGMENT_TICKS = 12000;   // 20 min at 10 Hz
+
+static Pass run(uint32_t segments, uint32_t seed, bool fresh) {
+    Pass out;
+    s_rng = seed;
+    s_version = 0;
+    uint32_t mr0, ms0, er0, es0;
+    MoodLogic::stats(mr0, ms0);
+    Evolution::stats(er0, es0);
+
+    for (uint32_t seg = 0; seg < segments; seg++) {
+        World w;
+        // Ages just short of the 1 / 7 / 180 day milestones
+        static const uint32_t DAYS[] = { 0, 6, 179, 30 };
+        w.pet.ageDays    = DAYS[rnd(4)];
+        w.pet.ageHours   = 23;
+        w.pet.ageMinutes = 40 + rnd(20);
+        w.pet.stage      = static_cast<EvolutionStage>(rnd(STAGE_ADULT + 1));
+        w.pet.hatched    = true;
+        w.pet.hunger     = 10 + rnd(91);
+        w.pet.happiness  = 10 + rnd(91);
+        w.pet.health     = 10 + rnd(91);
+        s_scanArmed = false;
+        s_nowMs = 1000 + rnd(5000);
+        PetLogic::seed(1 + rnd(0x7FFFFFFF));
+        PetLogic::init(w.ctx, s_nowMs);
+        if (chance(500)) pollCosmania(w.cosmania);
+
+        for (uint32_t t = 0; t < SEGMENT_TICKS; t++) {
+            s_nowMs += LOGIC_TICK_MS + rnd(16);
+            if (chance(3)) pollCosmania(w.cosmania);
+            if (chance(2)) changeRadio(w.radio);
+            if (chance(1)) {
+                // Fed / healed / reset from the UI: no producer, no version
+                w.pet.hunger    = static_cast<int>(rnd(101));
+                w.pet.happiness = static_cast<int>(rnd(101));
+                w.pet.health    = static_cast<int>(rnd(101));
+            }
+            if (chance(1)) PetLogic::catchUp(w.ctx, 60000 * (1 + rnd(600)), s_nowMs);
+            if (!w.pet.alive) {
+                PetLogic::resetPet(w.ctx, false, s_nowMs);
+                w.pet.alive = true;
+            }
+
+            if (fresh) {
+                MoodLogic::reset();
+                Evolution::reset();
+            }
+            PetLogic::tick(w.ctx, s_nowMs);
+            out.pets.push_back(w.pet);
+        }
+    }
+
+    MoodLogic::stats(out.moodRecomputed, out.moodSkipped);
+    Evolution::stats(out.evoRecomputed, out.evoSkipped);
+    out.moodRecomputed -= mr0;
+    out.moodSkipped    -= ms0;
+    out.evoRecomputed  -= er0;
+    out.evoSkipped     -= es0;
+    return out;
+}
+
+static bool samePet(const PetState& a, const PetState& b) {
+    return a.hunger == b.hunger && a.happiness == b.happiness && a.health == b.health &&
+           a.ageMinutes == b.ageMinutes && a.ageHours == b.ageHours &&
+           a.ageDays == b.ageDays && a.stage == b.stage && a.mood == b.mood &&
+           a.alive == b.alive && a.hatched == b.hatched;
+}
+
+int main(int argc, char** argv) {
+    uint32_t segments = argc > 1 ? strtoul(argv[1], nullptr, 10) : 48;
+    uint32_t seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    if (seed == 0) seed = 1;
+
+    printf("\n%u segments of %u ticks, gated vs fresh evaluation\n", segments, SEGMENT_TICKS);
+    Pass gated = run(segments, seed, false);
+    Pass fresh = run(segments, seed, true);
+
+    size_t ticks = gated.pets.size();
+    uint32_t moodWrong = 0, stageWrong = 0, petWrong = 0;
+    uint32_t moods = 0, stages = 0;
+    for (size_t t = 0; t < ticks; t++) {
+        const PetState& g = gated.pets[t];
+        const PetState& f = fresh.pets[t];
+        if (!samePet(g, f) && petWrong++ == 0) {
+            printf("  first difference at tick %zu: mood %d vs %d, stage %d vs %d\n", t,
+                   (int)g.mood, (int)f.mood, (int)g.stage, (int)f.stage);
+        }
+        moodWrong += g.mood != f.mood;
+        stageWrong += g.stage != f.stage;
+        moods |= 1u << g.mood;
+        stages |= 1u << g.stage;
+    }
+
+    uint32_t moodEvals = gated.moodRecomputed + gated.moodSkipped;
+    uint32_t evoEvals  = gated.evoRecomputed + gated.evoSkipped;
+    printf("  %zu ticks, inputs changed %u times\n", ticks, s_version);
+    printf("  mood:      %u recomputed, %u skipped (%.1f%%)\n", gated.moodRecomputed,
+           gated.moodSkipped, 100.0 * gated.moodSkipped / moodEvals);
+    printf("  evolution: %u recomputed, %u skipped (%.1f%%)\n", gated.evoRecomputed,
+           gated.evoSkipped, 100.0 * gated.evoSkipped / evoEvals);
+    printf("  moods reached %02x, stages reached %02x\n", moods, stages);
+
+    check(fresh.pets.size() == ticks && moodWrong == 0, "mood identical every tick");
+    check(stageWrong == 0 && petWrong == 0, "stage and pet identical every tick");
+    check(gated.moodSkipped > moodEvals * 9 / 10 && gated.evoSkipped > evoEvals * 9 / 10,
+          "gated pass skips over 90% of evaluations");
+    check(fresh.moodSkipped == 0 && fresh.evoSkipped == 0, "fresh pass evaluates every tick");
+    check(moods == (1u << (MOOD_CONTENT + 1)) - 1, "every mood reached");
+    check(stages == (1u << (STAGE_ELDER + 1)) - 1, "every stage reached");
+
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+// ==========================================================================
+// history_bench -- Host benchmark + fault injection for HistoryStore
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Itools/host -Iinclude -Isrc -o history_bench
+//       tools/history_bench/history_bench.cpp src/sys/history_store.cpp
+//       src/sys/journal_codec.cpp tools/host/flash_region_host.cpp
+//
+// Usage:
+//   history_bench [image.bin] [days]     default /tmp/history.bin, 90 days
+//
+// Runs the real store on a file-backed 512 KB NOR emulator (the size of
+// the "history" partition):
+//   1. sustained appends at one sample/min: throughput, erases, wear spread
+//   2. mount time and range-query latency (1 h, 24 h, everything)
+//   3. power cut at random points (mid-append, mid-compaction, mid-erase),
+//      remount, check the store is consistent and keeps working
+//   4. power cut at every step of one compaction, including the window
+//      after its header landed but before the sources were erased
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "sys/history_store.h"
+#include "flash_emu.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static constexpr uint32_t PARTITION_SIZE = 0x80000;
+static constexpr uint32_t SAMPLE_S       = 60;
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+static HistorySample synth(uint32_t t) {
+    HistorySample s;
+    double day = t / 86400.0;
+    s.time        = t;
+    s.hunger      = static_cast<uint8_t>(50 + 45 * sin(day * 6.283 * 3));
+    s.happiness   = static_cast<uint8_t>(60 + 30 * sin(day * 6.283));
+    s.health      = static_cast<uint8_t>(70 + 20 * cos(day * 6.283));
+    s.mood        = t / 3600 % 8;
+    s.stage       = 3;
+    s.flags       = HistorySample::FLAG_ALIVE | HistorySample::FLAG_HATCHED;
+    s.safetyScore = static_cast<uint8_t>(80 + (t / 60) % 20);
+    s.threatCount = (t / 600) % 3;
+    s.netCount    = static_cast<uint8_t>(10 + (t / 60) % 7);
+    s.avgRSSI     = -70;
+    s.bleDevices  = static_cast<uint8_t>((t / 120) % 30);
+    s.probeCount  = static_cast<uint8_t>((t / 60) % 12);
+    s.budgetTier  = 1;
+    s.spendCents  = static_cast<uint16_t>((t % 86400) / 100);
+    s.budgetCents = 2000;
+    return s;
+}
+
+// Full-range scan: time never steps backwards, returns the sample count
+static int scanAll(const HistoryStore& store, bool& ordered) {
+    static std::vector<HistorySample> buf(HistoryStore::MAX_SEGMENTS * HistoryStore::SLOTS);
+    int n = store.query(0, UINT32_MAX, buf.data(), static_cast<int>(buf.size()));
+    ordered = true;
+    for (int i = 1; i < n; i++) {
+        if (buf[i].time < buf[i - 1].time) ordered = false;
+    }
+    return n;
+}
+
+// -- 1 + 2. Throughput, wear, query latency --------------------------------
+static void sustained(const char* image, int days) {
+    printf("sustained appends (%d days at 1/min)\n", days);
+    remove(image);
+    FlashEmu::attach("history", image, PARTITION_SIZE);
+
+    FlashRegion flash;
+    flash.open("history");
+    HistoryStore store;
+    check(store.mount(flash), "mount blank partition");
+
+    uint32_t total = static_cast<uint32_t>(days) * 1440;
+    uint32_t t = 1735689600;                // 2025-01-01
+    uint32_t failed = 0;
+    double t0 = nowUs();
+    for (uint32_t i = 0; i < total; i++, t += SAMPLE_S) {
+        if (!store.append(synth(t))) failed++;
+    }
+    double us = nowUs() - t0;
+
+    const FlashEmu::Stats& fs = FlashEmu::stats();
+    const HistoryStore::Stats& st = store.stats();
+    printf("  %lu appends in %.1f ms: %.0f appends/s, %.2f us each\n",
+           (unsigned long)total, us / 1000, total / (us / 1e6), us / total);
+    printf("  programmed %.1f B/sample, %lu erases, %lu compactions, %lu drops\n",
+           (double)fs.bytesProgrammed / total, (unsigned long)fs.erases,
+           (unsigned long)st.compactions, (unsigned long)st.drops);
+    // NOR sectors are rated for ~100k erase cycles
+    double lifeYears = fs.maxSectorErases ? 100000.0 * days / fs.maxSectorErases / 365 : 1e9;
+    printf("  sector wear min %lu max %lu: hottest sector lasts %.0f years\n",
+           (unsigned long)fs.minSectorErases, (unsigned long)fs.maxSectorErases, lifeYears);
+    double spanDays = (store.newestTime() - store.oldestTime()) / 86400.0;
+    printf("  retained %.1f days: %lu samples, %d raw + %d compacted segments\n",
+           spanDays, (unsigned long)store.sampleCount(),
+           store.segmentsUsed(0), store.segmentsUsed(1));
+    check(failed == 0, "every append succeeded");
+    check(fs.violations == 0, "never programs over unerased bits");
+    check(lifeYears > 10, "hottest sector outlives 10 years");
+
+    // Remount: index rebuild cost
+    HistoryStore again;
+    FlashEmu::resetStats();
+    double m0 = nowUs();
+    again.mount(flash);
+    double mountUs = nowUs() - m0;
+    printf("  mount %.0f us, %lu B read\n", mountUs, (unsigned long)FlashEmu::stats().bytesRead);
+    check(again.newestTime() == store.newestTime() && again.sampleCount() == store.sampleCount(),
+          "remount rebuilds the same index");
+
+    // Query latency
+    static HistorySample out[HistoryStore::MAX_SEGMENTS * HistoryStore::SLOTS];
+    struct Range { const char* name; uint32_t span; } ranges[] = {
+        { "last 1 h",  3600 },
+        { "last 24 h", 86400 },
+        { "random 1 h", 3600 },
+        { "everything", UINT32_MAX },
+    };
+    uint32_t newest = again.newestTime(), oldest = again.oldestTime();
+    srand(7);
+    for (const Range& r : ranges) {
+        const int iters = 200;
+        int n = 0;
+        FlashEmu::resetStats();
+        double q0 = nowUs();
+        for (int i = 0; i < iters; i++) {
+            uint32_t to = newest;
+            if (r.name[0] == 'r') to = oldest + rand() % (newest - oldest);
+            uint32_t from = r.span > to ? 0 : to - r.span;
+            n = again.query(from, to, out, sizeof(out) / sizeof(out[0]));
+        }
+        double q = (nowUs() - q0) / iters;
+        printf("  query %-10s %6d samples %8.1f us %8lu B read\n", r.name, n, q,
+               (unsigned long)(FlashEmu::stats().bytesRead / iters));
+    }
+    bool ordered;
+    scanAll(again, ordered);
+    check(ordered, "full scan is time-ordered");
+    FlashEmu::detach();
+}
+
+// -- 3. Power cuts ---------------------------------------------------------
+static void powerCuts(const char* image) {
+    const int trials = 300;
+    printf("power cuts (%d trials)\n", trials);
+    remove(image);
+    FlashEmu::attach("history", image, PARTITION_SIZE);
+
+    FlashRegion flash;
+    flash.open("history");
+    uint32_t t = 1735689600;
+    srand(11);
+
+    // Fill past the first compactions so cuts land in every phase
+    {
+        HistoryStore store;
+        store.mount(flash);
+        for (int i = 0; i < 40000; i++, t += SAMPLE_S) store.append(synth(t));
+    }
+
+    int bad = 0, lostAcked = 0, recovered = 0, torn = 0;
+    uint32_t violationsBefore = FlashEmu::stats().violations;
+    for (int trial = 0; trial < trials; trial++) {
+        HistoryStore store;
+        store.mount(flash);
+
+        // Run until the cut fires; remember the newest acknowledged sample
+        FlashEmu::cutPowerAfter(1 + rand() % 200000);
+        uint32_t acked = 0;
+        while (!FlashEmu::powerLost()) {
+            if (store.append(synth(t))) acked = t;
+            t += SAMPLE_S;
+        }
+        FlashEmu::restorePower();
+
+        HistoryStore after;
+        if (!after.mount(flash)) {
+            bad++;
+            continue;
+        }
+        recovered += after.stats().recovered;
+
+        HistorySample s;
+        if (acked && after.query(acked, acked, &s, 1) != 1) lostAcked++;
+
+        bool ordered;
+        scanAll(after, ordered);
+        torn += after.stats().tornRecords;
+        if (!ordered || !after.append(synth(t))) bad++;
+        t += SAMPLE_S;
+    }
+
+    printf("  %d interrupted compactions finished at mount, %d torn records skipped\n",
+           recovered, torn);
+    check(bad == 0, "remount consistent, ordered, appendable");
+    check(lostAcked == 0, "no acknowledged sample lost");
+    check(FlashEmu::stats().violations == violationsBefore, "never programs over unerased bits");
+    FlashEmu::detach();
+}
+
+// -- 4. Every cut point inside one compaction ------------------------------
+static void compactionCuts(const char* image) {
+    printf("cuts inside one compaction\n");
+    remove(image);
+    FlashEmu::attach("history", image, PARTITION_SIZE);
+
+    FlashRegion flash;
+    flash.open("history");
+    HistoryStore store;
+    store.mount(flash);
+
+    // Advance to the append that triggers a compaction, keeping the state
+    // right before it (flash image + in-RAM store)
+    uint32_t t = 1735689600;
+    std::vector<uint8_t> image0;
+    HistoryStore before;
+    uint64_t ops = 0;
+    while (true) {
+        image0 = FlashEmu::snapshot();
+        before = store;
+        uint64_t ops0 = FlashEmu::stats().ops;
+        uint32_t compactions = store.stats().compactions;
+        store.append(synth(t));
+        if (store.stats().compactions != compactions) {
+            ops = FlashEmu::stats().ops - ops0;
+            break;
+        }
+        t += SAMPLE_S;
+    }
+
+    int bad = 0, recovered = 0;
+    for (uint64_t cut = 1; cut <= ops; cut++) {
+        FlashEmu::restore(image0);
+        HistoryStore run = before;
+        FlashEmu::cutPowerAfter(cut);
+        run.append(synth(t));
+        FlashEmu::restorePower();
+
+        HistoryStore after;
+        bool ordered = false;
+        if (!after.mount(flash)) { bad++; continue; }
+        recovered += after.stats().recovered ? 1 : 0;
+        scanAll(after, ordered);
+        HistorySample s;
+        if (!ordered || after.query(t - SAMPLE_S, t - SAMPLE_S, &s, 1) != 1) bad++;
+    }
+    printf("  %lu cut points, %d left a finished-but-unerased compaction\n",
+           (unsigned long)ops, recovered);
+    check(recovered > 0, "mount finishes an interrupted compaction");
+    check(bad == 0, "every cut point remounts ordered, nothing acked lost");
+    FlashEmu::detach();
+}
+
+int main(int argc, char** argv) {
+    const char* image = argc > 1 ? argv[1] : "/tmp/history.bin";
+    int days = argc > 2 ? atoi(argv[2]) : 90;
+
+    sustained(image, days);
+    powerCuts(image);
+    compactionCuts(image);
+    printf("%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,376 @@
+// ==========================================================================
+// hll_bench -- Host accuracy + cost check for WindowHll
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -pthread -Iinclude -Isrc -o hll_bench
+//       tools/hll_bench/hll_bench.cpp src/sys/window_hll.cpp
+// (add -fsanitize=thread to have TSan watch the feeder / loop() split)
+//
+// Usage:
+//   hll_bench [hours]                default 8 simulated hours in part 3
+//
+//   1. semantics: size, empty and tiny sets, buckets ageing out of each
+//      window on time, a long gap clearing everything
+//   2. crowd size: one bucket of n distinct MACs, n from 10 to 2M, many
+//      trials each; relative error against the standard error 1.04/sqrt(M),
+//      up to WindowHll::RANGE (the rows past it show the registers saturating)
+//   3. sliding windows: a simulated day of crowds coming and going (a
+//      quiet flat, a cafe, a station concourse, a stadium) from a pool of
+//      millions of MACs, hashed as the capture callbacks hash them. Every
+//      minute each window is checked against the exact distinct count
+//      over the span it covers
+//   4. a feeder thread adding while the main thread advances and counts,
+//      first with the clock standing, then turning a minute at a time
+//      under it; then add() cost per id
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "sys/window_hll.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// CPU time of the calling thread: what the capture task would pay
+static double threadUs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static const double SIGMA = 1.04 / sqrt(static_cast<double>(WindowHll::M));
+
+// -- MACs, hashed like promisc_cb / ScanCallbacks hash them ---------------
+// Device i of a run gets a locally administered MAC built from i and a
+// per-run salt, so runs don't share ids
+static uint32_t macHash(uint32_t i, uint32_t salt) {
+    uint8_t mac[6] = { uint8_t(0x02 | (salt << 2)), uint8_t(salt >> 6),
+                       uint8_t(i >> 24), uint8_t(i >> 16), uint8_t(i >> 8), uint8_t(i) };
+    uint32_t h = 2166136261u;
+    for (int k = 0; k < 6; k++) {
+        h ^= mac[k];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static double relErr(uint32_t est, uint32_t exact) {
+    return exact ? (static_cast<double>(est) - exact) / exact : (est ? 1.0 : 0.0);
+}
+
+// -- 1. Semantics ----------------------------------------------------------
+static void semantics() {
+    printf("semantics (%d buckets of %d registers, %zu B, sigma %.1f%%)\n",
+           WindowHll::SLOTS, WindowHll::M, WindowHll::bytes(), 100 * SIGMA);
+    static WindowHll h;
+    check(WindowHll::bytes() <= 1024, "a few hundred bytes");
+
+    h.advance(1000);
+    check(h.count(60) == 0 && h.count(300) == 0 && h.count(900) == 0, "empty sketch counts 0");
+
+    bool tiny = true;
+    for (uint32_t n = 1; n <= 40; n++) {
+        h.add(macHash(n, 1));
+        uint32_t est = h.count(60);
+        tiny = tiny && std::abs(static_cast<int>(est) - static_cast<int>(n)) <= 1 + static_cast<int>(n / 10);
+    }
+    check(tiny, "1..40 ids: within 1 + 10% (linear counting)");
+    for (int rep = 0; rep < 5; rep++)
+        for (uint32_t n = 1; n <= 40; n++) h.add(macHash(n, 1));
+    check(h.count(60) == h.count(900) && h.count(60) <= 44, "repeats don't count again");
+
+    // The 40 ids landed in minute 16 (t = 1000 s) and block 3
+    h.advance(16 * 60 + 59);
+    uint32_t same = h.count(60);
+    h.advance(17 * 60);
+    bool stillIn = h.count(60) == same;
+    h.advance(18 * 60);
+    check(stillIn && h.count(60) == 0 && h.count(300) == same, "1m window: out after its second minute");
+    h.advance(21 * 60 + 59);
+    stillIn = h.count(300) == same;
+    h.advance(22 * 60);
+    check(stillIn && h.count(300) == 0 && h.count(900) == same, "5m window: out after its sixth minute");
+    h.advance(7 * 300 - 1);
+    stillIn = h.count(900) == same;
+    h.advance(7 * 300);
+    check(stillIn && h.count(900) == 0, "15m window: out after its fourth block");
+
+    for (uint32_t n = 0; n < 1000; n++) h.add(macHash(n, 2));
+    h.advance(7 * 300 + 86400);
+    check(h.count(60) == 0 && h.count(900) == 0, "a day's gap clears every bucket");
+
+    // Windows in between round up to whole buckets
+    h.add(macHash(7, 3));
+    check(h.count(1) == 1 && h.count(120) == 1 && h.count(600) == 1 && h.count(99999) == 1,
+          "any window length accepted (clamped)");
+}
+
+// -- 2. Error against crowd size -------------------------------------------
+// 99th percentile of |e|; the estimate's tail is longer than a normal's
+static double p99(std::vector<double>& errs) {
+    std::sort(errs.begin(), errs.end());
+    return errs[(errs.size() - 1) * 99 / 100];
+}
+
+static void crowdSizes() {
+    printf("crowd size (one bucket, distinct ids)\n");
+    printf("  %9s %6s %9s %9s %9s %9s\n", "n", "trials", "bias", "mean|e|", "p99|e|", "max|e|");
+    static const uint32_t SIZES[]  = { 10, 100, 1000, 10000, 100000, 500000, 1000000, 2000000 };
+    static const int      TRIALS[] = { 1000, 1000, 1000, 1000, 300, 60, 20, 8 };
+    static WindowHll h;
+    bool meanOk = true, tailOk = true;
+    uint32_t salt = 100;
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        std::vector<double> errs;
+        double sum = 0, sumAbs = 0;
+        for (int t = 0; t < TRIALS[s]; t++) {
+            h.reset();
+            h.advance(0);
+            salt++;
+            for (uint32_t i = 0; i < SIZES[s]; i++) h.add(macHash(i, salt));
+            double e = relErr(h.count(60), SIZES[s]);
+            sum += e;
+            sumAbs += fabs(e);
+            errs.push_back(fabs(e));
+        }
+        double mean = sumAbs / TRIALS[s], tail = p99(errs);
+        bool saturating = SIZES[s] > WindowHll::RANGE;
+        printf("  %9u %6d %+8.1f%% %8.1f%% %8.1f%% %8.1f%%%s\n", SIZES[s], TRIALS[s],
+               100 * sum / TRIALS[s], 100 * mean, 100 * tail, 100 * errs.back(),
+               saturating ? "  past RANGE: reads low" : "");
+        if (saturating) continue;
+        // |e| of a normal error averages 0.8 sigma
+        meanOk = meanOk && mean <= SIGMA;
+        tailOk = tailOk && tail <= 3 * SIGMA;
+    }
+    check(meanOk, "mean |error| within sigma, up to RANGE");
+    check(tailOk, "99% of trials within 3 sigma, up to RANGE");
+}
+
+// -- 3. Sliding windows over a simulated day -------------------------------
+struct Phase {
+    const char* name;
+    uint32_t minutes;
+    uint32_t crowd;         // devices present at once
+    uint32_t turnoverS;     // time for the crowd to be replaced
+    uint32_t perSec;        // probes / adverts heard per second
+};
+
+static const Phase PHASES[] = {
+    { "flat",      60,     40,  7200,    3 },
+    { "cafe",      60,    400,  1800,   40 },
+    { "street",    60,   3000,   300,  400 },
+    { "station",   90,  40000,   600, 3000 },
+    { "stadium",  120, 300000,  3600, 9000 },
+    { "flat",      90,     40,  7200,    3 },
+};
+
+struct WindowStats {
+    uint32_t samples = 0;
+    double   sumAbs  = 0;
+    double   maxAbs  = 0;
+    uint32_t maxExact = 0;
+    void add(uint32_t est, uint32_t exact) {
+        if (!exact) return;
+        double e = fabs(relErr(est, exact));
+        samples++;
+        sumAbs += e;
+        if (e > maxAbs) maxAbs = e;
+        if (exact > maxExact) maxExact = exact;
+    }
+};
+
+static void slidingWindows(uint32_t hours) {
+    printf("sliding windows (%u simulated hours, checked every minute)\n", hours);
+    static WindowHll h;
+    h.reset();
+
+    // Exact answer: each device's last-seen minute, and how many devices
+    // were last seen in each minute; distinct over minutes [a, now] is the
+    // sum of that histogram from a on
+    const uint32_t totalMin = hours * 60;
+    std::vector<uint32_t> lastSeen;                 // minute + 1, 0 = never
+    std::vector<uint32_t> byMinute(totalMin + 1, 0);
+
+    uint32_t rng = 2463534242u;
+    auto next = [&rng] { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; };
+
+    WindowStats stats[3];
+    static const uint32_t WINDOWS[3] = { 60, 300, 900 };
+    uint64_t adds = 0;
+    double base = 0;            // the crowd present is [base, base + crowd)
+    size_t phase = 0;
+    uint32_t phaseEnd = PHASES[0].minutes;
+
+    for (uint32_t minute = 0; minute < totalMin; minute++) {
+        if (minute >= phaseEnd) {
+            phase = (phase + 1) % (sizeof(PHASES) / sizeof(PHASES[0]));
+            phaseEnd += PHASES[phase].minutes;
+        }
+        const Phase& p = PHASES[phase];
+        for (uint32_t sec = 0; sec < 60; sec++) {
+            uint32_t t = minute * 60 + sec;
+            h.advance(t);
+            for (uint32_t k = 0; k < p.perSec; k++) {
+                uint32_t id = static_cast<uint32_t>(base) + next() % p.crowd;
+                if (id >= lastSeen.size()) lastSeen.resize(id + 1 + (1u << 20), 0);
+                if (lastSeen[id]) byMinute[lastSeen[id] - 1]--;
+                lastSeen[id] = minute + 1;
+                byMinute[minute]++;
+                h.add(macHash(id, 7));
+                adds++;
+            }
+            base += static_cast<double>(p.crowd) / p.turnoverS;
+        }
+
+        // Check at the end of the minute: each window against the exact
+        // count over the buckets it covers
+        uint32_t block = minute / 5;
+        uint32_t from[3] = {
+            minute >= 1 ? minute - 1 : 0,
+            minute >= 5 ? minute - 5 : 0,
+            block >= 3 ? (block - 3) * 5 : 0,
+        };
+        for (int w = 0; w < 3; w++) {
+            uint32_t exact = 0;
+            for (uint32_t m = from[w]; m <= minute; m++) exact += byMinute[m];
+            stats[w].add(h.count(WINDOWS[w]), exact);
+        }
+    }
+
+    uint32_t devices = 0;
+    for (uint32_t v : lastSeen) devices += v != 0;
+    printf("  %llu ids added, %u distinct MACs\n", (unsigned long long)adds, devices);
+    printf("  %6s %8s %9s %9s %9s\n", "window", "samples", "mean|e|", "max|e|", "max n");
+    bool meanOk = true, maxOk = true;
+    for (int w = 0; w < 3; w++) {
+        const WindowStats& s = stats[w];
+        double mean = s.samples ? s.sumAbs / s.samples : 0;
+        printf("  %5us %8u %8.1f%% %8.1f%% %9u\n", WINDOWS[w], s.samples, 100 * mean,
+               100 * s.maxAbs, s.maxExact);
+        meanOk = meanOk && mean <= SIGMA;
+        maxOk  = maxOk && s.maxAbs <= 4 * SIGMA;
+    }
+    check(devices >= 1000000, "millions of distinct MACs");
+    check(meanOk, "mean |error| within sigma, every window");
+    check(maxOk, "no minute beyond 4 sigma");
+}
+
+// -- 4. Concurrency and cost -----------------------------------------------
+static void concurrencyAndCost() {
+    printf("feeder thread + loop(), then add() cost\n");
+    static WindowHll h;
+    h.reset();
+    h.advance(0);
+
+    // The feeder adds 0..N-1 twice over; loop() counts all the while. The
+    // clock stands still, so nothing ages out and the end count must be
+    // as good as a single-threaded one
+    const uint32_t N = 200000;
+    std::atomic<bool> done(false);
+    std::thread feeder([&] {
+        for (int rep = 0; rep < 2; rep++) {
+            for (uint32_t i = 0; i < N; i++) {
+                h.add(macHash(i, 9));
+                if ((i & 1023) == 0) std::this_thread::yield();
+            }
+        }
+        done.store(true, std::memory_order_release);
+    });
+    uint32_t counts = 0;
+    bool monotone = true;
+    uint32_t last = 0;
+    while (!done.load(std::memory_order_acquire)) {
+        h.advance(30);
+        uint32_t c = h.count(300);
+        monotone = monotone && c >= last;
+        last = c;
+        counts++;
+        std::this_thread::yield();
+    }
+    feeder.join();
+    double e = relErr(h.count(300), N);
+    printf("  %u counts while feeding, final error %+.1f%%\n", counts, 100 * e);
+    check(monotone, "counts never go backwards while feeding");
+    check(fabs(e) <= 4 * SIGMA, "final count within 4 sigma");
+
+    // Now the clock runs: every minute loop() publishes a new generation
+    // of K ids and advances, reusing (clearing) a bucket the feeder is
+    // writing to. The feeder may be one generation behind, so the last
+    // two minutes hold at most three generations -- an old bucket that
+    // survived its clear would add a fourth. Once the feeder stops and a
+    // whole ring goes by, nothing is left
+    const uint32_t K = 2000, MINUTES = 600;
+    std::atomic<uint32_t> gen(0), added(0);
+    done.store(false, std::memory_order_relaxed);
+    h.reset();
+    h.advance(0);
+    std::thread rotating([&] {
+        for (uint32_t i = 0; !done.load(std::memory_order_acquire); i++) {
+            h.add(macHash(i % K, 1000 + gen.load(std::memory_order_acquire)));
+            added.fetch_add(1, std::memory_order_release);
+            if ((i & 255) == 0) std::this_thread::yield();
+        }
+    });
+    uint32_t worst = 0;
+    for (uint32_t m = 1; m <= MINUTES; m++) {
+        gen.store(m, std::memory_order_release);
+        h.advance(m * 60);
+        uint32_t from = added.load(std::memory_order_acquire);
+        while (added.load(std::memory_order_acquire) - from < 2 * K) std::this_thread::yield();
+        worst = std::max(worst, h.count(60));
+    }
+    done.store(true, std::memory_order_release);
+    rotating.join();
+    h.advance((MINUTES + 20) * 60);
+    printf("  rotating clock: %u minutes of %u ids, worst count(60) %u\n", MINUTES, K, worst);
+    check(worst <= 3 * K * (1 + 4 * SIGMA), "no cleared bucket comes back while feeding");
+    check(h.count(900) == 0, "empty once the feeder stops and the ring turns");
+
+    const uint32_t ADDS = 5000000;
+    std::vector<uint32_t> ids(ADDS);
+    for (uint32_t i = 0; i < ADDS; i++) ids[i] = macHash(i, 11);
+    double best = 1e18;
+    for (int rep = 0; rep < 5; rep++) {
+        h.reset();
+        double c0 = threadUs();
+        for (uint32_t id : ids) h.add(id);
+        double spent = threadUs() - c0;
+        if (spent < best) best = spent;
+    }
+    double t0 = nowUs();
+    volatile uint32_t sink = 0;
+    for (int i = 0; i < 1000; i++) sink = sink + h.count(60 + (i % 3) * 420);
+    double countUs = (nowUs() - t0) / 1000;
+    printf("  add   %6.1f ns/id (best of 5)\n", best * 1000 / ADDS);
+    printf("  count %6.2f us (merge + estimate)\n", countUs);
+}
+
+int main(int argc, char** argv) {
+    uint32_t hours = argc > 1 ? strtoul(argv[1], nullptr, 10) : 8;
+    semantics();
+    crowdSizes();
+    slidingWindows(hours);
+    concurrencyAndCost();
+    printf("%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
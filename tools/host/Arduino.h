@@ -0,0 +1,36 @@
+#pragma once
+// ==========================================================================
+// Host shim for tools/ -- just enough of Arduino.h to compile src/state/
+// and src/hal/storage.cpp natively (the state layer takes its clock and
+// PRNG explicitly, see PetLogic::seed)
+// ==========================================================================
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+
+template <typename T, typename L, typename H>
+inline T constrain(T v, L lo, H hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+struct HostSerial {
+    void println(const char* s = "") { ::printf("%s\n", s); }
+    void printf(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        ::vprintf(fmt, args);
+        va_end(args);
+    }
+};
+inline HostSerial Serial;
+
+// Defined by the tools that compile a module reading the clock
+unsigned long millis();
@@ -0,0 +1,91 @@
+#pragma once
+// ==========================================================================
+// Host stand-in for the ESP32 Preferences (NVS) API -- in-memory key store
+// that counts write operations and entries so tools can measure flash wear.
+// The store is shared by all instances, like the real NVS partition.
+// tornNextPut() simulates a power cut mid-write (value stored truncated).
+// ==========================================================================
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    struct Counters {
+        uint32_t puts;          // NVS write operations
+        uint32_t entries;       // 32-byte NVS entries programmed
+        uint32_t removes;
+    };
+
+    bool begin(const char*, bool) { return true; }
+    void end() {}
+
+    // Primitives fit in one entry; blobs take a header entry + data entries
+    size_t putInt(const char* k, int32_t v)     { return put(k, &v, sizeof(v), 1); }
+    size_t putULong(const char* k, uint32_t v)  { return put(k, &v, sizeof(v), 1); }
+    size_t putUChar(const char* k, uint8_t v)   { return put(k, &v, sizeof(v), 1); }
+    size_t putUShort(const char* k, uint16_t v) { return put(k, &v, sizeof(v), 1); }
+    size_t putBool(const char* k, bool v)       { uint8_t b = v; return put(k, &b, 1, 1); }
+    size_t putBytes(const char* k, const void* v, size_t n) {
+        return put(k, v, n, 1 + static_cast<uint32_t>((n + 31) / 32));
+    }
+
+    int32_t  getInt(const char* k, int32_t d = 0)     { return get(k, d); }
+    uint32_t getULong(const char* k, uint32_t d = 0)  { return get(k, d); }
+    uint8_t  getUChar(const char* k, uint8_t d = 0)   { return get(k, d); }
+    uint16_t getUShort(const char* k, uint16_t d = 0) { return get(k, d); }
+    bool     getBool(const char* k, bool d = false)   { return get<uint8_t>(k, d) != 0; }
+
+    size_t getBytesLength(const char* k) {
+        auto it = m_store.find(k);
+        return it == m_store.end() ? 0 : it->second.size();
+    }
+    size_t getBytes(const char* k, void* out, size_t n) {
+        auto it = m_store.find(k);
+        if (it == m_store.end() || it->second.size() > n) return 0;
+        memcpy(out, it->second.data(), it->second.size());
+        return it->second.size();
+    }
+
+    bool isKey(const char* k) { return m_store.count(k) != 0; }
+    bool remove(const char* k) {
+        if (!m_store.erase(k)) return false;
+        m_counters.removes++;
+        return true;
+    }
+
+    // -- Host-only hooks ---------------------------------------------------
+    static const Counters& counters() { return m_counters; }
+    static void resetCounters() { m_counters = Counters{}; }
+    static void tornNextPut() { m_tearNext = true; }
+
+private:
+    size_t put(const char* k, const void* v, size_t n, uint32_t entries) {
+        const uint8_t* p = static_cast<const uint8_t*>(v);
+        m_counters.puts++;
+        m_counters.entries += entries;
+        if (m_tearNext) {
+            m_tearNext = false;
+            m_store[k].assign(p, p + n / 2);
+            return n;           // caller can't tell; the next load must cope
+        }
+        m_store[k].assign(p, p + n);
+        return n;
+    }
+
+    template <typename T>
+    T get(const char* k, T d) {
+        auto it = m_store.find(k);
+        if (it == m_store.end() || it->second.size() != sizeof(T)) return d;
+        T v;
+        memcpy(&v, it->second.data(), sizeof(T));
+        return v;
+    }
+
+    static inline std::map<std::string, std::vector<uint8_t>> m_store;
+    static inline Counters m_counters{};
+    static inline bool m_tearNext = false;
+};
@@ -0,0 +1,43 @@
+#pragma once
+// ==========================================================================
+// Host flash emulator behind FlashRegion (tools/host/flash_region_host.cpp)
+// A file-backed NOR partition: erase sets a 4 KB sector to 0xFF, program
+// can only clear bits (programming a 0 -> 1 is counted as a violation).
+// Tracks per-sector erase counts and can cut power after a number of
+// programmed bytes / erases: the op in flight is left partial and every
+// later op fails until restorePower() -- i.e. until the next "boot".
+// ==========================================================================
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace FlashEmu {
+
+// Creates (or reopens, keeping contents) `path` as partition `label`
+bool attach(const char* label, const char* path, uint32_t size);
+void detach();
+
+struct Stats {
+    uint64_t bytesRead;
+    uint64_t bytesProgrammed;
+    uint64_t ops;           // programmed bytes + erases: the cutPowerAfter unit
+    uint32_t erases;
+    uint32_t violations;    // program tried to set a 0 bit back to 1
+    uint32_t maxSectorErases;
+    uint32_t minSectorErases;
+};
+const Stats& stats();
+void resetStats();
+
+// Whole-image copy, to rerun the same operation with different cuts
+std::vector<uint8_t> snapshot();
+void restore(const std::vector<uint8_t>& image);
+
+// Power cut after `bytes` more programmed bytes (erase counts as 1);
+// 0 disarms. powerLost() is true once it has fired.
+void cutPowerAfter(uint64_t bytes);
+bool powerLost();
+void restorePower();
+
+}  // namespace FlashEmu
@@ -0,0 +1,150 @@
+#include "hal/flash_region.h"
+#include "flash_emu.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// ==========================================================================
+// FlashRegion on the host -- backed by FlashEmu's file image
+// ==========================================================================
+
+namespace {
+
+struct Partition {
+    std::string label;
+    FILE* file = nullptr;
+    std::vector<uint8_t> data;
+    std::vector<uint32_t> eraseCounts;
+};
+
+Partition s_part;
+FlashEmu::Stats s_stats;
+uint64_t s_budget = 0;      // 0 = no cut armed
+bool s_powerLost = false;
+
+void sync(uint32_t offset, size_t len) {
+    if (!s_part.file) return;
+    fseek(s_part.file, offset, SEEK_SET);
+    fwrite(&s_part.data[offset], 1, len, s_part.file);
+}
+
+// Consumes budget; returns how many of `len` units complete before the cut
+size_t spend(size_t len) {
+    if (s_powerLost) return 0;
+    size_t done = len;
+    if (s_budget != 0) {
+        if (len < s_budget) {
+            s_budget -= len;
+        } else {
+            done = static_cast<size_t>(s_budget) - 1;
+            s_budget = 0;
+            s_powerLost = true;
+        }
+    }
+    s_stats.ops += done;
+    return done;
+}
+
+}  // namespace
+
+bool FlashEmu::attach(const char* label, const char* path, uint32_t size) {
+    detach();
+    s_part.label = label;
+    s_part.data.assign(size, 0xFF);
+    s_part.eraseCounts.assign(size / FlashRegion::SECTOR_SIZE, 0);
+
+    s_part.file = fopen(path, "r+b");
+    if (s_part.file) {
+        size_t n = fread(s_part.data.data(), 1, size, s_part.file);
+        (void)n;
+    } else {
+        s_part.file = fopen(path, "w+b");
+        if (!s_part.file) return false;
+        sync(0, size);
+    }
+    resetStats();
+    return true;
+}
+
+void FlashEmu::detach() {
+    if (s_part.file) fclose(s_part.file);
+    s_part = Partition();
+}
+
+const FlashEmu::Stats& FlashEmu::stats() {
+    if (!s_part.eraseCounts.empty()) {
+        auto mm = std::minmax_element(s_part.eraseCounts.begin(), s_part.eraseCounts.end());
+        s_stats.minSectorErases = *mm.first;
+        s_stats.maxSectorErases = *mm.second;
+    }
+    return s_stats;
+}
+
+void FlashEmu::resetStats() {
+    s_stats = Stats();
+    std::fill(s_part.eraseCounts.begin(), s_part.eraseCounts.end(), 0);
+}
+
+std::vector<uint8_t> FlashEmu::snapshot() { return s_part.data; }
+void FlashEmu::restore(const std::vector<uint8_t>& image) {
+    s_part.data = image;
+    sync(0, image.size());
+}
+
+void FlashEmu::cutPowerAfter(uint64_t bytes) { s_budget = bytes; }
+bool FlashEmu::powerLost() { return s_powerLost; }
+void FlashEmu::restorePower() {
+    s_budget = 0;
+    s_powerLost = false;
+}
+
+// -- FlashRegion -----------------------------------------------------------
+bool FlashRegion::open(const char* label) {
+    if (s_part.data.empty() || s_part.label != label) return false;
+    m_part = &s_part;
+    m_size = static_cast<uint32_t>(s_part.data.size());
+    return true;
+}
+
+bool FlashRegion::read(uint32_t offset, void* dst, size_t len) const {
+    if (!m_part || offset + len > m_size || s_powerLost) return false;
+    memcpy(dst, &s_part.data[offset], len);
+    s_stats.bytesRead += len;
+    return true;
+}
+
+bool FlashRegion::write(uint32_t offset, const void* src, size_t len) {
+    if (!m_part || offset + len > m_size) return false;
+    size_t done = spend(len);
+    const uint8_t* p = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < done; i++) {
+        uint8_t& cell = s_part.data[offset + i];
+        if (p[i] & ~cell) s_stats.violations++;
+        cell &= p[i];
+    }
+    s_stats.bytesProgrammed += done;
+    sync(offset, done);
+    return done == len;
+}
+
+bool FlashRegion::eraseSector(uint32_t sector) {
+    if (!m_part || (sector + 1) * SECTOR_SIZE > m_size) return false;
+    uint32_t offset = sector * SECTOR_SIZE;
+    bool wasLost = s_powerLost;
+    if (spend(1) == 0) {
+        // Cut mid-erase: the first half made it back to 0xFF
+        if (!wasLost) {
+            memset(&s_part.data[offset], 0xFF, SECTOR_SIZE / 2);
+            sync(offset, SECTOR_SIZE / 2);
+        }
+        return false;
+    }
+    memset(&s_part.data[offset], 0xFF, SECTOR_SIZE);
+    s_part.eraseCounts[sector]++;
+    s_stats.erases++;
+    sync(offset, SECTOR_SIZE);
+    return true;
+}
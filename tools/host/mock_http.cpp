@@ -0,0 +1,199 @@
+#include "mock_http.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <strings.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ==========================================================================
+// MockHttp -- blocking sockets, one thread per connection
+// ==========================================================================
+
+const std::string* MockHttp::Request::header(const char* name) const {
+    for (const auto& h : headers) {
+        if (strcasecmp(h.first.c_str(), name) == 0) return &h.second;
+    }
+    return nullptr;
+}
+
+// -- Conn ------------------------------------------------------------------
+bool MockHttp::Conn::write(const std::string& data) {
+    if (m_fd < 0) return false;
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(m_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+        m_server.m_bytes += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+bool MockHttp::Conn::drip(const std::string& data, int pieces, int gapMs) {
+    size_t step = (data.size() + pieces - 1) / pieces;
+    for (size_t off = 0; off < data.size(); off += step) {
+        if (off) sleepMs(gapMs);
+        if (!write(data.substr(off, step))) return false;
+    }
+    return true;
+}
+
+void MockHttp::Conn::sleepMs(int ms) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (m_server.m_running && std::chrono::steady_clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void MockHttp::Conn::close() {
+    if (m_fd < 0) return;
+    shutdown(m_fd, SHUT_RDWR);
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+// -- Server ----------------------------------------------------------------
+MockHttp::MockHttp() = default;
+MockHttp::~MockHttp() { stop(); }
+
+bool MockHttp::start(Handler handler) {
+    m_handler = std::move(handler);
+    m_listen = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listen < 0) return false;
+    int one = 1;
+    setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = 0;
+    if (bind(m_listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(m_listen, 16) != 0) {
+        ::close(m_listen);
+        m_listen = -1;
+        return false;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(m_listen, reinterpret_cast<sockaddr*>(&addr), &len);
+    m_port = ntohs(addr.sin_port);
+
+    m_running = true;
+    m_acceptThread = std::thread(&MockHttp::acceptLoop, this);
+    return true;
+}
+
+void MockHttp::stop() {
+    if (!m_running.exchange(false)) return;
+    shutdown(m_listen, SHUT_RDWR);
+    ::close(m_listen);
+    m_listen = -1;
+    if (m_acceptThread.joinable()) m_acceptThread.join();
+    for (std::thread& t : m_workers) {
+        if (t.joinable()) t.join();
+    }
+    m_workers.clear();
+}
+
+std::string MockHttp::url(const char* path) const {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "http://127.0.0.1:%u", m_port);
+    return std::string(buf) + path;
+}
+
+void MockHttp::resetCounters() {
+    m_connections = 0;
+    m_requests = 0;
+    m_bytes = 0;
+}
+
+void MockHttp::acceptLoop() {
+    while (m_running) {
+        int fd = accept(m_listen, nullptr, nullptr);
+        if (fd < 0) continue;
+        m_connections++;
+        m_workers.emplace_back(&MockHttp::serve, this, fd);
+    }
+}
+
+void MockHttp::serve(int fd) {
+    timeval tv = { 0, 50 * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    Conn conn(fd, *this);
+    std::string buf;
+    char chunk[1024];
+    while (m_running && !conn.closed()) {
+        size_t end = buf.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n == 0) break;
+            if (n < 0) continue;            // timeout: re-check m_running
+            buf.append(chunk, static_cast<size_t>(n));
+            continue;
+        }
+
+        // Request line + headers, then a Content-Length body if there is one
+        Request req;
+        std::string head = buf.substr(0, end);
+        buf.erase(0, end + 4);
+        size_t lineEnd = head.find("\r\n");
+        std::string first = head.substr(0, lineEnd);
+        size_t sp1 = first.find(' '), sp2 = first.rfind(' ');
+        req.method = first.substr(0, sp1);
+        req.path   = first.substr(sp1 + 1, sp2 - sp1 - 1);
+        while (lineEnd != std::string::npos) {
+            size_t next = head.find("\r\n", lineEnd + 2);
+            std::string line = head.substr(lineEnd + 2, next == std::string::npos
+                                                          ? std::string::npos : next - lineEnd - 2);
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                size_t v = line.find_first_not_of(' ', colon + 1);
+                req.headers.emplace_back(line.substr(0, colon),
+                                         v == std::string::npos ? "" : line.substr(v));
+            }
+            lineEnd = next;
+        }
+        if (const std::string* len = req.header("Content-Length")) {
+            size_t want = strtoul(len->c_str(), nullptr, 10);
+            while (m_running && buf.size() < want) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n == 0) break;
+                if (n > 0) buf.append(chunk, static_cast<size_t>(n));
+            }
+            if (buf.size() < want) break;
+            req.body = buf.substr(0, want);
+            buf.erase(0, want);
+        }
+        m_requests++;
+        if (!m_handler(conn, req)) break;
+    }
+    conn.close();
+}
+
+// -- Canned responses ------------------------------------------------------
+std::string MockHttp::response(int status, const std::string& body,
+                               const std::string& extraHeaders, const char* contentType) {
+    char head[160];
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 %d X\r\nContent-Type: %s\r\nContent-Length: %zu\r\n",
+             status, contentType, body.size());
+    return head + extraHeaders + "\r\n" + body;
+}
+
+std::string MockHttp::chunkedResponse(const std::string& body, size_t chunk) {
+    std::string out = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                      "Transfer-Encoding: chunked\r\n\r\n";
+    for (size_t off = 0; off < body.size(); off += chunk) {
+        size_t n = body.size() - off < chunk ? body.size() - off : chunk;
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", n);
+        out += size + body.substr(off, n) + "\r\n";
+    }
+    return out + "0\r\n\r\n";
+}
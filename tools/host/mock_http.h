@@ -0,0 +1,78 @@
+#pragma once
+// ==========================================================================
+// Scripted HTTP/1.1 server on 127.0.0.1 for the host network tools
+// Listens on an ephemeral port; each connection runs on its own thread and
+// hands every parsed request to the handler, which writes the response
+// through Conn (optionally slowly, in pieces, or not at all). Counts
+// connections, requests and bytes served.
+// ==========================================================================
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MockHttp {
+public:
+    struct Request {
+        std::string method;
+        std::string path;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;               // Content-Length bytes, if any
+        const std::string* header(const char* name) const;     // case-insensitive
+    };
+
+    class Conn {
+    public:
+        explicit Conn(int fd, MockHttp& server) : m_fd(fd), m_server(server) {}
+        bool write(const std::string& data);
+        // data in `pieces` writes with `gapMs` between them
+        bool drip(const std::string& data, int pieces, int gapMs);
+        void sleepMs(int ms);
+        void close();                   // reset-free close, ends the connection
+        bool closed() const { return m_fd < 0; }
+        // False once the server is stopping: long-lived handlers return
+        bool serving() const { return m_server.m_running; }
+    private:
+        int m_fd;
+        MockHttp& m_server;
+    };
+
+    // Return true to keep the connection open for another request
+    using Handler = std::function<bool(Conn&, const Request&)>;
+
+    MockHttp();
+    ~MockHttp();
+
+    bool start(Handler handler);
+    void stop();
+    uint16_t port() const { return m_port; }
+    std::string url(const char* path) const;
+
+    uint32_t connections() const { return m_connections; }
+    uint32_t requests() const { return m_requests; }
+    uint64_t bytesServed() const { return m_bytes; }
+    void resetCounters();
+
+    // Canned response helpers
+    static std::string response(int status, const std::string& body,
+                                const std::string& extraHeaders = "",
+                                const char* contentType = "application/json");
+    static std::string chunkedResponse(const std::string& body, size_t chunk);
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+
+    int m_listen = -1;
+    uint16_t m_port = 0;
+    Handler m_handler;
+    std::thread m_acceptThread;
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint32_t> m_connections{0};
+    std::atomic<uint32_t> m_requests{0};
+    std::atomic<uint64_t> m_bytes{0};
+};
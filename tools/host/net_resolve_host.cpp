@@ -0,0 +1,30 @@
+#include "net/net_resolve.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// ==========================================================================
+// NetResolve on the host -- getaddrinfo, answered on the first call
+// (blocking here is fine: the tools only talk to 127.0.0.1)
+// ==========================================================================
+
+NetResolve::Result NetResolve::lookup(const char* host, uint32_t& ipv4) {
+    in_addr numeric;
+    if (inet_pton(AF_INET, host, &numeric) == 1) {
+        ipv4 = numeric.s_addr;
+        return RESOLVE_OK;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) return RESOLVE_FAILED;
+    ipv4 = reinterpret_cast<sockaddr_in*>(res->ai_addr)->sin_addr.s_addr;
+    freeaddrinfo(res);
+    return RESOLVE_OK;
+}
+
+void NetResolve::cancel() {}
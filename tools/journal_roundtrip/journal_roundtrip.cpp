@@ -0,0 +1,469 @@
+// ==========================================================================
+// journal_roundtrip -- Host checks for the journal writer, codec and replay
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -DFEATURE_JOURNAL=1 -Itools/host -Itools/replay
+//       -Iinclude -Isrc -o journal_roundtrip
+//       tools/journal_roundtrip/journal_roundtrip.cpp src/sys/journal.cpp
+//       src/sys/journal_codec.cpp src/state/pet_state.cpp src/state/mood.cpp
+//       src/state/evolution.cpp tools/host/flash_region_host.cpp
+//
+// Usage:
+//   journal_roundtrip [image.bin] [seed]   default /tmp/journal.bin, seed 1
+//
+// Runs the real Journal on a file-backed NOR emulator:
+//   1. every record type written through the Journal API, read back with
+//      the replay's RecordStream: same order, same times, and each body
+//      re-encodes to the bytes that went in; a corrupted page is rejected
+//      by its CRC and costs only its own records
+//   2. 25 simulated boots of the state layer (catch-up, scans, Cosmania
+//      and radio changes, resets, power cuts) on a 128 KB ring that wraps
+//      several times; after each boot the dump is replayed (replay_core.h,
+//      as tools/replay/ does) and must match every checkpoint in the ring
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "replay_core.h"
+#include "flash_emu.h"
+#include "hal/sound.h"
+#include "hal/leds.h"
+#include "hal/wifi_radio.h"
+#include "sys/journal.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace JournalCodec;
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static uint32_t s_rng = 1;
+
+static uint32_t rnd(uint32_t n) {
+    s_rng ^= s_rng << 13; s_rng ^= s_rng >> 17; s_rng ^= s_rng << 5;
+    return s_rng % n;
+}
+
+static bool chance(uint32_t perMille) { return rnd(1000) < perMille; }
+
+// -- Host clock and HAL stubs ----------------------------------------------
+static unsigned long s_nowMs = 0;
+unsigned long millis() { return s_nowMs; }
+
+void Sound::click() {}
+void Sound::goodFeed() {}
+void Sound::badFeed() {}
+void Sound::discover() {}
+void Sound::restStart() {}
+void Sound::restEnd() {}
+void Sound::hatch() {}
+
+void LEDs::off() {}
+void LEDs::happy() {}
+void LEDs::sad() {}
+void LEDs::wifi() {}
+void LEDs::rest() {}
+void LEDs::breathe(unsigned long) {}
+
+// Recording: a scan finishes 2-4 s after it starts, with made-up results.
+// Replaying: whatever replayImage() staged for the tick
+static bool          s_recording  = false;
+static bool          s_scanArmed  = false;
+static unsigned long s_scanDoneMs = 0;
+static uint32_t      s_version    = 0;
+
+static WifiStats randomWifi() {
+    WifiStats w;
+    w.netCount     = rnd(40);
+    w.strongCount  = rnd(w.netCount + 1);
+    w.hiddenCount  = rnd(4);
+    w.avgRSSI      = -40 - static_cast<int>(rnd(55));
+    w.openCount    = rnd(w.netCount + 1);
+    w.wpaCount     = w.netCount - w.openCount;
+    w.newCount     = rnd(6);
+    w.goneCount    = rnd(6);
+    w.changedCount = rnd(3);
+    w.knownCount   = rnd(300);
+    w.version      = ++s_version;
+    return w;
+}
+
+void WifiRadio::startScan() {
+    if (!s_recording) return;
+    s_scanArmed  = true;
+    s_scanDoneMs = s_nowMs + 2000 + rnd(2000);
+}
+bool WifiRadio::isScanDone() {
+    if (!s_recording) return g_replayScanReady;
+    return s_scanArmed && s_nowMs >= s_scanDoneMs;
+}
+WifiStats WifiRadio::getResults() {
+    if (!s_recording) {
+        g_replayScanReady = false;
+        return g_replayScan;
+    }
+    s_scanArmed = false;
+    return randomWifi();
+}
+
+// -- Random inputs ---------------------------------------------------------
+static PetState randomPet() {
+    PetState p;
+    p.hunger     = static_cast<int>(rnd(101));
+    p.happiness  = static_cast<int>(rnd(101));
+    p.health     = static_cast<int>(rnd(101));
+    p.ageMinutes = rnd(60);
+    p.ageHours   = rnd(24);
+    p.ageDays    = rnd(400);
+    p.stage      = static_cast<EvolutionStage>(rnd(STAGE_ELDER + 1));
+    p.mood       = static_cast<Mood>(rnd(MOOD_CONTENT + 1));
+    p.alive      = !chance(50);
+    p.hatched    = !chance(100);
+    return p;
+}
+
+static CosmaniaStatus randomCosmania() {
+    static const char* NAMES[] = { "sentinel", "dreamer", "coder", "scribe",
+                                   "auditor", "herald", "keeper" };
+    CosmaniaStatus c;
+    c.connected        = !chance(100);
+    c.stale            = chance(100);
+    c.budgetTier       = static_cast<BudgetTier>(rnd(TIER_UNKNOWN + 1));
+    c.totalDailyBudget = rnd(5000) / 100.0f;
+    c.totalDailySpend  = rnd(6000) / 100.0f;
+    c.agentCount       = static_cast<uint8_t>(rnd(8));
+    for (int i = 0; i < c.agentCount; i++) {
+        AgentInfo& a = c.agents[i];
+        strncpy(a.name, NAMES[i], sizeof(a.name) - 1);
+        a.overdue      = chance(150);
+        a.overBudget   = chance(100);
+        a.todayCostUsd = rnd(900) / 100.0f;
+        a.todayRuns    = chance(300) ? 0 : static_cast<int>(rnd(50));
+        a.minutesSince = chance(100) ? -1 : static_cast<int>(rnd(600));
+        c.activeCount += a.todayRuns > 0;
+        c.overdueCount += a.overdue;
+    }
+    c.errorCount      = static_cast<uint8_t>(rnd(5));
+    c.greenDaysStreak = static_cast<uint8_t>(rnd(12));
+    c.version         = ++s_version;
+    return c;
+}
+
+static RadioEnvironment randomRadio() {
+    RadioEnvironment r;
+    r.bleDeviceCount  = rnd(200);
+    r.bleScannerCount = rnd(3);
+    r.probeCount      = rnd(40);
+    r.uniqueProbers   = rnd(r.probeCount + 1);
+    r.deauthCount     = chance(100) ? rnd(50) : 0;
+    r.threatCount     = rnd(3);
+    r.worstThreat     = static_cast<ThreatSeverity>(rnd(THREAT_CRITICAL + 1));
+    r.safetyScore     = static_cast<uint8_t>(rnd(101));
+    r.version         = ++s_version;
+    return r;
+}
+
+// -- 1. Codec round trip ---------------------------------------------------
+// What went in, flattened: one entry per logic tick, one per other record
+struct Expected {
+    RecordType type;
+    uint32_t timeMs;
+    std::vector<uint8_t> body;
+};
+
+template <typename Encode>
+static std::vector<uint8_t> bodyOf(Encode encode) {
+    uint8_t buf[PAGE_SIZE];
+    Buf b(buf, sizeof(buf));
+    encode(b);
+    return std::vector<uint8_t>(buf, buf + b.len);
+}
+
+// The body a decoded record would have been written from
+static std::vector<uint8_t> reencode(const Record& r) {
+    switch (r.type) {
+        case REC_BOOT:     return bodyOf([&](Buf& b) { encodeBoot(b, r.seed, r.pet); });
+        case REC_BUTTONS:  return bodyOf([&](Buf& b) { b.put(r.buttons); });
+        case REC_WIFI:     return bodyOf([&](Buf& b) { encodeWifi(b, r.wifi); });
+        case REC_COSMANIA: return bodyOf([&](Buf& b) { encodeCosmania(b, r.cosmania); });
+        case REC_RADIO:    return bodyOf([&](Buf& b) { encodeRadio(b, r.radio); });
+        case REC_NFC:      return bodyOf([&](Buf& b) { encodeNfc(b, r.tap, r.uid, r.uidLen); });
+        case REC_RESET:    return bodyOf([&](Buf& b) { b.put(r.fullReset ? 1 : 0); });
+        case REC_PET:
+        case REC_CHECK:    return bodyOf([&](Buf& b) { encodePet(b, r.pet); });
+        case REC_CATCHUP:  return bodyOf([&](Buf& b) { b.varint(r.elapsedMs); });
+        default:           return {};
+    }
+}
+
+static std::vector<Expected> decodeAll(const std::vector<uint8_t>& image, size_t* badPages) {
+    std::vector<Expected> got;
+    RecordStream stream(image);
+    Record r;
+    while (stream.next(r)) {
+        if (r.type == REC_TICK || r.type == REC_TICKS) {
+            for (int i = 0; i < r.tickCount; i++) got.push_back({ REC_TICK, r.tickMs[i], {} });
+        } else {
+            got.push_back({ r.type, r.timeMs, reencode(r) });
+        }
+    }
+    if (badPages) *badPages = stream.badPages();
+    return got;
+}
+
+static bool same(const Expected& a, const Expected& b) {
+    return a.type == b.type && a.timeMs == b.timeMs && a.body == b.body;
+}
+
+static void roundTrip(const char* image) {
+    printf("\n1. every record type through the Journal API and back\n");
+    remove(image);
+    FlashEmu::attach("journal", image, 0x80000);    // 512 KB: does not wrap here
+    s_recording = true;
+
+    std::vector<Expected> want;
+    unsigned long now = 1234;
+    PetState boot = randomPet();
+    Journal::init(0xC0FFEE, boot, now);
+    want.push_back({ REC_BOOT, uint32_t(now), bodyOf([&](Buf& b) { encodeBoot(b, 0xC0FFEE, boot); }) });
+
+    std::vector<uint8_t> lastRadio;
+    uint32_t kinds = 0;
+    for (int op = 0; op < 40000; op++) {
+        // Mostly 10 Hz ticks a few ms late; sometimes a long or early gap
+        now += chance(20) ? 16 + rnd(20000) : 100 + rnd(16);
+        switch (rnd(24)) {
+            case 0: {
+                uint8_t mask = static_cast<uint8_t>(1 + rnd(255));
+                Journal::buttons(now, mask);
+                want.push_back({ REC_BUTTONS, uint32_t(now), bodyOf([&](Buf& b) { b.put(mask); }) });
+                break;
+            }
+            case 1: {
+                WifiStats w = randomWifi();
+                Journal::wifiScan(now, w);
+                want.push_back({ REC_WIFI, uint32_t(now), bodyOf([&](Buf& b) { encodeWifi(b, w); }) });
+                break;
+            }
+            case 2: {
+                CosmaniaStatus c = randomCosmania();
+                Journal::cosmania(now, c);
+                Journal::cosmania(now, c);      // same version: dropped
+                want.push_back({ REC_COSMANIA, uint32_t(now), bodyOf([&](Buf& b) { encodeCosmania(b, c); }) });
+                break;
+            }
+            case 3: {
+                // Small ranges so repeats happen: only changes are kept
+                RadioEnvironment r;
+                r.bleDeviceCount = rnd(3);
+                r.threatCount    = rnd(2);
+                Journal::radio(now, r);
+                std::vector<uint8_t> body = bodyOf([&](Buf& b) { encodeRadio(b, r); });
+                if (body != lastRadio) want.push_back({ REC_RADIO, uint32_t(now), body });
+                lastRadio = body;
+                break;
+            }
+            case 4: {
+                uint8_t uid[7];
+                uint8_t uidLen = static_cast<uint8_t>(4 + rnd(4));
+                for (auto& u : uid) u = static_cast<uint8_t>(rnd(256));
+                uint8_t tap = static_cast<uint8_t>(rnd(4));
+                Journal::nfcTap(now, tap, uid, uidLen);
+                want.push_back({ REC_NFC, uint32_t(now), bodyOf([&](Buf& b) { encodeNfc(b, tap, uid, uidLen); }) });
+                break;
+            }
+            case 5: {
+                bool full = chance(500);
+                Journal::petReset(now, full);
+                want.push_back({ REC_RESET, uint32_t(now), bodyOf([&](Buf& b) { b.put(full ? 1 : 0); }) });
+                break;
+            }
+            case 6: {
+                PetState p = randomPet();
+                Journal::petSnapshot(now, p);
+                want.push_back({ REC_PET, uint32_t(now), bodyOf([&](Buf& b) { encodePet(b, p); }) });
+                break;
+            }
+            case 7: {
+                PetState p = randomPet();
+                Journal::checkpoint(now, p);
+                want.push_back({ REC_CHECK, uint32_t(now), bodyOf([&](Buf& b) { encodePet(b, p); }) });
+                break;
+            }
+            case 8: {
+                uint32_t elapsed = rnd(1u << 30);
+                Journal::catchUp(now, elapsed);
+                want.push_back({ REC_CATCHUP, uint32_t(now), bodyOf([&](Buf& b) { b.varint(elapsed); }) });
+                break;
+            }
+            default:
+                Journal::logicTick(now);
+                want.push_back({ REC_TICK, uint32_t(now), {} });
+                break;
+        }
+        Journal::tick(now);
+    }
+    Journal::flush();
+    for (const Expected& e : want) kinds |= 1u << e.type;
+
+    std::vector<uint8_t> img = FlashEmu::snapshot();
+    FlashEmu::detach();
+    s_recording = false;
+
+    size_t bad = 0;
+    std::vector<Expected> got = decodeAll(img, &bad);
+    size_t firstDiff = 0;
+    while (firstDiff < want.size() && firstDiff < got.size() && same(want[firstDiff], got[firstDiff]))
+        firstDiff++;
+    printf("  %zu records in, %zu out, %zu pages\n", want.size(), got.size(),
+           RecordStream(img).pageCount());
+    if (firstDiff < want.size()) printf("  first difference at record %zu\n", firstDiff);
+    check(kinds == ((1u << (REC_CATCHUP + 1)) - 2 - (1u << REC_TICKS)), "every record type written");
+    check(bad == 0 && firstDiff == want.size() && got.size() == want.size(),
+          "same records, times and bodies, in order");
+
+    // One corrupt byte in page 3: that page is dropped, the rest decode
+    RecordStream clean(img);
+    size_t pages = clean.pageCount();
+    std::vector<uint8_t> torn = img;
+    torn[3 * PAGE_SIZE + PAGE_HEADER + 17] ^= 0x40;
+    RecordStream hurt(torn);
+    size_t tornBad = 0;
+    std::vector<Expected> rest = decodeAll(torn, &tornBad);
+    size_t kept = 0;
+    for (size_t i = 0, j = 0; i < rest.size(); i++) {
+        while (j < want.size() && !same(rest[i], want[j])) j++;
+        if (j < want.size()) { kept++; j++; }
+    }
+    check(tornBad == 1 && hurt.pageCount() == pages - 1, "corrupt page rejected by its CRC");
+    check(kept == rest.size() && rest.size() + 64 > want.size() && rest.size() < want.size(),
+          "records of every other page intact");
+}
+
+// -- 2. Boots, wrap, replay ------------------------------------------------
+// The dump as tools/replay/ would get it after a boot: the Journal is
+// re-opened on a detached partition so the replay's own scans record nothing
+static ReplaySummary replayRing(const char* image, uint32_t ringSize, uint32_t& maxSeq) {
+    std::vector<uint8_t> img = FlashEmu::snapshot();
+    FlashEmu::detach();
+    s_recording = false;
+    Journal::init(0, PetState(), 0);
+
+    for (size_t off = 0; off + PAGE_SIZE <= img.size(); off += PAGE_SIZE) {
+        PageHeader h;
+        if (readPageHeader(&img[off], h) && h.seq > maxSeq) maxSeq = h.seq;
+    }
+    ReplaySummary sum = replayImage(img, false, false);
+
+    FlashEmu::attach("journal", image, ringSize);
+    s_recording = true;
+    return sum;
+}
+
+static void boots(const char* image) {
+    static constexpr int BOOTS = 25;
+    static constexpr uint32_t RING_SIZE = 32 * 4096;
+    printf("\n2. %d boots on a %u KB ring, replayed after each\n", BOOTS, RING_SIZE / 1024);
+    remove(image);
+    FlashEmu::attach("journal", image, RING_SIZE);
+    s_recording = true;
+
+    Sim dev;
+    PetState saved;                 // what Storage would load at boot
+    saved.hatched = true;
+    uint32_t written = 0, cuts = 0, catchUps = 0, maxSeq = 0;
+    uint32_t replayed = 0, mismatches = 0, badPages = 0, uncovered = 0;
+    unsigned long minutes = 0;
+
+    for (int boot = 0; boot < BOOTS; boot++) {
+        dev.reset(saved);
+        s_scanArmed = false;
+        s_nowMs = 300 + rnd(3000);
+        uint32_t seed = 0x9E3779B9u * (boot + 1) + rnd(1u << 16);
+        PetLogic::seed(seed);
+        PetLogic::init(dev.ctx, s_nowMs);
+        Journal::init(seed, dev.pet, s_nowMs);
+        if (boot > 0 && chance(600)) {
+            uint32_t elapsed = 60000 * (10 + rnd(480));
+            Journal::catchUp(s_nowMs, elapsed);
+            PetLogic::catchUp(dev.ctx, elapsed, s_nowMs);
+            catchUps++;
+        }
+
+        unsigned long end = s_nowMs + 60000ul * (10 + rnd(31));
+        minutes += (end - s_nowMs) / 60000;
+        unsigned long lastSave = s_nowMs;
+        while (s_nowMs < end) {
+            // A tick every 100 ms, a few ms late; now and then a long frame
+            s_nowMs += chance(5) ? 200 + rnd(3000) : LOGIC_TICK_MS + rnd(16);
+
+            if (chance(20)) Journal::buttons(s_nowMs, static_cast<uint8_t>(1 + rnd(255)));
+            if (chance(10)) dev.radio = randomRadio();
+            Journal::radio(s_nowMs, dev.radio);
+            if (chance(4)) dev.cosmania = randomCosmania();
+            Journal::cosmania(s_nowMs, dev.cosmania);
+            if (chance(2)) {
+                uint8_t uid[4] = { 1, 2, 3, static_cast<uint8_t>(rnd(256)) };
+                Journal::nfcTap(s_nowMs, 1, uid, sizeof(uid));
+            }
+            if (rnd(20000) == 0) {
+                bool full = chance(300);
+                Journal::petReset(s_nowMs, full);
+                PetLogic::resetPet(dev.ctx, full, s_nowMs);
+            }
+            if (rnd(20000) == 0) {
+                dev.pet.hunger = static_cast<int>(rnd(101));
+                Journal::petSnapshot(s_nowMs, dev.pet);
+            }
+
+            Journal::logicTick(s_nowMs);
+            PetLogic::tick(dev.ctx, s_nowMs);
+
+            if (s_nowMs - lastSave >= 30000) {
+                Journal::checkpoint(s_nowMs, dev.pet);
+                saved = dev.pet;
+                lastSave = s_nowMs;
+                written++;
+            }
+            Journal::tick(s_nowMs);
+        }
+
+        // A clean shutdown writes the partial page; a power cut loses it
+        if (chance(250)) cuts++;
+        else Journal::flush();
+
+        ReplaySummary sum = replayRing(image, RING_SIZE, maxSeq);
+        replayed   += sum.checks;
+        mismatches += sum.mismatches;
+        badPages   += sum.badPages;
+        uncovered  += sum.segments == 0 || sum.checks == 0;
+    }
+    FlashEmu::detach();
+
+    printf("  %lu min recorded, %u checkpoints, %u catch-ups, %u power cuts\n", minutes,
+           written, catchUps, cuts);
+    printf("  %u pages written into %u slots\n", maxSeq, unsigned(RING_SIZE / PAGE_SIZE));
+    printf("  %u checkpoints replayed, %u mismatches\n", replayed, mismatches);
+    check(maxSeq > 2 * (RING_SIZE / PAGE_SIZE), "ring wrapped more than twice");
+    check(badPages == 0, "no corrupt pages");
+    check(uncovered == 0, "every boot's segment replayed from its BOOT");
+    check(replayed >= written, "checkpoints replayed >= checkpoints written");
+    check(mismatches == 0, "every checkpoint matches the replayed pet");
+}
+
+int main(int argc, char** argv) {
+    const char* image = argc > 1 ? argv[1] : "/tmp/journal.bin";
+    s_rng = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1;
+    if (s_rng == 0) s_rng = 1;
+    roundTrip(image);
+    boots(image);
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
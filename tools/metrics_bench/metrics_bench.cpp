@@ -0,0 +1,484 @@
+// ==========================================================================
+// metrics_bench -- Host benchmark + checks for Metrics and MetricsServer
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -pthread -DFEATURE_METRICS=1 -Iinclude -Isrc
+//       -o metrics_bench tools/metrics_bench/metrics_bench.cpp
+//       src/sys/metrics.cpp src/net/metrics_server.cpp
+//
+// Usage:
+//   metrics_bench
+//
+//   1. update cost: inc / set / observe, alone and from four threads at
+//      once, and that contended increments all land
+//   2. exposition: the text is the same whatever buffer render() gets,
+//      and is well-formed (one HELP/TYPE per family, cumulative buckets,
+//      +Inf == _count)
+//   3. scrapes over loopback while a stand-in render loop runs 60 fps
+//      frames and other threads update metrics: every scrape parses,
+//      poll() stays cheap (thread CPU time, so the scrapers sharing the
+//      core don't count), and frame pacing matches a run without scrapes
+//   4. 404 / 405, a client that never sends, more clients than slots,
+//      and a scraper that reads slowly
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "sys/metrics.h"
+#include "net/metrics_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static uint32_t nowMs() { return static_cast<uint32_t>(nowUs() / 1000); }
+
+// CPU time of the calling thread: what poll() itself costs the loop, not
+// time spent preempted by the scraper threads
+static double threadUs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double percentile(std::vector<double> v, double pct) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = static_cast<size_t>(pct / 100.0 * (v.size() - 1) + 0.5);
+    return v[i];
+}
+
+// -- Exposition parsing ----------------------------------------------------
+
+static std::string renderAll(size_t cap) {
+    std::string text;
+    std::vector<char> buf(cap);
+    Metrics::Cursor cursor;
+    while (!cursor.done()) {
+        size_t n = Metrics::render(cursor, buf.data(), cap);
+        if (n == 0) return "<stuck>";
+        text.append(buf.data(), n);
+    }
+    return text;
+}
+
+// Sample name (with labels) -> value; false if anything is malformed
+static bool parseText(const std::string& text, std::map<std::string, double>& samples) {
+    std::map<std::string, int> helps, types;
+    std::map<std::string, std::string> kinds;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) return false;     // unterminated line
+        std::string line = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        char name[128], kind[32];
+        if (line.compare(0, 7, "# HELP ") == 0) {
+            if (sscanf(line.c_str(), "# HELP %127s", name) != 1) return false;
+            if (++helps[name] > 1) return false;
+            continue;
+        }
+        if (line.compare(0, 7, "# TYPE ") == 0) {
+            if (sscanf(line.c_str(), "# TYPE %127s %31s", name, kind) != 2) return false;
+            if (++types[name] > 1) return false;
+            kinds[name] = kind;
+            continue;
+        }
+        size_t space = line.rfind(' ');
+        if (space == std::string::npos || line[0] == '#') return false;
+        std::string key = line.substr(0, space);
+        char* tail;
+        double v = strtod(line.c_str() + space + 1, &tail);
+        if (*tail != '\0') return false;
+        if (samples.count(key)) return false;
+        samples[key] = v;
+
+        // The family must have been typed already
+        std::string family = key.substr(0, key.find('{'));
+        for (const char* suffix : {"_bucket", "_sum", "_count"}) {
+            size_t n = strlen(suffix);
+            if (family.size() > n && family.compare(family.size() - n, n, suffix) == 0 &&
+                kinds.count(family.substr(0, family.size() - n))) {
+                family = family.substr(0, family.size() - n);
+                break;
+            }
+        }
+        if (!kinds.count(family)) return false;
+    }
+    return true;
+}
+
+// Buckets of a histogram rise and end at _count
+static bool histogramSane(const std::map<std::string, double>& samples, const std::string& name) {
+    double prev = -1, inf = -1;
+    int buckets = 0;
+    for (const auto& kv : samples) {
+        if (kv.first.compare(0, name.size() + 8, name + "_bucket{") != 0) continue;
+        buckets++;
+        if (kv.first.find("+Inf") != std::string::npos) inf = kv.second;
+    }
+    // Map order isn't `le` order: walk the buckets by bound
+    std::vector<std::pair<double, double>> ordered;
+    for (const auto& kv : samples) {
+        if (kv.first.compare(0, name.size() + 8, name + "_bucket{") != 0) continue;
+        if (kv.first.find("+Inf") != std::string::npos) continue;
+        double le = strtod(kv.first.c_str() + name.size() + 12, nullptr);
+        ordered.push_back({le, kv.second});
+    }
+    std::sort(ordered.begin(), ordered.end());
+    for (const auto& b : ordered) {
+        if (b.second < prev) return false;
+        prev = b.second;
+    }
+    auto count = samples.find(name + "_count");
+    return buckets > 1 && inf >= prev && count != samples.end() && count->second == inf &&
+           samples.count(name + "_sum");
+}
+
+// -- Loopback client -------------------------------------------------------
+
+static int connectTo(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    timeval tv = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Sends `request`, reads to EOF; status 0 if there was no response
+struct Reply {
+    int status = 0;
+    std::string body;
+};
+
+static Reply fetch(uint16_t port, const char* request, int readDelayUs = 0) {
+    Reply r;
+    int fd = connectTo(port);
+    if (fd < 0) return r;
+    if (readDelayUs) {
+        int small = 256;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    }
+    send(fd, request, strlen(request), MSG_NOSIGNAL);
+    std::string raw;
+    char buf[readDelayUs ? 64 : 4096];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        raw.append(buf, n);
+        if (readDelayUs) std::this_thread::sleep_for(std::chrono::microseconds(readDelayUs));
+    }
+    ::close(fd);
+    if (sscanf(raw.c_str(), "HTTP/1.1 %d", &r.status) != 1) r.status = 0;
+    size_t split = raw.find("\r\n\r\n");
+    if (split != std::string::npos) r.body = raw.substr(split + 4);
+    return r;
+}
+
+static const char SCRAPE[] =
+    "GET /metrics HTTP/1.1\r\nHost: tamafi\r\nAccept: text/plain\r\n"
+    "User-Agent: Prometheus/2.51\r\n\r\n";
+
+// Polls the server (the device's loop) until the client thread is done
+template <typename Fn>
+static void withServer(MetricsServer& server, Fn client) {
+    std::atomic<bool> done(false);
+    std::thread t([&] {
+        client();
+        done = true;
+    });
+    while (!done) {
+        server.poll(nowMs());
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    t.join();
+}
+
+// -- 1. Updates ------------------------------------------------------------
+
+static void updates() {
+    printf("\n1. update cost\n");
+    Metrics::reset();
+    const int N = 10000000;
+
+    double t0 = nowUs();
+    for (int i = 0; i < N; i++) Metrics::inc(Metrics::WIFI_SCANS);
+    double incNs = (nowUs() - t0) * 1000 / N;
+    t0 = nowUs();
+    for (int i = 0; i < N; i++) Metrics::set(Metrics::PET_HUNGER, i & 127);
+    double setNs = (nowUs() - t0) * 1000 / N;
+    t0 = nowUs();
+    for (int i = 0; i < N; i++) Metrics::observe(Metrics::LOOP_SECONDS, (i * 2654435761u) % 300000);
+    double obsNs = (nowUs() - t0) * 1000 / N;
+    printf("  inc %.1f ns, set %.1f ns, observe %.1f ns (one thread)\n", incNs, setNs, obsNs);
+
+    Metrics::reset();
+    const int THREADS = 4, PER = 2000000;
+    t0 = nowUs();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < PER; i++) {
+                Metrics::inc(Metrics::COSMANIA_POLLS);
+                Metrics::observe(Metrics::COSMANIA_POLL_SECONDS, (i + t) % 6000);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    double contendedNs = (nowUs() - t0) * 1000 / PER;
+    printf("  inc + observe from %d threads: %.1f ns per pair per thread\n", THREADS, contendedNs);
+    check(Metrics::value(Metrics::COSMANIA_POLLS) == uint32_t(THREADS * PER),
+          "contended increments all counted");
+    check(Metrics::count(Metrics::COSMANIA_POLL_SECONDS) == uint32_t(THREADS * PER),
+          "contended observations all counted");
+}
+
+// -- 2. Exposition -----------------------------------------------------------
+
+static void exposition() {
+    printf("\n2. exposition\n");
+    Metrics::reset();
+    Metrics::inc(Metrics::COSMANIA_ERRORS_HTTP, 3);
+    Metrics::set(Metrics::WIFI_NETWORKS, 17);
+    Metrics::set(Metrics::HEAP_FREE_BYTES, 183412);
+    Metrics::set(Metrics::SAFETY_SCORE, -1);
+    for (uint32_t us : {300u, 800u, 800u, 16000u, 400000u}) Metrics::observe(Metrics::LOOP_SECONDS, us);
+
+    std::string big = renderAll(8192);
+    std::string tight = renderAll(Metrics::LINE_MAX);
+    double t0 = nowUs();
+    const int REPS = 2000;
+    for (int i = 0; i < REPS; i++) renderAll(512);
+    double renderUs = (nowUs() - t0) / REPS;
+    printf("  %zu bytes, %.1f us to render in 512 B pieces\n", big.size(), renderUs);
+    check(big == tight, "same text whatever the buffer");
+
+    std::map<std::string, double> samples;
+    bool ok = parseText(big, samples);
+    check(ok, "well-formed exposition text");
+    check(samples["tamafi_cosmania_errors_total{kind=\"http\"}"] == 3 &&
+          samples.count("tamafi_cosmania_errors_total{kind=\"parse\"}"),
+          "labelled counters under one family");
+    check(samples["tamafi_wifi_networks"] == 17 && samples["tamafi_safety_score"] == -1,
+          "gauges, negative included");
+    check(histogramSane(samples, "tamafi_loop_seconds") &&
+          samples["tamafi_loop_seconds_count"] == 5 &&
+          samples["tamafi_loop_seconds_bucket{le=\"0.001\"}"] == 3 &&
+          samples["tamafi_loop_seconds_sum"] > 0.41789 && samples["tamafi_loop_seconds_sum"] < 0.41791,
+          "histogram buckets, sum and count");
+    check(big.find("# HELP tamafi_cosmania_errors_total") != std::string::npos &&
+          big.find("# TYPE tamafi_cosmania_errors_total counter") != std::string::npos,
+          "HELP / TYPE printed for the family");
+
+    // Observations landing mid-render: buckets still add up
+    Metrics::Cursor cursor;
+    std::vector<char> buf(Metrics::LINE_MAX);
+    std::string text;
+    uint32_t k = 0;
+    while (!cursor.done()) {
+        text.append(buf.data(), Metrics::render(cursor, buf.data(), buf.size()));
+        for (int i = 0; i < 50; i++) Metrics::observe(Metrics::LOOP_SECONDS, (k++ * 7919) % 300000);
+    }
+    samples.clear();
+    check(parseText(text, samples) && histogramSane(samples, "tamafi_loop_seconds"),
+          "histogram consistent under concurrent updates");
+}
+
+// -- 3. Scrapes during a render loop ---------------------------------------
+
+struct LoopRun {
+    std::vector<double> frameUs;    // frame-to-frame
+    std::vector<double> pollUs;     // server.poll()
+    int scrapes = 0;
+    int good    = 0;
+};
+
+// 60 fps frames of ~4 ms busy work, the server polled once per frame
+static LoopRun renderLoop(MetricsServer& server, int frames, int scrapers) {
+    LoopRun run;
+    std::atomic<bool> stop(false);
+    std::atomic<int> scrapes(0), good(0), finished(0);
+    std::vector<std::thread> threads;
+    for (int s = 0; s < scrapers; s++) {
+        threads.emplace_back([&] {
+            while (!stop) {
+                Reply r = fetch(server.port(), SCRAPE);
+                std::map<std::string, double> samples;
+                scrapes++;
+                if (r.status == 200 && parseText(r.body, samples) &&
+                    histogramSane(samples, "tamafi_loop_seconds")) {
+                    good++;
+                }
+            }
+            finished++;
+        });
+    }
+    // Another task bumping counters the whole time
+    threads.emplace_back([&] {
+        uint32_t i = 0;
+        while (!stop) {
+            Metrics::inc(Metrics::WIFI_SCANS);
+            Metrics::observe(Metrics::COSMANIA_POLL_SECONDS, i++ % 6000);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        finished++;
+    });
+
+    double frameStart = nowUs(), prevFrame = 0;
+    for (int f = 0; f < frames; f++) {
+        double t0 = nowUs();
+        double cpu0 = threadUs();
+        server.poll(nowMs());
+        run.pollUs.push_back(threadUs() - cpu0);
+
+        while (nowUs() - t0 < 4000) {}                  // logic + render
+        Metrics::observe(Metrics::LOOP_SECONDS, static_cast<uint32_t>(nowUs() - t0));
+        double next = frameStart + (f + 1) * 16667.0;   // vsync-ish pacing
+        while (nowUs() < next) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        double now = nowUs();
+        if (prevFrame) run.frameUs.push_back(now - prevFrame);
+        prevFrame = now;
+    }
+    // Keep serving until the scrapes in flight have finished
+    stop = true;
+    while (finished < scrapers + 1) {
+        server.poll(nowMs());
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    for (auto& t : threads) t.join();
+    run.scrapes = scrapes;
+    run.good    = good;
+    return run;
+}
+
+static void loopback(MetricsServer& server) {
+    printf("\n3. scrapes during a 60 fps loop\n");
+    Metrics::reset();
+    const int FRAMES = 300;
+
+    LoopRun quiet = renderLoop(server, FRAMES, 0);
+    LoopRun busy  = renderLoop(server, FRAMES, 2);
+
+    printf("  quiet: frame p50 %.0f p95 %.0f p99 %.0f max %.0f us, poll max %.1f us\n",
+           percentile(quiet.frameUs, 50), percentile(quiet.frameUs, 95), percentile(quiet.frameUs, 99),
+           percentile(quiet.frameUs, 100), percentile(quiet.pollUs, 100));
+    printf("  busy:  frame p50 %.0f p95 %.0f p99 %.0f max %.0f us, poll p99 %.1f max %.1f us, "
+           "%d scrapes\n",
+           percentile(busy.frameUs, 50), percentile(busy.frameUs, 95), percentile(busy.frameUs, 99),
+           percentile(busy.frameUs, 100), percentile(busy.pollUs, 99),
+           percentile(busy.pollUs, 100), busy.scrapes);
+
+    check(busy.scrapes >= 20 && busy.good == busy.scrapes, "every scrape well-formed");
+    check(percentile(busy.pollUs, 99) < 500, "poll() p99 under 0.5 ms while scraped");
+    // p95, not p99: on a shared core the host scheduler alone moves p99
+    check(percentile(busy.frameUs, 95) < percentile(quiet.frameUs, 95) + 2000,
+          "frame p95 within 2 ms of the unscraped loop");
+    check(Metrics::value(Metrics::SCRAPES) == server.stats().scrapes, "scrapes counted");
+}
+
+// -- 4. Edge cases -----------------------------------------------------------
+
+static void edges(MetricsServer& server) {
+    printf("\n4. edge cases\n");
+    Reply notFound, notAllowed, withQuery;
+    withServer(server, [&] {
+        notFound   = fetch(server.port(), "GET / HTTP/1.1\r\n\r\n");
+        notAllowed = fetch(server.port(), "POST /metrics HTTP/1.1\r\nContent-Length: 2\r\n\r\n{}");
+        withQuery  = fetch(server.port(), "GET /metrics?name[]=x HTTP/1.0\r\n\r\n");
+    });
+    check(notFound.status == 404 && notAllowed.status == 405, "404 for other paths, 405 for POST");
+    check(withQuery.status == 200 && !withQuery.body.empty(), "query string ignored");
+
+    // Two silent clients fill the slots; a third is turned away
+    uint32_t refused = server.stats().refused, timeouts = server.stats().timeouts;
+    int a = connectTo(server.port()), b = connectTo(server.port());
+    uint32_t t = nowMs();
+    for (int i = 0; i < 20; i++) {
+        server.poll(t);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    Reply third;
+    withServer(server, [&] { third = fetch(server.port(), SCRAPE); });
+    check(third.status == 0 && server.stats().refused == refused + 1,
+          "client past the slots is closed");
+    server.poll(t + MetricsServer::CLIENT_TIMEOUT_MS + 1);
+    check(server.active() == 0 && server.stats().timeouts == timeouts + 2,
+          "silent clients dropped after the timeout");
+    ::close(a);
+    ::close(b);
+
+    // A scraper reading 64 B at a time through a tiny window
+    Reply slow;
+    std::vector<double> pollUs;
+    std::atomic<bool> done(false);
+    std::thread reader([&] {
+        slow = fetch(server.port(), SCRAPE, 200);
+        done = true;
+    });
+    while (!done) {
+        double cpu0 = threadUs();
+        server.poll(nowMs());
+        pollUs.push_back(threadUs() - cpu0);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    reader.join();
+    std::map<std::string, double> samples;
+    printf("  slow reader: %zu polls, max %.1f us\n", pollUs.size(), percentile(pollUs, 100));
+    check(slow.status == 200 && parseText(slow.body, samples), "slow reader gets it all");
+    check(percentile(pollUs, 99) < 500, "slow reader never blocks poll()");
+}
+
+int main() {
+    updates();
+    exposition();
+
+    MetricsServer server;
+    bool up = server.begin(0);
+    check(up, "listening on loopback");
+    if (up) {
+        printf("  port %u\n", server.port());
+        loopback(server);
+        edges(server);
+    }
+
+    const MetricsServer::Stats& st = server.stats();
+    printf("\n%lu accepted, %lu scrapes, %lu complete, %lu bytes\n",
+           (unsigned long)st.accepted, (unsigned long)st.scrapes, (unsigned long)st.completed,
+           (unsigned long)st.bytes);
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
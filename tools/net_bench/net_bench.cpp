@@ -0,0 +1,1428 @@
+// ==========================================================================
+// net_bench -- Host checks of the Cosmania network path against MockHttp
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -pthread -Itools/host -Iinclude -Isrc -o net_bench
+//       tools/net_bench/net_bench.cpp src/net/http_fetch.cpp src/net/status_parser.cpp
+//       src/net/cosmania_poll.cpp src/net/cosmania_push.cpp src/net/poll_scheduler.cpp
+//       src/sys/journal_codec.cpp tools/host/net_resolve_host.cpp tools/host/mock_http.cpp
+//
+// Runs the real HttpFetch state machine against a scripted local server:
+//   1. fetch scenarios: normal, chunked + dripped, slow headers, stalled
+//      server (timeout), 500, refused, closed mid-body, garbage, HTTP/1.0
+//      read-until-close, body larger than the sink accepts. Each is
+//      driven like loop() does (one poll per 1 ms "frame") and checks
+//      that no poll() call blocks the frame.
+//   2. StatusParser on generated /status payloads of growing size (more
+//      agents, longer recentErrors, unknown nested fields), as JSON and
+//      as the same document in MessagePack: size and parse time of each,
+//      fixed state vs. body size, identical results for any input split,
+//      malformed bodies rejected, a partial agent delta merged field by
+//      field; then the largest one end to end through HttpFetch.
+//   3. CosmaniaPoll against a stub Cosmania whose status changes now and
+//      then: the same change script polled plain, with ETag, and with
+//      ETag + ?since= deltas, then deltas in MessagePack. Bytes served
+//      are counted by the server; the published status must equal the
+//      server's after every poll. Then recovery: an unknown cursor and an
+//      error both fall back to a full fetch, against a server that only
+//      speaks JSON.
+//   4. PollScheduler over eight simulated hours per usage scenario (zone,
+//      tier, screen, battery, how often Cosmania changes, outages):
+//      polls, radio duty cycle and how stale the status gets, next to
+//      the fixed 30 s poll it replaces; backoff spread across devices.
+//   5. Keep-alive: the same polls with Connection: close, on one kept
+//      connection, against a server that closes every 10 requests, and
+//      one that hangs up just as a kept connection is reused. Counts
+//      connections, reuses, retries, DNS lookups and per-poll latency.
+//   6. Push: CosmaniaPush on a stand-in SSE /events stream, with polling
+//      as the fallback the way CosmaniaClient runs it. Change-to-screen
+//      latency while live; the stream dropped, stalled and sent a broken
+//      event, each falling back to polls and resuming with Last-Event-ID.
+//   7. Warm start: a polled status through the cache encoding and back
+//      into a fresh CosmaniaPoll as a stale snapshot. Time until the
+//      dashboard has agents to draw from the cache vs. from a first
+//      poll; a failed poll leaves the snapshot be, a good one clears
+//      stale; malformed cache bodies are rejected.
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "net/cosmania_poll.h"
+#include "net/cosmania_push.h"
+#include "net/http_fetch.h"
+#include "net/poll_scheduler.h"
+#include "net/status_parser.h"
+#include "sys/journal_codec.h"
+#include "mock_http.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static constexpr double FRAME_BUDGET_US = 2000;    // worst poll() allowed
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t nowMs() { return static_cast<uint32_t>(nowUs() / 1000); }
+
+static const std::string STATUS_BODY =
+    "{\"budgetTier\":\"YELLOW\",\"totalDailyBudget\":20.0,\"totalDailySpend\":13.4,"
+    "\"agents\":[{\"name\":\"scout\",\"overdue\":false,\"overBudget\":false,"
+    "\"todayCostUsd\":1.25,\"todayRuns\":4,\"minutesSinceLastRun\":12},"
+    "{\"name\":\"scribe\",\"overdue\":true,\"overBudget\":false,"
+    "\"todayCostUsd\":0.0,\"todayRuns\":0,\"minutesSinceLastRun\":1440}],"
+    "\"recentErrors\":[{\"agent\":\"scribe\",\"message\":\"timeout\"}]}";
+
+// -- Fetch driver ----------------------------------------------------------
+struct Sink {
+    std::string body;
+    size_t cap = 1 << 20;
+};
+
+static bool sinkAppend(void* ctx, const uint8_t* data, size_t len) {
+    Sink* s = static_cast<Sink*>(ctx);
+    if (s->body.size() + len > s->cap) return false;
+    s->body.append(reinterpret_cast<const char*>(data), len);
+    return true;
+}
+
+struct Outcome {
+    HttpFetch::State state;
+    HttpFetch::Error error;
+    int      status;
+    uint32_t ms;
+    int      polls;
+    double   worstPollUs;
+    std::string body;
+};
+
+// Polls once per 1 ms frame, as loop() would
+static Outcome run(const std::string& url, uint32_t timeoutMs, size_t sinkCap = 1 << 20) {
+    HttpFetch fetch;
+    Sink sink;
+    sink.cap = sinkCap;
+    Outcome o = {};
+    fetch.setUrl(url.c_str());
+    fetch.setTimeout(timeoutMs);
+
+    uint32_t t0 = nowMs();
+    fetch.start(t0, sinkAppend, &sink);
+    while (fetch.busy()) {
+        double p0 = nowUs();
+        fetch.poll(nowMs());
+        double us = nowUs() - p0;
+        if (us > o.worstPollUs) o.worstPollUs = us;
+        o.polls++;
+        usleep(1000);
+    }
+    o.state  = fetch.state();
+    o.error  = fetch.error();
+    o.status = fetch.status();
+    o.ms     = nowMs() - t0;
+    o.body   = sink.body;
+    return o;
+}
+
+static void report(const char* name, const Outcome& o) {
+    printf("  %-22s %-6s %-8s %3d %6lu ms %5d polls, worst %6.0f us\n", name,
+           o.state == HttpFetch::DONE ? "done" : "failed", HttpFetch::errorName(o.error),
+           o.status, (unsigned long)o.ms, o.polls, o.worstPollUs);
+}
+
+// A port nothing listens on
+static uint16_t closedPort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// -- 1. Fetch scenarios ----------------------------------------------------
+static void scenarios() {
+    printf("fetch scenarios\n");
+    MockHttp server;
+    server.start([](MockHttp::Conn& c, const MockHttp::Request& req) {
+        const std::string& p = req.path;
+        if (p == "/ok") {
+            c.write(MockHttp::response(200, STATUS_BODY));
+        } else if (p == "/chunked") {
+            c.drip(MockHttp::chunkedResponse(STATUS_BODY, 7), 40, 10);
+        } else if (p == "/slow") {
+            c.sleepMs(1500);
+            c.write(MockHttp::response(200, STATUS_BODY));
+        } else if (p == "/stall") {
+            c.sleepMs(3000);
+        } else if (p == "/error") {
+            c.write(MockHttp::response(500, "{\"error\":\"boom\"}"));
+        } else if (p == "/truncated") {
+            std::string r = MockHttp::response(200, STATUS_BODY);
+            c.write(r.substr(0, r.size() - 100));
+        } else if (p == "/garbage") {
+            c.write("SSH-2.0-OpenSSH_9.6\r\n\r\n");
+        } else if (p == "/http10") {
+            c.write("HTTP/1.0 200 OK\r\nContent-Type: application/json\r\n\r\n" + STATUS_BODY);
+        } else {
+            c.write(MockHttp::response(404, ""));
+        }
+        return false;
+    });
+
+    struct Case {
+        const char* name;
+        std::string url;
+        uint32_t timeoutMs;
+        size_t sinkCap;
+        HttpFetch::State state;
+        HttpFetch::Error error;
+        int status;
+        bool wantBody;
+    };
+    std::string refused = "http://127.0.0.1:" + std::to_string(closedPort()) + "/status";
+    const Case cases[] = {
+        { "ok",              server.url("/ok"),        5000, 1 << 20, HttpFetch::DONE,   HttpFetch::ERR_NONE,     200, true  },
+        { "chunked dripped", server.url("/chunked"),   5000, 1 << 20, HttpFetch::DONE,   HttpFetch::ERR_NONE,     200, true  },
+        { "slow headers",    server.url("/slow"),      5000, 1 << 20, HttpFetch::DONE,   HttpFetch::ERR_NONE,     200, true  },
+        { "stalled",         server.url("/stall"),     1000, 1 << 20, HttpFetch::FAILED, HttpFetch::ERR_TIMEOUT,  0,   false },
+        { "500",             server.url("/error"),     5000, 1 << 20, HttpFetch::DONE,   HttpFetch::ERR_NONE,     500, false },
+        { "refused",         refused,                  5000, 1 << 20, HttpFetch::FAILED, HttpFetch::ERR_CONNECT,  0,   false },
+        { "closed mid-body", server.url("/truncated"), 5000, 1 << 20, HttpFetch::FAILED, HttpFetch::ERR_CLOSED,   200, false },
+        { "garbage",         server.url("/garbage"),   5000, 1 << 20, HttpFetch::FAILED, HttpFetch::ERR_PROTOCOL, 0,   false },
+        { "http/1.0 close",  server.url("/http10"),    5000, 1 << 20, HttpFetch::DONE,   HttpFetch::ERR_NONE,     200, true  },
+        { "sink full",       server.url("/ok"),        5000, 64,      HttpFetch::FAILED, HttpFetch::ERR_SINK,     200, false },
+    };
+
+    double worst = 0;
+    bool allMatch = true;
+    for (const Case& k : cases) {
+        Outcome o = run(k.url, k.timeoutMs, k.sinkCap);
+        report(k.name, o);
+        bool match = o.state == k.state && o.error == k.error && o.status == k.status &&
+                     (!k.wantBody || o.body == STATUS_BODY);
+        if (k.status == 500 && !o.body.empty()) match = false;    // error bodies not sunk
+        if (!match) {
+            printf("    expected %s/%s/%d\n", k.state == HttpFetch::DONE ? "done" : "failed",
+                   HttpFetch::errorName(k.error), k.status);
+            allMatch = false;
+        }
+        if (o.worstPollUs > worst) worst = o.worstPollUs;
+    }
+    Outcome stalled = run(server.url("/stall"), 1000);
+    check(allMatch, "every scenario ends in the expected state");
+    check(stalled.ms >= 1000 && stalled.ms < 1100, "stalled server times out on schedule");
+    check(stalled.polls > 500, "loop kept running while the server stalled");
+    check(worst < FRAME_BUDGET_US, "no poll() blocks the frame");
+    server.stop();
+}
+
+// -- 2. Streaming parse ----------------------------------------------------
+
+// A /status body with `agents` agents and `errors` recentErrors, plus the
+// CosmaniaStatus it should parse to. Extra fields the device ignores are
+// sprinkled in (nested objects, arrays, escapes, exponents, nulls).
+static std::string makeStatus(int agents, int errors, CosmaniaStatus& want) {
+    static const char* const TIERS[] = { "GREEN", "YELLOW", "RED", "BLACK" };
+    want = CosmaniaStatus();
+    want.budgetTier       = static_cast<BudgetTier>(agents % 4);
+    want.totalDailyBudget = 25.0f;
+    want.totalDailySpend  = 0.5f * agents;
+
+    char buf[256];
+    std::string out = "{\"version\":\"2.3.1\",\"budgetTier\":\"";
+    out += TIERS[agents % 4];
+    snprintf(buf, sizeof(buf), "\",\"totalDailyBudget\":2.5e1,\"totalDailySpend\":%g,"
+             "\"meta\":{\"host\":\"cosmania\",\"tags\":[\"a\",{\"b\":[1,2,{}]}]},\"agents\":[",
+             want.totalDailySpend);
+    out += buf;
+    for (int i = 0; i < agents; i++) {
+        AgentInfo a;
+        snprintf(a.name, sizeof(a.name), "agent-%03d", i % 1000);
+        a.overdue      = i % 5 == 1;
+        a.overBudget   = i % 7 == 3;
+        a.todayCostUsd = 0.25f * (i % 9);
+        a.todayRuns    = i % 3;
+        a.minutesSince = i % 4 == 0 ? -1 : i * 7;
+        if (i < 7) {
+            want.agents[i] = a;
+            want.agentCount++;
+            if (a.overdue) want.overdueCount++;
+            if (a.todayRuns > 0) want.activeCount++;
+        }
+        char minutes[16];
+        if (a.minutesSince < 0) snprintf(minutes, sizeof(minutes), "null");
+        else                    snprintf(minutes, sizeof(minutes), "%d", a.minutesSince);
+        // Name written with a \u escape for the dash
+        snprintf(buf, sizeof(buf),
+                 "%s{\"name\":\"agent\\u002d%03d\",\"schedule\":{\"cron\":\"*/5 * * * *\","
+                 "\"next\":[1700000000,1700000300]},\"overdue\":%s,\"overBudget\":%s,"
+                 "\"todayCostUsd\":%g,\"todayRuns\":%d,\"minutesSinceLastRun\":%s,"
+                 "\"notes\":\"line\\n\\\"quoted\\\"\"}",
+                 i ? "," : "", i, a.overdue ? "true" : "false", a.overBudget ? "true" : "false",
+                 a.todayCostUsd, a.todayRuns, minutes);
+        out += buf;
+    }
+    out += "],\"recentErrors\":[";
+    for (int i = 0; i < errors; i++) {
+        snprintf(buf, sizeof(buf),
+                 "%s{\"agent\":\"agent-%03d\",\"at\":%d,\"message\":\"upstream timeout after 30s\","
+                 "\"context\":{\"attempt\":%d,\"codes\":[502,504]}}",
+                 i ? "," : "", i % (agents ? agents : 1), 1700000000 + i, i % 3);
+        out += buf;
+    }
+    out += "]}";
+    want.errorCount = errors > 255 ? 255 : errors;
+    return out;
+}
+
+static bool sameStatus(const CosmaniaStatus& a, const CosmaniaStatus& b) {
+    if (a.budgetTier != b.budgetTier || a.agentCount != b.agentCount ||
+        a.errorCount != b.errorCount || a.overdueCount != b.overdueCount ||
+        a.activeCount != b.activeCount ||
+        fabsf(a.totalDailyBudget - b.totalDailyBudget) > 1e-4f ||
+        fabsf(a.totalDailySpend - b.totalDailySpend) > 1e-4f) {
+        return false;
+    }
+    for (int i = 0; i < a.agentCount; i++) {
+        const AgentInfo& x = a.agents[i];
+        const AgentInfo& y = b.agents[i];
+        if (strcmp(x.name, y.name) != 0 || x.overdue != y.overdue ||
+            x.overBudget != y.overBudget || x.todayRuns != y.todayRuns ||
+            x.minutesSince != y.minutesSince || fabsf(x.todayCostUsd - y.todayCostUsd) > 1e-4f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -- JSON -> MessagePack, as a server's encoder would write the document:
+// smallest integer encodings, float 64 for anything with a fraction
+static void packHeader(std::string& out, size_t n, uint8_t fix, size_t fixMax,
+                       int t8, uint8_t t16, uint8_t t32) {
+    if (n <= fixMax) {
+        out += static_cast<char>(fix | n);
+        return;
+    }
+    int bytes;
+    if (t8 >= 0 && n <= 0xFF) { out += static_cast<char>(t8);  bytes = 1; }
+    else if (n <= 0xFFFF)     { out += static_cast<char>(t16); bytes = 2; }
+    else                      { out += static_cast<char>(t32); bytes = 4; }
+    for (int i = bytes - 1; i >= 0; i--) out += static_cast<char>(n >> (8 * i));
+}
+
+static void packInt(std::string& out, long long v) {
+    uint8_t type;
+    int bytes;
+    if (v >= 0 && v < 128)        { out += static_cast<char>(v); return; }
+    if (v < 0 && v >= -32)        { out += static_cast<char>(v); return; }
+    if (v >= 0) {
+        if (v <= 0xFF)            { type = 0xCC; bytes = 1; }
+        else if (v <= 0xFFFF)     { type = 0xCD; bytes = 2; }
+        else if (v <= 0xFFFFFFFFLL) { type = 0xCE; bytes = 4; }
+        else                      { type = 0xCF; bytes = 8; }
+    } else {
+        if (v >= -128)            { type = 0xD0; bytes = 1; }
+        else if (v >= -32768)     { type = 0xD1; bytes = 2; }
+        else if (v >= INT32_MIN)  { type = 0xD2; bytes = 4; }
+        else                      { type = 0xD3; bytes = 8; }
+    }
+    out += static_cast<char>(type);
+    for (int i = bytes - 1; i >= 0; i--) out += static_cast<char>(static_cast<uint64_t>(v) >> (8 * i));
+}
+
+static void jsonSpace(const char*& p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+}
+
+static std::string jsonString(const char*& p) {
+    std::string s;
+    for (p++; *p && *p != '"'; p++) {
+        if (*p != '\\') {
+            s += *p;
+            continue;
+        }
+        switch (*++p) {
+            case 'b': s += '\b'; break;
+            case 'f': s += '\f'; break;
+            case 'n': s += '\n'; break;
+            case 'r': s += '\r'; break;
+            case 't': s += '\t'; break;
+            case 'u': {
+                unsigned cp = strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+                p += 4;
+                if (cp < 0x80) {
+                    s += static_cast<char>(cp);
+                } else if (cp < 0x800) {
+                    s += static_cast<char>(0xC0 | cp >> 6);
+                    s += static_cast<char>(0x80 | (cp & 0x3F));
+                } else {
+                    s += static_cast<char>(0xE0 | cp >> 12);
+                    s += static_cast<char>(0x80 | (cp >> 6 & 0x3F));
+                    s += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default: s += *p; break;
+        }
+    }
+    p++;
+    return s;
+}
+
+// One value at p (valid JSON assumed: the bench wrote it)
+static void jsonToPack(const char*& p, std::string& out) {
+    jsonSpace(p);
+    if (*p == '{' || *p == '[') {
+        bool object = *p++ == '{';
+        std::string items;
+        size_t n = 0;
+        jsonSpace(p);
+        while (*p != (object ? '}' : ']')) {
+            if (object) {
+                jsonSpace(p);
+                std::string key = jsonString(p);
+                packHeader(items, key.size(), 0xA0, 31, 0xD9, 0xDA, 0xDB);
+                items += key;
+                jsonSpace(p);
+                p++;                                        // ':'
+            }
+            jsonToPack(p, items);
+            n++;
+            jsonSpace(p);
+            if (*p == ',') p++;
+            jsonSpace(p);
+        }
+        p++;
+        if (object) packHeader(out, n, 0x80, 15, -1, 0xDE, 0xDF);
+        else        packHeader(out, n, 0x90, 15, -1, 0xDC, 0xDD);
+        out += items;
+    } else if (*p == '"') {
+        std::string str = jsonString(p);
+        packHeader(out, str.size(), 0xA0, 31, 0xD9, 0xDA, 0xDB);
+        out += str;
+    } else if (strncmp(p, "true", 4) == 0)  { out += '\xC3'; p += 4; }
+    else if (strncmp(p, "false", 5) == 0)   { out += '\xC2'; p += 5; }
+    else if (strncmp(p, "null", 4) == 0)    { out += '\xC0'; p += 4; }
+    else {
+        char* end;
+        double d = strtod(p, &end);
+        bool integral = true;
+        for (const char* q = p; q < end; q++) {
+            if (*q == '.' || *q == 'e' || *q == 'E') integral = false;
+        }
+        p = end;
+        if (integral) {
+            packInt(out, static_cast<long long>(d));
+        } else {
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            out += '\xCB';
+            for (int i = 7; i >= 0; i--) out += static_cast<char>(bits >> (8 * i));
+        }
+    }
+}
+
+static std::string toMsgpack(const std::string& json) {
+    std::string out;
+    const char* p = json.c_str();
+    jsonToPack(p, out);
+    return out;
+}
+
+// Feeds `body` in pieces of 1..maxPiece bytes (0 = all at once)
+static bool parseSplit(const std::string& body, size_t maxPiece, CosmaniaStatus& out,
+                       StatusParser::Format format = StatusParser::JSON) {
+    StatusParser parser;
+    parser.begin(out, format);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(body.data());
+    size_t off = 0;
+    while (off < body.size()) {
+        size_t n = maxPiece ? 1 + rand() % maxPiece : body.size();
+        if (n > body.size() - off) n = body.size() - off;
+        if (!parser.feed(p + off, n)) return false;
+        off += n;
+    }
+    return parser.finish();
+}
+
+static void streamingParse() {
+    printf("streaming parse (parser state %zu B)\n", sizeof(StatusParser));
+    struct Size { int agents, errors; } sizes[] = {
+        { 2, 1 }, { 7, 20 }, { 7, 200 }, { 50, 1000 }, { 200, 5000 },
+    };
+    srand(3);
+    bool allSame = true, splitsSame = true;
+    size_t jsonBytes = 0, packBytes = 0;
+    double jsonUs = 0, packUs = 0;
+    for (const Size& z : sizes) {
+        CosmaniaStatus want;
+        std::string bodies[2];
+        bodies[0] = makeStatus(z.agents, z.errors, want);
+        bodies[1] = toMsgpack(bodies[0]);
+        double us[2];
+        for (int f = 0; f < 2; f++) {
+            StatusParser::Format format = f ? StatusParser::MSGPACK : StatusParser::JSON;
+            const std::string& body = bodies[f];
+            CosmaniaStatus got;
+            int iters = static_cast<int>(2000000 / bodies[0].size()) + 1;
+            double t0 = nowUs();
+            bool ok = true;
+            for (int i = 0; i < iters; i++) ok = parseSplit(body, 0, got, format) && ok;
+            us[f] = (nowUs() - t0) / iters;
+            allSame = allSame && ok && sameStatus(got, want);
+
+            // Same answer whatever the recv() boundaries
+            for (size_t piece : { (size_t)1, (size_t)7, (size_t)536 }) {
+                CosmaniaStatus split;
+                if (!parseSplit(body, piece, split, format) || !sameStatus(split, want)) {
+                    splitsSame = false;
+                }
+            }
+        }
+        jsonBytes += bodies[0].size();
+        packBytes += bodies[1].size();
+        jsonUs    += us[0];
+        packUs    += us[1];
+        printf("  %3d agents %5d errors  json %8zu B %9.1f us %6.1f MB/s  "
+               "msgpack %8zu B %9.1f us\n", z.agents, z.errors, bodies[0].size(), us[0],
+               bodies[0].size() / us[0], bodies[1].size(), us[1]);
+    }
+    printf("  msgpack: %.0f%% of the JSON bytes, %.0f%% of the parse time\n",
+           100.0 * packBytes / jsonBytes, 100.0 * packUs / jsonUs);
+    check(allSame, "every payload parses to the expected status");
+    check(splitsSame, "1 B / 7 B / random splits parse identically");
+    check(packBytes < jsonBytes && packUs < jsonUs, "msgpack is smaller and parses faster");
+
+    const char* const BAD[] = {
+        "{\"agents\":[{\"name\":\"x\"}",             // truncated
+        "{\"agents\":[}",                               // mismatched
+        "{\"budgetTier\":\"GREEN\",}",                   // trailing comma
+        "[{\"budgetTier\":\"GREEN\"}]",                 // root not an object
+        "{\"totalDailySpend\":1.2.3}",                  // bad number
+        "{\"budgetTier\":\"GR\\xEEN\"}",                // bad escape
+    };
+    bool rejected = true;
+    for (const char* bad : BAD) {
+        CosmaniaStatus out;
+        if (parseSplit(bad, 0, out)) rejected = false;
+    }
+    const std::string BAD_PACK[] = {
+        "\x82\xA6" "agents" "\x91\x81\xA4" "name",            // truncated
+        "\x91\x80",                                     // root not a map
+        "\x81\xA1" "x" "\xC1",                           // reserved type byte
+        "\x81\x80\x01",                                 // map as a key
+        "\x81\xAA" "budgetTier" "\xA3" "RE",             // string cut short
+    };
+    for (const std::string& bad : BAD_PACK) {
+        CosmaniaStatus out;
+        if (parseSplit(bad, 0, out, StatusParser::MSGPACK)) rejected = false;
+    }
+    check(rejected, "malformed bodies are rejected");
+
+    // A delta naming an agent carries only what changed: the rest of the
+    // agent stays. Keys in any order, "delta" after the agents included
+    const std::string FULL =
+        "{\"budgetTier\":\"YELLOW\",\"agents\":["
+        "{\"name\":\"a\",\"overdue\":true,\"overBudget\":true,\"todayCostUsd\":1.5,"
+        "\"todayRuns\":3,\"minutesSinceLastRun\":12},"
+        "{\"name\":\"b\",\"overdue\":false,\"todayCostUsd\":0.25,\"todayRuns\":1,"
+        "\"minutesSinceLastRun\":40}]}";
+    const std::string PARTIAL[] = {
+        "{\"delta\":true,\"agents\":[{\"todayRuns\":4,\"name\":\"a\"},"
+        "{\"name\":\"c\",\"todayRuns\":2}]}",
+        "{\"agents\":[{\"name\":\"a\",\"todayRuns\":4},{\"todayRuns\":2,\"name\":\"c\"}],"
+        "\"delta\":true}",
+    };
+    bool merged = true;
+    for (const std::string& partial : PARTIAL) {
+        for (int f = 0; f < 2; f++) {
+            StatusParser::Format format = f ? StatusParser::MSGPACK : StatusParser::JSON;
+            CosmaniaStatus st;
+            bool ok = parseSplit(f ? toMsgpack(FULL) : FULL, 0, st, format) &&
+                      parseSplit(f ? toMsgpack(partial) : partial, 0, st, format);
+            const AgentInfo& a = st.agents[0];
+            const AgentInfo& b = st.agents[1];
+            const AgentInfo& c = st.agents[2];
+            merged = merged && ok && st.agentCount == 3 && st.budgetTier == TIER_YELLOW &&
+                     strcmp(a.name, "a") == 0 && a.todayRuns == 4 && a.overdue && a.overBudget &&
+                     a.todayCostUsd == 1.5f && a.minutesSince == 12 &&
+                     strcmp(b.name, "b") == 0 && b.todayRuns == 1 && b.minutesSince == 40 &&
+                     strcmp(c.name, "c") == 0 && c.todayRuns == 2 && !c.overdue &&
+                     c.todayCostUsd == 0.0f && c.minutesSince == -1 &&
+                     st.overdueCount == 1 && st.activeCount == 3;
+        }
+    }
+    check(merged, "partial agent delta keeps the fields it omits");
+
+    // Largest payload end to end: chunked over loopback into the parser
+    CosmaniaStatus want;
+    std::string body = makeStatus(200, 5000, want);
+    MockHttp server;
+    server.start([&body](MockHttp::Conn& c, const MockHttp::Request&) {
+        c.drip(MockHttp::chunkedResponse(body, 1400), 50, 2);
+        return false;
+    });
+    CosmaniaStatus got;
+    StatusParser parser;
+    parser.begin(got);
+    HttpFetch fetch;
+    fetch.setUrl(server.url("/status").c_str());
+    fetch.start(nowMs(), [](void* ctx, const uint8_t* d, size_t n) {
+        return static_cast<StatusParser*>(ctx)->feed(d, n);
+    }, &parser);
+    double worst = 0;
+    while (fetch.busy()) {
+        double p0 = nowUs();
+        fetch.poll(nowMs());
+        double us = nowUs() - p0;
+        if (us > worst) worst = us;
+        usleep(1000);
+    }
+    printf("  end to end: %lu B body, worst poll %.0f us\n",
+           (unsigned long)fetch.bodyBytes(), worst);
+    check(fetch.state() == HttpFetch::DONE && parser.finish() && sameStatus(got, want),
+          "streamed over HTTP parses to the expected status");
+    check(worst < FRAME_BUDGET_US, "no poll() blocks the frame while parsing");
+    server.stop();
+}
+
+// -- 3. Conditional and delta polling ------------------------------------
+
+// Cosmania as far as /status is concerned, with a revision per change.
+// ETag is "r<rev>", the cursor r<rev>; ?since= answers with what changed
+// after that revision, or the full status if the revision is unknown.
+struct StubCosmania {
+    struct Agent {
+        AgentInfo info;
+        int       rev;          // last changed
+    };
+    struct Removed {
+        std::string name;
+        int         rev;
+    };
+
+    std::mutex m;
+    bool etags = true;
+    bool since = true;
+    int  failNext = 0;          // answer the next N requests with 500
+    bool keepAlive = false;     // honour Connection: keep-alive
+    int  perConn   = 0;         // ... for this many requests (0 = no limit)
+    int  dropReused = 0;        // hang up on the next N requests on a kept connection
+    int  rev      = 1;
+    int  floorRev = 1;          // oldest revision ?since= still knows
+    int  errorsRev = 1;
+    int  nextAgent = 0;
+    CosmaniaStatus truth;       // scalars + errorCount
+    std::vector<Agent>   agents;
+    std::vector<Removed> removed;
+    bool msgpack = false;       // answer Accept: application/msgpack in kind
+    std::string lastPath, lastIfNoneMatch, lastAccept;
+    uint32_t statusRequests = 0;
+
+    // /events
+    int  streams    = 0;        // connections served
+    int  resumed    = 0;        // ... that resumed from a known Last-Event-ID
+    int  dropGen    = 0;        // bump to hang up every open stream
+    bool refuse     = false;    // answer new streams with 503
+    bool stall      = false;    // stop writing (events and heartbeats)
+    bool corruptNext = false;   // next event's data is not JSON
+    int  beatMs     = 20;
+
+    StubCosmania() {
+        truth.budgetTier       = TIER_GREEN;
+        truth.totalDailyBudget = 25.0f;
+        for (int i = 0; i < 5; i++) addAgent();
+    }
+
+    void addAgent() {
+        Agent a;
+        snprintf(a.info.name, sizeof(a.info.name), "agent-%03d", nextAgent++ % 1000);
+        a.info.minutesSince = -1;
+        a.rev = rev;
+        agents.push_back(a);
+    }
+
+    // One random change, as a new revision
+    void mutate() {
+        std::lock_guard<std::mutex> lock(m);
+        rev++;
+        int kind = rand() % 10;
+        if (kind < 6) {
+            Agent& a = agents[rand() % agents.size()];
+            a.info.todayRuns++;
+            a.info.todayCostUsd += 0.25f;
+            a.info.minutesSince  = 0;
+            a.info.overdue       = false;
+            a.rev = rev;
+            truth.totalDailySpend += 0.25f;
+        } else if (kind < 7) {
+            Agent& a = agents[rand() % agents.size()];
+            a.info.overdue = true;
+            a.rev = rev;
+        } else if (kind < 8) {
+            truth.errorCount++;
+            errorsRev = rev;
+        } else if (kind < 9 && agents.size() > 3) {
+            size_t i = rand() % agents.size();
+            removed.push_back({ agents[i].info.name, rev });
+            agents.erase(agents.begin() + i);
+        } else if (agents.size() < 7) {
+            addAgent();
+        } else {
+            truth.budgetTier = static_cast<BudgetTier>((truth.budgetTier + 1) % 4);
+        }
+    }
+
+    CosmaniaStatus want() {
+        std::lock_guard<std::mutex> lock(m);
+        CosmaniaStatus s = truth;
+        for (const Agent& a : agents) {
+            s.agents[s.agentCount++] = a.info;
+            if (a.info.overdue) s.overdueCount++;
+            if (a.info.todayRuns > 0) s.activeCount++;
+        }
+        return s;
+    }
+
+    // Agents carry the schedule and notes the real server sends, so a
+    // full body is the size it would be
+    static void writeAgent(std::string& out, const AgentInfo& a) {
+        char buf[384];
+        char minutes[16];
+        if (a.minutesSince < 0) snprintf(minutes, sizeof(minutes), "null");
+        else                    snprintf(minutes, sizeof(minutes), "%d", a.minutesSince);
+        snprintf(buf, sizeof(buf),
+                 "{\"name\":\"%s\",\"schedule\":{\"cron\":\"*/15 * * * *\","
+                 "\"next\":[1700000000,1700000900]},\"overdue\":%s,\"overBudget\":%s,"
+                 "\"todayCostUsd\":%g,\"todayRuns\":%d,\"minutesSinceLastRun\":%s,"
+                 "\"notes\":\"rotates credentials, reports to #ops\"}",
+                 a.name, a.overdue ? "true" : "false", a.overBudget ? "true" : "false",
+                 a.todayCostUsd, a.todayRuns, minutes);
+        out += buf;
+    }
+
+    std::string body(int sinceRev) {
+        static const char* const TIERS[] = { "GREEN", "YELLOW", "RED", "BLACK" };
+        bool delta = sinceRev >= floorRev && sinceRev <= rev;
+        char buf[192];
+        snprintf(buf, sizeof(buf),
+                 "{\"version\":\"2.3.1\",\"budgetTier\":\"%s\",\"totalDailyBudget\":%g,"
+                 "\"totalDailySpend\":%g",
+                 TIERS[truth.budgetTier], truth.totalDailyBudget, truth.totalDailySpend);
+        std::string out = buf;
+        if (since) {
+            snprintf(buf, sizeof(buf), ",\"cursor\":\"r%d\"%s", rev, delta ? ",\"delta\":true" : "");
+            out += buf;
+        }
+        out += ",\"agents\":[";
+        bool first = true;
+        for (const Agent& a : agents) {
+            if (delta && a.rev <= sinceRev) continue;
+            if (!first) out += ",";
+            writeAgent(out, a.info);
+            first = false;
+        }
+        out += "]";
+        if (delta) {
+            out += ",\"removed\":[";
+            first = true;
+            for (const Removed& r : removed) {
+                if (r.rev <= sinceRev) continue;
+                out += first ? "\"" : ",\"";
+                out += r.name + "\"";
+                first = false;
+            }
+            out += "]";
+        }
+        if (!delta || errorsRev > sinceRev) {
+            out += ",\"recentErrors\":[";
+            for (int i = 0; i < truth.errorCount; i++) {
+                snprintf(buf, sizeof(buf),
+                         "%s{\"agent\":\"agent-000\",\"at\":%d,\"message\":\"upstream timeout\"}",
+                         i ? "," : "", 1700000000 + i);
+                out += buf;
+            }
+            out += "]";
+        }
+        return out + "}";
+    }
+
+    bool handle(MockHttp::Conn& c, const MockHttp::Request& req) {
+        std::lock_guard<std::mutex> lock(m);
+        static thread_local int onConn = 0;     // MockHttp: a thread per connection
+        onConn++;
+        if (dropReused > 0 && onConn > 1) {
+            dropReused--;
+            c.close();                          // as if the idle timer fired just now
+            return false;
+        }
+        // Closes silently after the limit, like an idle or request-count timeout
+        const std::string* conn = req.header("Connection");
+        bool keep = keepAlive && conn && *conn == "keep-alive" && (!perConn || onConn < perConn);
+
+        const std::string* inm = req.header("If-None-Match");
+        const std::string* accept = req.header("Accept");
+        statusRequests++;
+        lastPath        = req.path;
+        lastIfNoneMatch = inm ? *inm : "";
+        lastAccept      = accept ? *accept : "";
+        if (failNext > 0) {
+            failNext--;
+            c.write(MockHttp::response(500, "{}"));
+            return false;
+        }
+
+        char etag[32];
+        snprintf(etag, sizeof(etag), "\"r%d\"", rev);
+        std::string headers = etags ? std::string("ETag: ") + etag + "\r\n" : "";
+        if (etags && inm && *inm == etag) {
+            c.write(MockHttp::response(304, "", headers));
+            return keep;
+        }
+        int sinceRev = -1;
+        size_t q = req.path.find("?since=r");
+        if (since && q != std::string::npos) sinceRev = atoi(req.path.c_str() + q + 8);
+        if (msgpack && lastAccept.find("application/msgpack") != std::string::npos) {
+            c.write(MockHttp::response(200, toMsgpack(body(sinceRev)), headers, "application/msgpack"));
+        } else {
+            c.write(MockHttp::response(200, body(sinceRev), headers));
+        }
+        return keep;
+    }
+
+    // One status event from `sinceRev`; data split over lines between
+    // agents (where JSON allows a newline), alternating LF and CRLF
+    std::string event(int sinceRev) {
+        const char* eol = rev % 2 ? "\r\n" : "\n";
+        std::string data = corruptNext ? "{\"budgetTier\":" : body(sinceRev);
+        corruptNext = false;
+        std::string out = "id: r" + std::to_string(rev) + eol + "event: status" + eol + "data: ";
+        size_t from = 0, at;
+        while ((at = data.find("},", from)) != std::string::npos) {
+            out += data.substr(from, at + 2 - from) + eol + "data: ";
+            from = at + 2;
+        }
+        return out + data.substr(from) + eol + eol;
+    }
+
+    // Holds an SSE connection: resumes from Last-Event-ID, then one event
+    // per revision and a comment every beatMs, until dropGen moves
+    bool stream(MockHttp::Conn& c, const MockHttp::Request& req) {
+        std::string out = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                          "Cache-Control: no-cache\r\n\r\n"
+                          "retry: 50\n\nevent: hello\ndata: not a status\n\n";
+        int sent, gen;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            if (refuse) {
+                c.write(MockHttp::response(503, "", ""));
+                return false;
+            }
+            streams++;
+            const std::string* last = req.header("Last-Event-ID");
+            int since = last && !last->empty() && (*last)[0] == 'r' ? atoi(last->c_str() + 1) : -1;
+            if (since >= floorRev && since <= rev) resumed++;
+            out += event(since);
+            sent = rev;
+            gen  = dropGen;
+        }
+        double beat = nowUs();
+        while (c.serving() && c.write(out)) {
+            out.clear();
+            c.sleepMs(1);
+            std::lock_guard<std::mutex> lock(m);
+            if (dropGen != gen) break;
+            if (stall) continue;
+            if (rev != sent) {
+                out  = event(sent);
+                sent = rev;
+            } else if (nowUs() - beat > beatMs * 1000.0) {
+                out  = ": ping\n";
+                beat = nowUs();
+            }
+        }
+        return false;
+    }
+};
+
+struct PollTally {
+    uint32_t updated = 0, notModified = 0, deltas = 0, errors = 0;
+    uint64_t bodyBytes = 0;
+};
+
+static CosmaniaPoll::Result pollOnce(CosmaniaPoll& poll, PollTally& t) {
+    poll.start(nowMs());
+    CosmaniaPoll::Result r;
+    while ((r = poll.poll(nowMs())) == CosmaniaPoll::BUSY) usleep(50);
+    t.bodyBytes += poll.lastBytes();
+    switch (r) {
+        case CosmaniaPoll::UPDATED:      t.updated++; if (poll.lastDelta()) t.deltas++; break;
+        case CosmaniaPoll::NOT_MODIFIED: t.notModified++; break;
+        default:                         t.errors++; break;
+    }
+    return r;
+}
+
+// Same change script (seeded) for each mode; returns bytes served
+static uint64_t pollScript(const char* name, bool etags, bool since, bool packed, int polls,
+                           bool& exact) {
+    StubCosmania stub;
+    stub.etags   = etags;
+    stub.since   = since;
+    stub.msgpack = packed;
+    MockHttp server;
+    server.start([&stub](MockHttp::Conn& c, const MockHttp::Request& r) { return stub.handle(c, r); });
+    CosmaniaPoll poll;
+    poll.setUrl(server.url("/status").c_str());
+    poll.setMsgpack(packed);
+
+    srand(36);
+    PollTally t;
+    exact = true;
+    for (int i = 0; i < polls; i++) {
+        if (rand() % 5 == 0) stub.mutate();
+        if (rand() % 23 == 0) stub.mutate();        // two changes between polls
+        CosmaniaPoll::Result r = pollOnce(poll, t);
+        if (!poll.status().connected || !sameStatus(poll.status(), stub.want())) exact = false;
+        if (r == CosmaniaPoll::UPDATED && poll.lastPacked() != packed) exact = false;
+    }
+    uint64_t served = server.bytesServed();
+    printf("  %-14s %4u updated (%3u delta) %4u not modified %u errors  "
+           "%7lu B served, %6lu B body, %u versions\n",
+           name, t.updated, t.deltas, t.notModified, t.errors, (unsigned long)served,
+           (unsigned long)t.bodyBytes, poll.status().version);
+    server.stop();
+    return served;
+}
+
+static void conditionalPoll() {
+    printf("conditional polling (poll state %zu B)\n", sizeof(CosmaniaPoll));
+    const int POLLS = 300;
+    bool exactPlain, exactEtag, exactDelta, exactPacked;
+    uint64_t plain  = pollScript("plain", false, false, false, POLLS, exactPlain);
+    uint64_t etag   = pollScript("etag", true, false, false, POLLS, exactEtag);
+    uint64_t delta  = pollScript("etag + since", true, true, false, POLLS, exactDelta);
+    uint64_t packed = pollScript("... msgpack", true, true, true, POLLS, exactPacked);
+    printf("  served: etag %.0f%%, etag + since %.0f%%, in msgpack %.0f%% of plain\n",
+           100.0 * etag / plain, 100.0 * delta / plain, 100.0 * packed / plain);
+    check(exactPlain && exactEtag && exactDelta && exactPacked,
+          "published status matches the server every poll");
+    check(etag * 2 < plain, "ETag serves under half the bytes of plain");
+    check(delta < etag, "since= deltas serve fewer bytes than ETag alone");
+    check(packed < delta, "msgpack deltas serve fewer bytes than JSON");
+
+    // Recovery: the server forgets history, then fails once. It only
+    // speaks JSON, though the poller asks for MessagePack
+    StubCosmania stub;
+    MockHttp server;
+    server.start([&stub](MockHttp::Conn& c, const MockHttp::Request& r) { return stub.handle(c, r); });
+    CosmaniaPoll poll;
+    poll.setUrl(server.url("/status").c_str());
+    poll.setMsgpack(true);
+    PollTally t;
+    pollOnce(poll, t);
+    check(stub.lastAccept.find("application/msgpack") == 0 && !poll.lastPacked() &&
+          sameStatus(poll.status(), stub.want()), "JSON answer to a msgpack Accept is parsed");
+    stub.mutate();
+    {
+        std::lock_guard<std::mutex> lock(stub.m);
+        stub.floorRev = stub.rev + 1;               // every cursor is now unknown
+    }
+    CosmaniaPoll::Result r = pollOnce(poll, t);
+    check(r == CosmaniaPoll::UPDATED && !poll.lastDelta() && sameStatus(poll.status(), stub.want()),
+          "unknown cursor gets a full status");
+
+    stub.failNext = 1;
+    stub.mutate();
+    r = pollOnce(poll, t);
+    bool dropped = r == CosmaniaPoll::HTTP_ERROR && !poll.status().connected &&
+                   poll.etag()[0] == '\0' && poll.cursor()[0] == '\0';
+    r = pollOnce(poll, t);
+    bool resynced = r == CosmaniaPoll::UPDATED && poll.status().connected &&
+                    stub.lastPath == "/status" && stub.lastIfNoneMatch.empty() &&
+                    sameStatus(poll.status(), stub.want());
+    check(dropped, "error disconnects and forgets ETag + cursor");
+    check(resynced, "next poll is an unconditional full fetch");
+
+    uint32_t version = poll.status().version;
+    r = pollOnce(poll, t);
+    check(r == CosmaniaPoll::NOT_MODIFIED && poll.status().version == version,
+          "304 publishes nothing");
+    server.stop();
+}
+
+// -- 5. Keep-alive ---------------------------------------------------------
+
+struct KeepRun {
+    uint32_t connections = 0, polls = 0, ok = 0;
+    double   meanUs = 0, freshUs = 0, reusedUs = 0;
+    uint32_t reuses = 0, retries = 0, lookups = 0;
+    uint32_t reusedPolls = 0;           // polls that lastReused() reported
+    bool     exact = true;
+};
+
+static KeepRun keepScript(bool keepAlive, int perConn, int dropEvery, int polls) {
+    StubCosmania stub;
+    stub.keepAlive = true;
+    stub.perConn   = perConn;
+    MockHttp server;
+    server.start([&stub](MockHttp::Conn& c, const MockHttp::Request& r) { return stub.handle(c, r); });
+    CosmaniaPoll poll;
+    poll.setUrl(server.url("/status").c_str());
+    poll.setKeepAlive(keepAlive);
+
+    srand(38);
+    KeepRun k;
+    PollTally t;
+    double total = 0, fresh = 0, reused = 0;
+    uint32_t nFresh = 0, nReused = 0;
+    for (int i = 0; i < polls; i++) {
+        if (rand() % 5 == 0) stub.mutate();
+        if (dropEvery && i % dropEvery == dropEvery - 1) stub.dropReused = 1;
+        double t0 = nowUs();
+        CosmaniaPoll::Result r = pollOnce(poll, t);
+        double us = nowUs() - t0;
+        total += us;
+        if (poll.lastReused()) { reused += us; nReused++; }
+        else                   { fresh  += us; nFresh++;  }
+        if (r == CosmaniaPoll::UPDATED || r == CosmaniaPoll::NOT_MODIFIED) k.ok++;
+        if (!sameStatus(poll.status(), stub.want())) k.exact = false;
+        usleep(300);                    // the server may close in between
+    }
+    k.polls       = polls;
+    k.connections = server.connections();
+    k.meanUs      = total / polls;
+    k.freshUs     = nFresh ? fresh / nFresh : 0;
+    k.reusedUs    = nReused ? reused / nReused : 0;
+    k.reusedPolls = nReused;
+    k.reuses      = poll.fetch().reuses();
+    k.retries     = poll.fetch().retries();
+    k.lookups     = poll.fetch().lookups();
+    server.stop();
+    return k;
+}
+
+static void keepAlive() {
+    printf("keep-alive\n");
+    const int POLLS = 200;
+    struct { const char* name; bool keep; int perConn; int dropEvery; } RUNS[] = {
+        { "connection: close",      false, 0,  0 },
+        { "keep-alive",             true,  0,  0 },
+        { "server closes every 10", true,  10, 0 },
+        { "stale every 25",         true,  0,  25 },
+    };
+    KeepRun k[4];
+    int n = 0;
+    for (const auto& run : RUNS) {
+        k[n] = keepScript(run.keep, run.perConn, run.dropEvery, POLLS);
+        printf("  %-24s %3u/%u ok %3u conns %3u reuses %2u retries %2u dns  "
+               "mean %5.0f us (fresh %5.0f, reused %5.0f)\n",
+               run.name, k[n].ok, k[n].polls, k[n].connections, k[n].reuses, k[n].retries,
+               k[n].lookups, k[n].meanUs, k[n].freshUs, k[n].reusedUs);
+        n++;
+    }
+    bool allOk = true;
+    for (const KeepRun& r : k) allOk = allOk && r.ok == r.polls && r.exact;
+    check(allOk, "every poll succeeds with the right status");
+    check(k[0].connections == POLLS && k[1].connections == 1, "one connection for the whole run");
+    check(k[1].lookups == 1, "address resolved once");
+    check(k[2].connections == POLLS / 10 && k[2].retries == 0,
+          "server-side close is seen before reuse");
+    check(k[3].retries == POLLS / 25, "stale connection retried on a fresh one");
+    // Loopback latency is mostly noise, so it is only printed: what keep-alive
+    // buys is every poll after the first skipping the handshake
+    check(k[0].reusedPolls == 0 && k[1].reusedPolls == POLLS - 1 && k[1].reuses == POLLS - 1,
+          "every kept-alive poll after the first reuses");
+
+    // Idle close, and a server that hangs up after an error
+    StubCosmania stub;
+    stub.keepAlive = true;
+    MockHttp server;
+    server.start([&stub](MockHttp::Conn& c, const MockHttp::Request& r) { return stub.handle(c, r); });
+    CosmaniaPoll poll;
+    poll.setUrl(server.url("/status").c_str());
+    poll.setKeepAlive(true);
+    PollTally t;
+    pollOnce(poll, t);
+    bool kept = poll.fetch().connected();
+    poll.idle(nowMs() + 1000);
+    bool stillKept = poll.fetch().connected();
+    poll.idle(nowMs() + HttpFetch::IDLE_MS);
+    check(kept && stillKept && !poll.fetch().connected(), "kept connection closes after IDLE_MS idle");
+    // A 500 the server hangs up after: its EOF is seen before the next send
+    stub.failNext = 1;
+    pollOnce(poll, t);
+    usleep(1000);
+    uint32_t connects = poll.fetch().connects();
+    CosmaniaPoll::Result r = pollOnce(poll, t);
+    check(r == CosmaniaPoll::UPDATED && poll.fetch().connects() == connects + 1 &&
+          poll.fetch().retries() == 0, "hang-up after an error: fresh connect, no retry");
+    server.stop();
+}
+
+// -- 6. Push ---------------------------------------------------------------
+
+// The client's loop in miniature: stream first, polls while it is down
+struct PushClient {
+    static constexpr uint32_t FALLBACK_MS = 40;
+
+    CosmaniaPoll poll;
+    CosmaniaPush push{poll};
+    PollTally    tally;
+    uint32_t     lastPoll = 0;
+    bool         force = false;
+    uint32_t     fallbackPolls = 0;
+
+    void tick() {
+        uint32_t now = nowMs();
+        push.connect(now);
+        if (push.poll(now) == CosmaniaPush::DROPPED) force = true;
+        if (push.live()) return;
+        if (!poll.busy()) {
+            if (!force && now - lastPoll < FALLBACK_MS) return;
+            force    = false;
+            lastPoll = now;
+            poll.start(now);
+            fallbackPolls++;
+        }
+        CosmaniaPoll::Result r = poll.poll(now);
+        if (r == CosmaniaPoll::UPDATED) tally.updated++;
+    }
+
+    // Runs the loop until `done` or `ms` pass; false on timeout
+    template <typename Done>
+    bool until(Done done, uint32_t ms) {
+        double end = nowUs() + ms * 1000.0;
+        while (nowUs() < end) {
+            tick();
+            if (done()) return true;
+            usleep(200);
+        }
+        return false;
+    }
+};
+
+// Changes one at a time; ms from each change until the status shows it
+static void pushLatency(StubCosmania& stub, PushClient& cl, int changes,
+                        double& mean, double& worst, bool& allSeen) {
+    mean = worst = 0;
+    allSeen = true;
+    for (int i = 0; i < changes; i++) {
+        stub.mutate();
+        CosmaniaStatus want = stub.want();
+        double t0 = nowUs();
+        bool seen = cl.until([&] { return sameStatus(cl.poll.status(), want); }, 2000);
+        double ms = (nowUs() - t0) / 1000.0;
+        allSeen = allSeen && seen;
+        mean += ms / changes;
+        if (ms > worst) worst = ms;
+        usleep(1000 + rand() % 4000);
+    }
+}
+
+static void pushStream() {
+    printf("push (SSE)\n");
+    StubCosmania stub;
+    MockHttp server;
+    server.start([&stub](MockHttp::Conn& c, const MockHttp::Request& r) {
+        if (r.path.compare(0, 7, "/events") == 0) return stub.stream(c, r);
+        return stub.handle(c, r);
+    });
+    PushClient cl;
+    cl.poll.setUrl(server.url("/status").c_str());
+    cl.poll.setKeepAlive(true);
+    cl.push.setUrl(server.url("/events").c_str());
+    cl.push.setIdleTimeout(300);
+    srand(39);
+
+    bool up = cl.until([&] { return cl.push.live() && sameStatus(cl.poll.status(), stub.want()); }, 2000);
+    check(up, "stream opens and delivers the full status");
+
+    // Live: every change pushed, no polls
+    const int CHANGES = 100;
+    uint32_t polls0 = stub.statusRequests;
+    double mean, worst;
+    bool allSeen;
+    pushLatency(stub, cl, CHANGES, mean, worst, allSeen);
+    uint32_t livePolls = stub.statusRequests - polls0;
+    const CosmaniaPush::Stats& ps = cl.push.stats();
+    printf("  live: %d changes, %u events, %u heartbeats, %u polls, latency mean %.2f ms, "
+           "worst %.2f ms\n", CHANGES, ps.events, ps.heartbeats, livePolls, mean, worst);
+    check(allSeen && livePolls == 0, "every change arrives by push, no polls");
+    check(ps.events == (uint32_t)CHANGES + 1 && ps.heartbeats > 0,
+          "one event per change; other event types ignored");
+
+    // Dropped and refused for a while: polls take over at once with the
+    // stream's cursor, then the stream resumes from Last-Event-ID
+    int resumed = stub.resumed;
+    {
+        std::lock_guard<std::mutex> lock(stub.m);
+        stub.dropGen++;
+        stub.refuse = true;
+    }
+    stub.mutate();
+    CosmaniaStatus want = stub.want();
+    bool caught = cl.until([&] { return !cl.push.live() && sameStatus(cl.poll.status(), want); }, 2000);
+    bool sincePoll = stub.lastPath.find("?since=r") != std::string::npos;
+    double downMean, downWorst;
+    bool downSeen;
+    pushLatency(stub, cl, 5, downMean, downWorst, downSeen);
+    bool stayedDown = !cl.push.live();
+    {
+        std::lock_guard<std::mutex> lock(stub.m);
+        stub.refuse = false;
+    }
+    bool back = cl.until([&] { return cl.push.live(); }, 2000);
+    pushLatency(stub, cl, 5, mean, worst, allSeen);
+    printf("  dropped: caught up by poll, %u fallback polls, latency while down %.1f ms, "
+           "%u streams opened\n", cl.fallbackPolls, downMean, cl.push.stats().connects);
+    check(caught && sincePoll && downSeen && stayedDown, "drop falls back to ?since= polls at once");
+    check(back && stub.resumed == resumed + 1 && allSeen, "stream resumes from Last-Event-ID");
+
+    // Stalled (no heartbeats): the idle timeout drops it
+    {
+        std::lock_guard<std::mutex> lock(stub.m);
+        stub.stall = true;
+    }
+    bool timedOut = cl.until([&] { return !cl.push.live(); }, 2000);
+    stub.mutate();
+    want = stub.want();
+    bool polled = cl.until([&] { return sameStatus(cl.poll.status(), want); }, 2000);
+    {
+        std::lock_guard<std::mutex> lock(stub.m);
+        stub.stall = false;
+    }
+    check(timedOut && polled, "silent stream times out, polls carry on");
+    cl.until([&] { return cl.push.live(); }, 2000);
+
+    // Broken event: dropped, and the next stream starts from full
+    int streams = stub.streams;
+    resumed = stub.resumed;
+    {
+        std::lock_guard<std::mutex> lock(stub.m);
+        stub.corruptNext = true;
+    }
+    stub.mutate();
+    stub.mutate();
+    want = stub.want();
+    bool recovered = cl.until([&] {
+        return cl.push.live() && stub.streams > streams && sameStatus(cl.poll.status(), want);
+    }, 2000);
+    check(recovered && cl.push.stats().badEvents == 1 && stub.resumed == resumed,
+          "broken event: reconnect without Last-Event-ID");
+    server.stop();
+}
+
+// -- 7. Warm start ---------------------------------------------------------
+static void warmStart() {
+    printf("warm start\n");
+    StubCosmania stub;
+    for (int i = 0; i < 6; i++) stub.mutate();
+    MockHttp server;
+    server.start([&stub](MockHttp::Conn& c, const MockHttp::Request& r) { return stub.handle(c, r); });
+
+    // Last boot: one poll, written out the way CosmaniaClient caches it
+    CosmaniaPoll last;
+    last.setUrl(server.url("/status").c_str());
+    PollTally t;
+    pollOnce(last, t);
+    uint8_t cache[256];
+    JournalCodec::Buf b(cache, sizeof(cache));
+    JournalCodec::encodeCosmania(b, last.status());
+    CosmaniaStatus decoded;
+    check(b.ok && JournalCodec::decodeCosmania(cache, b.len, decoded) &&
+          sameStatus(decoded, last.status()), "cache body round-trips a polled status");
+    check(!JournalCodec::decodeCosmania(cache, b.len - 1, decoded) &&
+          !JournalCodec::decodeCosmania(cache, b.len + 1, decoded),
+          "short or overlong cache body rejected");
+
+    // This boot: the snapshot first, then the link comes up
+    CosmaniaPoll poll;
+    poll.setUrl(server.url("/status").c_str());
+    double t0 = nowUs();
+    CosmaniaStatus snap;
+    bool restored = JournalCodec::decodeCosmania(cache, b.len, snap) && poll.restore(snap, true);
+    double warmUs = nowUs() - t0;
+    const CosmaniaStatus& st = poll.status();
+    check(restored && st.stale && st.connected && st.version == 1 && sameStatus(st, last.status()),
+          "snapshot published stale before any poll");
+
+    stub.failNext = 1;
+    pollOnce(poll, t);
+    check(poll.status().stale && poll.status().connected, "failed poll leaves the snapshot be");
+    poll.trustStale(false);
+    check(poll.status().stale && !poll.status().connected, "aged-out snapshot reads as disconnected");
+
+    stub.mutate();
+    t0 = nowUs();
+    CosmaniaPoll::Result r = pollOnce(poll, t);
+    double liveUs = nowUs() - t0;
+    check(r == CosmaniaPoll::UPDATED && !poll.status().stale && poll.status().connected &&
+          sameStatus(poll.status(), stub.want()), "first good poll replaces it, stale cleared");
+    check(!poll.restore(snap, true), "no restore once a poll has published");
+    printf("  dashboard has agents after: cache %.1f us (%zu B), first poll %.0f us "
+           "on loopback (+ link-up on the device)\n", warmUs, b.len, liveUs);
+    server.stop();
+}
+
+// -- 4. Poll schedule -----------------------------------------------------
+
+// Radio time charged per request (a 304 or small delta over a home AP),
+// plus the power-save tail before the modem sleeps again; a dead server
+// costs the full HttpFetch timeout
+static constexpr uint32_t REQ_OK_MS      = 60;
+static constexpr uint32_t REQ_TIMEOUT_MS = HttpFetch::TIMEOUT_MS;
+static constexpr uint32_t RADIO_TAIL_MS  = 100;
+static constexpr uint32_t SIM_MS         = 8UL * 3600 * 1000;
+
+struct Scenario {
+    const char* name;
+    PollScheduler::Inputs in;
+    uint32_t changeEveryMs;         // mean gap between Cosmania changes
+    uint32_t outageFromMs, outageToMs;
+};
+
+struct SimResult {
+    uint32_t polls   = 0;
+    uint32_t failed  = 0;
+    double   duty    = 0;           // share of time the radio is awake
+    double   staleS  = 0;           // mean change -> seen delay
+};
+
+// fixedMs != 0 replays the old fixed-interval poll instead
+static SimResult simulate(const Scenario& sc, uint32_t fixedMs, uint32_t seed) {
+    PollScheduler sched;
+    sched.setBase(30000);
+    sched.seed(seed);
+    srand(seed);
+
+    SimResult r;
+    uint64_t busy = 0;
+    uint32_t now = 0, lastFixed = 0;
+    uint32_t nextChange = 1 + rand() % (2 * sc.changeEveryMs);
+    std::vector<uint32_t> pending;          // change times not yet seen
+    double staleSum = 0;
+    uint32_t seen = 0;
+    bool first = true;
+
+    while (now < SIM_MS) {
+        while (nextChange <= now) {
+            pending.push_back(nextChange);
+            nextChange += 1 + rand() % (2 * sc.changeEveryMs);
+        }
+        bool due = fixedMs ? (first || now - lastFixed >= fixedMs) : sched.due(now, sc.in);
+        if (!due) {
+            now += 100;
+            continue;
+        }
+        first = false;
+        lastFixed = now;
+        sched.started(now);
+        r.polls++;
+        bool down = now >= sc.outageFromMs && now < sc.outageToMs;
+        uint32_t took = down ? REQ_TIMEOUT_MS : REQ_OK_MS;
+        busy += took + RADIO_TAIL_MS;
+        now += took;
+        if (down) {
+            r.failed++;
+            sched.failed(sc.in);
+            continue;
+        }
+        for (uint32_t t : pending) staleSum += now - t;
+        seen += pending.size();
+        sched.succeeded(!pending.empty());
+        pending.clear();
+    }
+    r.duty   = 100.0 * busy / SIM_MS;
+    r.staleS = seen ? staleSum / seen / 1000.0 : 0;
+    return r;
+}
+
+static void pollSchedule() {
+    printf("poll schedule (8 h simulated per scenario)\n");
+    const uint32_t NO_OUTAGE = 0;
+    auto inputs = [](LocationZone zone, BudgetTier tier, Screen screen, bool asleep, int battery) {
+        PollScheduler::Inputs in;
+        in.zone = zone; in.tier = tier; in.screen = screen;
+        in.displayAsleep = asleep; in.batteryPct = battery;
+        return in;
+    };
+    const Scenario SCENARIOS[] = {
+        { "home, asleep",     inputs(LOC_HOME,   TIER_GREEN,  SCREEN_HOME,      true,  -1), 15 * 60000, NO_OUTAGE, 0 },
+        { "home, pet screen", inputs(LOC_HOME,   TIER_GREEN,  SCREEN_HOME,      false, -1), 5 * 60000,  NO_OUTAGE, 0 },
+        { "home, dashboard",  inputs(LOC_HOME,   TIER_YELLOW, SCREEN_DASHBOARD, false, -1), 60000,      NO_OUTAGE, 0 },
+        { "work",             inputs(LOC_WORK,   TIER_GREEN,  SCREEN_HOME,      false, -1), 5 * 60000,  NO_OUTAGE, 0 },
+        { "travel, red tier", inputs(LOC_TRAVEL, TIER_RED,    SCREEN_HOME,      false, 60), 2 * 60000,  NO_OUTAGE, 0 },
+        { "low battery",      inputs(LOC_HOME,   TIER_GREEN,  SCREEN_HOME,      true,   8), 15 * 60000, NO_OUTAGE, 0 },
+        { "server down 4 h",  inputs(LOC_HOME,   TIER_GREEN,  SCREEN_HOME,      false, -1), 5 * 60000,  3600000, 5 * 3600000 },
+    };
+    printf("  %-18s %21s   %21s\n", "", "adaptive", "fixed 30 s");
+    printf("  %-18s %6s %6s %7s   %6s %6s %7s\n", "scenario", "polls", "duty%", "stale s",
+           "polls", "duty%", "stale s");
+    SimResult adaptive[sizeof(SCENARIOS) / sizeof(SCENARIOS[0])];
+    SimResult fixed[sizeof(SCENARIOS) / sizeof(SCENARIOS[0])];
+    int n = 0;
+    for (const Scenario& sc : SCENARIOS) {
+        adaptive[n] = simulate(sc, 0, 37);
+        fixed[n]    = simulate(sc, 30000, 37);
+        printf("  %-18s %6u %6.2f %7.1f   %6u %6.2f %7.1f\n", sc.name,
+               adaptive[n].polls, adaptive[n].duty, adaptive[n].staleS,
+               fixed[n].polls, fixed[n].duty, fixed[n].staleS);
+        n++;
+    }
+    check(adaptive[0].duty * 3 < fixed[0].duty, "asleep at home: duty cycle under a third");
+    check(adaptive[2].staleS < fixed[2].staleS, "dashboard: status fresher than fixed");
+    check(adaptive[4].staleS < fixed[4].staleS, "travel / red: status fresher than fixed");
+    check(adaptive[5].duty < adaptive[0].duty, "low battery polls least");
+    check(adaptive[6].duty * 4 < fixed[6].duty, "outage: backoff cuts duty to under a quarter");
+
+    // Jitter: devices failing together must not retry together
+    const int DEVICES = 50;
+    PollScheduler fleet[DEVICES];
+    PollScheduler::Inputs in;
+    uint32_t lo = UINT32_MAX, hi = 0;
+    for (int d = 0; d < DEVICES; d++) {
+        fleet[d].seed(1000 + d);
+        fleet[d].started(0);
+        for (int f = 0; f < 4; f++) fleet[d].failed(in);
+        uint32_t wait = fleet[d].backoffMs();
+        if (wait < lo) lo = wait;
+        if (wait > hi) hi = wait;
+    }
+    printf("  50 devices after 4 failures retry in %.0f .. %.0f s\n", lo / 1000.0, hi / 1000.0);
+    check(hi - lo > (hi / 4), "backoff retries are spread, not synchronised");
+    check(hi <= PollScheduler::BACKOFF_MAX_MS, "backoff is capped");
+}
+
+int main() {
+    scenarios();
+    streamingParse();
+    conditionalPoll();
+    pollSchedule();
+    keepAlive();
+    pushStream();
+    warmStart();
+    printf("%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,250 @@
+// ==========================================================================
+// net_table_bench -- Host benchmark + consistency checks for NetTable
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Iinclude -Isrc -o net_table_bench
+//       tools/net_table_bench/net_table_bench.cpp src/sys/net_table.cpp
+//
+// Usage:
+//   net_table_bench [capacity]       default 4096 (NET_TABLE_CAPACITY)
+//
+//   1. insert and lookup rates (hits and misses) at 1/4, 1/2 and 3/4 full
+//   2. scan diffs: new, gone, changed against a scripted neighbourhood
+//   3. eviction: a rolling population many times the capacity, with the
+//      table held under its limit and every recent network still found
+//   4. after every scan of (3), each stored entry is reachable from its
+//      home slot, i.e. backward-shift deletes left no broken probe run
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "sys/net_table.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration_cast<duration<double, std::micro>>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Vendors hand out MACs in blocks: a few OUIs, sequential low bytes
+struct Mac {
+    uint8_t b[6];
+};
+
+static Mac macFor(uint32_t n) {
+    static const uint8_t OUI[4][3] = {
+        {0x24, 0x0A, 0xC4}, {0xDC, 0xA6, 0x32}, {0x3C, 0x84, 0x6A}, {0xF4, 0xF2, 0x6D},
+    };
+    Mac m;
+    memcpy(m.b, OUI[n % 4], 3);
+    uint32_t low = n / 4;
+    m.b[3] = static_cast<uint8_t>(low >> 16);
+    m.b[4] = static_cast<uint8_t>(low >> 8);
+    m.b[5] = static_cast<uint8_t>(low);
+    return m;
+}
+
+// Stable per-network attributes, as a scan would report them
+static uint32_t ssidFor(uint32_t n) { return n % 7 == 0 ? 0 : 0x1000 + n % 500; }
+static uint8_t  authFor(uint32_t n) { return n % 5 == 0 ? 0 : 3; }
+static uint8_t  chanFor(uint32_t n) { return static_cast<uint8_t>(1 + n % 13); }
+static int      rssiFor(uint32_t n) { return -40 - static_cast<int>(n % 50); }
+
+static void observe(NetTable& t, uint32_t n) {
+    Mac m = macFor(n);
+    t.observe(m.b, ssidFor(n), authFor(n), chanFor(n), rssiFor(n));
+}
+
+// Every entry can be found from its home slot
+static bool reachable(const NetTable& t) {
+    bool ok = true;
+    uint32_t count = 0;
+    t.forEach([&](const NetEntry& e) {
+        count++;
+        if (t.find(e.bssid) != &e) ok = false;
+    });
+    return ok && count == t.size();
+}
+
+// -- 1. Rates --------------------------------------------------------------
+
+static void rates(uint32_t capacity) {
+    printf("\n1. insert / lookup, capacity %u (%zu B)\n", capacity, NetTable::bytesFor(capacity));
+    std::vector<NetEntry> storage(capacity);
+
+    for (int quarter = 1; quarter <= 3; quarter++) {
+        NetTable t;
+        t.init(storage.data(), capacity);
+        uint32_t fill = capacity / 4 * quarter;
+
+        t.beginScan(1);
+        double t0 = nowUs();
+        for (uint32_t n = 0; n < fill; n++) observe(t, n);
+        double insertUs = nowUs() - t0;
+        t.endScan();
+
+        std::vector<Mac> hits(fill), misses(fill);
+        for (uint32_t n = 0; n < fill; n++) {
+            hits[n]   = macFor((n * 2654435761u) % fill);
+            misses[n] = macFor(capacity * 4 + n);
+        }
+        uint32_t found = 0;
+        t0 = nowUs();
+        for (int r = 0; r < 8; r++)
+            for (uint32_t n = 0; n < fill; n++) found += t.find(hits[n].b) != nullptr;
+        double hitUs = nowUs() - t0;
+        uint32_t stray = 0;
+        t0 = nowUs();
+        for (int r = 0; r < 8; r++)
+            for (uint32_t n = 0; n < fill; n++) stray += t.find(misses[n].b) != nullptr;
+        double missUs = nowUs() - t0;
+
+        printf("  %u%% full (%5u): insert %6.1f ns, hit %6.1f ns, miss %6.1f ns\n",
+               quarter * 25, fill, insertUs * 1000 / fill, hitUs * 1000 / (fill * 8.0),
+               missUs * 1000 / (fill * 8.0));
+        char what[64];
+        snprintf(what, sizeof(what), "%u%% full: all found, no false hits", quarter * 25);
+        check(found == fill * 8 && stray == 0 && t.size() == fill, what);
+    }
+}
+
+// -- 2. Diffs --------------------------------------------------------------
+
+static void diffs() {
+    printf("\n2. scan diffs\n");
+    std::vector<NetEntry> storage(256);
+    NetTable t;
+    t.init(storage.data(), 256);
+
+    // Scan 1: networks 0..29
+    t.beginScan(100);
+    for (uint32_t n = 0; n < 30; n++) observe(t, n);
+    NetTable::Diff d = t.endScan();
+    check(d.heard == 30 && d.added == 30 && d.gone == 0 && d.changed == 0,
+          "first scan: everything new");
+
+    // Scan 2: 0..24 again (two of them moved), 30..34 appear, 25..29 gone
+    t.beginScan(110);
+    for (uint32_t n = 0; n < 25; n++) {
+        Mac m = macFor(n);
+        if (n == 3)      t.observe(m.b, ssidFor(n) + 1, authFor(n), chanFor(n), rssiFor(n));
+        else if (n == 4) t.observe(m.b, ssidFor(n), authFor(n), chanFor(n), rssiFor(n) - 20);
+        else             t.observe(m.b, ssidFor(n), authFor(n), chanFor(n), rssiFor(n) + 3);
+    }
+    for (uint32_t n = 30; n < 35; n++) observe(t, n);
+    d = t.endScan();
+    printf("  heard %u, new %u, gone %u, changed %u\n", d.heard, d.added, d.gone, d.changed);
+    check(d.heard == 30 && d.added == 5 && d.gone == 5 && d.changed == 2,
+          "second scan: 5 new, 5 gone, 2 changed");
+
+    const NetEntry* e = t.find(macFor(27).b);
+    check(e && (e->flags & NetEntry::F_GONE) && e->lastSeen == 100, "gone entry kept, flagged");
+    e = t.find(macFor(31).b);
+    check(e && (e->flags & NetEntry::F_NEW) && e->firstSeen == 110, "new entry flagged");
+    e = t.find(macFor(3).b);
+    check(e && (e->flags & NetEntry::F_CHANGED) && e->firstSeen == 100 && e->scans == 2,
+          "renamed entry flagged changed");
+    e = t.find(macFor(5).b);
+    check(e && e->flags == 0, "small RSSI wobble is not a change");
+
+    // Scan 3, same second as scan 2: still a scan of its own
+    t.beginScan(110);
+    for (uint32_t n = 0; n < 35; n++) observe(t, n);
+    d = t.endScan();
+    check(d.added == 0 && d.gone == 0 && d.heard == 35,
+          "same-second scan: 25..29 come back, not new");
+    e = t.find(macFor(27).b);
+    check(e && e->flags == 0 && e->scans == 2, "returning entry counts its scans");
+
+    // Scan 4: nothing heard
+    t.beginScan(120);
+    d = t.endScan();
+    check(d.heard == 0 && d.gone == 35 && t.size() == 35, "empty scan: all gone, none forgotten");
+}
+
+// -- 3/4. Eviction ---------------------------------------------------------
+
+static void eviction(uint32_t capacity) {
+    printf("\n3. eviction, rolling population\n");
+    std::vector<NetEntry> storage(capacity);
+    NetTable t;
+    t.init(storage.data(), capacity);
+
+    // Each scan hears a window of `perScan` networks that slides by `step`:
+    // about capacity * 8 distinct BSSIDs over the run
+    const uint32_t perScan = capacity / 16 > 8 ? capacity / 16 : 8;
+    const uint32_t step    = perScan / 2;
+    const uint32_t scans   = capacity * 8 / step;
+
+    bool underLimit = true, intact = true, recent = true;
+    uint32_t maxSize = 0, worstScanUs = 0;
+    for (uint32_t s = 0; s < scans; s++) {
+        uint32_t first = s * step;
+        double t0 = nowUs();
+        t.beginScan(1 + s * 30);
+        for (uint32_t n = first; n < first + perScan; n++) observe(t, n);
+        t.endScan();
+        uint32_t us = static_cast<uint32_t>(nowUs() - t0);
+        if (us > worstScanUs) worstScanUs = us;
+
+        if (t.size() > maxSize) maxSize = t.size();
+        if (t.size() > t.limit()) underLimit = false;
+        if (!reachable(t)) intact = false;
+        for (uint32_t n = first; n < first + perScan; n++) {
+            if (!t.find(macFor(n).b)) recent = false;
+        }
+    }
+    const NetTable::Stats& st = t.stats();
+    printf("  %u scans of %u, %u inserts, %u evicted, peak %u / %u, slowest scan %u us\n",
+           st.scans, perScan, st.inserts, st.evictions, maxSize, capacity, worstScanUs);
+    check(underLimit, "held under 3/4 full after every scan");
+    check(recent, "current scan always fully present");
+    check(st.overflows == 0, "no inserts dropped");
+    check(st.inserts - st.evictions == t.size(), "inserts - evictions == size");
+    check(!t.find(macFor(0).b), "oldest networks evicted");
+
+    printf("\n4. probe runs after deletes\n");
+    check(intact, "every entry reachable after every scan");
+
+    // A scan bigger than the table: extra networks dropped, not stored
+    uint32_t overflows = st.overflows;
+    t.clear();
+    t.beginScan(1);
+    for (uint32_t n = 0; n < capacity + 10; n++) observe(t, n);
+    t.endScan();
+    check(t.size() == capacity - 1 && st.overflows == overflows + 11 && reachable(t),
+          "overfull scan keeps one slot free");
+    t.beginScan(2);
+    observe(t, 0);
+    t.endScan();
+    check(t.size() <= t.limit() && t.find(macFor(0).b) && reachable(t),
+          "next scan evicts back under the limit");
+}
+
+int main(int argc, char** argv) {
+    uint32_t capacity = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 4096;
+    if (capacity < NetTable::CAPACITY_MIN || (capacity & (capacity - 1)) != 0) {
+        fprintf(stderr, "capacity must be a power of two >= %u\n", NetTable::CAPACITY_MIN);
+        return 2;
+    }
+    printf("NetEntry %zu B\n", sizeof(NetEntry));
+
+    rates(capacity);
+    diffs();
+    eviction(capacity);
+
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+// ==========================================================================
+// replay -- Re-run a journal dump through the real state layer on the host
+//
+// Dump the partition (offset/size from partitions.csv):
+//   esptool.py --chip esp32s3 read_flash 0x810000 0x200000 journal.bin
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Itools/host -Iinclude -Isrc -o replay
+//       tools/replay/replay.cpp src/sys/journal_codec.cpp
+//       src/state/pet_state.cpp src/state/mood.cpp src/state/evolution.cpp
+//
+// Usage:
+//   replay journal.bin            verify every checkpoint, print a summary
+//   replay journal.bin --csv      also print PetState after every tick
+//
+// Pages are ordered by seq and decoded; each BOOT record starts a segment
+// (seed + loaded pet). Every later input is applied in order, and each
+// CHECK record (written at auto-save) is compared against the replayed
+// pet (replay_core.h, shared with tools/journal_roundtrip/). Exit code is
+// 1 if any checkpoint mismatched.
+// ==========================================================================
+
+#include "replay_core.h"
+#include "hal/sound.h"
+#include "hal/leds.h"
+#include "hal/wifi_radio.h"
+#include "sys/journal.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// -- HAL stubs: the state layer's only side effects ------------------------
+void Sound::click() {}
+void Sound::goodFeed() {}
+void Sound::badFeed() {}
+void Sound::discover() {}
+void Sound::restStart() {}
+void Sound::restEnd() {}
+void Sound::hatch() {}
+
+void LEDs::off() {}
+void LEDs::happy() {}
+void LEDs::sad() {}
+void LEDs::wifi() {}
+void LEDs::rest() {}
+void LEDs::breathe(unsigned long) {}
+
+void WifiRadio::startScan() {}
+bool WifiRadio::isScanDone() { return g_replayScanReady; }
+WifiStats WifiRadio::getResults() {
+    g_replayScanReady = false;
+    return g_replayScan;
+}
+
+void Journal::wifiScan(unsigned long, const WifiStats&) {}
+
+static bool loadFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s journal.bin [--csv]\n", argv[0]);
+        return 2;
+    }
+    bool csv = argc > 2 && strcmp(argv[2], "--csv") == 0;
+
+    std::vector<uint8_t> image;
+    if (!loadFile(argv[1], image)) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 2;
+    }
+
+    ReplaySummary sum = replayImage(image, true, csv);
+    printf("# %u records, %u segments, %u ticks, %u checkpoints, %u mismatches\n",
+           sum.records, sum.segments, sum.ticks, sum.checks, sum.mismatches);
+    return sum.mismatches ? 1 : 0;
+}
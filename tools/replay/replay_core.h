@@ -0,0 +1,255 @@
+#pragma once
+// ==========================================================================
+// Replay core -- Journal pages in, the state layer re-run, checkpoints out
+// Shared by tools/replay/ (a dump read off the device) and
+// tools/journal_roundtrip/ (a ring the real writer just filled on the
+// host). Header-only; include it from one file of each tool, which also
+// provides the HAL stubs PetLogic calls. Its WifiRadio stub must hand
+// out g_replayScan while g_replayScanReady is set: that is how a
+// journaled scan reaches the tick that consumed it.
+// ==========================================================================
+
+#include "state/pet_state.h"
+#include "sys/journal_codec.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+static WifiStats g_replayScan;
+static bool      g_replayScanReady = false;
+
+// -- Record stream over seq-ordered pages ----------------------------------
+class RecordStream {
+public:
+    RecordStream(const std::vector<uint8_t>& image) : m_image(image) {
+        for (size_t off = 0; off + JournalCodec::PAGE_SIZE <= image.size();
+             off += JournalCodec::PAGE_SIZE) {
+            JournalCodec::PageHeader h;
+            if (JournalCodec::readPageHeader(&image[off], h)) m_pages.push_back({ h.seq, off });
+            else if (h.len != 0xFFFF) m_badPages++;
+        }
+        std::sort(m_pages.begin(), m_pages.end(),
+                  [](const Page& a, const Page& b) { return a.seq < b.seq; });
+        m_hasPeek = fetch(m_peek);
+    }
+
+    bool next(JournalCodec::Record& out) {
+        if (!m_hasPeek) return false;
+        out = m_peek;
+        bool gap = m_peekGap;
+        m_peekGap = false;
+        m_hasPeek = fetch(m_peek);
+        m_gap = gap;
+        return true;
+    }
+    const JournalCodec::Record* peek() const { return m_hasPeek ? &m_peek : nullptr; }
+
+    // True if pages were lost right before the record last returned by next()
+    bool takeGap() {
+        bool g = m_gap;
+        m_gap = false;
+        return g;
+    }
+
+    size_t pageCount() const { return m_pages.size(); }
+    size_t badPages() const  { return m_badPages; }
+
+private:
+    struct Page {
+        uint32_t seq;
+        size_t   offset;
+    };
+
+    bool fetch(JournalCodec::Record& out) {
+        while (true) {
+            if (m_reader && m_reader->next(out)) return true;
+            if (m_pageIdx >= m_pages.size()) return false;
+
+            const Page& p = m_pages[m_pageIdx++];
+            if (m_pageIdx > 1 && p.seq != m_pages[m_pageIdx - 2].seq + 1) m_peekGap = true;
+            m_reader.emplace(&m_image[p.offset]);
+        }
+    }
+
+    const std::vector<uint8_t>& m_image;
+    std::vector<Page> m_pages;
+    std::optional<JournalCodec::PageReader> m_reader;
+    size_t m_pageIdx  = 0;
+    size_t m_badPages = 0;
+    bool   m_gap      = false;
+    bool   m_peekGap  = false;
+    JournalCodec::Record m_peek;
+    bool   m_hasPeek  = false;
+};
+
+// -- Replayed state (mirrors the globals main.cpp hands to PetLogic) -------
+struct Sim {
+    PetState pet;
+    WifiStats wifi;
+    CosmaniaStatus cosmania;
+    Settings settings;
+    Activity activity = ACT_NONE;
+    RestPhase restPhase = REST_NONE;
+    int restFrameIndex = 0;
+    unsigned long restDurationMs = 0;
+    bool restStatsApplied = false;
+    RadioEnvironment radio;
+    PetLogic::Context ctx;
+
+    void reset(const PetState& loaded) {
+        *this = Sim();
+        pet = loaded;
+        ctx.pet              = &pet;
+        ctx.wifi             = &wifi;
+        ctx.cosmania         = &cosmania;
+        ctx.settings         = &settings;
+        ctx.activity         = &activity;
+        ctx.restPhase        = &restPhase;
+        ctx.restFrameIndex   = &restFrameIndex;
+        ctx.restDurationMs   = &restDurationMs;
+        ctx.restStatsApplied = &restStatsApplied;
+        ctx.radio            = &radio;
+    }
+};
+
+static bool samePet(const PetState& a, const PetState& b) {
+    return a.hunger == b.hunger && a.happiness == b.happiness &&
+           a.health == b.health && a.ageMinutes == b.ageMinutes &&
+           a.ageHours == b.ageHours && a.ageDays == b.ageDays &&
+           a.stage == b.stage && a.mood == b.mood &&
+           a.alive == b.alive && a.hatched == b.hatched;
+}
+
+static void printPet(const char* tag, const PetState& p) {
+    printf("%s hunger=%d happy=%d health=%d age=%ud%uh%um stage=%d mood=%d alive=%d hatched=%d\n",
+           tag, p.hunger, p.happiness, p.health,
+           (unsigned)p.ageDays, (unsigned)p.ageHours, (unsigned)p.ageMinutes,
+           (int)p.stage, (int)p.mood, p.alive ? 1 : 0, p.hatched ? 1 : 0);
+}
+
+// -- Replay ----------------------------------------------------------------
+struct ReplaySummary {
+    size_t   pages = 0, badPages = 0;
+    unsigned records = 0, segments = 0, ticks = 0, checks = 0, mismatches = 0;
+};
+
+// Each BOOT record starts a segment (seed + loaded pet). Every later input
+// is applied in order, and each CHECK record (written at auto-save) is
+// compared against the replayed pet. `verbose` prints boots, gaps and
+// mismatches as "# " lines; `csv` the pet after every tick
+static ReplaySummary replayImage(const std::vector<uint8_t>& image, bool verbose, bool csv) {
+    using namespace JournalCodec;
+
+    // Decoded snapshots carry no version; give each a fresh one as the
+    // device producers do, so the mood/evolution fingerprint gates see it
+    uint32_t version = 0;
+
+    RecordStream stream(image);
+    ReplaySummary sum;
+    sum.pages    = stream.pageCount();
+    sum.badPages = stream.badPages();
+    if (verbose) printf("# %zu pages, %zu corrupt\n", sum.pages, sum.badPages);
+    if (csv) printf("ms,hunger,happiness,health,ageMin,stage,mood,activity,alive\n");
+
+    Sim sim;
+    bool live = false;              // inside a segment that began with BOOT
+
+    Record rec;
+    while (stream.next(rec)) {
+        sum.records++;
+        if (stream.takeGap() && live) {
+            if (verbose) {
+                printf("# seq gap at %lu ms: segment abandoned until next boot\n",
+                       (unsigned long)rec.timeMs);
+            }
+            live = false;
+        }
+
+        if (rec.type == REC_BOOT) {
+            sim.reset(rec.pet);
+            PetLogic::seed(rec.seed);
+            PetLogic::init(sim.ctx, rec.timeMs);
+            live = true;
+            sum.segments++;
+            if (verbose) {
+                printf("# boot seed %08lx at %lu ms\n", (unsigned long)rec.seed,
+                       (unsigned long)rec.timeMs);
+            }
+            continue;
+        }
+        if (!live) continue;       // ring wrapped mid-segment: no start state
+
+        switch (rec.type) {
+            case REC_TICK:
+            case REC_TICKS:
+                for (int i = 0; i < rec.tickCount; i++) {
+                    unsigned long now = rec.tickMs[i];
+
+                    // A scan consumed during this tick was journaled right after it
+                    const Record* nx = stream.peek();
+                    if (i == rec.tickCount - 1 && nx && nx->type == REC_WIFI &&
+                        nx->timeMs == now) {
+                        g_replayScan = nx->wifi;
+                        g_replayScan.version = ++version;
+                        g_replayScanReady = true;
+                    }
+
+                    PetLogic::tick(sim.ctx, now);
+                    g_replayScanReady = false;
+                    sum.ticks++;
+
+                    if (csv) {
+                        const PetState& p = sim.pet;
+                        printf("%lu,%d,%d,%d,%lu,%d,%d,%d,%d\n", now,
+                               p.hunger, p.happiness, p.health,
+                               (unsigned long)p.ageMinutes, (int)p.stage,
+                               (int)p.mood, (int)sim.activity, p.alive ? 1 : 0);
+                    }
+                }
+                break;
+
+            case REC_WIFI:      break;  // consumed by the preceding tick
+            case REC_COSMANIA:
+                sim.cosmania = rec.cosmania;
+                sim.cosmania.version = ++version;
+                break;
+            case REC_RADIO:
+                sim.radio = rec.radio;
+                sim.radio.version = ++version;
+                break;
+            case REC_BUTTONS:   break;  // UI-only; state effects arrive as RESET/PET
+            case REC_NFC:       break;
+
+            case REC_RESET:
+                PetLogic::resetPet(sim.ctx, rec.fullReset, rec.timeMs);
+                break;
+
+            case REC_PET:
+                sim.pet = rec.pet;
+                break;
+
+            case REC_CATCHUP:
+                PetLogic::catchUp(sim.ctx, rec.elapsedMs, rec.timeMs);
+                break;
+
+            case REC_CHECK:
+                sum.checks++;
+                if (!samePet(sim.pet, rec.pet)) {
+                    sum.mismatches++;
+                    if (verbose) {
+                        printf("# MISMATCH at %lu ms\n", (unsigned long)rec.timeMs);
+                        printPet("#   device:", rec.pet);
+                        printPet("#   replay:", sim.pet);
+                    }
+                    sim.pet = rec.pet;  // resync so one divergence isn't reported forever
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+    return sum;
+}
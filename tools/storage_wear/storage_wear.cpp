@@ -0,0 +1,286 @@
+// ==========================================================================
+// storage_wear -- Host check of Storage's NVS write volume and recovery
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Itools/host -Iinclude -Isrc -o storage_wear
+//       tools/storage_wear/storage_wear.cpp src/hal/storage.cpp src/hal/storage_codec.cpp
+//       src/state/pet_state.cpp src/state/mood.cpp src/state/evolution.cpp
+//
+// Runs the real Storage against tools/host/Preferences.h (in-memory NVS
+// with write counters):
+//   1. migration from the legacy one-key-per-field layout
+//   2. one simulated day of auto-saves (egg, Cosmania-fed, starving, dead),
+//      advanced with PetLogic::catchUp, vs. the legacy 15 puts per save
+//   3. a torn blob write followed by a reboot
+//   4. the field table: every Settings field round-trips, a schema-1 blob
+//      migrates forward, unknown tags from a newer build are skipped
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "hal/storage.h"
+#include "hal/storage_codec.h"
+#include "hal/sound.h"
+#include "hal/leds.h"
+#include "hal/wifi_radio.h"
+#include "state/pet_state.h"
+#include "sys/journal.h"
+#include "config.h"
+
+#include <Preferences.h>
+#include <cstdio>
+#include <cstring>
+
+// -- State-layer stubs -----------------------------------------------------
+void Sound::click() {}
+void Sound::goodFeed() {}
+void Sound::badFeed() {}
+void Sound::discover() {}
+void Sound::restStart() {}
+void Sound::restEnd() {}
+void Sound::hatch() {}
+
+void LEDs::off() {}
+void LEDs::happy() {}
+void LEDs::sad() {}
+void LEDs::wifi() {}
+void LEDs::rest() {}
+void LEDs::breathe(unsigned long) {}
+
+void WifiRadio::startScan() {}
+bool WifiRadio::isScanDone() { return false; }
+WifiStats WifiRadio::getResults() { return WifiStats(); }
+
+void Journal::wifiScan(unsigned long, const WifiStats&) {}
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-44s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static bool samePet(const PetState& a, const PetState& b) {
+    return a.hunger == b.hunger && a.happiness == b.happiness &&
+           a.health == b.health && a.ageMinutes == b.ageMinutes &&
+           a.ageHours == b.ageHours && a.ageDays == b.ageDays &&
+           a.stage == b.stage && a.hatched == b.hatched;
+}
+
+// -- 1. Legacy migration ---------------------------------------------------
+static void legacyMigration() {
+    printf("legacy migration\n");
+    Preferences nvs;
+    nvs.putInt("hunger", 41);
+    nvs.putInt("happy", 52);
+    nvs.putInt("health", 63);
+    nvs.putULong("ageDay", 3);
+    nvs.putUChar("stage", STAGE_NYMPH);
+    nvs.putBool("hatched", true);
+    nvs.putUChar("tftBri", 2);
+
+    PetState pet;
+    Settings settings;
+    Storage::init();
+    Storage::load(pet, settings);
+    check(pet.hunger == 41 && pet.health == 63 && pet.ageDays == 3 &&
+          pet.stage == STAGE_NYMPH && settings.tftBrightness == 2,
+          "legacy keys loaded");
+
+    Storage::save(pet, settings);
+    check(!nvs.isKey("hunger") && !nvs.isKey("tftBri"), "legacy keys removed after first save");
+
+    PetState again;
+    Settings againSettings;
+    Storage::load(again, againSettings);
+    check(samePet(pet, again) && againSettings.tftBrightness == 2, "blob round-trips");
+}
+
+// -- 2. One day of auto-saves ----------------------------------------------
+static void simulatedDay() {
+    printf("simulated day (auto-save every %d ms)\n", DEFAULT_SAVE_MS);
+
+    PetState pet;
+    Settings settings;
+    WifiStats wifi;
+    CosmaniaStatus cosmania;
+    RadioEnvironment radio;
+    Activity activity = ACT_NONE;
+    RestPhase restPhase = REST_NONE;
+    int restFrame = 0;
+    unsigned long restDuration = 0;
+    bool restApplied = false;
+    PetLogic::Context ctx = { &pet, &wifi, &cosmania, &settings, &activity,
+                              &restPhase, &restFrame, &restDuration, &restApplied, &radio };
+
+    Storage::load(pet, settings);
+    pet = PetState();
+    PetLogic::init(ctx, 0);
+    Preferences::resetCounters();
+    const uint32_t writtenBefore = Storage::stats().written;
+    const uint32_t skippedBefore = Storage::stats().skipped;
+
+    const uint32_t saves = 24UL * 3600 * 1000 / DEFAULT_SAVE_MS;
+    unsigned long now = 0;
+    for (uint32_t i = 0; i < saves; i++) {
+        uint32_t hour = i * DEFAULT_SAVE_MS / 3600000;
+
+        // 0-2 h egg on the hatch screen: no logic ticks
+        if (hour == 2 && !pet.hatched) pet.hatched = true;
+
+        // 2-16 h Cosmania GREEN keeps health/happiness pinned; then it
+        // drops out and the pet starves until it dies
+        cosmania.connected  = hour < 16;
+        cosmania.budgetTier = TIER_GREEN;
+
+        now += DEFAULT_SAVE_MS;
+        if (pet.hatched && pet.alive) PetLogic::catchUp(ctx, DEFAULT_SAVE_MS, now);
+        Storage::save(pet, settings);
+    }
+
+    const Preferences::Counters& c = Preferences::counters();
+    const Storage::Stats& st = Storage::stats();
+    const uint32_t written = st.written - writtenBefore;
+    const uint32_t legacyPuts = saves * 15;     // 14 fields + savedAt, one entry each
+    printf("  saves %lu  blob writes %lu  skipped %lu  pet %s\n",
+           (unsigned long)saves, (unsigned long)written,
+           (unsigned long)(st.skipped - skippedBefore), pet.alive ? "alive" : "dead");
+    printf("  NVS puts    %6lu  (legacy %lu, %.1fx fewer)\n", (unsigned long)c.puts,
+           (unsigned long)legacyPuts, c.puts ? (double)legacyPuts / c.puts : 0.0);
+    printf("  NVS entries %6lu  (legacy %lu, %.1fx fewer)\n", (unsigned long)c.entries,
+           (unsigned long)legacyPuts, c.entries ? (double)legacyPuts / c.entries : 0.0);
+    check(c.puts == written, "one NVS put per blob write");
+    check(c.puts < legacyPuts / 10, "at least 10x fewer puts than legacy");
+}
+
+// -- 3. Torn write ---------------------------------------------------------
+static void tornWrite() {
+    printf("torn write\n");
+    PetState pet;
+    Settings settings;
+    Storage::load(pet, settings);
+
+    pet.hunger = 11;
+    Storage::save(pet, settings);
+    PetState committed = pet;
+
+    pet.hunger = 22;
+    Preferences::tornNextPut();
+    Storage::save(pet, settings);       // power lost mid-write
+
+    PetState loaded;
+    Settings loadedSettings;
+    uint32_t corruptBefore = Storage::stats().corruptSlots;
+    Storage::load(loaded, loadedSettings);
+    check(samePet(loaded, committed), "reboot loads the last complete slot");
+    check(Storage::stats().corruptSlots == corruptBefore + 1, "torn slot reported");
+
+    loaded.hunger = 33;
+    Storage::save(loaded, loadedSettings);
+    PetState after;
+    Storage::load(after, loadedSettings);
+    check(after.hunger == 33, "next save overwrites the torn slot");
+}
+
+// -- 4. Field table --------------------------------------------------------
+static bool sameSettings(const Settings& a, const Settings& b) {
+    bool same = a.soundEnabled == b.soundEnabled && a.neoPixelsEnabled == b.neoPixelsEnabled &&
+                a.tftBrightness == b.tftBrightness && a.ledBrightness == b.ledBrightness &&
+                a.autoSleep == b.autoSleep && a.autoSaveMs == b.autoSaveMs &&
+                a.pollIntervalMs == b.pollIntervalMs &&
+                strcmp(a.cosmaniaUrl, b.cosmaniaUrl) == 0 &&
+                strcmp(a.wifiSsid, b.wifiSsid) == 0 && strcmp(a.wifiPass, b.wifiPass) == 0;
+    for (int i = 0; i < 4; i++) {
+        const GeoProfile& x = a.geoProfiles[i];
+        const GeoProfile& y = b.geoProfiles[i];
+        same &= x.lat == y.lat && x.lng == y.lng && x.radius == y.radius && x.zone == y.zone;
+    }
+    for (int i = 0; i < 8; i++) {
+        const NfcTag& x = a.nfcTags[i];
+        const NfcTag& y = b.nfcTags[i];
+        same &= x.uidLen == y.uidLen && x.zone == y.zone && memcmp(x.uid, y.uid, 7) == 0;
+    }
+    return same;
+}
+
+static void fieldTable() {
+    using namespace StorageCodec;
+    printf("field table (%d fields, schema %u)\n", FIELD_COUNT, (unsigned)SCHEMA_VERSION);
+
+    PetState pet;
+    pet.hunger = -3;                    // sign survives
+    pet.ageDays = 400;
+    pet.stage = STAGE_ELDER;
+    pet.hatched = true;
+
+    Settings settings;
+    settings.soundEnabled = false;
+    settings.pollIntervalMs = 12000;
+    strcpy(settings.cosmaniaUrl, "http://cosmania.local:8080/api/status");
+    strcpy(settings.wifiSsid, "tama-net");
+    memset(settings.wifiPass, 'p', sizeof(settings.wifiPass) - 1);
+    settings.geoProfiles[1] = { 52.52f, 13.405f, 250.0f, LOC_WORK };
+    settings.geoProfiles[3].radius = 0.0f;
+    settings.nfcTags[7] = { { 1, 2, 3, 4, 5, 6, 7 }, 7, LOC_TRAVEL };
+
+    uint8_t payload[PAYLOAD_MAX];
+    size_t len = encode(pet, settings, 1234, payload, sizeof(payload));
+    PetState pet2;
+    Settings settings2;
+    uint32_t savedAt = 0;
+    bool ok = len > 0 && decode(SCHEMA_VERSION, payload, len, pet2, settings2, savedAt);
+    check(ok && samePet(pet, pet2) && sameSettings(settings, settings2) && savedAt == 1234,
+          "all fields round-trip");
+
+    PetState defPet;
+    Settings defSettings;
+    size_t defLen = encode(defPet, defSettings, 0, payload, sizeof(payload));
+    printf("  payload %zu B full, %zu B at defaults\n", len, defLen);
+    check(defLen == 4, "defaults are omitted");
+
+    // Unknown tag from a newer build, then a known one after it
+    len = encode(pet, settings, 0, payload, sizeof(payload));
+    const uint8_t extra[] = { 250, 3, 9, 9, 9 };
+    memmove(payload + 4 + sizeof(extra), payload + 4, len - 4);
+    memcpy(payload + 4, extra, sizeof(extra));
+    PetState pet3;
+    Settings settings3;
+    ok = decode(SCHEMA_VERSION, payload, len + sizeof(extra), pet3, settings3, savedAt);
+    check(ok && samePet(pet, pet3) && sameSettings(settings, settings3), "unknown tags skipped");
+
+    // Schema-1 blob (packed fixed layout) in slot A
+    uint8_t v1[HEADER_SIZE + 31] = {};
+    uint8_t* body = v1 + HEADER_SIZE;
+    body[0] = 55;                       // hunger
+    body[14] = 2;                       // ageDays
+    body[18] = STAGE_NYMPH;
+    body[19] = 1;                       // hatched
+    body[22] = 2;                       // tftBrightness
+    body[25] = 0x60; body[26] = 0xEA;   // autoSaveMs 60000
+    Header h = { MAGIC, 1, 31, 5, crc32(body, 31) };
+    writeHeader(v1, h);
+
+    Preferences nvs;
+    nvs.remove("stateB");
+    nvs.putBytes("stateA", v1, sizeof(v1));
+    PetState migrated;
+    Settings migratedSettings;
+    Storage::load(migrated, migratedSettings);
+    check(migrated.hunger == 55 && migrated.ageDays == 2 && migrated.stage == STAGE_NYMPH &&
+          migratedSettings.tftBrightness == 2 && migratedSettings.autoSaveMs == 60000 &&
+          migratedSettings.pollIntervalMs == 30000, "schema 1 blob loads, new fields default");
+
+    Storage::save(migrated, migratedSettings);
+    uint8_t raw[HEADER_SIZE + PAYLOAD_MAX];
+    nvs.getBytes("stateB", raw, sizeof(raw));
+    readHeader(raw, h);
+    check(h.schema == SCHEMA_VERSION && h.seq == 6, "unchanged state rewritten at new schema");
+}
+
+int main() {
+    legacyMigration();
+    simulatedDay();
+    tornWrite();
+    fieldTable();
+    printf("%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,663 @@
+// ==========================================================================
+// telemetry_bench -- Host test of TelemetryQueue against a local endpoint
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -pthread -Itools/host -Iinclude -Isrc -o telemetry_bench
+//       tools/telemetry_bench/telemetry_bench.cpp src/net/telemetry_queue.cpp
+//       src/net/telemetry_spill.cpp src/net/deflate.cpp src/net/http_fetch.cpp
+//       src/sys/journal_codec.cpp tools/host/net_resolve_host.cpp
+//       tools/host/mock_http.cpp tools/host/flash_region_host.cpp -lz
+//
+// Usage:
+//   telemetry_bench [image.bin]          default /tmp/telemetry.bin
+//
+// Drives the real queue with a simulated day of pet / radio / threat
+// events (virtual clock) and POSTs to MockHttp on 127.0.0.1, which
+// inflates every frame with zlib, decodes the MessagePack and rebuilds the
+// events from their deltas:
+//   1. link always up: every event arrives, exact and in order; bytes per
+//      event raw vs MessagePack vs deflated, batch occupancy at seal
+//   2. a 6 h outage with the flash spill: frames spill, come back oldest
+//      first, nothing lost
+//   3. the same outage without a spill: the batch fills, the overflow is
+//      dropped and counted, everything kept still arrives
+//   4. 503s and dropped connections back off and then deliver; a 400
+//      drops the frame and the queue moves on
+//   5. reboot with frames in flash, and power cuts mid-spill and between
+//      POST and ack: nothing corrupt is sent, duplicates share boot + seq
+//   6. record / deflate cost, deflate size vs zlib
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "net/telemetry_queue.h"
+#include "net/deflate.h"
+#include "flash_emu.h"
+#include "mock_http.h"
+
+#include <zlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t PARTITION_SIZE = 0x40000;
+static constexpr uint32_t EPOCH0         = 1760000000;     // sim start, epoch s
+static constexpr uint32_t DEVICE_ID      = 0xC0FFEE;
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+static double nowUs() {
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+static double threadUs() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// -- Events ----------------------------------------------------------------
+struct Event {
+    uint8_t  kind = 0;
+    uint32_t time = 0;
+    std::vector<int32_t> fields;
+
+    bool operator==(const Event& o) const {
+        return kind == o.kind && time == o.time && fields == o.fields;
+    }
+};
+
+// A day shaped like the firmware's: pet every 60 s and on mood changes,
+// radio on change (>= 15 s apart), the odd threat
+static std::vector<Event> simulate(uint32_t start, uint32_t seconds, uint32_t seed) {
+    std::vector<Event> out;
+    srand(seed);
+    int32_t hunger = 80, happy = 70, health = 90, mood = 2, age = 5000;
+    int32_t radio[8] = { 12, 1, 30, 4, 0, 0, 95, 0 };
+    uint32_t lastPet = 0, lastRadio = 0;
+    for (uint32_t t = start; t < start + seconds; t++) {
+        if (t % 60 == 0) {
+            age++;
+            hunger = std::max(0, hunger - 1 + (rand() % 40 == 0) * 30);
+            happy  = std::max(0, std::min(100, happy + rand() % 3 - 1));
+        }
+        bool moodChange = rand() % 1800 == 0;
+        if (moodChange) mood = rand() % 8;
+        if (t - lastPet >= 60 || moodChange) {
+            out.push_back({ 0, t, { hunger, happy, health, mood, 3, age, 3 } });
+            lastPet = t;
+        }
+        if (rand() % 20 == 0) {
+            radio[0] = std::max(0, radio[0] + rand() % 5 - 2);
+            radio[2] += rand() % 4;
+            radio[3] = 2 + rand() % 6;
+            radio[6] = 80 + rand() % 21;
+        }
+        if (t - lastRadio >= 15) {
+            out.push_back({ 1, t, std::vector<int32_t>(radio, radio + 8) });
+            lastRadio = t;
+        }
+        if (rand() % 5000 == 0) out.push_back({ 2, t, { 1 + rand() % 6, rand() % 4 } });
+    }
+    return out;
+}
+
+// -- Endpoint: inflate, decode, un-delta -----------------------------------
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint8_t byte() {
+        if (p >= end) { ok = false; return 0; }
+        return *p++;
+    }
+    uint32_t be(int n) {
+        uint32_t v = 0;
+        while (n--) v = (v << 8) | byte();
+        return v;
+    }
+    int64_t integer() {
+        uint8_t b = byte();
+        if (b <= 0x7f) return b;
+        if (b >= 0xe0) return static_cast<int8_t>(b);
+        switch (b) {
+            case 0xcc: return be(1);
+            case 0xcd: return be(2);
+            case 0xce: return be(4);
+            case 0xd0: return static_cast<int8_t>(be(1));
+            case 0xd1: return static_cast<int16_t>(be(2));
+            case 0xd2: return static_cast<int32_t>(be(4));
+        }
+        ok = false;
+        return 0;
+    }
+    std::string str() {
+        uint8_t b = byte();
+        if ((b & 0xe0) != 0xa0) { ok = false; return ""; }
+        std::string s(reinterpret_cast<const char*>(p), std::min<size_t>(b & 0x1f, end - p));
+        p += s.size();
+        return s;
+    }
+    uint32_t array() {
+        uint8_t b = byte();
+        if ((b & 0xf0) == 0x90) return b & 0x0f;
+        if (b == 0xdd) return be(4);
+        ok = false;
+        return 0;
+    }
+};
+
+struct Frame {
+    uint32_t boot = 0, seq = 0, dev = 0;
+    std::vector<Event> events;
+    std::string doc;            // inflated MessagePack
+    size_t wireBytes = 0;
+};
+
+static bool inflateBody(const std::string& body, std::string& out) {
+    out.resize(8192);
+    uLongf len = out.size();
+    if (uncompress(reinterpret_cast<Bytef*>(&out[0]), &len,
+                   reinterpret_cast<const Bytef*>(body.data()), body.size()) != Z_OK) {
+        return false;
+    }
+    out.resize(len);
+    return true;
+}
+
+static bool decodeFrame(const std::string& doc, Frame& f) {
+    Reader r{ reinterpret_cast<const uint8_t*>(doc.data()),
+              reinterpret_cast<const uint8_t*>(doc.data()) + doc.size() };
+    if (r.byte() != 0x86) return false;
+    uint32_t t0 = 0, count = 0;
+    for (int i = 0; i < 6 && r.ok; i++) {
+        std::string key = r.str();
+        if (key == "ev") { count = r.array(); break; }
+        int64_t v = r.integer();
+        if (key == "v" && v != 1) return false;
+        if (key == "dev")  f.dev  = v;
+        if (key == "boot") f.boot = v;
+        if (key == "seq")  f.seq  = v;
+        if (key == "t0")   t0     = v;
+    }
+    uint32_t last[TelemetryQueue::KIND_COUNT][TelemetryQueue::FIELDS_MAX] = {};
+    uint32_t t = t0;
+    for (uint32_t e = 0; e < count && r.ok; e++) {
+        uint32_t n = r.array();
+        Event ev;
+        ev.kind = r.integer();
+        if (n < 2 || ev.kind >= TelemetryQueue::KIND_COUNT) return false;
+        t += static_cast<int32_t>(r.integer());
+        ev.time = t;
+        for (uint32_t i = 0; i + 2 < n; i++) {
+            last[ev.kind][i] += static_cast<uint32_t>(r.integer());
+            ev.fields.push_back(static_cast<int32_t>(last[ev.kind][i]));
+        }
+        f.events.push_back(ev);
+    }
+    return r.ok && r.p == r.end;
+}
+
+struct Endpoint {
+    MockHttp server;
+    std::mutex lock;
+    std::vector<Frame> frames;          // accepted, arrival order
+    std::atomic<int> status{200};       // 0 = drop the connection unanswered
+    std::atomic<uint32_t> posts{0};
+    std::atomic<uint32_t> malformed{0};
+
+    bool start() {
+        return server.start([this](MockHttp::Conn& c, const MockHttp::Request& req) {
+            posts++;
+            const std::string* enc = req.header("Content-Encoding");
+            const std::string* type = req.header("Content-Type");
+            Frame f;
+            f.wireBytes = req.body.size();
+            bool good = req.method == "POST" && req.path == "/telemetry" &&
+                        enc && *enc == "deflate" && type && *type == "application/msgpack" &&
+                        inflateBody(req.body, f.doc) && decodeFrame(f.doc, f);
+            if (!good) malformed++;
+            int st = status;
+            if (st == 0) {
+                c.close();
+                return false;
+            }
+            if (st == 200 && good) {
+                std::lock_guard<std::mutex> g(lock);
+                frames.push_back(std::move(f));
+            }
+            c.write(MockHttp::response(good ? st : 400, ""));
+            return false;
+        });
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> g(lock);
+        frames.clear();
+        posts = 0;
+        malformed = 0;
+    }
+
+    // Every accepted event in (boot, seq) order, duplicates folded;
+    // false if two copies of one frame differ
+    bool events(std::vector<Event>& out, uint32_t& duplicates) {
+        std::lock_guard<std::mutex> g(lock);
+        std::map<std::pair<uint32_t, uint32_t>, const Frame*> bySeq;
+        duplicates = 0;
+        bool same = true;
+        for (const Frame& f : frames) {
+            auto key = std::make_pair(f.boot, f.seq);
+            auto it = bySeq.find(key);
+            if (it != bySeq.end()) {
+                duplicates++;
+                same = same && it->second->doc == f.doc;
+                continue;
+            }
+            bySeq[key] = &f;
+        }
+        out.clear();
+        for (auto& kv : bySeq) {
+            out.insert(out.end(), kv.second->events.begin(), kv.second->events.end());
+        }
+        return same;
+    }
+};
+
+static Endpoint s_endpoint;
+
+// -- Driver ----------------------------------------------------------------
+// One virtual second: polls until any upload it started has finished
+static void pump(TelemetryQueue& q, uint32_t t, bool link) {
+    uint32_t ms = (t - EPOCH0) * 1000;
+    q.poll(ms, t, link);
+    double until = nowUs() + 3e6;
+    while (q.uploading() && nowUs() < until) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        q.poll(ms, t, link);
+    }
+}
+
+struct RunResult {
+    std::vector<Event> kept;            // events record() accepted
+    int    sealOccupancySum = 0;
+    int    seals = 0;
+};
+
+// Feeds `events` second by second; link(t) says whether the STA is up
+template <typename LinkFn>
+static RunResult run(TelemetryQueue& q, const std::vector<Event>& events,
+                     uint32_t from, uint32_t to, LinkFn link) {
+    RunResult res;
+    size_t i = 0;
+    while (i < events.size() && events[i].time < from) i++;
+    for (uint32_t t = from; t < to && !FlashEmu::powerLost(); t++) {
+        for (; i < events.size() && events[i].time == t; i++) {
+            const Event& e = events[i];
+            if (q.record(static_cast<TelemetryQueue::Kind>(e.kind), e.time,
+                         e.fields.data(), static_cast<int>(e.fields.size()))) {
+                res.kept.push_back(e);
+            }
+        }
+        uint32_t batches = q.stats().batches;
+        int occ = q.occupancy();
+        pump(q, t, link(t));
+        if (q.stats().batches != batches) {
+            res.sealOccupancySum += occ;
+            res.seals++;
+        }
+    }
+    return res;
+}
+
+// Idle seconds until nothing is left to send
+static void drain(TelemetryQueue& q, uint32_t& t, TelemetrySpill* spill) {
+    q.flush();
+    for (int i = 0; i < 4000 && (q.batchEvents() || q.outboxFull() || (spill && spill->pending())); i++) {
+        pump(q, t++, true);
+    }
+}
+
+static bool sameEvents(const std::vector<Event>& a, const std::vector<Event>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+static std::unique_ptr<TelemetryQueue> makeQueue(uint32_t boot) {
+    std::unique_ptr<TelemetryQueue> q(new TelemetryQueue());
+    q->begin(s_endpoint.server.url("/telemetry").c_str(), DEVICE_ID, boot);
+    return q;
+}
+
+static bool freshFlash(const char* path) {
+    remove(path);
+    return FlashEmu::attach("telemetry", path, PARTITION_SIZE);
+}
+
+// -- 1. Steady link --------------------------------------------------------
+static void testSteady(const std::vector<Event>& day) {
+    printf("\n1. Link always up, 24 h (%zu events)\n", day.size());
+    s_endpoint.clear();
+    auto q = makeQueue(1);
+    uint32_t t = EPOCH0 + 86400;
+    RunResult r = run(*q, day, EPOCH0, t, [](uint32_t) { return true; });
+    drain(*q, t, nullptr);
+
+    std::vector<Event> got;
+    uint32_t dups;
+    s_endpoint.events(got, dups);
+    const TelemetryQueue::Stats& st = q->stats();
+    double raw = static_cast<double>(st.rawBytes) / st.events;
+    double packed = static_cast<double>(st.packedBytes) / st.sealedEvents;
+    printf("  %u uploads, %.0f events/upload, %.0f B/upload on the wire\n",
+           (unsigned)st.uploads, (double)st.sealedEvents / st.batches,
+           (double)st.sentBytes / st.uploads);
+    printf("  bytes/event: %.1f raw, %.1f MessagePack, %.1f deflated (%.0f%% of raw)\n",
+           raw, packed, q->bytesPerEvent(), 100.0 * q->bytesPerEvent() / raw);
+    printf("  batch occupancy at seal: %.0f%% avg\n",
+           r.seals ? (double)r.sealOccupancySum / r.seals : 0.0);
+    check(r.kept.size() == day.size(), "every event accepted");
+    check(sameEvents(got, day), "endpoint rebuilt every event exactly, in order");
+    check(s_endpoint.malformed == 0 && st.failures == 0, "no malformed frames, no failures");
+    check(q->bytesPerEvent() < packed && packed < raw, "deflated < MessagePack < raw per event");
+    check(st.uploads < day.size() / 20, "at least 20 events per POST");
+    bool seqOk = true;
+    for (size_t i = 0; i < s_endpoint.frames.size(); i++) {
+        seqOk = seqOk && s_endpoint.frames[i].seq == i && s_endpoint.frames[i].dev == DEVICE_ID;
+    }
+    check(seqOk, "frames carry device id and seq 0, 1, 2 ...");
+}
+
+// -- 2 + 3. Outage ----------------------------------------------------------
+static void testOutage(const std::vector<Event>& day, const char* image) {
+    const uint32_t downFrom = EPOCH0 + 2 * 3600, downTo = downFrom + 6 * 3600;
+    auto link = [&](uint32_t t) { return t < downFrom || t >= downTo; };
+
+    printf("\n2. 6 h outage, spill to flash\n");
+    s_endpoint.clear();
+    freshFlash(image);
+    FlashRegion flash;
+    TelemetrySpill spill;
+    check(flash.open("telemetry") && spill.mount(flash), "spill mounts on a blank partition");
+    auto q = makeQueue(2);
+    q->setSpill(&spill);
+    uint32_t t = EPOCH0 + 12 * 3600;
+    int peak = 0;
+    RunResult r = run(*q, day, EPOCH0, downTo, link);
+    peak = spill.pending();
+    RunResult r2 = run(*q, day, downTo, t, link);
+    r.kept.insert(r.kept.end(), r2.kept.begin(), r2.kept.end());
+    drain(*q, t, &spill);
+
+    std::vector<Event> got, want(day.begin(), day.end());
+    want.erase(std::remove_if(want.begin(), want.end(),
+                              [&](const Event& e) { return e.time >= EPOCH0 + 12 * 3600; }),
+               want.end());
+    uint32_t dups;
+    s_endpoint.events(got, dups);
+    const TelemetryQueue::Stats& st = q->stats();
+    printf("  %u frames spilled (peak %d of %d sectors), %u restored, %u uploads\n",
+           (unsigned)st.spilled, peak, spill.capacity(), (unsigned)st.restored, (unsigned)st.uploads);
+    check(st.spilled > 0 && st.restored == st.spilled, "offline frames spilled and read back");
+    check(st.dropped == 0 && sameEvents(got, want), "nothing lost across the outage");
+    check(spill.pending() == 0, "flash ring empty afterwards");
+    check(FlashEmu::stats().violations == 0, "no 0 -> 1 programs (acks are in place)");
+    FlashEmu::detach();
+
+    printf("\n3. Same outage, no spill\n");
+    s_endpoint.clear();
+    q = makeQueue(3);
+    t = EPOCH0 + 12 * 3600;
+    r = run(*q, day, EPOCH0, t, link);
+    drain(*q, t, nullptr);
+    s_endpoint.events(got, dups);
+    printf("  %u of %u events dropped while offline\n",
+           (unsigned)q->stats().dropped, (unsigned)(q->stats().events + q->stats().dropped));
+    check(q->stats().dropped > 0, "overflow dropped and counted");
+    check(q->stats().dropped + r.kept.size() == want.size(), "dropped + kept == recorded");
+    check(sameEvents(got, r.kept), "every kept event delivered exactly");
+}
+
+// -- 4. Server errors ------------------------------------------------------
+static void testErrors(const std::vector<Event>& day) {
+    printf("\n4. Server errors\n");
+    s_endpoint.clear();
+    auto q = makeQueue(4);
+    q->setThresholds(256, 60);
+    uint32_t t0 = EPOCH0, t = t0;
+    std::vector<Event> kept;
+
+    // 503 for 20 min, connection drops for 20 min, then fine
+    std::vector<uint32_t> attempts;
+    for (; t < t0 + 3600; t++) {
+        s_endpoint.status = t < t0 + 1200 ? 503 : t < t0 + 2400 ? 0 : 200;
+        for (const Event& e : day) {
+            if (e.time == t && q->record(static_cast<TelemetryQueue::Kind>(e.kind), e.time,
+                                         e.fields.data(), static_cast<int>(e.fields.size()))) {
+                kept.push_back(e);
+            }
+        }
+        uint32_t before = s_endpoint.posts;
+        pump(*q, t, true);
+        if (s_endpoint.posts != before && t < t0 + 2400) attempts.push_back(t);
+    }
+    drain(*q, t, nullptr);
+    uint32_t minGap = UINT32_MAX;
+    for (size_t i = 1; i < attempts.size(); i++) minGap = std::min(minGap, attempts[i] - attempts[i - 1]);
+    std::vector<Event> got;
+    uint32_t dups;
+    s_endpoint.events(got, dups);
+    printf("  %zu failed attempts in 40 min, closest %u s apart\n", attempts.size(), minGap);
+    check(q->stats().failures == attempts.size(), "each failed POST counted");
+    check(minGap * 1000 >= TelemetryQueue::RETRY_MIN_MS / 2, "retries back off");
+    check(attempts.size() < 20, "no retry storm");
+    check(sameEvents(got, kept), "everything delivered once the server recovers");
+
+    s_endpoint.clear();
+    s_endpoint.status = 400;
+    uint32_t rejected = q->stats().rejected;
+    int32_t f[] = { 1, 2 };
+    q->record(TelemetryQueue::THREAT, t, f, 2);
+    drain(*q, t, nullptr);
+    s_endpoint.status = 200;
+    q->record(TelemetryQueue::THREAT, t, f, 2);
+    drain(*q, t, nullptr);
+    check(q->stats().rejected == rejected + 1 && s_endpoint.frames.size() == 1,
+          "400 drops the frame, the next one goes through");
+}
+
+// -- 5. Reboots and power cuts ---------------------------------------------
+static void testPower(const std::vector<Event>& day, const char* image) {
+    printf("\n5. Reboot and power cuts\n");
+    s_endpoint.clear();
+    freshFlash(image);
+    std::vector<Event> kept;
+    {
+        FlashRegion flash;
+        TelemetrySpill spill;
+        flash.open("telemetry");
+        spill.mount(flash);
+        auto q = makeQueue(5);
+        q->setSpill(&spill);
+        kept = run(*q, day, EPOCH0, EPOCH0 + 4 * 3600, [](uint32_t) { return false; }).kept;
+        q->flush();
+        pump(*q, EPOCH0 + 4 * 3600, false);
+        printf("  boot 1: %d frames in flash, power off\n", spill.pending());
+    }
+    FlashEmu::detach();
+    FlashEmu::attach("telemetry", image, PARTITION_SIZE);
+    {
+        FlashRegion flash;
+        TelemetrySpill spill;
+        flash.open("telemetry");
+        check(spill.mount(flash) && spill.pending() > 0, "boot 2: frames found in flash");
+        auto q = makeQueue(6);
+        q->setSpill(&spill);
+        uint32_t t = EPOCH0 + 5 * 3600;
+        drain(*q, t, &spill);
+        std::vector<Event> got;
+        uint32_t dups;
+        s_endpoint.events(got, dups);
+        check(sameEvents(got, kept), "boot 2 uploads boot 1's frames intact");
+    }
+
+    // Power cuts: even runs at a random point while frames spill (the
+    // device dies there), odd runs on one of the first acks once the link
+    // is back, so those frames go out again after the reboot
+    uint64_t spillOps;
+    {
+        freshFlash(image);
+        FlashRegion flash;
+        TelemetrySpill spill;
+        flash.open("telemetry");
+        spill.mount(flash);
+        auto q = makeQueue(99);
+        q->setSpill(&spill);
+        FlashEmu::resetStats();
+        run(*q, day, EPOCH0, EPOCH0 + 3600, [](uint32_t) { return false; });
+        spillOps = FlashEmu::stats().ops;
+        FlashEmu::detach();
+    }
+    srand(45);
+    int cuts = 0, cleanTrials = 0;
+    uint32_t totalDups = 0;
+    for (int trial = 0; trial < 40; trial++) {
+        s_endpoint.clear();
+        freshFlash(image);
+        std::vector<Event> sent;
+        {
+            FlashRegion flash;
+            TelemetrySpill spill;
+            flash.open("telemetry");
+            spill.mount(flash);
+            auto q = makeQueue(100 + trial);
+            q->setSpill(&spill);
+            auto offline = [](uint32_t) { return false; };
+            auto online  = [](uint32_t) { return true; };
+            if (trial % 2 == 0) FlashEmu::cutPowerAfter(1 + rand() % spillOps);
+            sent = run(*q, day, EPOCH0, EPOCH0 + 3600, offline).kept;
+            if (trial % 2 == 1) FlashEmu::cutPowerAfter(1 + rand() % 3);
+            RunResult r = run(*q, day, EPOCH0 + 3600, EPOCH0 + 5400, online);
+            sent.insert(sent.end(), r.kept.begin(), r.kept.end());
+        }
+        cuts += FlashEmu::powerLost();
+        FlashEmu::restorePower();
+        FlashEmu::cutPowerAfter(0);
+        FlashEmu::detach();
+        FlashEmu::attach("telemetry", image, PARTITION_SIZE);
+        FlashRegion flash;
+        TelemetrySpill spill;
+        flash.open("telemetry");
+        spill.mount(flash);
+        auto q = makeQueue(200 + trial);
+        q->setSpill(&spill);
+        uint32_t t = EPOCH0 + 7200;
+        drain(*q, t, &spill);
+
+        std::vector<Event> got;
+        uint32_t dups;
+        bool same = s_endpoint.events(got, dups);
+        // Every delivered event is one that was recorded, in order
+        size_t j = 0;
+        for (const Event& e : got) {
+            while (j < sent.size() && !(sent[j] == e)) j++;
+            if (j == sent.size()) same = false;
+        }
+        cleanTrials += same && s_endpoint.malformed == 0;
+        totalDups += dups;
+    }
+    FlashEmu::detach();
+    printf("  40 runs, %d with a power cut, %u duplicate frames re-sent\n", cuts, totalDups);
+    check(cleanTrials == 40, "no corrupt or altered frame ever sent");
+    check(totalDups > 0, "an unacked frame is re-sent, same boot + seq");
+}
+
+// -- 6. Cost ---------------------------------------------------------------
+static void testCost(const std::vector<Event>& day) {
+    printf("\n6. Cost\n");
+    // record(): fill fresh batches, link down, no spill
+    double us = 0;
+    size_t n = 0;
+    for (int rep = 0; rep < 50; rep++) {
+        auto q = makeQueue(7);
+        double t0 = threadUs();
+        for (size_t i = 0; i < 150; i++) {
+            const Event& e = day[(rep * 150 + i) % day.size()];
+            q->record(static_cast<TelemetryQueue::Kind>(e.kind), e.time,
+                      e.fields.data(), static_cast<int>(e.fields.size()));
+        }
+        us += threadUs() - t0;
+        n += 150;
+    }
+    printf("  record(): %.2f us/event\n", us / n);
+
+    // Deflate on full batches, as the endpoint received them
+    s_endpoint.clear();
+    auto q = makeQueue(8);
+    q->setThresholds(TelemetryQueue::BATCH_LEN - TelemetryQueue::EVENT_MAX, 86400);
+    uint32_t t = EPOCH0 + 86400;
+    run(*q, day, EPOCH0, t, [](uint32_t) { return true; });
+    drain(*q, t, nullptr);
+    static Deflate deflate;
+    std::vector<uint8_t> out(Deflate::bound(Deflate::INPUT_MAX));
+    size_t ours = 0, z1 = 0, z9 = 0, docs = 0;
+    double worst = 0, total = 0;
+    for (const Frame& f : s_endpoint.frames) {
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(f.doc.data());
+        double c0 = threadUs();
+        ours += deflate.compress(in, f.doc.size(), out.data(), out.size());
+        double dt = threadUs() - c0;
+        worst = std::max(worst, dt);
+        total += dt;
+        docs  += f.doc.size();
+        uLongf len = compressBound(f.doc.size());
+        std::vector<Bytef> zb(len);
+        compress2(zb.data(), &len, in, f.doc.size(), 1);
+        z1 += len;
+        len = zb.size();
+        compress2(zb.data(), &len, in, f.doc.size(), 9);
+        z9 += len;
+    }
+    size_t frames = s_endpoint.frames.size();
+    printf("  deflate: %.0f us avg, %.0f us worst per %.0f B batch\n",
+           total / frames, worst, (double)docs / frames);
+    printf("  size vs input: ours %.1f%%, zlib -1 %.1f%%, zlib -9 %.1f%%\n",
+           100.0 * ours / docs, 100.0 * z1 / docs, 100.0 * z9 / docs);
+    check(ours <= z1 * 13 / 10, "within 30% of zlib -1");
+}
+
+int main(int argc, char** argv) {
+    const char* image = argc > 1 ? argv[1] : "/tmp/telemetry.bin";
+    printf("telemetry_bench: batch %zu B, frame %zu B, spill %u sectors\n",
+           TelemetryQueue::BATCH_LEN, TelemetryQueue::FRAME_LEN,
+           (unsigned)(PARTITION_SIZE / FlashRegion::SECTOR_SIZE));
+    if (!s_endpoint.start()) {
+        printf("can't start the mock endpoint\n");
+        return 1;
+    }
+    std::vector<Event> day = simulate(EPOCH0, 86400, 1);
+
+    testSteady(day);
+    testOutage(day, image);
+    testErrors(day);
+    testPower(day, image);
+    testCost(day);
+
+    s_endpoint.server.stop();
+    printf("\n%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,288 @@
+// ==========================================================================
+// threat_replay -- Replay a BLE advert trace through ThreatDetect
+//
+// Build from the repo root:
+//   g++ -std=gnu++17 -O2 -Itools/host -Iinclude -Isrc -o threat_replay
+//       tools/threat_replay/threat_replay.cpp src/state/threat_detect.cpp
+//       src/sys/ble_table.cpp
+//
+// Usage:
+//   threat_replay [seed]             default 1
+//
+// A simulated two hours next to the device, heard through the real scan
+// duty cycle (BLE_SCAN_DURATION_S of every BLE_SCAN_INTERVAL_MS):
+//
+//   residents    a dozen phones and laptops, there all along
+//   passers-by   about one a minute, for 20 s to 2 min
+//   scanner      a rogue scanner, minutes 30 - 45
+//   pairing      one resident advertising fast for 90 s at minute 60
+//   enumerator   a mass enumeration tool, minutes 90 - 100
+//
+// Each device keeps one advertising interval plus the 0-10 ms random
+// delay BLE adds to every event: residents and passers-by somewhere in
+// 100 ms - 1 s, the pairing phone 50 ms, the scanner 40 ms and the
+// enumerator the 20 ms minimum. Every advert heard is reported, as the
+// scan callback gets duplicates.
+//
+// The trace runs twice through the real ThreatDetect::tick() and
+// BleTable, once with each device's scanRate kept the old way (+1 per
+// sighting within 10 s, never down, against the old thresholds of 10
+// and 20) and once as a RateMeter. Against the ground truth -- which
+// devices really advertise above the thresholds, and when -- it reports
+// false flags per device, the highest rate read off a device that isn't
+// a scanner, and the minutes a rogue scanner threat stood with no
+// scanner about, plus how fast the real ones were caught.
+// Exit code is non-zero if any check fails.
+// ==========================================================================
+
+#include "config.h"
+#include "hal/ble.h"
+#include "hal/wifi_promisc.h"
+#include "state/threat_detect.h"
+#include "sys/ble_table.h"
+#include "sys/rate_meter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int s_failures = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-48s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failures++;
+}
+
+// -- HAL stubs: the clock, a BLE module over a real BleTable ---------------
+static unsigned long s_nowMs = 0;
+unsigned long millis() { return s_nowMs; }
+
+static bool     s_legacy = false;
+static BleTable s_table;
+static int      s_scannerCount = 0;
+
+int BLE::deviceCount() { return s_table.size(); }
+int BLE::scannerCount() { return s_scannerCount; }
+const BleDevice* BLE::device(int idx) {
+    if (idx < 0 || idx >= static_cast<int>(s_table.size())) return nullptr;
+    return &s_table.entries()[idx];
+}
+// The old counter flagged at 10 and enumeration at 20: scaled so that
+// 10 reads as ROGUE_SCAN_THRESHOLD
+static const float LEGACY_SCALE = ROGUE_SCAN_THRESHOLD / 10.0f;
+
+float BLE::scanRate(const BleDevice& d) {
+    if (s_legacy) return d.scanRate * LEGACY_SCALE;
+    return RateMeter::at(d.scanRate, d.lastSeenMs, millis(), BLE_RATE_WINDOW_MS);
+}
+uint32_t BLE::distinctDevices(uint32_t) { return s_table.size(); }
+
+int WifiPromisc::probeCount() { return 0; }
+int WifiPromisc::uniqueProbers() { return 0; }
+int WifiPromisc::deauthCount() { return 0; }
+void WifiPromisc::resetDeauthCount() {}
+
+// What BLE::tick() does with a drained advert, either way
+static void advert(uint32_t id) {
+    uint8_t hash[4] = { uint8_t(id >> 24), uint8_t(id >> 16), uint8_t(id >> 8), uint8_t(id) };
+    bool created;
+    BleDevice& d = *s_table.upsert(hash, created);
+    unsigned long now = millis();
+    if (s_legacy) {
+        if (created) d.scanRate = 0;
+        else if (now - d.lastSeenMs < 10000 && d.scanRate < 255) d.scanRate++;
+    } else {
+        d.scanRate = RateMeter::hit(created ? 0 : d.scanRate, d.lastSeenMs, now, BLE_RATE_WINDOW_MS);
+    }
+    d.lastSeenMs = now;
+}
+
+// What BLE::tick() does when a scan window ends
+static void recountScanners() {
+    s_scannerCount = 0;
+    BleDevice* devices = s_table.entries();
+    for (uint32_t i = 0; i < s_table.size(); i++) {
+        bool over = BLE::scanRate(devices[i]) >= ROGUE_SCAN_THRESHOLD;
+        devices[i].isScanner = s_legacy ? devices[i].isScanner || over : over;
+        if (devices[i].isScanner) s_scannerCount++;
+    }
+}
+
+// -- The trace -------------------------------------------------------------
+struct Source {
+    uint32_t id;
+    uint32_t fromMs, toMs;      // present
+    uint32_t gapMinMs, gapMaxMs;    // interval, plus the random delay
+    uint32_t nextMs;
+    bool     scanner;           // ground truth: advertises above ROGUE_SCAN_THRESHOLD
+    const char* kind;
+};
+
+static const uint32_t MIN_MS  = 60000;
+static const uint32_t RUN_MS  = 120 * MIN_MS;
+static const double   HEARD   = static_cast<double>(BLE_SCAN_DURATION_S * 1000) / BLE_SCAN_INTERVAL_MS;
+
+static uint32_t s_rng;
+static uint32_t rnd() {
+    s_rng ^= s_rng << 13; s_rng ^= s_rng >> 17; s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// Heard adverts per minute from a source with these gaps
+static double heardPerMin(uint32_t gapMin, uint32_t gapMax) {
+    return HEARD * 60000.0 / ((gapMin + gapMax) / 2.0);
+}
+
+static Source source(uint32_t id, uint32_t from, uint32_t to, uint32_t intervalMs,
+                     const char* kind) {
+    uint32_t gapMin = intervalMs, gapMax = intervalMs + 10;
+    Source s = { id, from, to, gapMin, gapMax, from + rnd() % gapMax, false, kind };
+    s.scanner = heardPerMin(gapMin, gapMax) >= ROGUE_SCAN_THRESHOLD;
+    return s;
+}
+
+static std::vector<Source> makeTrace(uint32_t seed) {
+    s_rng = 0x9E3779B9u ^ seed * 2654435761u;
+    if (!s_rng) s_rng = 1;
+    std::vector<Source> t;
+    uint32_t id = 1;
+    // The fastest resident decides the margin: one at 100 ms always
+    t.push_back(source(id++, 0, RUN_MS, 100, "resident"));
+    for (int i = 1; i < 12; i++) t.push_back(source(id++, 0, RUN_MS, 100 + rnd() % 901, "resident"));
+    for (uint32_t at = rnd() % MIN_MS; at < RUN_MS; at += 20000 + rnd() % 80000) {
+        uint32_t stay = 20000 + rnd() % 100000;
+        t.push_back(source(id++, at, at + stay, 100 + rnd() % 901, "passer-by"));
+    }
+    t.push_back(source(id++, 30 * MIN_MS, 45 * MIN_MS, 40, "scanner"));
+    // The pairing phone is a resident with a fast spell: three sources, one id
+    uint32_t pairing = id++, usual = 200 + rnd() % 801;
+    t.push_back(source(pairing, 0, 60 * MIN_MS, usual, "resident"));
+    t.push_back(source(pairing, 60 * MIN_MS, 60 * MIN_MS + 90000, 50, "pairing"));
+    t.push_back(source(pairing, 60 * MIN_MS + 90000, RUN_MS, usual, "resident"));
+    t.push_back(source(id++, 90 * MIN_MS, 100 * MIN_MS, 20, "enumerator"));
+    return t;
+}
+
+// -- Replay ----------------------------------------------------------------
+struct Result {
+    uint32_t adverts        = 0;
+    uint32_t falseFlags     = 0;    // device evaluations over the threshold, truth below
+    uint32_t flaggedDevices = 0;    // distinct ids ever falsely over
+    float    peakBenignRate = 0;    // highest rate read off a device that isn't a scanner
+    double   falseThreatMin = 0;    // rogue threat up, no scanner about
+    double   scannerLatencyS  = -1; // first rogue threat after the scanner arrived
+    double   enumLatencyS     = -1; // first mass-enum threat after the enumerator arrived
+    bool     pairingCleared = false;
+};
+
+static bool hasThreat(ThreatType type) {
+    for (int i = 0; i < ThreatDetect::threatCount(); i++) {
+        if (ThreatDetect::threats()[i].type == type) return true;
+    }
+    return false;
+}
+
+static Result replay(uint32_t seed, bool legacy) {
+    s_legacy = legacy;
+    std::vector<Source> trace = makeTrace(seed);
+    static std::vector<uint32_t> storage(BleTable::bytesFor(BLE_TABLE_CAPACITY) / 4 + 1);
+    s_table.init(storage.data(), BLE_TABLE_CAPACITY);
+    s_scannerCount = 0;
+    s_nowMs = 1;
+    ThreatDetect::init();
+
+    // A real scanner's threat may stand THREAT_EXPIRE_MS after it was last
+    // flagged, and its rate takes a couple of windows to decay below
+    const uint32_t GRACE_MS = THREAT_EXPIRE_MS + 2 * BLE_RATE_WINDOW_MS;
+    uint32_t lastTruthMs = 0;
+    bool anyTruth = false;
+    std::vector<bool> falselyFlagged(trace.size() + 1, false);
+    Result r;
+
+    // Adverts keep their own schedule; a step only rounds their times
+    const uint32_t STEP_MS = 10;
+    for (uint32_t t = 0; t < RUN_MS; t += STEP_MS) {
+        s_nowMs = t + 1;
+        bool scanning = t % BLE_SCAN_INTERVAL_MS < BLE_SCAN_DURATION_S * 1000;
+        for (Source& s : trace) {
+            if (t < s.fromMs || t >= s.toMs) continue;
+            if (s.scanner) {
+                lastTruthMs = t;
+                anyTruth = true;
+            }
+            while (t >= s.nextMs) {
+                s.nextMs += s.gapMinMs + rnd() % (s.gapMaxMs - s.gapMinMs + 1);
+                if (scanning) {
+                    advert(s.id);
+                    r.adverts++;
+                }
+            }
+        }
+        if (t % BLE_SCAN_INTERVAL_MS == BLE_SCAN_DURATION_S * 1000) recountScanners();
+        if (t % 2000 != 0) continue;
+
+        ThreatDetect::tick();
+
+        // Per device: over the threshold now, but no part of the truth
+        for (uint32_t i = 0; i < s_table.size(); i++) {
+            const BleDevice& d = s_table.entries()[i];
+            float rate = BLE::scanRate(d);
+            uint32_t id = uint32_t(d.addrHash[0]) << 24 | uint32_t(d.addrHash[1]) << 16 |
+                          uint32_t(d.addrHash[2]) << 8 | d.addrHash[3];
+            bool truth = false;
+            for (const Source& s : trace) {
+                if (s.id == id && s.scanner && t >= s.fromMs && t < s.toMs + 2 * BLE_RATE_WINDOW_MS)
+                    truth = true;
+            }
+            if (truth) continue;
+            if (rate > r.peakBenignRate) r.peakBenignRate = rate;
+            if (rate < ROGUE_SCAN_THRESHOLD) continue;
+            r.falseFlags++;
+            if (id < falselyFlagged.size() && !falselyFlagged[id]) {
+                falselyFlagged[id] = true;
+                r.flaggedDevices++;
+            }
+        }
+
+        bool rogue = hasThreat(THREAT_ROGUE_SCANNER);
+        if (rogue && !(anyTruth && t - lastTruthMs <= GRACE_MS)) r.falseThreatMin += 2.0 / 60;
+        if (rogue && r.scannerLatencyS < 0 && t >= 30 * MIN_MS && t < 45 * MIN_MS)
+            r.scannerLatencyS = (t - 30 * MIN_MS) / 1000.0;
+        if (hasThreat(THREAT_MASS_ENUM) && r.enumLatencyS < 0 && t >= 90 * MIN_MS)
+            r.enumLatencyS = (t - 90 * MIN_MS) / 1000.0;
+        // Minute 70: the pairing spell is 8.5 min gone
+        if (t == 70 * MIN_MS) r.pairingCleared = !rogue;
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+    uint32_t seed = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1;
+    printf("threat replay: 2 h, seed %u, scans %u s of every %u ms, thresholds %d / %d per min\n",
+           seed, BLE_SCAN_DURATION_S, BLE_SCAN_INTERVAL_MS, ROGUE_SCAN_THRESHOLD, MASS_ENUM_THRESHOLD);
+    Result old = replay(seed, true);
+    Result now = replay(seed, false);
+
+    printf("  %-30s %12s %12s\n", "", "sightings", "RateMeter");
+    printf("  %-30s %12u %12u\n", "adverts heard", old.adverts, now.adverts);
+    printf("  %-30s %12u %12u\n", "false flags (device x eval)", old.falseFlags, now.falseFlags);
+    printf("  %-30s %12u %12u\n", "devices falsely flagged", old.flaggedDevices, now.flaggedDevices);
+    printf("  %-30s %12.0f %12.0f\n", "peak rate, no scanner (/min)", old.peakBenignRate,
+           now.peakBenignRate);
+    printf("  %-30s %12.1f %12.1f\n", "rogue threat, no scanner (min)", old.falseThreatMin,
+           now.falseThreatMin);
+    printf("  %-30s %12.0f %12.0f\n", "scanner caught after (s)", old.scannerLatencyS,
+           now.scannerLatencyS);
+    printf("  %-30s %12.0f %12.0f\n", "enumerator caught after (s)", old.enumLatencyS,
+           now.enumLatencyS);
+    printf("  %-30s %12s %12s\n", "pairing phone cleared", old.pairingCleared ? "yes" : "no",
+           now.pairingCleared ? "yes" : "no");
+
+    check(now.falseFlags * 20 < old.falseFlags, "false flags down more than 20x");
+    check(now.falseThreatMin < 1, "rogue threat stands only with a scanner about");
+    check(now.scannerLatencyS >= 0 && now.scannerLatencyS <= 120, "scanner still caught within 2 min");
+    check(now.enumLatencyS >= 0 && now.enumLatencyS <= 60, "enumerator still caught within 1 min");
+    check(now.pairingCleared, "pairing spell forgotten once it's over");
+    printf("%s\n", s_failures ? "FAILED" : "all checks passed");
+    return s_failures ? 1 : 0;
+}